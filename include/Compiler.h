@@ -65,6 +65,9 @@ namespace vc4c
          * \param inputFile Can be used by the compiler to speed-up compilation (e.g. by running the pre-compiler with
          * this file instead of needing to write input to a temporary file) \return the number of bytes written (only
          * meaningful for binary output-mode)
+         *
+         * To generate kernel variants specialized for known argument values and work-group/global sizes, set the
+         * Configuration#kernelSpecializations of the given configuration.
          */
         static std::size_t compile(std::istream& input, std::ostream& output, Configuration config = {},
             const std::string& options = "", const Optional<std::string>& inputFile = {});
@@ -73,6 +76,8 @@ namespace vc4c
         std::istream& input;
         std::ostream& output;
         Configuration config;
+        // the file the input stream is read from, if known
+        Optional<std::string> inputFile;
     };
 
     /*
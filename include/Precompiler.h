@@ -131,8 +131,12 @@ namespace vc4c
          * \param options Specify additional compiler-options to pass onto the pre-compiler
          * \param inputFile Can be used by the compiler to speed-up compilation (e.g. by running the pre-compiler with
          * these files instead of needing to write input to a temporary file) \param outputFile The optional output-file
-         * to write the pre-compiled code into. If this is specified, the code is compiled into the file, otherwise the
-         * output stream is filled with the compiled code
+         * to write the pre-compiled code into. If this is specified, the code is compiled into the file and the output
+         * stream is set to an empty stream, otherwise the output stream is set to the buffer containing the compiled
+         * code.
+         *
+         * NOTE: If no conversion is required, the output stream is set to read the input (file) directly, the output
+         * file is not written in this case.
          */
         static void precompile(std::istream& input, std::unique_ptr<std::istream>& output, Configuration config = {},
             const std::string& options = "", const Optional<std::string>& inputFile = {},
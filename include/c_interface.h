@@ -48,6 +48,13 @@ typedef struct _data_storage
     unsigned long data_length;
 } storage;
 
+/*
+ * Compiles the input into the output.
+ *
+ * The options are passed to the pre-compiler, except for kernel specializations of the form
+ * "--specialize=<kernel>[,name=<name>][,arg<index>=<value>][,local=<x>x<y>x<z>][,global=<x>x<y>x<z>]" (same as for
+ * the vc4c program), which additionally generate a variant of the kernel with the given arguments and work-sizes fixed.
+ */
 int convert(const storage* in, storage* out, const configuration config, const char* options);
 
 typedef void (*CompilationErrorHandler)(const char* message, const size_t length, void* userData);
@@ -63,6 +70,68 @@ void setErrorHandler(CompilationErrorHandler errorHandler, void* userData);
 
 int determineSourceType(const storage* in);
 
+#define OPTIMIZATION_LEVEL_NONE 0
+#define OPTIMIZATION_LEVEL_BASIC 1
+#define OPTIMIZATION_LEVEL_MEDIUM 2
+#define OPTIMIZATION_LEVEL_FULL 3
+
+/*
+ * A single compilation job of a batch compilation.
+ *
+ * The input is read directly from the given buffer (or file), without being copied.
+ *
+ * If the output is not a file, the compiled code is written directly into the caller-owned buffer "output.data" with
+ * the capacity "output.data_length". After the compilation, "output.data_length" is set to the number of bytes of the
+ * compiled code. If the buffer is too small, the status is set to -61 (CL_INVALID_BUFFER_SIZE) and
+ * "output.data_length" is set to the required size.
+ */
+typedef struct _compilation_job
+{
+    storage input;
+    storage output;
+    configuration config;
+    unsigned optimization_level;
+    /* the pre-compiler options and kernel specializations, see convert() */
+    const char* options;
+    /* set on completion, 0 (CL_SUCCESS) or an OpenCL error code */
+    int status;
+} compilation_job;
+
+typedef struct _compilation_batch* compilation_handle;
+
+/*
+ * Callback invoked (from a background thread) whenever a single job of a batch completes
+ */
+typedef void (*CompilationCallback)(compilation_job* job, void* userData);
+
+/*
+ * Starts compiling all the given jobs in parallel and returns immediately.
+ *
+ * The jobs and their input and output buffers need to stay valid until the batch is completed. The returned handle
+ * needs to be released via releaseCompilations().
+ *
+ * The callback is optional and can be NULL.
+ */
+compilation_handle submitCompilations(
+    compilation_job* jobs, size_t numJobs, CompilationCallback callback, void* userData);
+
+/*
+ * Returns whether all jobs of the given batch are completed
+ */
+int isCompilationDone(compilation_handle handle);
+
+/*
+ * Blocks until all jobs of the given batch are completed.
+ *
+ * Returns 0 (CL_SUCCESS) if all jobs succeeded, the status of the first failed job otherwise.
+ */
+int waitForCompilations(compilation_handle handle);
+
+/*
+ * Waits for the given batch to complete and frees all associated resources
+ */
+void releaseCompilations(compilation_handle handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,9 +7,12 @@
 #ifndef VC4C_CONFIG_H
 #define VC4C_CONFIG_H
 
+#include <array>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace vc4c
 {
@@ -160,6 +163,53 @@ namespace vc4c
          * if there are two optimizations which reverse each others changes.
          */
         unsigned maxOptimizationIterations = 512;
+
+        /*
+         * The maximum time (in milliseconds) the SPIRV-Tools optimizations are allowed to run on the SPIR-V input. If
+         * the optimizations do not finish in time (or fail), the unoptimized module is used.
+         *
+         * The optimizations are run by the external spirv-opt program, which usually finishes within a fraction of a
+         * second. The default limits the time lost if it stalls. Setting this to zero disables the optimizations.
+         */
+        unsigned spirvOptimizerTimeout = 5000;
+
+        /*
+         * The maximum number of copies of a loop body created by unrolling a loop.
+         *
+         * Setting this to a value smaller than 2 disables loop unrolling.
+         */
+        unsigned maxUnrollFactor = 8;
+    };
+
+    /*
+     * Values known at compile-time to generate a specialized variant of a kernel for.
+     *
+     * The specialized variant is emitted as additional kernel with its own meta-data next to the generic kernel. The
+     * bound arguments are removed from its parameter list, so they are neither passed nor loaded as UNIFORMs.
+     */
+    struct KernelSpecialization
+    {
+        /*
+         * The name of the kernel to specialize
+         */
+        std::string kernelName;
+        /*
+         * The name of the specialized kernel variant, defaults to "<kernelName>_specialized"
+         */
+        std::string specializedName;
+        /*
+         * The fixed values of scalar (non-pointer, non-vector) arguments, mapped by the argument index
+         */
+        std::map<unsigned, uint32_t> argumentValues;
+        /*
+         * The fixed local sizes (work-group sizes) per dimension, 0 if not fixed
+         */
+        std::array<uint32_t, 3> localSizes{{0, 0, 0}};
+        /*
+         * The fixed global sizes per dimension, 0 if not fixed. Requires the local size of the same dimension to be
+         * fixed too
+         */
+        std::array<uint32_t, 3> globalSizes{{0, 0, 0}};
     };
 
     /*
@@ -208,6 +258,10 @@ namespace vc4c
          * Whether to use CLang opt to apply optimizations like force-vectorization, etc...
          */
         bool useOpt = false;
+        /*
+         * The kernels to additionally generate specialized variants for
+         */
+        std::vector<KernelSpecialization> kernelSpecializations;
     };
 
     /*
@@ -71,6 +71,14 @@ namespace vc4c
              * The path to dump the results of the instrumentation
              */
             std::string instrumentationDump;
+            /*
+             * The number of ULP the results of the SFU reciprocal are moved away from (for positive values) or towards
+             * (for negative values) zero.
+             *
+             * The emulated SFU calculates the correctly rounded reciprocal, while the hardware result is less accurate.
+             * This allows to check the code using the reciprocal against the inaccuracies of the hardware.
+             */
+            int32_t sfuReciprocalError = 0;
 
             explicit EmulationData(){};
 
@@ -175,6 +183,32 @@ namespace vc4c
          */
         bool parseConfigurationParameter(Configuration& config, const std::string& arg);
 
+        /*
+         * Runs the resident compilation server listening on the given UNIX domain socket.
+         *
+         * The given configuration and pre-compiler options are used as base for every compilation and can be extended
+         * by the arguments of the single requests.
+         *
+         * The connections are handled concurrently by a fixed number of worker threads. Since the server process is
+         * not restarted between compilations, all process-wide caches (e.g. the pre-loaded VC4CL standard-library
+         * module, the optimization pass tables) as well as the cache of compilation results stay warm. Clients not
+         * sending or receiving any data for some time are disconnected.
+         *
+         * The server runs until it receives a SIGTERM or SIGINT or #stopCompilationServer() is called. Only a single
+         * server can run per process.
+         *
+         * @return the exit status, zero if the server was shut down cleanly
+         */
+        int runCompilationServer(
+            const std::string& socketPath, const Configuration& baseConfig, const std::string& baseOptions);
+
+        /*
+         * Stops the compilation server running in this process (if any).
+         *
+         * The compilations already running or waiting are completed before #runCompilationServer() returns.
+         */
+        void stopCompilationServer();
+
     } /* namespace tools */
 } /* namespace vc4c */
 
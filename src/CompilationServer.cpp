@@ -0,0 +1,414 @@
+/*
+ * Author: doe300
+ *
+ * See the file "LICENSE" for the full license governing this code.
+ */
+
+#include "Compiler.h"
+#include "tools.h"
+
+#include "CompilationError.h"
+#include "log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <poll.h>
+#include <queue>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace vc4c;
+using namespace vc4c::tools;
+
+/*
+ * Protocol of the compilation server:
+ *
+ * Every connection handles a single compilation request of the form:
+ *   <arguments>\n
+ *   <number of bytes of the source code>\n
+ *   <source code>
+ * The arguments are the same (space-separated) flags and options accepted by the vc4c program, e.g. "-O3 --hex
+ * -cl-fast-relaxed-math", but without any input or output file. The source code can be of any type supported as input
+ * by the vc4c program.
+ *
+ * The server answers with:
+ *   OK <number of bytes of the compiled code>\n<compiled code>
+ * or on failure:
+ *   ERROR <number of bytes of the error message>\n<error message>
+ */
+
+// the maximum number of compilation results kept
+static constexpr std::size_t MAX_CACHED_RESULTS = 64;
+// the maximum size of the source code accepted
+static constexpr std::size_t MAX_SOURCE_SIZE = 256 * 1024 * 1024;
+// the number of seconds to wait for a client to send (or receive) data before dropping the connection
+static constexpr time_t CLIENT_TIMEOUT_SECONDS = 30;
+
+// the pipe used to wake up the accepting loop on shutdown, written to by the signal handler
+static int shutdownPipe[2] = {-1, -1};
+// whether a server is currently running, since the shutdown pipe and signal handlers are process-wide
+static std::atomic_flag serverRunning = ATOMIC_FLAG_INIT;
+
+static void requestShutdown(int /* signal */)
+{
+    // only async-signal-safe functions are allowed in here
+    const auto savedErrno = errno;
+    if(shutdownPipe[1] >= 0)
+    {
+        const char c = 0;
+        (void) write(shutdownPipe[1], &c, 1);
+    }
+    errno = savedErrno;
+}
+
+/*
+ * Cache of the results of previous compilations, identified by the exact arguments and source code.
+ *
+ * Since the compiler is deterministic, repeated requests (e.g. from a build-farm rebuilding an unchanged program) can
+ * be answered without compiling again.
+ */
+class ResultCache
+{
+public:
+    bool find(const std::string& key, std::string& result)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = results.find(key);
+        if(it == results.end())
+            return false;
+        // move to the front of the least-recently-used list
+        usage.splice(usage.begin(), usage, it->second.second);
+        result = it->second.first;
+        return true;
+    }
+
+    void insert(const std::string& key, const std::string& result)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if(results.find(key) != results.end())
+            return;
+        if(results.size() >= MAX_CACHED_RESULTS)
+        {
+            results.erase(*usage.back());
+            usage.pop_back();
+        }
+        auto it = results.emplace(key, std::make_pair(result, usage.end())).first;
+        usage.push_front(&it->first);
+        it->second.second = usage.begin();
+    }
+
+private:
+    std::mutex lock;
+    std::unordered_map<std::string, std::pair<std::string, std::list<const std::string*>::iterator>> results;
+    std::list<const std::string*> usage;
+};
+
+static bool readFully(int fd, char* data, std::size_t size)
+{
+    while(size > 0)
+    {
+        ssize_t numBytes = read(fd, data, size);
+        if(numBytes < 0 && errno == EINTR)
+            continue;
+        if(numBytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            logging::warn() << "Client did not send any data for " << CLIENT_TIMEOUT_SECONDS
+                            << " seconds, dropping connection" << logging::endl;
+            return false;
+        }
+        if(numBytes <= 0)
+            return false;
+        data += numBytes;
+        size -= static_cast<std::size_t>(numBytes);
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const char* data, std::size_t size)
+{
+    while(size > 0)
+    {
+        ssize_t numBytes = write(fd, data, size);
+        if(numBytes < 0 && errno == EINTR)
+            continue;
+        if(numBytes <= 0)
+            return false;
+        data += numBytes;
+        size -= static_cast<std::size_t>(numBytes);
+    }
+    return true;
+}
+
+static bool readLine(int fd, std::string& line)
+{
+    line.clear();
+    char c;
+    while(readFully(fd, &c, 1))
+    {
+        if(c == '\n')
+            return true;
+        line.push_back(c);
+        if(line.size() > 64 * 1024)
+            return false;
+    }
+    return false;
+}
+
+static void sendResponse(int fd, bool success, const std::string& content)
+{
+    const std::string header = std::string(success ? "OK " : "ERROR ") + std::to_string(content.size()) + "\n";
+    if(!writeFully(fd, header.data(), header.size()) || !writeFully(fd, content.data(), content.size()))
+        logging::warn() << "Failed to send compilation result to client: " << strerror(errno) << logging::endl;
+}
+
+static std::string compile(const Configuration& baseConfig, const std::string& baseOptions,
+    const std::string& arguments, const std::string& source)
+{
+    Configuration config = baseConfig;
+    std::string options = baseOptions;
+    std::istringstream args(arguments);
+    std::string arg;
+    while(args >> arg)
+    {
+        if(!tools::parseConfigurationParameter(config, arg) || arg.find("-cl") == 0)
+            // pass every not understood option to the pre-compiler, as well as every OpenCL compiler option
+            options.append(arg).append(" ");
+    }
+
+    std::istringstream input(source);
+    std::ostringstream output;
+    Compiler::compile(input, output, config, options);
+    return output.str();
+}
+
+static void handleClient(
+    int fd, const Configuration& baseConfig, const std::string& baseOptions, ResultCache& cache)
+{
+    std::string arguments;
+    std::string sizeLine;
+    if(!readLine(fd, arguments) || !readLine(fd, sizeLine))
+    {
+        sendResponse(fd, false, "Malformed request header");
+        return;
+    }
+    std::size_t sourceSize = 0;
+    try
+    {
+        sourceSize = std::stoul(sizeLine);
+    }
+    catch(const std::exception&)
+    {
+        sendResponse(fd, false, "Invalid source size: " + sizeLine);
+        return;
+    }
+    if(sourceSize > MAX_SOURCE_SIZE)
+    {
+        sendResponse(fd, false, "Source code too large: " + sizeLine);
+        return;
+    }
+    std::string source(sourceSize, '\0');
+    if(!readFully(fd, &source[0], sourceSize))
+    {
+        sendResponse(fd, false, "Failed to read source code");
+        return;
+    }
+
+    const std::string key = arguments + '\n' + source;
+    std::string result;
+    if(cache.find(key, result))
+    {
+        logging::info() << "Answering compilation request from cache" << logging::endl;
+        sendResponse(fd, true, result);
+        return;
+    }
+
+    try
+    {
+        result = compile(baseConfig, baseOptions, arguments, source);
+        cache.insert(key, result);
+        sendResponse(fd, true, result);
+    }
+    catch(const std::exception& e)
+    {
+        logging::error() << "Compilation request failed: " << e.what() << logging::endl;
+        sendResponse(fd, false, e.what());
+    }
+}
+
+static void setClientTimeout(int client)
+{
+    timeval timeout{};
+    timeout.tv_sec = CLIENT_TIMEOUT_SECONDS;
+    if(setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0)
+        logging::warn() << "Failed to set client socket timeout: " << strerror(errno) << logging::endl;
+}
+
+void tools::stopCompilationServer()
+{
+    requestShutdown(0);
+}
+
+int tools::runCompilationServer(
+    const std::string& socketPath, const Configuration& baseConfig, const std::string& baseOptions)
+{
+    if(serverRunning.test_and_set())
+        throw CompilationError(CompilationStep::GENERAL, "Compilation server is already running in this process");
+    // resets the running flag on every exit from this function
+    std::unique_ptr<std::atomic_flag, void (*)(std::atomic_flag*)> runningGuard(
+        &serverRunning, [](std::atomic_flag* flag) { flag->clear(); });
+
+    sockaddr_un address{};
+    if(socketPath.size() >= sizeof(address.sun_path))
+        throw CompilationError(CompilationStep::GENERAL, "Socket path is too long", socketPath);
+    address.sun_family = AF_UNIX;
+    std::copy(socketPath.begin(), socketPath.end(), address.sun_path);
+
+    if(pipe2(shutdownPipe, O_CLOEXEC | O_NONBLOCK) != 0)
+        throw CompilationError(CompilationStep::GENERAL, "Failed to create shutdown pipe", strerror(errno));
+    int serverSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(serverSocket < 0)
+    {
+        auto error = errno;
+        close(shutdownPipe[0]);
+        close(shutdownPipe[1]);
+        shutdownPipe[0] = shutdownPipe[1] = -1;
+        throw CompilationError(CompilationStep::GENERAL, "Failed to create socket", strerror(error));
+    }
+    // remove stale socket of a previous run
+    unlink(socketPath.data());
+    if(bind(serverSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(serverSocket, SOMAXCONN) != 0)
+    {
+        auto error = errno;
+        close(serverSocket);
+        close(shutdownPipe[0]);
+        close(shutdownPipe[1]);
+        shutdownPipe[0] = shutdownPipe[1] = -1;
+        throw CompilationError(CompilationStep::GENERAL, "Failed to listen on socket", strerror(error));
+    }
+    // clients disconnecting before receiving the result should not terminate the server
+    signal(SIGPIPE, SIG_IGN);
+    // shut down cleanly (finishing the running compilations and removing the socket) on termination requests
+    struct sigaction shutdownAction
+    {
+    };
+    shutdownAction.sa_handler = requestShutdown;
+    sigemptyset(&shutdownAction.sa_mask);
+    struct sigaction previousTermAction
+    {
+    };
+    struct sigaction previousIntAction
+    {
+    };
+    sigaction(SIGTERM, &shutdownAction, &previousTermAction);
+    sigaction(SIGINT, &shutdownAction, &previousIntAction);
+
+    ResultCache cache;
+    std::mutex queueLock;
+    std::condition_variable queueCondition;
+    std::queue<int> pendingClients;
+
+    // every compilation itself already uses multiple threads, so don't run too many compilations in parallel
+    const unsigned numWorkers = std::max(1u, std::thread::hardware_concurrency() / 2);
+    std::vector<std::thread> workers;
+    workers.reserve(numWorkers);
+    for(unsigned i = 0; i < numWorkers; ++i)
+    {
+        workers.emplace_back([&]() {
+            while(true)
+            {
+                int client = -1;
+                {
+                    std::unique_lock<std::mutex> guard(queueLock);
+                    queueCondition.wait(guard, [&]() -> bool { return !pendingClients.empty(); });
+                    client = pendingClients.front();
+                    pendingClients.pop();
+                }
+                if(client < 0)
+                    // shutdown
+                    return;
+                handleClient(client, baseConfig, baseOptions, cache);
+                close(client);
+            }
+        });
+    }
+
+    logging::info() << "Compilation server listening on '" << socketPath << "' with " << numWorkers << " workers"
+                    << logging::endl;
+    std::cout << "Compilation server listening on: " << socketPath << std::endl;
+
+    int status = 0;
+    while(true)
+    {
+        std::array<pollfd, 2> fds{};
+        fds[0].fd = serverSocket;
+        fds[0].events = POLLIN;
+        fds[1].fd = shutdownPipe[0];
+        fds[1].events = POLLIN;
+        if(poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            logging::error() << "Failed to wait for connections: " << strerror(errno) << logging::endl;
+            status = 1;
+            break;
+        }
+        if(fds[1].revents != 0)
+        {
+            logging::info() << "Shutting down compilation server..." << logging::endl;
+            break;
+        }
+        if((fds[0].revents & POLLIN) == 0)
+            continue;
+        int client = accept4(serverSocket, nullptr, nullptr, SOCK_CLOEXEC);
+        if(client < 0)
+        {
+            if(errno == EINTR || errno == ECONNABORTED || errno == EAGAIN || errno == EWOULDBLOCK)
+                continue;
+            logging::error() << "Failed to accept connection: " << strerror(errno) << logging::endl;
+            status = 1;
+            break;
+        }
+        // don't let a stale client block a worker forever
+        setClientTimeout(client);
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            pendingClients.push(client);
+        }
+        queueCondition.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        for(unsigned i = 0; i < numWorkers; ++i)
+            pendingClients.push(-1);
+    }
+    queueCondition.notify_all();
+    // the already accepted connections are still handled before the workers terminate
+    for(auto& worker : workers)
+        worker.join();
+    close(serverSocket);
+    unlink(socketPath.data());
+    sigaction(SIGTERM, &previousTermAction, nullptr);
+    sigaction(SIGINT, &previousIntAction, nullptr);
+    close(shutdownPipe[0]);
+    close(shutdownPipe[1]);
+    shutdownPipe[0] = shutdownPipe[1] = -1;
+    return status;
+}
@@ -15,6 +15,7 @@
 #include "logger.h"
 #include "normalization/Normalizer.h"
 #include "optimization/Optimizer.h"
+#include "precompilation/ClangLibrary.h"
 #include "spirv/SPIRVParser.h"
 #include "llvm/BitcodeReader.h"
 
@@ -46,7 +47,8 @@ Compiler::Compiler(std::istream& stream, std::ostream& output) : input(stream),
         throw CompilationError(CompilationStep::GENERAL, "Invalid input");
 }
 
-static std::unique_ptr<Parser> getParser(std::istream& stream)
+static std::unique_ptr<Parser> getParser(
+    std::istream& stream, const Configuration& config, const Optional<std::string>& inputFile)
 {
     // determine which parser to use in which settings
     /*
@@ -61,13 +63,13 @@ static std::unique_ptr<Parser> getParser(std::istream& stream)
     case SourceType::LLVM_IR_TEXT:
         logging::info() << "Using LLVM-IR frontend..." << logging::endl;
 #ifdef USE_LLVM_LIBRARY
-        return std::unique_ptr<Parser>(new llvm2qasm::BitcodeReader(stream, SourceType::LLVM_IR_TEXT));
+        return std::unique_ptr<Parser>(new llvm2qasm::BitcodeReader(stream, SourceType::LLVM_IR_TEXT, inputFile));
 #else
         throw CompilationError(CompilationStep::GENERAL, "No LLVM IR text front-end available!");
 #endif
     case SourceType::LLVM_IR_BIN:
 #ifdef USE_LLVM_LIBRARY
-        return std::unique_ptr<Parser>(new llvm2qasm::BitcodeReader(stream, SourceType::LLVM_IR_BIN));
+        return std::unique_ptr<Parser>(new llvm2qasm::BitcodeReader(stream, SourceType::LLVM_IR_BIN, inputFile));
 #else
         throw CompilationError(
             CompilationStep::GENERAL, "LLVM-IR binary needs to be first converted to SPIR-V binary or LLVM-IR text!");
@@ -76,7 +78,7 @@ static std::unique_ptr<Parser> getParser(std::istream& stream)
         throw CompilationError(CompilationStep::GENERAL, "SPIR-V text needs to be first converted to SPIR-V binary!");
     case SourceType::SPIRV_BIN:
         logging::info() << "Using SPIR-V frontend..." << logging::endl;
-        return std::unique_ptr<Parser>(new spirv2qasm::SPIRVParser(stream, false));
+        return std::unique_ptr<Parser>(new spirv2qasm::SPIRVParser(stream, false, config));
     case SourceType::OPENCL_C:
         throw CompilationError(CompilationStep::GENERAL, "OpenCL code needs to be first compiled with CLang!");
     case SourceType::QPUASM_BIN:
@@ -126,13 +128,12 @@ static void toMachineCode(qpu_asm::CodeGenerator& codeGen, Method& kernel)
 #endif
 }
 
-std::size_t Compiler::convert()
+static std::size_t compileModule(Parser& parser, std::ostream& output, const Configuration& config)
 {
     Module module(config);
 
-    std::unique_ptr<Parser> parser = getParser(input);
     PROFILE_START(Parser);
-    parser->parse(module);
+    parser.parse(module);
     PROFILE_END(Parser);
 
     normalization::Normalizer norm(config);
@@ -164,6 +165,12 @@ std::size_t Compiler::convert()
     return bytesWritten;
 }
 
+std::size_t Compiler::convert()
+{
+    std::unique_ptr<Parser> parser = getParser(input, config, inputFile);
+    return compileModule(*parser, output, config);
+}
+
 Configuration& Compiler::getConfiguration()
 {
     return config;
@@ -179,19 +186,45 @@ std::size_t Compiler::compile(std::istream& input, std::ostream& output, const C
 {
     try
     {
+#ifdef USE_CLANG_LIBRARY
+        if(precompilation::isInProcessCompilationAvailable(config) &&
+            Precompiler::getSourceType(input) == SourceType::OPENCL_C)
+        {
+            // compile and pass on the LLVM module without starting any process or serializing the module in between
+            auto llvmModule = precompilation::compileOpenCLInProcess(
+                inputFile ? precompilation::OpenCLSource(inputFile.value()) : precompilation::OpenCLSource(input),
+                options, config.useOpt);
+            llvm2qasm::BitcodeReader parser(std::move(llvmModule.context), std::move(llvmModule.module));
+            std::size_t result = compileModule(parser, output, config);
+
+            logging::debug() << "Compilation complete: " << result << " bytes written" << logging::endl;
+            return result;
+        }
+#endif
         // pre-compilation
         TemporaryFile tmpFile;
         std::unique_ptr<std::istream> in;
+        Optional<std::string> precompiledFile;
         Precompiler::precompile(input, in, config, options, inputFile, tmpFile.fileName);
 
         if(in == nullptr ||
-            (dynamic_cast<std::istringstream*>(in.get()) != nullptr &&
-                dynamic_cast<std::istringstream*>(in.get())->str().empty()))
+            (dynamic_cast<std::stringstream*>(in.get()) != nullptr &&
+                in->peek() == std::char_traits<char>::eof()))
+        {
             // replace only when pre-compiled (and not just linked output to input, e.g. if source-type is output-type)
             tmpFile.openInputStream(in);
+            // allows the front-end to read the file directly instead of copying the stream
+            precompiledFile = tmpFile.fileName;
+        }
+        else if(dynamic_cast<std::stringstream*>(in.get()) == nullptr)
+            // the input is passed through unmodified by re-opening the input file or by sharing the buffer of the input
+            // stream (see Precompiler#run), so the front-end can read the input file (if any) directly
+            precompiledFile = inputFile;
+        // otherwise, the pre-compiled result is only available in the stream and not in any file
 
         // compilation
         Compiler conv(*in.get(), output);
+        conv.inputFile = precompiledFile;
 
         conv.getConfiguration() = config;
         std::size_t result = conv.convert();
@@ -60,11 +60,16 @@ namespace vc4c
          * The compilation-time preferred work-group size, specified by the work_group_size_hint attribute
          */
         std::array<uint32_t, 3> workGroupSizeHints;
+        /*
+         * The compilation-time number of work-groups per dimension (0 if unknown), only set for specialized kernels
+         */
+        std::array<uint32_t, 3> numGroups;
 
         KernelMetaData()
         {
             workGroupSizes.fill(0);
             workGroupSizeHints.fill(0);
+            numGroups.fill(0);
         }
 
         /*
@@ -8,8 +8,23 @@
 
 #include "intermediate/IntermediateInstruction.h"
 
+#include <mutex>
+
 using namespace vc4c;
 
+// Locals residing in memory (esp. global data) are shared between methods, which can be processed in parallel (e.g. by
+// the front-ends or the normalization), so all accesses to their users need to be synchronized.
+// This is a recursive mutex, since the consumer passed to #forUsers may access the users of other Locals in memory
+static std::recursive_mutex memoryUsersLock;
+
+static std::unique_lock<std::recursive_mutex> lockUsers(const Local& local)
+{
+    std::unique_lock<std::recursive_mutex> guard(memoryUsersLock, std::defer_lock);
+    if(local.residesInMemory())
+        guard.lock();
+    return guard;
+}
+
 Local::Local(const DataType& type, const std::string& name) : type(type), name(name), reference(nullptr, ANY_ELEMENT) {}
 
 bool Local::operator<(const Local& other) const
@@ -38,6 +53,7 @@ const OrderedMap<const LocalUser*, LocalUse>& Local::getUsers() const
 
 FastSet<const LocalUser*> Local::getUsers(const LocalUse::Type type) const
 {
+    auto guard = lockUsers(*this);
     FastSet<const LocalUser*> users;
     for(const auto& pair : this->users)
     {
@@ -50,6 +66,7 @@ FastSet<const LocalUser*> Local::getUsers(const LocalUse::Type type) const
 
 void Local::forUsers(const LocalUse::Type type, const std::function<void(const LocalUser*)>& consumer) const
 {
+    auto guard = lockUsers(*this);
     for(const auto& pair : this->users)
     {
         if((has_flag(type, LocalUse::Type::READER) && pair.second.readsLocal()) ||
@@ -60,6 +77,7 @@ void Local::forUsers(const LocalUse::Type type, const std::function<void(const L
 
 void Local::removeUser(const LocalUser& user, const LocalUse::Type type)
 {
+    auto guard = lockUsers(*this);
     if(type == LocalUse::Type::BOTH)
     {
         // if we remove the user completely, ignore if it was a user
@@ -80,6 +98,7 @@ void Local::removeUser(const LocalUser& user, const LocalUse::Type type)
 
 void Local::addUser(const LocalUser& user, const LocalUse::Type type)
 {
+    auto guard = lockUsers(*this);
     if(users.find(&user) == users.end())
         users.emplace(&user, LocalUse());
     LocalUse& use = users.at(&user);
@@ -91,6 +110,7 @@ void Local::addUser(const LocalUser& user, const LocalUse::Type type)
 
 const LocalUser* Local::getSingleWriter() const
 {
+    auto guard = lockUsers(*this);
     const LocalUser* writer = nullptr;
     for(const auto& pair : this->users)
     {
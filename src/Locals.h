@@ -95,6 +95,9 @@ namespace vc4c
 
         /*
          * Returns all the LocalUsers accessing this object
+         *
+         * NOTE: The access to the returned container is not synchronized. For Locals residing in memory (which can be
+         * accessed by multiple methods processed in parallel), use one of the other accessors below instead.
          */
         const OrderedMap<const LocalUser*, LocalUse>& getUsers() const;
         /*
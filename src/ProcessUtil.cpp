@@ -10,18 +10,24 @@
 #include "Profiler.h"
 #include "log.h"
 
+#include <algorithm>
 #include <array>
-#include <chrono>
+#include <cerrno>
+#include <csignal>
 #include <cstdio>
 #include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <spawn.h>
 #include <sstream>
-#include <sys/select.h>
-#include <sys/time.h>
 #include <sys/wait.h>
 #include <thread>
 #include <unistd.h>
 #include <vector>
 
+extern char** environ;
+
 using namespace vc4c;
 
 static constexpr int STD_IN = 0;
@@ -31,316 +37,358 @@ static constexpr int STD_ERR = 2;
 static constexpr int READ = 0;
 static constexpr int WRITE = 1;
 
-static constexpr int BUFFER_SIZE = 1024;
+// large enough to transfer the whole content of the pipe buffer (64KB on Linux) at once
+static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
 
-static void initPipe(std::array<int, 2>& fds)
+static void initPipe(std::array<int, 2>& fds, int parentEnd)
 {
     if(pipe(fds.data()) != 0)
         throw CompilationError(CompilationStep::GENERAL, "Error creating pipe", strerror(errno));
+    // the pipes are mapped to the standard streams of the child, so the original descriptors are not inherited
+    if(fcntl(fds[READ], F_SETFD, FD_CLOEXEC) == -1 || fcntl(fds[WRITE], F_SETFD, FD_CLOEXEC) == -1)
+        throw CompilationError(CompilationStep::GENERAL, "Error configuring pipe", strerror(errno));
+    // the parent does not block on any single pipe, but waits for all of them to become ready
+    if(fcntl(fds[parentEnd], F_SETFL, fcntl(fds[parentEnd], F_GETFL) | O_NONBLOCK) == -1)
+        throw CompilationError(CompilationStep::GENERAL, "Error configuring pipe", strerror(errno));
 }
 
-static void closePipe(int fd)
+static void closePipe(int& fd)
 {
+    if(fd < 0)
+        return;
     if(close(fd) != 0)
         throw CompilationError(CompilationStep::GENERAL, "Error closing pipe", strerror(errno));
+    fd = -1;
 }
 
-static void mapPipe(int pipe, int fd)
+/*
+ * The pipes for the standard streams of the child process.
+ *
+ * All pipe ends still open are closed on destruction, so no file descriptors are leaked if an error is thrown
+ */
+struct ChildPipes
 {
-    if(dup2(pipe, fd) == -1)
-        throw CompilationError(CompilationStep::GENERAL, "Error duplicating pipe", strerror(errno));
-}
+    std::array<std::array<int, 2>, 3> fds;
 
-static std::vector<std::string> splitString(const std::string& input, const char delimiter)
-{
-    std::vector<std::string> result;
-    std::stringstream in(input);
-    std::string token;
-    while(std::getline(in, token, delimiter))
+    ChildPipes()
     {
-        result.push_back(token);
+        for(auto& pipe : fds)
+            pipe.fill(-1);
     }
-    return result;
-}
 
-static void runChild(
-    const std::string& command, std::array<std::array<int, 2>, 3>& pipes, bool hasStdIn, bool hasStdOut, bool hasStdErr)
-{
-    // map pipes into stdin/stdout/stderr
-    // close pipes not used by child
-    if(hasStdIn)
+    ChildPipes(const ChildPipes&) = delete;
+    ChildPipes& operator=(const ChildPipes&) = delete;
+
+    ~ChildPipes()
     {
-        mapPipe(pipes[STD_IN][READ], STDIN_FILENO);
-        closePipe(pipes[STD_IN][READ]);
-        closePipe(pipes[STD_IN][WRITE]);
+        for(auto& pipe : fds)
+        {
+            for(int fd : pipe)
+            {
+                // errors are ignored, since this might run while an exception is thrown
+                if(fd >= 0)
+                    close(fd);
+            }
+        }
     }
-    if(hasStdOut)
+
+    std::array<int, 2>& operator[](std::size_t index)
     {
-        mapPipe(pipes[STD_OUT][WRITE], STDOUT_FILENO);
-        closePipe(pipes[STD_OUT][READ]);
-        closePipe(pipes[STD_OUT][WRITE]);
+        return fds[index];
     }
-    if(hasStdErr)
+};
+
+/*
+ * Destroys the file actions for spawning the child process, also if an error is thrown while setting them up
+ */
+struct SpawnFileActions
+{
+    posix_spawn_file_actions_t actions;
+
+    SpawnFileActions()
     {
-        mapPipe(pipes[STD_ERR][WRITE], STDERR_FILENO);
-        closePipe(pipes[STD_ERR][READ]);
-        closePipe(pipes[STD_ERR][WRITE]);
+        posix_spawn_file_actions_init(&actions);
     }
 
-    // split command
-    std::vector<std::string> parts = splitString(command, ' ');
-    const std::string file = parts.at(0);
-    std::array<char*, 128> args{};
-    args.fill(nullptr);
-    // man(3) exec: "The first argument, by convention, should point to the filename associated with the file being
-    // executed"
-    for(std::size_t i = 0; i < parts.size(); ++i)
+    SpawnFileActions(const SpawnFileActions&) = delete;
+    SpawnFileActions& operator=(const SpawnFileActions&) = delete;
+
+    ~SpawnFileActions()
     {
-        args.at(i) = const_cast<char*>(parts[i].data());
+        posix_spawn_file_actions_destroy(&actions);
     }
+};
 
-    execvp(file.data(), args.data());
-}
-
-static bool isChildFinished(pid_t pid, int* exitStatus, bool wait = false)
+static std::vector<std::string> splitString(const std::string& input, const char delimiter)
 {
-    int status = 0;
-    int result = waitpid(pid, &status, WUNTRACED | (wait ? 0 : WNOHANG));
-    if(result == -1)
+    std::vector<std::string> result;
+    std::stringstream in(input);
+    std::string token;
+    while(std::getline(in, token, delimiter))
     {
-        throw CompilationError(CompilationStep::GENERAL, "Error retrieving child process information", strerror(errno));
+        // skip empty tokens from consecutive delimiters
+        if(!token.empty())
+            result.push_back(token);
     }
-    if(result == 0)
-        // child still running, no changes to status, returned because of WNOHANG
-        return false;
+    return result;
+}
+
+static int toExitStatus(int status)
+{
     // check whether child terminated "normally" having an exit-code or was terminated by a signal
     if(WIFEXITED(status))
-    {
-        *exitStatus = WEXITSTATUS(status);
-        return true;
-    }
+        return WEXITSTATUS(status);
     if(WIFSIGNALED(status))
+        return WTERMSIG(status);
+    throw CompilationError(
+        CompilationStep::GENERAL, "Unhandled case in retrieving child process information", std::to_string(status));
+}
+
+static int waitForChild(pid_t pid)
+{
+    int status = 0;
+    while(waitpid(pid, &status, 0) == -1)
     {
-        *exitStatus = WTERMSIG(status);
-        return true;
+        if(errno != EINTR)
+            throw CompilationError(
+                CompilationStep::GENERAL, "Error retrieving child process information", strerror(errno));
     }
-    throw CompilationError(
-        CompilationStep::GENERAL, "Unhandled case in retrieving child process information", std::to_string(result));
+    return toExitStatus(status);
 }
 
-static int runReadOnlySubprocess(const std::string& command, std::ostream* output)
+/*
+ * Waits for the child to terminate until the deadline has passed.
+ *
+ * Returns whether the child terminated, in which case its exit status is written into the given status
+ */
+static bool waitForChild(pid_t pid, std::chrono::steady_clock::time_point deadline, int& exitStatus)
 {
-    auto fd = popen(command.data(), "r");
-    if(fd == nullptr)
-        throw CompilationError(CompilationStep::GENERAL, "Failed to run command", strerror(errno));
-    if(output != nullptr)
+    int status = 0;
+    while(true)
     {
-        std::array<char, 512> buffer;
-        std::size_t numRead = 0;
-        while((numRead = fread(buffer.data(), sizeof(char), buffer.size(), fd)) > 0)
-        {
-            output->write(buffer.data(), numRead);
-        }
-        if(ferror(fd))
+        pid_t result = waitpid(pid, &status, WNOHANG);
+        if(result == pid)
         {
-            auto err = ferror(fd);
-            pclose(fd);
-            throw CompilationError(CompilationStep::GENERAL, "Error reading from sub-process", strerror(err));
+            exitStatus = toExitStatus(status);
+            return true;
         }
+        if(result == -1 && errno != EINTR)
+            throw CompilationError(
+                CompilationStep::GENERAL, "Error retrieving child process information", strerror(errno));
+        if(std::chrono::steady_clock::now() >= deadline)
+            return false;
+        // the child closed its streams, so it should terminate shortly
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
-    return pclose(fd);
 }
 
-static int runWriteOnlySubprocess(const std::string& command, std::istream* input)
+/*
+ * Kills the child which did not finish in time and throws an error.
+ *
+ * The streams are closed (by the caller) after the child is terminated to not let it block on them
+ */
+[[noreturn]] static void abortChild(pid_t pid, std::chrono::milliseconds timeout)
 {
-    auto fd = popen(command.data(), "w");
-    if(fd == nullptr)
-        throw CompilationError(CompilationStep::GENERAL, "Failed to run command", strerror(errno));
-    if(input != nullptr)
+    kill(pid, SIGKILL);
+    waitForChild(pid);
+    throw CompilationError(CompilationStep::GENERAL, "Child process did not finish in time, aborted it",
+        std::to_string(timeout.count()) + "ms");
+}
+
+/*
+ * Blocks the SIGPIPE signal for the current thread, so writing into the standard input of an already terminated child
+ * process returns EPIPE instead of killing this process
+ */
+struct SigPipeBlocker
+{
+    sigset_t previousMask;
+    sigset_t pipeMask;
+
+    SigPipeBlocker()
     {
-        std::array<char, 512> buffer;
-        while(input->read(buffer.data(), buffer.size()))
-        {
-            fwrite(buffer.data(), sizeof(char), input->gcount(), fd);
-        }
-        if(ferror(fd))
+        sigemptyset(&pipeMask);
+        sigaddset(&pipeMask, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipeMask, &previousMask);
+    }
+
+    ~SigPipeBlocker()
+    {
+        // consume a SIGPIPE raised by us, so it is not delivered after unblocking
+        const timespec noWait{0, 0};
+        while(sigtimedwait(&pipeMask, nullptr, &noWait) > 0)
         {
-            auto err = ferror(fd);
-            pclose(fd);
-            throw CompilationError(CompilationStep::GENERAL, "Error writing into sub-process", strerror(err));
         }
+        pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
     }
-    return pclose(fd);
-}
+};
 
-int vc4c::runProcess(const std::string& command, std::istream* stdin, std::ostream* stdout, std::ostream* stderr)
+/*
+ * Feeds the next part of the input into the non-blocking pipe.
+ *
+ * Returns whether there is more data to write
+ */
+static bool writeInput(int fd, std::istream& in, std::vector<char>& buffer, std::size_t& offset, std::size_t& size)
 {
-    /*
-     * Simple version, only ONE of stdin, stdout or stderr is set.
-     * Now we can simplify by using popen
-     */
-    if(static_cast<unsigned>(stdin != nullptr) + static_cast<unsigned>(stdout != nullptr) +
-            static_cast<unsigned>(stderr != nullptr) <=
-        1)
+    while(true)
     {
-        if(stderr != nullptr)
+        if(offset == size)
         {
-            // redirect stderr to stdout, so we can read it
-            // see
-            // https://stackoverflow.com/questions/876239/how-can-i-redirect-and-append-both-stdout-and-stderr-to-a-file-with-bash
-            return runReadOnlySubprocess(command + " 2>&1", stderr);
+            // buffer is completely written, read next chunk
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            size = static_cast<std::size_t>(in.gcount());
+            offset = 0;
+            if(size == 0)
+                return false;
         }
-        else if(stdout != nullptr)
+        ssize_t numBytes = write(fd, buffer.data() + offset, size - offset);
+        if(numBytes < 0)
         {
-            return runReadOnlySubprocess(command, stderr);
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+                // pipe is full, wait for the child to consume some data
+                return true;
+            if(errno == EINTR)
+                continue;
+            if(errno == EPIPE)
+            {
+                // child closed its input, e.g. because it does not read all of it
+                logging::debug() << "Child process closed its standard input early" << logging::endl;
+                return false;
+            }
+            throw CompilationError(CompilationStep::GENERAL, "Error writing into child process", strerror(errno));
         }
-        return runWriteOnlySubprocess(command, stdin);
+        offset += static_cast<std::size_t>(numBytes);
     }
+}
 
-    /*
-     * For the general case:
-     *
-     * NOTE: not setting a stream to put the stdout of the child-process in doesn't currently work (hangs the
-     * child-process)  so we always set an output-stream, even if we write to file. But since the stream will have no
-     * content (is not written to), it has no impact
-     */
-
-    /*
-     * See:
-     * https://jineshkj.wordpress.com/2006/12/22/how-to-capture-stdin-stdout-and-stderr-of-child-program/
-     * https://stackoverflow.com/questions/6171552/popen-simultaneous-read-and-write
-     * https://www.linuxquestions.org/questions/programming-9/popen-read-and-write-both-how-201083/
-     * https://stackoverflow.com/questions/29554036/waiting-for-popen-subprocess-to-terminate-before-reading?rq=1
-     */
-
-    std::array<std::array<int, 2>, 3> pipes{};
-
-    if(stdin != nullptr)
-        initPipe(pipes[STD_IN]);
-    if(true)
-        initPipe(pipes[STD_OUT]);
-    if(stderr != nullptr)
-        initPipe(pipes[STD_ERR]);
-
-    pid_t pid = fork();
-    if(pid == 0) // child
+/*
+ * Drains the currently available output of the non-blocking pipe.
+ *
+ * Returns whether the stream is still open
+ */
+static bool readOutput(int fd, std::ostream* out, std::vector<char>& buffer)
+{
+    while(true)
     {
-        runChild(command, pipes, stdin != nullptr, true, stderr != nullptr);
-        /*
-         * Nothing below this line should be executed by child process. If so, it means that the exec function wasn't
-         * successful, so lets exit:
-         */
-        throw CompilationError(CompilationStep::GENERAL, "Error executing the child process", strerror(errno));
+        ssize_t numBytes = read(fd, buffer.data(), buffer.size());
+        if(numBytes == 0)
+            // EOF
+            return false;
+        if(numBytes < 0)
+        {
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            if(errno == EINTR)
+                continue;
+            throw CompilationError(CompilationStep::GENERAL, "Error reading from child process", strerror(errno));
+        }
+        if(out != nullptr)
+            out->write(buffer.data(), numBytes);
     }
+}
 
-    std::array<char, BUFFER_SIZE> buffer{};
-    ssize_t numBytes;
-    int exitStatus = 0;
-    bool childFinished = false;
-
-    PROFILE_START(WriteToChildProcess);
-    // write to stdin
-    if(stdin != nullptr)
+int vc4c::runProcess(const std::string& command, std::istream* stdin, std::ostream* stdout, std::ostream* stderr,
+    std::chrono::milliseconds timeout)
+{
+    PROFILE_START(RunChildProcess);
+    // split command, no shell is involved, so quoting, redirections, etc. are not supported
+    std::vector<std::string> parts = splitString(command, ' ');
+    if(parts.empty())
+        throw CompilationError(CompilationStep::GENERAL, "Cannot run empty command");
+    std::vector<char*> args;
+    args.reserve(parts.size() + 1);
+    // man(3) exec: "The first argument, by convention, should point to the filename associated with the file being
+    // executed"
+    for(auto& part : parts)
+        args.push_back(&part[0]);
+    args.push_back(nullptr);
+
+    ChildPipes pipes;
+    SpawnFileActions fileActions;
+    // map pipes into stdin/stdout/stderr, streams not given are redirected to/from /dev/null
+    const std::array<bool, 3> hasStream = {stdin != nullptr, stdout != nullptr, stderr != nullptr};
+    for(int fd = STD_IN; fd <= STD_ERR; ++fd)
     {
-        std::istream& in = *stdin;
-        while(!(childFinished = childFinished || isChildFinished(pid, &exitStatus)))
+        const int childEnd = fd == STD_IN ? READ : WRITE;
+        if(hasStream[static_cast<std::size_t>(fd)])
         {
-            in.read(buffer.data(), buffer.size());
-            numBytes = in.gcount();
-            write(pipes[STD_IN][WRITE], buffer.data(), in.gcount());
-            if(numBytes != buffer.size())
-                break;
+            initPipe(pipes[static_cast<std::size_t>(fd)], 1 - childEnd);
+            posix_spawn_file_actions_adddup2(&fileActions.actions, pipes[static_cast<std::size_t>(fd)][childEnd], fd);
         }
-        closePipe(pipes[STD_IN][READ]);
-        closePipe(pipes[STD_IN][WRITE]);
+        else
+            posix_spawn_file_actions_addopen(
+                &fileActions.actions, fd, "/dev/null", fd == STD_IN ? O_RDONLY : O_WRONLY, 0);
     }
-    PROFILE_END(WriteToChildProcess);
 
-    bool stdOutFinished = true;
-    bool stdErrFinished = stderr != nullptr;
+    // posix_spawn uses vfork/clone(CLONE_VM) where available, which avoids copying the page tables of this process
+    pid_t pid = 0;
+    int spawnStatus = posix_spawnp(&pid, parts.front().data(), &fileActions.actions, nullptr, args.data(), environ);
+
+    // close the pipe ends used by the child
+    closePipe(pipes[STD_IN][READ]);
+    closePipe(pipes[STD_OUT][WRITE]);
+    closePipe(pipes[STD_ERR][WRITE]);
 
-    int highestFD = std::max(pipes[STD_OUT][READ], pipes[STD_ERR][READ]);
-    fd_set readDescriptors{};
-    timeval timeout{};
+    if(spawnStatus != 0)
+        throw CompilationError(CompilationStep::GENERAL, "Error executing the child process", strerror(spawnStatus));
+
+    std::vector<char> inBuffer(stdin != nullptr ? BUFFER_SIZE : 0);
+    std::size_t inOffset = 0;
+    std::size_t inSize = 0;
+    std::vector<char> outBuffer(BUFFER_SIZE);
+    SigPipeBlocker sigPipeBlocker;
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
 
     /*
-     * While the child program has not yet finished and the output-streams are not read to the end (EOF, thus the child
-     * process has also finished), check which output stream has data and read it
+     * Feed the standard input while draining the standard output and error streams at the same time, since the child
+     * might block on writing its output until we read it, before it reads any more input.
      */
-    PROFILE_START(ReadFromChildProcess);
-    while(!(stdOutFinished && stdErrFinished) || !(childFinished = childFinished || isChildFinished(pid, &exitStatus)))
+    while(pipes[STD_IN][WRITE] >= 0 || pipes[STD_OUT][READ] >= 0 || pipes[STD_ERR][READ] >= 0)
     {
-        FD_ZERO(&readDescriptors);
-        if(true)
-            FD_SET(pipes[STD_OUT][READ], &readDescriptors);
-        if(stderr != nullptr)
-            FD_SET(pipes[STD_ERR][READ], &readDescriptors);
-
-        /*
-         * We need to re-initialize the timeout every iteration, because the select man-page states:
-         * On Linux, select() modifies timeout to reflect the amount of time not slept; most other implementations do
-         * not do this. (POSIX.1-2001 permits either behavior.) This causes problems both when Linux code which reads
-         * timeout is ported to other operating systems, and when code is ported to Linux that reuses a struct timeval
-         * for multiple select()s in a loop without reinitializing it. Consider timeout to be undefined after select()
-         * returns.
-         */
-        timeout.tv_sec = 0;
-        // wait 1ms
-        timeout.tv_usec = 1000;
-
-        /*
-         * "Those listed in readfds will be watched to see if characters become available for reading
-         * [...] On exit, the sets are modified in place to indicate which file descriptors actually changed status."
-         *
-         * "nfds is the highest-numbered file descriptor in any of the three sets, plus 1.
-         *
-         * "On success, select() and pselect() return the number of file descriptors contained in the three returned
-         * descriptor sets
-         * [...] which may be zero if the timeout expires before anything interesting happens"
-         */
-        int selectStatus = select(highestFD + 1, &readDescriptors, nullptr, nullptr, &timeout);
-        if(selectStatus == -1)
-            throw CompilationError(
-                CompilationStep::GENERAL, "Error waiting on child's output streams", strerror(errno));
-        else if(selectStatus != 0)
+        std::array<pollfd, 3> fds{};
+        fds[STD_IN] = pollfd{pipes[STD_IN][WRITE], POLLOUT, 0};
+        fds[STD_OUT] = pollfd{pipes[STD_OUT][READ], POLLIN, 0};
+        fds[STD_ERR] = pollfd{pipes[STD_ERR][READ], POLLIN, 0};
+
+        int pollTimeout = -1;
+        if(timeout.count() > 0)
         {
-            // something happened
-            if(FD_ISSET(pipes[STD_OUT][READ], &readDescriptors))
-            {
-                numBytes = read(pipes[STD_OUT][READ], buffer.data(), buffer.size());
-                if(stdout != nullptr)
-                    stdout->write(buffer.data(), numBytes);
-                if(numBytes == 0)
-                    // EOF
-                    stdOutFinished = true;
-            }
-            if(stderr != nullptr && FD_ISSET(pipes[STD_ERR][READ], &readDescriptors))
-            {
-                numBytes = read(pipes[STD_ERR][READ], buffer.data(), buffer.size());
-                stderr->write(buffer.data(), numBytes);
-                if(numBytes == 0)
-                    // EOF
-                    stdErrFinished = true;
-            }
+            // check on every iteration, since a child continuously writing output never lets the poll time out
+            const auto now = std::chrono::steady_clock::now();
+            if(now >= deadline)
+                abortChild(pid, timeout);
+            // round up to not spin on sub-millisecond remaining times
+            pollTimeout = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now + std::chrono::microseconds(999))
+                    .count());
         }
-    }
-    PROFILE_END(ReadFromChildProcess);
-
-    if(true)
-    {
-        closePipe(pipes[STD_OUT][READ]);
-        closePipe(pipes[STD_OUT][WRITE]);
-    }
 
-    if(stderr != nullptr)
-    {
-        closePipe(pipes[STD_ERR][READ]);
-        closePipe(pipes[STD_ERR][WRITE]);
+        // negative file descriptors are ignored by poll
+        int numReady = poll(fds.data(), fds.size(), pollTimeout);
+        if(numReady == -1)
+        {
+            if(errno == EINTR)
+                continue;
+            throw CompilationError(CompilationStep::GENERAL, "Error waiting on child's streams", strerror(errno));
+        }
+        if(numReady == 0)
+            // timed out, the deadline is checked at the start of the next iteration
+            continue;
+
+        if(fds[STD_IN].revents != 0 && !writeInput(pipes[STD_IN][WRITE], *stdin, inBuffer, inOffset, inSize))
+            // signal EOF to the child
+            closePipe(pipes[STD_IN][WRITE]);
+        if(fds[STD_OUT].revents != 0 && !readOutput(pipes[STD_OUT][READ], stdout, outBuffer))
+            closePipe(pipes[STD_OUT][READ]);
+        if(fds[STD_ERR].revents != 0 && !readOutput(pipes[STD_ERR][READ], stderr, outBuffer))
+            closePipe(pipes[STD_ERR][READ]);
     }
 
-    if(!childFinished)
-    {
-        PROFILE(isChildFinished, pid, &exitStatus, true);
-    }
+    // the child might still run after closing its streams, or might not have any streams at all
+    int exitStatus = 0;
+    if(timeout.count() == 0)
+        exitStatus = waitForChild(pid);
+    else if(!waitForChild(pid, deadline, exitStatus))
+        abortChild(pid, timeout);
+    PROFILE_END(RunChildProcess);
     return exitStatus;
 }
@@ -7,6 +7,7 @@
 #ifndef PROCESSUTIL_H
 #define PROCESSUTIL_H
 
+#include <chrono>
 #include <iostream>
 #include <string>
 
@@ -14,10 +15,16 @@ namespace vc4c
 {
     /*
      * Runs the command in a new child-process, passes the standard input/output/error streams, waits for the process to
-     * finish and returns it status
+     * finish and returns it status.
+     *
+     * The input is fed to the child while its output is read, so large inputs and outputs do not block each other.
+     * Streams which are not given are redirected to/from /dev/null. The command is not run in a shell.
+     *
+     * If a (non-zero) timeout is given and the child does not close its output streams and terminate in time, it is
+     * killed and a CompilationError is thrown.
      */
     int runProcess(const std::string& command, std::istream* stdin = nullptr, std::ostream* stdout = nullptr,
-        std::ostream* stderr = nullptr);
+        std::ostream* stderr = nullptr, std::chrono::milliseconds timeout = std::chrono::milliseconds::zero());
 
 } /* namespace vc4c */
 
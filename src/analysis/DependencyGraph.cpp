@@ -168,7 +168,7 @@ static void addDependency(Dependency& dependency, DependencyType type, unsigned
 static bool isLocallyLimited(const Local* local, const intermediate::IntermediateInstruction* currentInstr,
     const intermediate::IntermediateInstruction* lastWriter, const intermediate::IntermediateInstruction* lastReader)
 {
-    auto tmp = local->getUsers();
+    auto tmp = local->getUsers(LocalUse::Type::BOTH);
     tmp.erase(currentInstr);
     tmp.erase(lastWriter);
     tmp.erase(lastReader);
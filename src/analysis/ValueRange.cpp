@@ -189,8 +189,57 @@ std::string ValueRange::to_string() const
     throw CompilationError(CompilationStep::GENERAL, "Invalid range type", std::to_string(static_cast<unsigned>(type)));
 }
 
+/*
+ * Calculates the range of the result of the given integer operation via interval arithmetic.
+ *
+ * Returns an empty optional, if the range cannot be determined, e.g. since the calculation might overflow.
+ */
+static Optional<IntegerRange> calculateIntegerRange(
+    const OpCode& code, const IntegerRange& first, const IntegerRange& second)
+{
+    IntegerRange result;
+    if(code == OP_ADD)
+    {
+        result.minValue = first.minValue + second.minValue;
+        result.maxValue = first.maxValue + second.maxValue;
+    }
+    else if(code == OP_SUB)
+    {
+        result.minValue = first.minValue - second.maxValue;
+        result.maxValue = first.maxValue - second.minValue;
+    }
+    else if(code == OP_MUL24)
+    {
+        // mul24 only uses the lower 24 bits of both operands
+        if(first.minValue < 0 || second.minValue < 0 || first.maxValue > 0xFFFFFF || second.maxValue > 0xFFFFFF)
+            return {};
+        result.minValue = first.minValue * second.minValue;
+        result.maxValue = first.maxValue * second.maxValue;
+    }
+    else if(code == OP_MIN || code == OP_MAX)
+    {
+        // min/max use signed comparison, so the operands need to be valid signed values
+        if(first.maxValue > std::numeric_limits<int32_t>::max() ||
+            second.maxValue > std::numeric_limits<int32_t>::max())
+            return {};
+        result.minValue = code == OP_MIN ? std::min(first.minValue, second.minValue) :
+                                           std::max(first.minValue, second.minValue);
+        result.maxValue = code == OP_MIN ? std::min(first.maxValue, second.maxValue) :
+                                           std::max(first.maxValue, second.maxValue);
+    }
+    else
+        return {};
+
+    // the result overflows or cannot be unambiguously interpreted as either signed or unsigned value
+    if(result.minValue < std::numeric_limits<int32_t>::min() ||
+        result.maxValue > std::numeric_limits<uint32_t>::max() ||
+        (result.minValue < 0 && result.maxValue > std::numeric_limits<int32_t>::max()))
+        return {};
+    return result;
+}
+
 void ValueRange::update(const Optional<Value>& constant, const FastMap<const Local*, ValueRange>& ranges,
-    const intermediate::IntermediateInstruction* it, Method* method)
+    const intermediate::IntermediateInstruction* it, Method* method, bool useGlobalRanges)
 {
     const Operation* op = dynamic_cast<const Operation*>(it);
 
@@ -348,13 +397,16 @@ void ValueRange::update(const Optional<Value>& constant, const FastMap<const Loc
         }
     }
     // general case for operations, only works if the used locals are only written once (otherwise, their range
-    // could change afterwards!)
+    // could change afterwards!) or if the ranges of the locals already contain all writes (global propagation)
     else if(op && !it->getArguments().empty() &&
         (op->op == OP_ADD || op->op == OP_AND || op->op == OP_FADD || op->op == OP_FMAX || op->op == OP_FMAXABS ||
             op->op == OP_FMIN || op->op == OP_FMINABS || op->op == OP_FMUL || op->op == OP_FSUB || op->op == OP_ITOF ||
             op->op == OP_MAX || op->op == OP_MIN || op->op == OP_MUL24 || op->op == OP_SHR || op->op == OP_SUB) &&
         std::all_of(it->getArguments().begin(), it->getArguments().end(),
-            [](const Value& arg) -> bool { return arg.isLiteralValue() || (arg.getSingleWriter() != nullptr); }))
+            [&](const Value& arg) -> bool {
+                return arg.isLiteralValue() || (arg.getSingleWriter() != nullptr) ||
+                    (useGlobalRanges && arg.hasLocal() && ranges.find(arg.local()) != ranges.end());
+            }))
     {
         /*
          * We have an operation (with a valid op-code) where all operands are either constants or locals which
@@ -409,6 +461,21 @@ void ValueRange::update(const Optional<Value>& constant, const FastMap<const Loc
             else if(arg1.hasLocal() && ranges.find(arg1.local()) != ranges.end())
                 secondRange.extendBoundaries(ranges.at(arg1.local()));
 
+            if(!it->getOutput()->type.isFloatingType() && firstRange.type == RangeType::INTEGER &&
+                secondRange.type == RangeType::INTEGER &&
+                (op->op == OP_ADD || op->op == OP_SUB || op->op == OP_MUL24 || op->op == OP_MIN || op->op == OP_MAX))
+            {
+                // applying the operation to the boundaries only is not correct for e.g. subtraction and does not
+                // detect overflows, so use interval arithmetic instead
+                auto resultRange = calculateIntegerRange(op->op, firstRange.intRange, secondRange.intRange);
+                if(resultRange)
+                    extendBoundaries(resultRange->minValue, resultRange->maxValue);
+                else
+                    extendBoundariesToUnknown(isUnsignedType(it->getOutput()->type) ||
+                        it->hasDecoration(InstructionDecorations::UNSIGNED_RESULT));
+                return;
+            }
+
             Value secondMin(TYPE_UNKNOWN);
             Value secondMax(TYPE_UNKNOWN);
 
@@ -478,23 +545,54 @@ void ValueRange::update(const Optional<Value>& constant, const FastMap<const Loc
     }
 }
 
+// the maximum number of locals to take into account when determining the range of a single value
+static constexpr unsigned MAX_VALUE_RANGE_LOCALS = 32;
+// the number of changes to a local's range, after which its boundaries are widened
+static constexpr unsigned WIDENING_THRESHOLD = 3;
+// the maximum number of rounds for narrowing the widened ranges again
+static constexpr unsigned NARROWING_ROUNDS = 2;
+
 ValueRange ValueRange::getValueRange(const Value& val, Method* method)
 {
     ValueRange range(val.type.isFloatingType(), true);
-    auto singleWriter = val.hasLocal() ? val.local()->getSingleWriter() : nullptr;
-    FastMap<const Local*, ValueRange> ranges;
-    if(singleWriter && dynamic_cast<const MoveOperation*>(singleWriter))
+    if(!val.hasLocal())
     {
-        const Value& src = dynamic_cast<const MoveOperation*>(singleWriter)->getSource();
-        if(src.hasLocal())
-        {
-            auto& tmp = ranges.emplace(src.local(), src.local()->type).first->second;
-            tmp.update(NO_VALUE, ranges, src.local()->getSingleWriter(), method);
-        }
+        range.update(val.isLiteralValue() ? Optional<Value>(val) : Optional<Value>{}, {}, nullptr, method);
+        return range;
+    }
+
+    // collect all instructions (transitively) contributing to the value of the local
+    FastMap<const Local*, ValueRange> ranges;
+    FastAccessList<const IntermediateInstruction*> writers;
+    FastSet<const Local*> visitedLocals;
+    FastAccessList<const Local*> openLocals;
+    openLocals.push_back(val.local());
+    while(!openLocals.empty() && visitedLocals.size() < MAX_VALUE_RANGE_LOCALS)
+    {
+        const Local* loc = openLocals.back();
+        openLocals.pop_back();
+        if(!visitedLocals.emplace(loc).second)
+            continue;
+        if(loc->is<Parameter>())
+            ranges.emplace(loc, loc->type);
+        loc->forUsers(LocalUse::Type::WRITER, [&](const LocalUser* user) {
+            auto inst = dynamic_cast<const IntermediateInstruction*>(user);
+            if(inst == nullptr || !inst->hasValueType(ValueType::LOCAL))
+                return;
+            writers.push_back(inst);
+            for(const Value& arg : inst->getArguments())
+            {
+                if(arg.hasLocal() && visitedLocals.find(arg.local()) == visitedLocals.end())
+                    openLocals.push_back(arg.local());
+            }
+        });
     }
-    range.update(val.isLiteralValue() ? Optional<Value>(val) :
-                                        (singleWriter ? singleWriter->precalculate(3) : Optional<Value>{}),
-        ranges, singleWriter, method);
+
+    propagateValueRanges(ranges, writers, method);
+
+    auto rangeIt = ranges.find(val.local());
+    if(rangeIt != ranges.end())
+        return rangeIt->second;
     return range;
 }
 
@@ -507,18 +605,18 @@ FastMap<const Local*, ValueRange> ValueRange::determineValueRanges(Method& metho
         ranges.emplace(&param, param.type);
     }
 
+    FastAccessList<const IntermediateInstruction*> writers;
     auto it = method.walkAllInstructions();
     while(!it.isEndOfMethod())
     {
         if(it.has() && !it.has<BranchLabel>() && it->hasValueType(ValueType::LOCAL))
-        {
-            ValueRange& range = ranges.emplace(it->getOutput()->local(), it->getOutput()->local()->type).first->second;
-            range.update(it->precalculate(3), ranges, it.get(), &method);
-        }
+            writers.push_back(it.get());
 
         it.nextInMethod();
     }
 
+    propagateValueRanges(ranges, writers, &method);
+
 #ifdef DEBUG_MODE
     std::for_each(ranges.begin(), ranges.end(), [](const std::pair<const Local*, ValueRange>& pair) -> void {
         logging::debug() << "Local " << pair.first->to_string() << " with range " << pair.second.to_string()
@@ -529,6 +627,133 @@ FastMap<const Local*, ValueRange> ValueRange::determineValueRanges(Method& metho
     return ranges;
 }
 
+void ValueRange::propagateValueRanges(FastMap<const Local*, ValueRange>& ranges,
+    const FastAccessList<const IntermediateInstruction*>& writers, Method* method)
+{
+    FastSet<const Local*> writtenLocals;
+    for(const IntermediateInstruction* inst : writers)
+        writtenLocals.emplace(inst->getOutput()->local());
+
+    // whether the instruction reads a local which is written, but whose range is not yet known
+    auto hasPendingArguments = [&](const IntermediateInstruction* inst) -> bool {
+        return std::any_of(inst->getArguments().begin(), inst->getArguments().end(), [&](const Value& arg) -> bool {
+            return arg.hasLocal() && writtenLocals.find(arg.local()) != writtenLocals.end() &&
+                ranges.find(arg.local()) == ranges.end();
+        });
+    };
+    auto calculateRange = [&](const IntermediateInstruction* inst) -> ValueRange {
+        const Local* loc = inst->getOutput()->local();
+        ValueRange range(loc->type);
+        if(inst->hasPackMode())
+            // the pack-mode modifies the calculated value
+            range.extendBoundariesToUnknown(isUnsignedType(loc->type));
+        else
+            range.update(inst->precalculate(3), ranges, inst, method, true);
+        return range;
+    };
+    auto replaceRange = [&](const Local* loc, const ValueRange& range) {
+        // ValueRange is not assignable, so we need to re-insert it
+        ranges.erase(loc);
+        ranges.emplace(loc, range);
+    };
+
+    /*
+     * Ascending phase: join the ranges of all writes of a local until a fixed point is reached.
+     *
+     * Instructions reading locals with yet unknown ranges are skipped at first, to not pessimize the ranges of
+     * loop-carried values (e.g. phi-nodes) right from the beginning. Once there is no more progress, these
+     * instructions are evaluated anyway (with the unknown ranges) to guarantee all writes are taken into account.
+     */
+    FastMap<const Local*, unsigned> numChanges;
+    bool evaluateAll = false;
+    unsigned numRounds = 0;
+    while(true)
+    {
+        // widening guarantees termination, this is only a safe-guard
+        if(++numRounds > (WIDENING_THRESHOLD + 4) * std::max(writtenLocals.size(), std::size_t{1}))
+        {
+            logging::debug() << "Value range propagation did not converge, discarding results" << logging::endl;
+            for(const Local* loc : writtenLocals)
+            {
+                if(!loc->is<Parameter>())
+                    ranges.erase(loc);
+            }
+            return;
+        }
+        bool changedRange = false;
+        for(const IntermediateInstruction* inst : writers)
+        {
+            if(!evaluateAll && hasPendingArguments(inst))
+                continue;
+            const Local* loc = inst->getOutput()->local();
+            ValueRange newRange = calculateRange(inst);
+            auto rangeIt = ranges.find(loc);
+            if(rangeIt == ranges.end())
+            {
+                ranges.emplace(loc, newRange);
+                changedRange = true;
+                continue;
+            }
+            ValueRange joinedRange(rangeIt->second);
+            joinedRange.joinBoundaries(newRange);
+            if(!joinedRange.hasSameBoundaries(rangeIt->second))
+            {
+                // the range of the local is still growing (e.g. loop iteration variable), widen its boundaries
+                if(++numChanges[loc] > WIDENING_THRESHOLD)
+                    joinedRange.widenBoundaries(rangeIt->second);
+                // values calculated from the widened range might exceed the limits, which are not widened any further
+                if(!joinedRange.hasSameBoundaries(rangeIt->second))
+                {
+                    replaceRange(loc, joinedRange);
+                    changedRange = true;
+                }
+            }
+        }
+        if(!changedRange)
+        {
+            if(evaluateAll)
+                break;
+            evaluateAll = true;
+        }
+    }
+
+    /*
+     * Descending phase: re-calculate the ranges from the (widened) fixed point and accept them, if they are more
+     * precise. Since the fixed point covers all writes, the re-calculated ranges are still valid.
+     */
+    for(unsigned round = 0; round < NARROWING_ROUNDS; ++round)
+    {
+        FastMap<const Local*, ValueRange> narrowedRanges;
+        for(const IntermediateInstruction* inst : writers)
+        {
+            const Local* loc = inst->getOutput()->local();
+            auto rangeIt = narrowedRanges.find(loc);
+            if(rangeIt == narrowedRanges.end())
+            {
+                rangeIt = narrowedRanges.emplace(loc, calculateRange(inst)).first;
+                if(loc->is<Parameter>())
+                    // parameters have an initial value set from outside
+                    rangeIt->second.joinBoundaries(ValueRange(loc->type));
+            }
+            else
+                rangeIt->second.joinBoundaries(calculateRange(inst));
+        }
+        bool changedRange = false;
+        for(const auto& pair : narrowedRanges)
+        {
+            auto rangeIt = ranges.find(pair.first);
+            if(rangeIt != ranges.end() && pair.second.isContainedIn(rangeIt->second) &&
+                !pair.second.hasSameBoundaries(rangeIt->second))
+            {
+                replaceRange(pair.first, pair.second);
+                changedRange = true;
+            }
+        }
+        if(!changedRange)
+            break;
+    }
+}
+
 void ValueRange::extendBoundaries(double newMin, double newMax)
 {
     if(newMax < newMin)
@@ -638,3 +863,60 @@ void ValueRange::extendBoundariesToUnknown(bool isKnownToBeUnsigned)
     }
     hasDefaultBoundaries = false;
 }
+
+void ValueRange::joinBoundaries(const ValueRange& other)
+{
+    // unlike #extendBoundaries, this also takes the default boundaries into account
+    bool wasDefault = hasDefaultBoundaries;
+    hasDefaultBoundaries = false;
+    extendBoundaries(other);
+    hasDefaultBoundaries = wasDefault && other.hasDefaultBoundaries;
+}
+
+void ValueRange::widenBoundaries(const ValueRange& previous)
+{
+    // move the boundaries which grew since the previous range directly to the limits
+    switch(type)
+    {
+    case RangeType::FLOAT:
+        if(floatRange.minValue < previous.floatRange.minValue)
+            floatRange.minValue = FloatRange().minValue;
+        if(floatRange.maxValue > previous.floatRange.maxValue)
+            floatRange.maxValue = FloatRange().maxValue;
+        break;
+    case RangeType::INTEGER:
+        if(intRange.minValue < previous.intRange.minValue)
+            intRange.minValue = IntegerRange().minValue;
+        if(intRange.maxValue > previous.intRange.maxValue)
+            intRange.maxValue = IntegerRange().maxValue;
+        break;
+    }
+}
+
+bool ValueRange::hasSameBoundaries(const ValueRange& other) const
+{
+    if(type != other.type || hasDefaultBoundaries != other.hasDefaultBoundaries)
+        return false;
+    switch(type)
+    {
+    case RangeType::FLOAT:
+        return floatRange.minValue == other.floatRange.minValue && floatRange.maxValue == other.floatRange.maxValue;
+    case RangeType::INTEGER:
+        return intRange.minValue == other.intRange.minValue && intRange.maxValue == other.intRange.maxValue;
+    }
+    return false;
+}
+
+bool ValueRange::isContainedIn(const ValueRange& other) const
+{
+    if(type != other.type)
+        return false;
+    switch(type)
+    {
+    case RangeType::FLOAT:
+        return floatRange.minValue >= other.floatRange.minValue && floatRange.maxValue <= other.floatRange.maxValue;
+    case RangeType::INTEGER:
+        return intRange.minValue >= other.intRange.minValue && intRange.maxValue <= other.intRange.maxValue;
+    }
+    return false;
+}
@@ -60,7 +60,20 @@ namespace vc4c
 
             std::string to_string() const;
 
+            /*
+             * Determines the value range of the given value.
+             *
+             * For locals, the ranges of all (transitive) writers are propagated until they reach a fixed point, so
+             * values written in several basic blocks (e.g. phi-nodes) are supported too.
+             */
             static ValueRange getValueRange(const Value& val, Method* method = nullptr);
+            /*
+             * Determines the value ranges of all locals within the given method.
+             *
+             * The ranges are propagated across all basic blocks and through loops until they reach a fixed point.
+             * Boundaries which are still changing after a few iterations are widened to the limits of the underlying
+             * type (to guarantee termination) and afterwards narrowed again as far as the writing instructions allow.
+             */
             static FastMap<const Local*, ValueRange> determineValueRanges(Method& method);
 
         private:
@@ -82,8 +95,16 @@ namespace vc4c
             void extendBoundaries(int64_t newMin, int64_t newMax);
             void extendBoundaries(const ValueRange& other);
             void extendBoundariesToUnknown(bool isKnownToBeUnsigned = false);
+            void joinBoundaries(const ValueRange& other);
+            void widenBoundaries(const ValueRange& previous);
+            bool hasSameBoundaries(const ValueRange& other) const;
+            bool isContainedIn(const ValueRange& other) const;
             void update(const Optional<Value>& constant, const FastMap<const Local*, ValueRange>& ranges,
-                const intermediate::IntermediateInstruction* it = nullptr, Method* method = nullptr);
+                const intermediate::IntermediateInstruction* it = nullptr, Method* method = nullptr,
+                bool useGlobalRanges = false);
+
+            static void propagateValueRanges(FastMap<const Local*, ValueRange>& ranges,
+                const FastAccessList<const intermediate::IntermediateInstruction*>& writers, Method* method);
         };
 
     } /* namespace analysis */
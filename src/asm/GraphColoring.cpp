@@ -794,6 +794,125 @@ static bool blocksLocal(const ColoredNode* neighbor, LocalRelation relation)
         !has_flag(neighbor->possibleFiles, RegisterFile::ACCUMULATOR);
 }
 
+// the maximum number of reads of a constant to be rematerialized, since every read requires an additional instruction
+static constexpr std::size_t MAX_REMATERIALIZED_READS = 8;
+
+/*
+ * Returns the instruction writing the given local, if the local is written exactly once by an instruction loading a
+ * constant, which can be cheaply repeated before every read (loading of a literal or small immediate value without any
+ * side-effects).
+ */
+static Optional<InstructionWalker> findRematerializableWriter(const Local* local, const LocalUsage& localUse)
+{
+    const auto writers = local->getUsers(LocalUse::Type::WRITER);
+    if(writers.size() != 1)
+        return {};
+    const LocalUser* writer = *writers.begin();
+    if(writer->hasConditionalExecution() || writer->hasSideEffects() || writer->hasPackMode() ||
+        writer->hasUnpackMode())
+        return {};
+    auto move = dynamic_cast<const intermediate::MoveOperation*>(writer);
+    if(dynamic_cast<const intermediate::LoadImmediate*>(writer) == nullptr &&
+        (move == nullptr || dynamic_cast<const intermediate::VectorRotation*>(writer) != nullptr ||
+            !move->getSource().hasImmediate()))
+        return {};
+    // input locals of vector rotations cannot be written by the directly preceding instruction
+    if(std::any_of(localUse.associatedInstructions.begin(), localUse.associatedInstructions.end(),
+           [](InstructionWalker it) -> bool { return it.has<intermediate::VectorRotation>(); }))
+        return {};
+    for(InstructionWalker it : localUse.associatedInstructions)
+    {
+        if(it.get() == writer)
+            return it;
+    }
+    // the writer is part of a combined instruction
+    return {};
+}
+
+/*
+ * Replaces the given local with a new temporary loading the same constant directly before every read.
+ *
+ * Since the temporaries are only live for a single instruction, they can all be mapped to accumulators and the
+ * register previously occupied by the local for its whole live-range becomes available.
+ */
+static void rematerializeLocal(Method& method, ColoredGraph& graph, const Local* local, InstructionWalker writerIt,
+    FastMap<const Local*, LocalUsage>& localUses)
+{
+    logging::debug() << "Rematerializing constant before every read: " << writerIt->to_string() << logging::endl;
+    // we need to copy the associated instructions, since we modify the collection
+    const FastSet<InstructionWalker> copy(localUses.at(local).associatedInstructions);
+    for(InstructionWalker it : copy)
+    {
+        if(it.get() == writerIt.get())
+            continue;
+        const Value tmp = method.addNewLocal(local->type, "%remat");
+        intermediate::IntermediateInstruction* load = nullptr;
+        if(auto loadImmediate = writerIt.get<const intermediate::LoadImmediate>())
+            load = loadImmediate->type == intermediate::LoadType::REPLICATE_INT32 ?
+                new intermediate::LoadImmediate(tmp, loadImmediate->getImmediate()) :
+                new intermediate::LoadImmediate(
+                    tmp, loadImmediate->getImmediate().unsignedInt(), loadImmediate->type);
+        else
+            load = new intermediate::MoveOperation(
+                tmp, writerIt.get<const intermediate::MoveOperation>()->getSource());
+        it.emplace(load->copyExtrasFrom(writerIt.get()));
+        auto& tmpUse = localUses.emplace(tmp.local(), LocalUsage(it, it)).first->second;
+        it.nextInBlock();
+        it->replaceLocal(local, tmp.local(), LocalUse::Type::READER);
+        // the temporary is read in the next instruction
+        tmpUse.possibleFiles = RegisterFile::ACCUMULATOR;
+        tmpUse.lastOccurrence = it;
+        tmpUse.associatedInstructions.insert(it);
+        // the node is only required for fixing other errors in this round, the graph is re-created for the next round
+        graph.getOrCreateNode(tmp.local(), ColoredNode(graph, tmp.local(), RegisterFile::ACCUMULATOR));
+        PROFILE_COUNTER(vc4c::profiler::COUNTER_BACKEND + 50, "Rematerialized constants", 1);
+    }
+    writerIt.erase();
+    localUses.erase(local);
+}
+
+/*
+ * Tries to lower the register-pressure for the given node by rematerializing a constant, which is either the local of
+ * the node itself or one of the locals live at the same time.
+ *
+ * Re-loading a constant costs one instruction per read, while keeping the constant in a register blocks this register
+ * for all the other locals it interferes with. So of all candidates, the local with the most interfering locals per
+ * read is chosen.
+ */
+static bool rematerializeConstant(
+    Method& method, ColoredGraph& graph, ColoredNode& node, FastMap<const Local*, LocalUsage>& localUses)
+{
+    const Local* bestCandidate = nullptr;
+    Optional<InstructionWalker> bestWriter;
+    double bestScore = 0.0;
+    auto checkCandidate = [&](const ColoredNode& candidate) {
+        auto useIt = localUses.find(candidate.key);
+        if(useIt == localUses.end() || has_flag(useIt->second.blockedFiles, RegisterFile::ACCUMULATOR))
+            return;
+        const auto numReads = candidate.key->getUsers(LocalUse::Type::READER).size();
+        if(numReads == 0 || numReads > MAX_REMATERIALIZED_READS)
+            return;
+        const double score = static_cast<double>(candidate.getEdgesSize()) / static_cast<double>(numReads);
+        if(score <= bestScore)
+            return;
+        auto writer = findRematerializableWriter(candidate.key, useIt->second);
+        if(!writer)
+            return;
+        bestCandidate = candidate.key;
+        bestWriter = writer;
+        bestScore = score;
+    };
+    checkCandidate(node);
+    node.forAllEdges([&](const ColoredNode& neighbor, const ColoredEdge&) -> bool {
+        checkCandidate(neighbor);
+        return true;
+    });
+    if(bestCandidate == nullptr)
+        return false;
+    rematerializeLocal(method, graph, bestCandidate, bestWriter.value(), localUses);
+    return true;
+}
+
 static bool fixSingleError(Method& method, ColoredGraph& graph, ColoredNode& node,
     FastMap<const Local*, LocalUsage>& localUses, LocalUsage& localUse)
 {
@@ -829,6 +948,8 @@ static bool fixSingleError(Method& method, ColoredGraph& graph, ColoredNode& nod
      *     Otherwise, one copy per file would need to be created (and we would need to hope, the next iteration can
      * assign both)
      *   - need to make sure, copy is written to when the main local is written!
+     *  -> if there are no free registers on any file, the register-pressure can be lowered by re-loading a constant
+     * (the local itself or an interfering one) before every read instead of keeping it live in a register
      */
 
     // TODO if we only use fixes which do not change the graph (don't insert new locals)
@@ -967,6 +1088,9 @@ static bool fixSingleError(Method& method, ColoredGraph& graph, ColoredNode& nod
         else if(!moveToFileA && !moveToFileB)
         {
             // there are no more free register AT ALL
+            if(rematerializeConstant(method, graph, node, localUses))
+                // the graph needs to be re-created, since locals were removed and inserted
+                return false;
             // since we do not spill, we can only about
             logging::error() << "Local " << node.key->to_string() << " cannot be assigned to ANY register, aborting!"
                              << logging::endl;
@@ -1007,6 +1131,9 @@ bool GraphColoring::fixErrors()
     bool allFixed = true;
     for(const Local* local : errorSet)
     {
+        if(localUses.find(local) == localUses.end())
+            // local was removed by fixing a previous error, e.g. by rematerializing it
+            continue;
         ColoredNode& node = graph.assertNode(local);
         logging::debug() << "Error in register-allocation for node: " << node.to_string() << logging::endl;
         auto& s = logging::debug() << "Local is blocked by: ";
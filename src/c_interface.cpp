@@ -6,16 +6,23 @@
 
 #include "../include/c_interface.h"
 
+#include <cctype>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string.h>
+#include <thread>
+#include <vector>
 
 #include "../lib/cpplog/include/logger.h"
+#include "BackgroundWorker.h"
 #include "CompilationError.h"
 #include "Compiler.h"
 #include "Precompiler.h"
 #include "log.h"
+#include "tools.h"
 
 using namespace vc4c;
 
@@ -24,14 +31,113 @@ const configuration DEFAULT_CONFIG = {MATH_TYPE_FAST, OUTPUT_BINARY, LOG_WARNING
 static CompilationErrorHandler errorCallback = NULL;
 static void* callbackData = NULL;
 
-int convert(const storage* in, storage* out, const configuration config, const char* options)
+// guards the replacement of the global logger
+static std::mutex loggerLock;
+// the number of compilations (single conversions or batches) currently running and possibly logging
+static unsigned numActiveCompilations = 0;
+
+static unsigned getVerbosity(char logLevel)
+{
+    switch(logLevel)
+    {
+    case LOG_DEBUG:
+        return 4;
+    case LOG_INFO:
+        return 3;
+    case LOG_WARNING:
+        return 2;
+    case LOG_ERROR:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Marks the start of a compilation and sets the logger for the given log-level.
+ *
+ * The global logger is only replaced if no other compilation is running, since these might still be logging. Otherwise
+ * the current logger (with the log-level of the already running compilations) is kept.
+ */
+static void beginCompilation(char logLevel)
+{
+    std::lock_guard<std::mutex> guard(loggerLock);
+    if(numActiveCompilations == 0)
+        // TODO allow to redirect log
+        logging::LOGGER.reset(new logging::ColoredLogger(std::wcerr, static_cast<logging::Level>(logLevel)));
+    ++numActiveCompilations;
+}
+
+static void endCompilation()
+{
+    std::lock_guard<std::mutex> guard(loggerLock);
+    --numActiveCompilations;
+}
+
+struct CompilationScope
+{
+    explicit CompilationScope(char logLevel)
+    {
+        beginCompilation(logLevel);
+    }
+
+    ~CompilationScope()
+    {
+        endCompilation();
+    }
+};
+
+static void reportError(const char* message)
+{
+    logging::severe() << message << logging::endl;
+    if(errorCallback != NULL)
+    {
+        errorCallback(message, strlen(message), callbackData);
+    }
+}
+
+static Configuration toConfiguration(const configuration& config)
 {
-    // TODO allow to redirect log
-    logging::LOGGER.reset(new logging::ColoredLogger(std::wcerr, static_cast<logging::Level>(config.log_level)));
     Configuration realConfig;
     realConfig.mathType = static_cast<MathType>(config.math_type);
     realConfig.outputMode = static_cast<OutputMode>(config.output_mode);
     realConfig.writeKernelInfo = true;
+    return realConfig;
+}
+
+/*
+ * Removes all kernel specializations ("--specialize=...") from the options and applies them to the configuration.
+ *
+ * Returns the remaining options to be passed to the pre-compiler
+ */
+static std::string applyKernelSpecializations(Configuration& config, const char* options)
+{
+    static const std::string SPECIALIZE_OPTION = "--specialize=";
+    std::string remainingOptions(options == NULL ? "" : options);
+    auto pos = remainingOptions.find(SPECIALIZE_OPTION);
+    while(pos != std::string::npos)
+    {
+        if(pos != 0 && !std::isspace(static_cast<unsigned char>(remainingOptions[pos - 1])))
+        {
+            // not the start of an option
+            pos = remainingOptions.find(SPECIALIZE_OPTION, pos + 1);
+            continue;
+        }
+        auto end = remainingOptions.find_first_of(" \t\n", pos);
+        const std::string option =
+            remainingOptions.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        if(!tools::parseConfigurationParameter(config, option))
+            throw CompilationError(CompilationStep::GENERAL, "Invalid kernel specialization", option);
+        remainingOptions.erase(pos, option.size());
+        pos = remainingOptions.find(SPECIALIZE_OPTION, pos);
+    }
+    return remainingOptions;
+}
+
+int convert(const storage* in, storage* out, const configuration config, const char* options)
+{
+    CompilationScope scope(config.log_level);
+    Configuration realConfig = toConfiguration(config);
 
     std::unique_ptr<std::istream> is;
     if(in->is_file)
@@ -60,18 +166,18 @@ int convert(const storage* in, storage* out, const configuration config, const c
     std::size_t bytesWritten = 0;
     try
     {
-        const std::string optionsString(options == NULL ? "" : options);
+        const std::string optionsString = applyKernelSpecializations(realConfig, options);
         bytesWritten = Compiler::compile(*is.get(), *os.get(), realConfig, optionsString);
         logging::info() << "Compilation done, " << bytesWritten << " bytes written!" << logging::endl;
     }
-    catch(CompilationError& err)
+    catch(const std::exception& err)
     {
-        logging::severe() << err.what() << logging::endl;
-        if(errorCallback != NULL)
-        {
-            errorCallback(err.what(), strlen(err.what()), callbackData);
-        }
-        bytesWritten = 0;
+        reportError(err.what());
+        return -15 /* CL_COMPILE_PROGRAM_FAILURE */;
+    }
+    catch(...)
+    {
+        reportError("Unknown error during compilation");
         return -15 /* CL_COMPILE_PROGRAM_FAILURE */;
     }
 
@@ -115,3 +221,242 @@ int determineSourceType(const storage* in)
 
     return static_cast<int>(Precompiler::getSourceType(*is.get()));
 }
+
+/*
+ * Stream buffer reading directly from the caller-owned input buffer
+ */
+class InputBuffer : public std::streambuf
+{
+public:
+    InputBuffer(char* data, std::size_t length)
+    {
+        setg(data, data, data + length);
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        if(!(which & std::ios_base::in))
+            return pos_type(off_type(-1));
+        char* base = dir == std::ios_base::beg ? eback() : (dir == std::ios_base::cur ? gptr() : egptr());
+        if(base + off < eback() || base + off > egptr())
+            return pos_type(off_type(-1));
+        setg(eback(), base + off, egptr());
+        return pos_type(gptr() - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+/*
+ * Stream buffer writing directly into the caller-owned output buffer.
+ *
+ * Any data not fitting into the buffer is dropped, but still counted to be able to report the required size.
+ */
+class OutputBuffer : public std::streambuf
+{
+public:
+    OutputBuffer(char* data, std::size_t capacity) : droppedBytes(0)
+    {
+        setp(data, data + capacity);
+    }
+
+    std::size_t getTotalSize() const
+    {
+        return static_cast<std::size_t>(pptr() - pbase()) + droppedBytes;
+    }
+
+    bool hasOverflown() const
+    {
+        return droppedBytes > 0;
+    }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if(!traits_type::eq_int_type(c, traits_type::eof()))
+            ++droppedBytes;
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char_type* s, std::streamsize count) override
+    {
+        const auto fitting = std::min(count, static_cast<std::streamsize>(epptr() - pptr()));
+        if(fitting > 0)
+        {
+            traits_type::copy(pptr(), s, static_cast<std::size_t>(fitting));
+            pbump(static_cast<int>(fitting));
+        }
+        droppedBytes += static_cast<std::size_t>(count - fitting);
+        return count;
+    }
+
+private:
+    // the number of bytes not fitting into the buffer
+    std::size_t droppedBytes;
+};
+
+struct _compilation_batch
+{
+    std::vector<compilation_job*> jobs;
+    CompilationCallback callback;
+    void* userData;
+
+    std::mutex lock;
+    std::condition_variable completed;
+    bool done = false;
+#ifdef MULTI_THREADED
+    std::thread controller;
+#endif
+};
+
+static void runCompilationJob(compilation_job* job)
+{
+    Configuration realConfig = toConfiguration(job->config);
+    realConfig.optimizationLevel = static_cast<OptimizationLevel>(
+        std::min(job->optimization_level, static_cast<unsigned>(OPTIMIZATION_LEVEL_FULL)));
+
+    std::unique_ptr<std::streambuf> inputBuffer;
+    std::unique_ptr<std::istream> is;
+    if(job->input.is_file)
+        is.reset(new std::ifstream(job->input.file_name, std::ios_base::in));
+    else
+    {
+        inputBuffer.reset(new InputBuffer(job->input.data, job->input.data_length));
+        is.reset(new std::istream(inputBuffer.get()));
+    }
+
+    std::unique_ptr<OutputBuffer> outputBuffer;
+    std::unique_ptr<std::ostream> os;
+    if(job->output.is_file)
+        os.reset(new std::ofstream(
+            job->output.file_name, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary));
+    else
+    {
+        outputBuffer.reset(
+            new OutputBuffer(job->output.data, job->output.data == nullptr ? 0 : job->output.data_length));
+        os.reset(new std::ostream(outputBuffer.get()));
+    }
+
+    try
+    {
+        const std::string optionsString = applyKernelSpecializations(realConfig, job->options);
+        Optional<std::string> inputFile;
+        if(job->input.is_file)
+            inputFile = std::string(job->input.file_name);
+        auto bytesWritten = Compiler::compile(*is, *os, realConfig, optionsString, inputFile);
+        logging::info() << "Compilation job done, " << bytesWritten << " bytes written!" << logging::endl;
+        job->status = bytesWritten > 0 ? 0 /* CL_SUCCESS */ : -15 /* CL_COMPILE_PROGRAM_FAILURE */;
+    }
+    catch(const std::exception& err)
+    {
+        // not only CompilationErrors, since any exception escaping the background worker terminates the whole process
+        reportError(err.what());
+        job->status = -15 /* CL_COMPILE_PROGRAM_FAILURE */;
+    }
+    catch(...)
+    {
+        reportError("Unknown error during compilation job");
+        job->status = -15 /* CL_COMPILE_PROGRAM_FAILURE */;
+    }
+
+    if(outputBuffer)
+    {
+        os->flush();
+        job->output.data_length = outputBuffer->getTotalSize();
+        if(outputBuffer->hasOverflown() && job->status == 0)
+            job->status = -61 /* CL_INVALID_BUFFER_SIZE */;
+    }
+}
+
+static void runCompilationBatch(compilation_handle batch)
+{
+    BackgroundWorker::scheduleAll<compilation_job*, std::vector<compilation_job*>>(
+        batch->jobs,
+        [batch](compilation_job* const& job) {
+            runCompilationJob(job);
+            if(batch->callback != NULL)
+                batch->callback(job, batch->userData);
+        },
+        "Compilation Job");
+
+    endCompilation();
+    {
+        std::lock_guard<std::mutex> guard(batch->lock);
+        batch->done = true;
+    }
+    batch->completed.notify_all();
+}
+
+compilation_handle submitCompilations(
+    compilation_job* jobs, size_t numJobs, CompilationCallback callback, void* userData)
+{
+    if(jobs == NULL || numJobs == 0)
+        return NULL;
+
+    // use the most verbose log-level of all jobs
+    char logLevel = jobs[0].config.log_level;
+    for(size_t i = 1; i < numJobs; ++i)
+    {
+        if(getVerbosity(jobs[i].config.log_level) > getVerbosity(logLevel))
+            logLevel = jobs[i].config.log_level;
+    }
+    beginCompilation(logLevel);
+
+    compilation_handle batch = new _compilation_batch();
+    batch->jobs.reserve(numJobs);
+    for(size_t i = 0; i < numJobs; ++i)
+    {
+        jobs[i].status = -15 /* CL_COMPILE_PROGRAM_FAILURE */;
+        batch->jobs.push_back(&jobs[i]);
+    }
+    batch->callback = callback;
+    batch->userData = userData;
+    logging::debug() << "Submitting batch of " << numJobs << " compilation jobs..." << logging::endl;
+
+#ifdef MULTI_THREADED
+    batch->controller = std::thread(runCompilationBatch, batch);
+#else
+    runCompilationBatch(batch);
+#endif
+    return batch;
+}
+
+int isCompilationDone(compilation_handle handle)
+{
+    if(handle == NULL)
+        return 1;
+    std::lock_guard<std::mutex> guard(handle->lock);
+    return handle->done ? 1 : 0;
+}
+
+int waitForCompilations(compilation_handle handle)
+{
+    if(handle == NULL)
+        return -30 /* CL_INVALID_VALUE */;
+    {
+        std::unique_lock<std::mutex> guard(handle->lock);
+        handle->completed.wait(guard, [handle]() -> bool { return handle->done; });
+    }
+    for(const compilation_job* job : handle->jobs)
+    {
+        if(job->status != 0)
+            return job->status;
+    }
+    return 0 /* CL_SUCCESS */;
+}
+
+void releaseCompilations(compilation_handle handle)
+{
+    if(handle == NULL)
+        return;
+    waitForCompilations(handle);
+#ifdef MULTI_THREADED
+    if(handle->controller.joinable())
+        handle->controller.join();
+#endif
+    delete handle;
+}
@@ -197,11 +197,11 @@ static bool canMoveIntoVPM(const Value& val, bool isMemoryAddress)
         // any non-local cannot be moved to VPM
         return false;
 
-    return std::all_of(val.local()->getUsers().begin(), val.local()->getUsers().end(),
-        [](const std::pair<const LocalUser*, LocalUse>& pair) -> bool {
-            // TODO enable if handled correctly by optimizations (e.g. combination of read/write into copy)
-            return false; // return dynamic_cast<const MemoryInstruction*>(pair.first) != nullptr;
-        });
+    const auto users = val.local()->getUsers(LocalUse::Type::BOTH);
+    return std::all_of(users.begin(), users.end(), [](const LocalUser* user) -> bool {
+        // TODO enable if handled correctly by optimizations (e.g. combination of read/write into copy)
+        return false; // return dynamic_cast<const MemoryInstruction*>(user) != nullptr;
+    });
 }
 
 bool MemoryInstruction::canMoveSourceIntoVPM() const
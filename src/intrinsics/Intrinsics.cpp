@@ -526,6 +526,46 @@ static bool isPowerTwo(int32_t val)
     return val > 0 && (val & (val - 1)) == 0;
 }
 
+/*
+ * Whether all possible values fit into the unsigned 24-bit operands of the mul24 instruction
+ */
+static bool fitsIntoMul24(Method& method, const Value& val)
+{
+    auto range = vc4c::analysis::ValueRange::getValueRange(val, &method).getIntRange();
+    return range && range->minValue >= 0 && range->maxValue <= 0xFFFFFF;
+}
+
+/*
+ * Whether all possible values fit into the range supported by the division via floating-point reciprocal, which is
+ * [0, 2^23) for unsigned and (-2^23, 2^23) for signed divisions
+ */
+static bool fitsIntoReciprocalDivision(Method& method, const Value& val, bool isSigned)
+{
+    auto range = vc4c::analysis::ValueRange::getValueRange(val, &method).getIntRange();
+    return range && range->minValue >= (isSigned ? -0x7FFFFF : 0) && range->maxValue <= 0x7FFFFF;
+}
+
+/*
+ * Whether the unsigned division by the given constant can be calculated via multiplication with its inverse, which
+ * requires both the numerator and the divisor to fit into 16-bit unsigned integers
+ */
+static bool canDivideByConstant(Method& method, const Value& numerator, const Value& divisor)
+{
+    if(!divisor.isLiteralValue() && !divisor.hasContainer())
+        return false;
+    if(numerator.type.getScalarBitCount() <= 16)
+        return true;
+    // the type is too large, but the actual values might still be small enough
+    auto isSmallLiteral = [](const Value& val) -> bool {
+        return val.getLiteralValue() && val.getLiteralValue()->unsignedInt() <= std::numeric_limits<uint16_t>::max();
+    };
+    if(divisor.hasContainer() ?
+            !std::all_of(divisor.container().elements.begin(), divisor.container().elements.end(), isSmallLiteral) :
+            !isSmallLiteral(divisor))
+        return false;
+    return vc4c::analysis::ValueRange::getValueRange(numerator, &method).fitsIntoType(TYPE_INT16, false);
+}
+
 static InstructionWalker intrinsifyArithmetic(Method& method, InstructionWalker it, const MathType& mathType)
 {
     IntrinsicOperation* op = it.get<IntrinsicOperation>();
@@ -571,6 +611,14 @@ static InstructionWalker intrinsifyArithmetic(Method& method, InstructionWalker
             it.reset(new Operation(OP_MUL24, op->getOutput().value(), op->getFirstArg(), op->assertArgument(1),
                 op->conditional, op->setFlags));
         }
+        else if(fitsIntoMul24(method, arg0) && fitsIntoMul24(method, arg1))
+        {
+            logging::debug() << "Intrinsifying multiplication of integers with small value ranges to mul24: "
+                             << op->to_string() << logging::endl;
+            it.reset(new Operation(OP_MUL24, op->getOutput().value(), op->getFirstArg(), op->assertArgument(1),
+                op->conditional, op->setFlags));
+            it->addDecorations(InstructionDecorations::UNSIGNED_RESULT);
+        }
         else if(arg0.getLiteralValue() && isPowerTwo(arg0.getLiteralValue()->signedInt() + 1))
         {
             // x * (2^k - 1) = x * 2^k - x = x << k - x
@@ -601,6 +649,14 @@ static InstructionWalker intrinsifyArithmetic(Method& method, InstructionWalker
             logging::debug() << "Intrinsifying multiplication via binary method: " << op->to_string() << logging::endl;
             it = intrinsifyIntegerMultiplicationViaBinaryMethod(method, it, *op);
         }
+        else if(fitsIntoMul24(method, arg1))
+        {
+            it = intrinsifyIntegerMultiplicationWith24BitOperand(method, it, *op, true);
+        }
+        else if(fitsIntoMul24(method, arg0))
+        {
+            it = intrinsifyIntegerMultiplicationWith24BitOperand(method, it, *op, false);
+        }
         else if(std::all_of(op->getArguments().begin(), op->getArguments().end(), [](const Value& arg) -> bool {
                     return vc4c::analysis::ValueRange::getValueRange(arg).isUnsigned();
                 }))
@@ -636,10 +692,14 @@ static InstructionWalker intrinsifyArithmetic(Method& method, InstructionWalker
                 op->conditional, op->setFlags));
             it->addDecorations(InstructionDecorations::UNSIGNED_RESULT);
         }
-        else if((arg1.isLiteralValue() || arg1.hasContainer()) && arg0.type.getScalarBitCount() <= 16)
+        else if(canDivideByConstant(method, arg0, arg1))
         {
             it = intrinsifyUnsignedIntegerDivisionByConstant(method, it, *op);
         }
+        else if(fitsIntoReciprocalDivision(method, arg0, false) && fitsIntoReciprocalDivision(method, arg1, false))
+        {
+            it = intrinsifyIntegerDivisionViaReciprocal(method, it, *op);
+        }
         else
         {
             it = intrinsifyUnsignedIntegerDivision(method, it, *op);
@@ -686,24 +746,11 @@ static InstructionWalker intrinsifyArithmetic(Method& method, InstructionWalker
         {
             it = intrinsifySignedIntegerDivisionByConstant(method, it, *op);
         }
-        /*        // a / b = ftoi(itof(a) / itof(b))
-                // possible for |type| < 24, since for -2^23 <= x <= 2^23 float is an exact representation
-                else if(arg0.type.getScalarBitCount() < 24 && arg1.type.getScalarBitCount() < 24)
-                {
-                    logging::debug() << "Intrinsifying signed division with floating-point division" << logging::endl;
-                    Value arg0Float = method.addNewLocal(TYPE_FLOAT.toVectorType(arg0.type.getVectorWidth()));
-                    Value arg1Float = method.addNewLocal(TYPE_FLOAT.toVectorType(arg1.type.getVectorWidth()));
-                    Value resultFloat =
-           method.addNewLocal(TYPE_FLOAT.toVectorType(op->getOutput()->type.getVectorWidth())); it.emplace(new
-           Operation(OP_ITOF, arg0Float, arg0)); it.nextInBlock(); it.emplace(new Operation(OP_ITOF, arg1Float, arg1));
-                    it.nextInBlock();
-                    //insert dummy instruction to replace
-                    it.emplace(new IntrinsicOperation("fdiv", resultFloat, arg0Float, arg1Float));
-                    it = intrinsifyFloatingDivision(method, it, *it.get<IntrinsicOperation>());
-                    it.nextInBlock();
-                    it.reset(new Operation(OP_FTOI, op->getOutput().value(), resultFloat));
-                }
-        */
+        // a / b = ftoi(itof(a) * recip(itof(b))) with correction, possible since -2^23 < x < 2^23 is exact in float
+        else if(fitsIntoReciprocalDivision(method, arg0, true) && fitsIntoReciprocalDivision(method, arg1, true))
+        {
+            it = intrinsifySignedIntegerDivision(method, it, *op, false, true);
+        }
         else
         {
             it = intrinsifySignedIntegerDivision(method, it, *op);
@@ -730,10 +777,14 @@ static InstructionWalker intrinsifyArithmetic(Method& method, InstructionWalker
                 Value(Literal(arg1.getLiteralValue()->unsignedInt() - 1), arg1.type), op->conditional, op->setFlags));
             it->addDecorations(InstructionDecorations::UNSIGNED_RESULT);
         }
-        else if((arg1.isLiteralValue() || arg1.hasContainer()) && arg0.type.getScalarBitCount() <= 16)
+        else if(canDivideByConstant(method, arg0, arg1))
         {
             it = intrinsifyUnsignedIntegerDivisionByConstant(method, it, *op, true);
         }
+        else if(fitsIntoReciprocalDivision(method, arg0, false) && fitsIntoReciprocalDivision(method, arg1, false))
+        {
+            it = intrinsifyIntegerDivisionViaReciprocal(method, it, *op, true);
+        }
         else
         {
             it = intrinsifyUnsignedIntegerDivision(method, it, *op, true);
@@ -778,6 +829,10 @@ static InstructionWalker intrinsifyArithmetic(Method& method, InstructionWalker
         {
             it = intrinsifySignedIntegerDivisionByConstant(method, it, *op, true);
         }
+        else if(fitsIntoReciprocalDivision(method, arg0, true) && fitsIntoReciprocalDivision(method, arg1, true))
+        {
+            it = intrinsifySignedIntegerDivision(method, it, *op, true, true);
+        }
         else
         {
             it = intrinsifySignedIntegerDivision(method, it, *op, true);
@@ -801,8 +856,9 @@ static InstructionWalker intrinsifyArithmetic(Method& method, InstructionWalker
             it.reset(new Operation(OP_FMUL, op->getOutput().value(), op->getFirstArg(),
                 periphery::precalculateSFU(REG_SFU_RECIP, arg1).value(), op->conditional, op->setFlags));
         }
+        // with -cl-unsafe-math-optimizations or -cl-fast-relaxed-math, the precision of the division is given up
         else if(op->hasDecoration(InstructionDecorations::ALLOW_RECIP) ||
-            op->hasDecoration(InstructionDecorations::FAST_MATH))
+            op->hasDecoration(InstructionDecorations::FAST_MATH) || has_flag(mathType, MathType::UNSAFE_MATH))
         {
             logging::debug() << "Intrinsifying floating division with multiplication of reciprocal: " << op->to_string()
                              << logging::endl;
@@ -1064,6 +1120,23 @@ static InstructionWalker intrinsifyReadLocalSize(Method& method, InstructionWalk
         add_flag(InstructionDecorations::BUILTIN_LOCAL_SIZE, InstructionDecorations::UNSIGNED_RESULT));
 }
 
+static InstructionWalker intrinsifyReadNumGroups(Method& method, InstructionWalker it, const Value& arg)
+{
+    // use the number of work-groups fixed for specialized kernels - if set
+    if(arg.getLiteralValue() && arg.getLiteralValue()->unsignedInt() < method.metaData.numGroups.size() &&
+        method.metaData.numGroups.at(arg.getLiteralValue()->unsignedInt()) > 0)
+    {
+        return it.reset((new MoveOperation(it->getOutput().value(),
+                             Value(Literal(method.metaData.numGroups.at(arg.getLiteralValue()->unsignedInt())),
+                                 TYPE_INT32)))
+                            ->copyExtrasFrom(it.get())
+                            ->addDecorations(InstructionDecorations::UNSIGNED_RESULT));
+    }
+    return intrinsifyReadWorkGroupInfo(method, it, arg,
+        {Method::NUM_GROUPS_X, Method::NUM_GROUPS_Y, Method::NUM_GROUPS_Z}, INT_ONE,
+        add_flag(InstructionDecorations::BUILTIN_NUM_GROUPS, InstructionDecorations::UNSIGNED_RESULT));
+}
+
 static InstructionWalker intrinsifyReadLocalID(Method& method, InstructionWalker it, const Value& arg)
 {
     if(method.metaData.isWorkGroupSizeSet() &&
@@ -1103,9 +1176,7 @@ static InstructionWalker intrinsifyWorkItemFunctions(Method& method, Instruction
     if(callSite->methodName == "vc4cl_num_groups" && callSite->getArguments().size() == 1)
     {
         logging::debug() << "Intrinsifying reading of the number of work-groups" << logging::endl;
-        return intrinsifyReadWorkGroupInfo(method, it, callSite->assertArgument(0),
-            {Method::NUM_GROUPS_X, Method::NUM_GROUPS_Y, Method::NUM_GROUPS_Z}, INT_ONE,
-            add_flag(InstructionDecorations::BUILTIN_NUM_GROUPS, InstructionDecorations::UNSIGNED_RESULT));
+        return intrinsifyReadNumGroups(method, it, callSite->assertArgument(0));
     }
     if(callSite->methodName == "vc4cl_group_id" && callSite->getArguments().size() == 1)
     {
@@ -1143,9 +1214,7 @@ static InstructionWalker intrinsifyWorkItemFunctions(Method& method, Instruction
         it = intrinsifyReadLocalSize(method, it, callSite->assertArgument(0));
         it.nextInBlock();
         it.emplace(new MoveOperation(tmpNumGroups, NOP_REGISTER));
-        it = intrinsifyReadWorkGroupInfo(method, it, callSite->assertArgument(0),
-            {Method::NUM_GROUPS_X, Method::NUM_GROUPS_Y, Method::NUM_GROUPS_Z}, INT_ONE,
-            add_flag(InstructionDecorations::BUILTIN_NUM_GROUPS, InstructionDecorations::UNSIGNED_RESULT));
+        it = intrinsifyReadNumGroups(method, it, callSite->assertArgument(0));
         it.nextInBlock();
         return it.reset(
             (new Operation(OP_MUL24, callSite->getOutput().value(), tmpLocalSize, tmpNumGroups))
@@ -6,6 +6,7 @@
 
 #include "Operators.h"
 
+#include "../analysis/ValueRange.h"
 #include "../intermediate/Helper.h"
 #include "../periphery/SFU.h"
 #include "Comparisons.h"
@@ -175,6 +176,43 @@ InstructionWalker intermediate::intrinsifyUnsignedIntegerMultiplication(
     return it;
 }
 
+InstructionWalker intermediate::intrinsifyIntegerMultiplicationWith24BitOperand(
+    Method& method, InstructionWalker it, IntrinsicOperation& op, const bool secondIsSmall)
+{
+    /*
+     * The lower 32 bits of a product do not depend on the signedness of the operands. So if one operand is known to fit
+     * into the unsigned 24-bit operand of mul24, only the other operand needs to be split:
+     *
+     * a * b = (a[hi] << 16 + a[lo]) * b = (a[hi] * b) << 16 + a[lo] * b
+     *
+     * where a[hi] and a[lo] are 16-bit values and therefore both partial products can be calculated with mul24.
+     */
+    const Value& arg = secondIsSmall ? op.getFirstArg() : op.assertArgument(1);
+    const Value& smallArg = secondIsSmall ? op.assertArgument(1) : op.getFirstArg();
+    logging::debug() << "Intrinsifying multiplication of integers with 24-bit operand: " << op.to_string()
+                     << logging::endl;
+
+    const Value lower = method.addNewLocal(op.getOutput()->type, "%mul.lo");
+    const Value upper = method.addNewLocal(op.getOutput()->type, "%mul.hi");
+    const Value lowerProduct = method.addNewLocal(op.getOutput()->type, "%mul.out0");
+    const Value upperProduct = method.addNewLocal(op.getOutput()->type, "%mul.out1");
+    const Value upperShifted = method.addNewLocal(op.getOutput()->type, "%mul.out1.shifted");
+
+    it.emplace(new Operation(OP_AND, lower, arg, Value(Literal(0xFFFFu), TYPE_INT16)));
+    it.nextInBlock();
+    it.emplace(new Operation(OP_SHR, upper, arg, Value(Literal(16u), TYPE_INT8)));
+    it.nextInBlock();
+    it.emplace(new Operation(OP_MUL24, lowerProduct, lower, smallArg));
+    it.nextInBlock();
+    it.emplace(new Operation(OP_MUL24, upperProduct, upper, smallArg));
+    it.nextInBlock();
+    it.emplace(new Operation(OP_SHL, upperShifted, upperProduct, Value(Literal(16u), TYPE_INT8)));
+    it.nextInBlock();
+    it.reset(new Operation(OP_ADD, op.getOutput().value(), lowerProduct, upperShifted, op.conditional, op.setFlags));
+
+    return it;
+}
+
 /*
  * "The number of elementary operations q is the number of 1’s in the binary expansion, minus 1"
  * note: q is a shift and an addition
@@ -275,7 +313,7 @@ InstructionWalker intermediate::intrinsifyIntegerMultiplicationViaBinaryMethod(
  */
 
 InstructionWalker intermediate::intrinsifySignedIntegerDivision(
-    Method& method, InstructionWalker it, IntrinsicOperation& op, const bool useRemainder)
+    Method& method, InstructionWalker it, IntrinsicOperation& op, const bool useRemainder, const bool useReciprocal)
 {
     Value opDest = op.getOutput().value();
     // check any operand is negative
@@ -297,7 +335,10 @@ InstructionWalker intermediate::intrinsifySignedIntegerDivision(
     op.setOutput(tmpDest);
 
     // calculate unsigned division
-    it = intrinsifyUnsignedIntegerDivision(method, it, op, useRemainder);
+    if(useReciprocal)
+        it = intrinsifyIntegerDivisionViaReciprocal(method, it, op, useRemainder);
+    else
+        it = intrinsifyUnsignedIntegerDivision(method, it, op, useRemainder);
     it.nextInBlock();
 
     if(op1Sign.hasLiteral(INT_ZERO.literal()) && op2Sign.hasLiteral(INT_ZERO.literal()))
@@ -326,7 +367,7 @@ InstructionWalker intermediate::intrinsifyUnsignedIntegerDivision(
 {
     // https://en.wikipedia.org/wiki/Division_algorithm#Integer_division_.28unsigned.29_with_remainder
     // see also: https://www.microsoft.com/en-us/research/wp-content/uploads/2008/08/tr-2008-141.pdf
-    // TODO for |type| < 24, use floating-point division??
+    // NOTE: for small operands, see intrinsifyIntegerDivisionViaReciprocal
     // NOTE: the instructions are ordered in a way, that the insertion of NOPs to split read-after-write is minimal
     const Value& numerator = op.getFirstArg();
     const Value& divisor = op.getSecondArg().value_or(UNDEFINED_VALUE);
@@ -408,6 +449,117 @@ InstructionWalker intermediate::intrinsifyUnsignedIntegerDivision(
     return it;
 }
 
+InstructionWalker intermediate::intrinsifyIntegerDivisionViaReciprocal(
+    Method& method, InstructionWalker it, IntrinsicOperation& op, const bool useRemainder)
+{
+    /*
+     * For operands in [0, 2^23), the values are represented exactly as floating-point values and the quotient can be
+     * approximated by multiplying with the (refined) result of SFU_RECIP. The approximation is then corrected with
+     * integer arithmetic, which only requires mul24, since the quotient estimates still fit into 24 bits.
+     *
+     * r = SFU_RECIP(itof(D)), r' = r * (2 - itof(D) * r)    -- reciprocal with one Newton-Raphson step
+     * Q0 = ftoi(itof(N) * r')                                -- off by a few units at most
+     * Q1 = max(Q0 + ftoi(itof(N - Q0 * D) * r'), 0)         -- off by at most one
+     * R = N - Q1 * D
+     * if R < 0 then Q := Q1 - 1, R := R + D
+     * if R >= D then Q := Q + 1, R := R - D
+     *
+     * See also: https://en.wikipedia.org/wiki/Division_algorithm#Newton%E2%80%93Raphson_division
+     */
+    const Value& numerator = op.getFirstArg();
+    const Value& divisor = op.assertArgument(1);
+    const DataType floatType = TYPE_FLOAT.toVectorType(op.getOutput()->type.getVectorWidth());
+    const DataType intType = op.getOutput()->type;
+
+    logging::debug() << "Intrinsifying division of small unsigned integers via reciprocal" << logging::endl;
+
+    const Value numeratorFloat = method.addNewLocal(floatType, "%udiv.numerator");
+    const Value divisorFloat = method.addNewLocal(floatType, "%udiv.divisor");
+    it.emplace(new Operation(OP_ITOF, numeratorFloat, numerator));
+    it.nextInBlock();
+    it.emplace(new Operation(OP_ITOF, divisorFloat, divisor));
+    it.nextInBlock();
+
+    // r' = r * (2 - D * r)
+    const Value recip = method.addNewLocal(floatType, "%udiv.recip");
+    periphery::insertSFUCall(REG_SFU_RECIP, it, divisorFloat);
+    it.emplace(new MoveOperation(recip, Value(REG_SFU_OUT, TYPE_FLOAT)));
+    it.nextInBlock();
+    Value tmpFloat = UNDEFINED_VALUE;
+    it = insertOperation(OP_FMUL, it, method, tmpFloat, divisorFloat, recip);
+    Value correction = UNDEFINED_VALUE;
+    it = insertOperation(OP_FSUB, it, method, correction, Value(Literal(2.0f), TYPE_FLOAT), tmpFloat);
+    const Value refinedRecip = method.addNewLocal(floatType, "%udiv.recip");
+    it.emplace(new Operation(OP_FMUL, refinedRecip, recip, correction));
+    it.nextInBlock();
+
+    // Q0 = ftoi(N * r')
+    Value quotientFloat = UNDEFINED_VALUE;
+    it = insertOperation(OP_FMUL, it, method, quotientFloat, numeratorFloat, refinedRecip);
+    const Value estimate = method.addNewLocal(intType, "%udiv.quotient");
+    it.emplace(new Operation(OP_FTOI, estimate, quotientFloat));
+    it.nextInBlock();
+
+    // Q1 = max(Q0 + ftoi((N - Q0 * D) * r'), 0)
+    Value product = UNDEFINED_VALUE;
+    it = insertOperation(OP_MUL24, it, method, product, estimate, divisor);
+    Value error = UNDEFINED_VALUE;
+    it = insertOperation(OP_SUB, it, method, error, numerator, product);
+    Value errorAsFloat = UNDEFINED_VALUE;
+    it = insertOperation(OP_ITOF, it, method, errorAsFloat, error);
+    Value errorQuotientFloat = UNDEFINED_VALUE;
+    it = insertOperation(OP_FMUL, it, method, errorQuotientFloat, errorAsFloat, refinedRecip);
+    Value errorQuotient = UNDEFINED_VALUE;
+    it = insertOperation(OP_FTOI, it, method, errorQuotient, errorQuotientFloat);
+    Value refinedEstimate = UNDEFINED_VALUE;
+    it = insertOperation(OP_ADD, it, method, refinedEstimate, estimate, errorQuotient);
+    // the refinement can undershoot by one for a quotient of zero, which would break the following mul24
+    const Value quotient = method.addNewLocal(intType, "%udiv.quotient");
+    it.emplace(new Operation(OP_MAX, quotient, refinedEstimate, INT_ZERO));
+    it.nextInBlock();
+
+    // R = N - Q1 * D, if R < 0 then Q1 is one too large
+    Value product2 = UNDEFINED_VALUE;
+    it = insertOperation(OP_MUL24, it, method, product2, quotient, divisor);
+    const Value remainder = method.addNewLocal(intType, "%udiv.remainder");
+    it.emplace(new Operation(OP_SUB, remainder, numerator, product2, COND_ALWAYS, SetFlag::SET_FLAGS));
+    it.nextInBlock();
+    const Value quotient2 = method.addNewLocal(intType, "%udiv.quotient");
+    it.emplace(new Operation(OP_SUB, quotient2, quotient, INT_ONE, COND_NEGATIVE_SET));
+    it.nextInBlock();
+    it.emplace(new MoveOperation(quotient2, quotient, COND_NEGATIVE_CLEAR));
+    it.nextInBlock();
+    const Value remainder2 = method.addNewLocal(intType, "%udiv.remainder");
+    it.emplace(new Operation(OP_ADD, remainder2, remainder, divisor, COND_NEGATIVE_SET));
+    it.nextInBlock();
+    it.emplace(new MoveOperation(remainder2, remainder, COND_NEGATIVE_CLEAR));
+    it.nextInBlock();
+
+    // if R >= D then Q1 is one too small
+    const Value tmp = method.addNewLocal(intType, "%udiv.tmp");
+    it.emplace(new Operation(OP_SUB, tmp, remainder2, divisor, COND_ALWAYS, SetFlag::SET_FLAGS));
+    it.nextInBlock();
+    const Value quotient3 = method.addNewLocal(intType, "%udiv.quotient");
+    it.emplace(new Operation(OP_ADD, quotient3, quotient2, INT_ONE, COND_NEGATIVE_CLEAR));
+    it.nextInBlock();
+    it.emplace(new MoveOperation(quotient3, quotient2, COND_NEGATIVE_SET));
+    it.nextInBlock();
+    const Value remainder3 = method.addNewLocal(intType, "%udiv.remainder");
+    it.emplace(new MoveOperation(remainder3, tmp, COND_NEGATIVE_CLEAR));
+    it.nextInBlock();
+    it.emplace(new MoveOperation(remainder3, remainder2, COND_NEGATIVE_SET));
+    it.nextInBlock();
+
+    // make move from original instruction
+    if(useRemainder)
+        it.reset(new MoveOperation(op.getOutput().value(), remainder3));
+    else
+        it.reset(new MoveOperation(op.getOutput().value(), quotient3));
+    it->addDecorations(InstructionDecorations::UNSIGNED_RESULT);
+
+    return it;
+}
+
 InstructionWalker intermediate::intrinsifySignedIntegerDivisionByConstant(
     Method& method, InstructionWalker it, IntrinsicOperation& op, bool useRemainder)
 {
@@ -506,7 +658,8 @@ InstructionWalker intermediate::intrinsifyUnsignedIntegerDivisionByConstant(
      * USHORT_MAX - 1.
      */
 
-    if(op.getFirstArg().type.getScalarBitCount() > 16)
+    if(op.getFirstArg().type.getScalarBitCount() > 16 &&
+        !analysis::ValueRange::getValueRange(op.getFirstArg(), &method).fitsIntoType(TYPE_INT16, false))
         throw CompilationError(CompilationStep::OPTIMIZER, "Division by constant may overflow for argument type",
             op.getFirstArg().type.to_string());
     if(!op.getSecondArg().ifPresent(toFunction(&Value::isLiteralValue)) &&
@@ -576,23 +729,39 @@ InstructionWalker intermediate::intrinsifyUnsignedIntegerDivisionByConstant(
 
 InstructionWalker intermediate::intrinsifyFloatingDivision(Method& method, InstructionWalker it, IntrinsicOperation& op)
 {
-    // TODO correct??
-
     /*
      * https://dspace.mit.edu/bitstream/handle/1721.1/80133/43609668-MIT.pdf
      * https://en.wikipedia.org/wiki/Division_algorithm#Newton.E2.80.93Raphson_division
      * http://www.rfwireless-world.com/Tutorials/floating-point-tutorial.html
+     * P. Markstein, "Computation of elementary functions on the IBM RISC System/6000 processor", 1990
      */
     logging::debug() << "Intrinsifying floating-point division" << logging::endl;
 
     const Value nominator = op.getFirstArg();
     const Value& divisor = op.assertArgument(1);
 
-    ////
-    // Newton-Raphson
-    ////
-    // TODO: "The Newton-Raphson  algorithm [...] is commonly used if the result does not require proper rounding"
-    //-> use Goldschmidt??
+    /*
+     * Error bounds (for round-to-nearest arithmetic without denormals, e := relative error, u := 2^-24 the unit
+     * roundoff). The QPU has no fused multiply-add, so every product below is rounded separately:
+     *
+     * The SFU_RECIP result is assumed to be accurate to more than 8 bits (e0 < 2^-8). A Newton-Raphson step
+     * Pi+1 = Pi * (2 - D * Pi) squares the relative error of the reciprocal and adds the rounding errors of its
+     * multiplications and the subtraction (< 3u), so after two steps, the reciprocal P2 has an error of
+     * e2 < e0^4 + 3u < 2^-22.
+     *
+     * The quotient estimate Q0 = N * P2 then has an error of e2 + u < 2^-21, i.e. of a few ULP. The product Q0 * D is
+     * rounded with an error of at most u * |N|, the following subtraction from N is exact (Sterbenz lemma), since
+     * Q0 * D is close to N. Thus the residual R = N - Q0 * D is off by at most u * |N| (a fused multiply-add would
+     * calculate it exactly) and R * P2 is off by u * |N / D| < 1 ULP of the quotient. The remaining errors of R * P2
+     * (e2 and the rounding of the product, both relative to a correction of a few ULP) are negligible. Together with
+     * the final rounding of Q1 = Q0 + R * P2 (1/2 ULP), the error is below 1.5 ULP, which is within the 2.5 ULP
+     * required by the OpenCL specification for single precision division.
+     *
+     * NOTE: This does not hold for results or reciprocals in the denormal range, which are flushed to zero by the QPU.
+     *
+     * A Goldschmidt iteration has the same convergence, but accumulates the rounding errors of both the nominator and
+     * the divisor series and therefore would also need the final correction step.
+     */
 
     // 1. initialization step: P0 = SFU_RECIP(D)
     /*
@@ -606,7 +775,7 @@ InstructionWalker intermediate::intrinsifyFloatingDivision(Method& method, Instr
     const Value const2(Literal(2.0f), TYPE_FLOAT);
 
     // 2. iteration step: Pi+1 = Pi(2 - D * Pi)
-    // run 5 iterations
+    // run 2 iterations
     const Value P1 = method.addNewLocal(op.getOutput()->type, "%fdiv_p1");
     const Value P1_1 = method.addNewLocal(op.getOutput()->type, "%fdiv_p1");
     const Value P1_2 = method.addNewLocal(op.getOutput()->type, "%fdiv_p1");
@@ -627,40 +796,22 @@ InstructionWalker intermediate::intrinsifyFloatingDivision(Method& method, Instr
     it.emplace(new Operation(OP_FMUL, P2_2, P1_2, P2_1));
     it.nextInBlock();
 
-    const Value P3 = method.addNewLocal(op.getOutput()->type, "%fdiv_p3");
-    const Value P3_1 = method.addNewLocal(op.getOutput()->type, "%fdiv_p3");
-    const Value P3_2 = method.addNewLocal(op.getOutput()->type, "%fdiv_p3");
-    it.emplace(new Operation(OP_FMUL, P3, divisor, P2_2));
-    it.nextInBlock();
-    it.emplace(new Operation(OP_FSUB, P3_1, const2, P3));
-    it.nextInBlock();
-    it.emplace(new Operation(OP_FMUL, P3_2, P2_2, P3_1));
-    it.nextInBlock();
-
-    const Value P4 = method.addNewLocal(op.getOutput()->type, "%fdiv_p4");
-    const Value P4_1 = method.addNewLocal(op.getOutput()->type, "%fdiv_p4");
-    const Value P4_2 = method.addNewLocal(op.getOutput()->type, "%fdiv_p4");
-    it.emplace(new Operation(OP_FMUL, P4, divisor, P3_2));
-    it.nextInBlock();
-    it.emplace(new Operation(OP_FSUB, P4_1, const2, P4));
-    it.nextInBlock();
-    it.emplace(new Operation(OP_FMUL, P4_2, P3_2, P4_1));
+    // 3. quotient estimate: Q0 = P2 * N
+    const Value Q0 = method.addNewLocal(op.getOutput()->type, "%fdiv_q0");
+    it.emplace(new Operation(OP_FMUL, Q0, nominator, P2_2));
     it.nextInBlock();
 
-    const Value P5 = method.addNewLocal(op.getOutput()->type, "%fdiv_p5");
-    const Value P5_1 = method.addNewLocal(op.getOutput()->type, "%fdiv_p5");
-    const Value P5_2 = method.addNewLocal(op.getOutput()->type, "%fdiv_p5");
-    it.emplace(new Operation(OP_FMUL, P5, divisor, P4_2));
+    // 4. correction step: R = N - Q0 * D, Q1 = Q0 + R * P2
+    const Value R = method.addNewLocal(op.getOutput()->type, "%fdiv_r");
+    const Value R_1 = method.addNewLocal(op.getOutput()->type, "%fdiv_r");
+    const Value R_2 = method.addNewLocal(op.getOutput()->type, "%fdiv_r");
+    it.emplace(new Operation(OP_FMUL, R, Q0, divisor));
     it.nextInBlock();
-    it.emplace(new Operation(OP_FSUB, P5_1, const2, P5));
+    it.emplace(new Operation(OP_FSUB, R_1, nominator, R));
     it.nextInBlock();
-    it.emplace(new Operation(OP_FMUL, P5_2, P4_2, P5_1));
+    it.emplace(new Operation(OP_FMUL, R_2, R_1, P2_2));
     it.nextInBlock();
-
-    // TODO add a 6th step? Sometimes the float-division is too inaccurate
-
-    // 3. final step: Q = Pn * N
-    it.reset(new Operation(OP_FMUL, op.getOutput().value(), nominator, P5_2));
+    it.reset(new Operation(OP_FADD, op.getOutput().value(), Q0, R_2));
 
     return it;
 }
@@ -18,12 +18,33 @@ namespace vc4c
         bool canOptimizeMultiplicationWithBinaryMethod(const IntrinsicOperation& op);
         InstructionWalker intrinsifyUnsignedIntegerMultiplication(
             Method& method, InstructionWalker it, IntrinsicOperation& op);
+        /*
+         * Intrinsifies a multiplication where one operand (the second if secondIsSmall is set, the first otherwise) is
+         * known to fit into an unsigned 24-bit integer, using only two mul24 instructions.
+         *
+         * This works for signed and unsigned multiplications, since the lower 32 bits of the product are the same.
+         */
+        InstructionWalker intrinsifyIntegerMultiplicationWith24BitOperand(
+            Method& method, InstructionWalker it, IntrinsicOperation& op, bool secondIsSmall);
         InstructionWalker intrinsifyIntegerMultiplicationViaBinaryMethod(
             Method& method, InstructionWalker it, IntrinsicOperation& op);
-        InstructionWalker intrinsifySignedIntegerDivision(
-            Method& method, InstructionWalker it, IntrinsicOperation& op, bool useRemainder = false);
+        /*
+         * Intrinsifies a signed division or remainder. If useReciprocal is set, the absolute values of both operands
+         * need to be in the range supported by intrinsifyIntegerDivisionViaReciprocal
+         */
+        InstructionWalker intrinsifySignedIntegerDivision(Method& method, InstructionWalker it, IntrinsicOperation& op,
+            bool useRemainder = false, bool useReciprocal = false);
         InstructionWalker intrinsifyUnsignedIntegerDivision(
             Method& method, InstructionWalker it, IntrinsicOperation& op, bool useRemainder = false);
+        /*
+         * Intrinsifies an unsigned division or remainder via the floating-point reciprocal of the divisor, followed by
+         * an integer correction step.
+         *
+         * NOTE: Both operands need to be known to be within [0, 2^23), which leaves enough headroom for the
+         * intermediate quotient estimates to fit into the 24-bit operands of mul24
+         */
+        InstructionWalker intrinsifyIntegerDivisionViaReciprocal(
+            Method& method, InstructionWalker it, IntrinsicOperation& op, bool useRemainder = false);
         InstructionWalker intrinsifySignedIntegerDivisionByConstant(
             Method& method, InstructionWalker it, IntrinsicOperation& op, bool useRemainder = false);
         InstructionWalker intrinsifyUnsignedIntegerDivisionByConstant(
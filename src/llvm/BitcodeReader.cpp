@@ -8,6 +8,7 @@
 
 #ifdef USE_LLVM_LIBRARY
 
+#include "../BackgroundWorker.h"
 #include "../intermediate/IntermediateInstruction.h"
 #include "../intrinsics/Images.h"
 #include "log.h"
@@ -71,35 +72,69 @@ static void dumpLLVM(const T* val)
 #endif
 }
 
-BitcodeReader::BitcodeReader(std::istream& stream, SourceType sourceType) : context()
+static std::unique_ptr<llvm::MemoryBuffer> readInput(
+    std::istream& stream, const Optional<std::string>& inputFile, bool requiresNullTerminator)
 {
+    if(inputFile)
+    {
+        // this memory-maps the file (if large enough) instead of copying its content
+#if LLVM_LIBRARY_VERSION >= 130
+        auto buffer = llvm::MemoryBuffer::getFile(inputFile.value(), false, requiresNullTerminator);
+#else
+        auto buffer = llvm::MemoryBuffer::getFile(inputFile.value(), -1, requiresNullTerminator);
+#endif
+        if(buffer)
+            return std::move(buffer.get());
+        logging::warn() << "Failed to read input file '" << inputFile.value()
+                        << "', falling back to reading from stream: " << buffer.getError().message() << logging::endl;
+    }
     // required, since LLVM cannot read from std::istreams
     const std::string tmp((std::istreambuf_iterator<char>(stream)), (std::istreambuf_iterator<char>()));
-    std::unique_ptr<llvm::MemoryBuffer> buf(llvm::MemoryBuffer::getMemBuffer(llvm::StringRef(tmp)));
+    return llvm::MemoryBuffer::getMemBufferCopy(tmp);
+}
+
+BitcodeReader::BitcodeReader(std::istream& stream, SourceType sourceType, const Optional<std::string>& inputFile) :
+    context(new llvm::LLVMContext())
+{
     if(sourceType == SourceType::LLVM_IR_BIN)
     {
         logging::debug() << "Reading LLVM module from bit-code..." << logging::endl;
-        auto expected = llvm::parseBitcodeFile(buf->getMemBufferRef(), context);
+        // the module takes ownership of the buffer, since the function bodies are read from it on demand
+        // NOTE: Function bodies are only materialized when they are reached by #parseFunction()
+#if LLVM_LIBRARY_VERSION >= 40
+        auto expected = llvm::getOwningLazyBitcodeModule(readInput(stream, inputFile, false), *context);
         if(!expected)
         {
-#if LLVM_LIBRARY_VERSION >= 40
             throw std::system_error(llvm::errorToErrorCode(expected.takeError()), "Error parsing LLVM module");
+        }
 #else
+        auto expected = llvm::getLazyBitcodeModule(readInput(stream, inputFile, false), *context);
+        if(!expected)
+        {
             throw std::system_error(expected.getError(), "Error parsing LLVM module");
-#endif
         }
+#endif
         else
         {
             // expected.get() is either std::unique_ptr<llvm::Module> or llvm::Module*
             std::unique_ptr<llvm::Module> tmp(std::move(expected.get()));
             llvmModule.swap(tmp);
         }
+        // the module-level meta-data (e.g. the list of kernels for older LLVM versions) is not loaded lazily
+#if LLVM_LIBRARY_VERSION >= 40
+        if(auto error = llvmModule->materializeMetadata())
+            throw std::system_error(llvm::errorToErrorCode(std::move(error)), "Error parsing LLVM module meta-data");
+#else
+        if(auto error = llvmModule->materializeMetadata())
+            throw std::system_error(error, "Error parsing LLVM module meta-data");
+#endif
     }
     else if(sourceType == SourceType::LLVM_IR_TEXT)
     {
         logging::debug() << "Reading LLVM module from IR..." << logging::endl;
+        auto buf = readInput(stream, inputFile, true);
         llvm::SMDiagnostic error;
-        llvmModule = llvm::parseIR(buf->getMemBufferRef(), error, context);
+        llvmModule = llvm::parseIR(buf->getMemBufferRef(), error, *context);
         if(!llvmModule)
             throw CompilationError(CompilationStep::PARSER, "Error parsing LLVM IR module", error.getMessage());
     }
@@ -108,6 +143,15 @@ BitcodeReader::BitcodeReader(std::istream& stream, SourceType sourceType) : cont
             std::to_string(static_cast<unsigned>(sourceType)));
 }
 
+BitcodeReader::BitcodeReader(std::unique_ptr<llvm::LLVMContext>&& context, std::unique_ptr<llvm::Module>&& module) :
+    context(std::move(context)), llvmModule(std::move(module))
+{
+    if(!this->context || !llvmModule)
+        throw CompilationError(CompilationStep::PARSER, "No LLVM module given to read from");
+    logging::debug() << "Reading in-memory LLVM module '" << llvmModule->getModuleIdentifier() << "'..."
+                     << logging::endl;
+}
+
 #if LLVM_LIBRARY_VERSION >= 39 /* Function meta-data was introduced in LLVM 3.9 */
 static void extractKernelMetadata(
     Method& kernel, const llvm::Function& func, const llvm::Module& llvmModule, const llvm::LLVMContext& context)
@@ -451,20 +495,23 @@ void BitcodeReader::parse(Module& module)
         {
             logging::debug() << "Found SPIR kernel-function: " << func.getName() << logging::endl;
             Method& kernelFunc = parseFunction(module, func);
-            extractKernelMetadata(kernelFunc, func, *llvmModule.get(), context);
+            extractKernelMetadata(kernelFunc, func, *llvmModule.get(), *context);
             kernelFunc.isKernel = true;
         }
     }
 
     // map instructions to intermediate representation
-    for(auto& method : parsedFunctions)
-    {
+    // all types, constants and globals are already resolved while parsing, so the functions can be mapped in parallel
+    using ParsedFunction = decltype(parsedFunctions)::value_type;
+    const auto mapFunction = [](const ParsedFunction& method) -> void {
         logging::debug() << "Mapping function '" << method.second.first->name << "'..." << logging::endl;
-        for(LLVMInstructionList::value_type& inst : method.second.second)
+        for(const LLVMInstructionList::value_type& inst : method.second.second)
         {
             inst->mapInstruction(*method.second.first);
         }
-    }
+    };
+    BackgroundWorker::scheduleAll<ParsedFunction, decltype(parsedFunctions)>(
+        parsedFunctions, mapFunction, "LLVM Mapper");
 }
 
 static DataType& addToMap(DataType&& dataType, const llvm::Type* type, FastMap<const llvm::Type*, DataType>& typesMap)
@@ -619,6 +666,23 @@ static std::string toParameterName(const llvm::Argument& arg, unsigned& counter)
     return std::string("%") + arg.getName().str();
 }
 
+static void materializeFunction(const llvm::Function& func)
+{
+    if(!func.isMaterializable())
+        return;
+    logging::debug() << "Materializing function body of: " << func.getName() << logging::endl;
+    // materializing only reads the body of the already existing function object from the lazily loaded module
+    auto& function = const_cast<llvm::Function&>(func);
+#if LLVM_LIBRARY_VERSION >= 40
+    if(auto error = function.materialize())
+        throw CompilationError(
+            CompilationStep::PARSER, "Error reading LLVM function body", llvm::toString(std::move(error)));
+#else
+    if(auto error = function.materialize())
+        throw CompilationError(CompilationStep::PARSER, "Error reading LLVM function body", error.message());
+#endif
+}
+
 Method& BitcodeReader::parseFunction(Module& module, const llvm::Function& func)
 {
     auto it = parsedFunctions.find(&func);
@@ -655,6 +719,7 @@ Method& BitcodeReader::parseFunction(Module& module, const llvm::Function& func)
         localMap[&arg] = &method->parameters.back();
     }
 
+    materializeFunction(func);
     parseFunctionBody(module, *method, parsedFunctions.at(&func).second, func);
 
     return *method;
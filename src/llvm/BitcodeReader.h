@@ -38,14 +38,27 @@ namespace vc4c
         class BitcodeReader final : public Parser
         {
         public:
-            explicit BitcodeReader(std::istream& stream, SourceType sourceType);
+            /*
+             * Reads the LLVM module from the given stream, or - if specified - the given input file.
+             *
+             * For LLVM bit-code input, the functions are loaded lazily, only the bodies of functions actually used by
+             * any kernel are read.
+             */
+            explicit BitcodeReader(
+                std::istream& stream, SourceType sourceType, const Optional<std::string>& inputFile = {});
+            /*
+             * Reads an already loaded LLVM module, e.g. as created by the in-process pre-compilation.
+             *
+             * NOTE: The module needs to be created within the given context, which is kept alive by this reader.
+             */
+            BitcodeReader(std::unique_ptr<llvm::LLVMContext>&& context, std::unique_ptr<llvm::Module>&& module);
             ~BitcodeReader() override = default;
 
             void parse(Module& module) override;
 
         private:
             //"the lifetime of the LLVMContext needs to outlast the module"
-            llvm::LLVMContext context;
+            std::unique_ptr<llvm::LLVMContext> context;
             std::unique_ptr<llvm::Module> llvmModule;
             FastMap<const llvm::Function*, std::pair<Method*, LLVMInstructionList>> parsedFunctions;
             FastMap<const llvm::Value*, const Local*> localMap;
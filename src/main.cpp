@@ -64,6 +64,10 @@ static void printHelp()
               << "\tThe maximum depth of nested loops to move constants out of" << std::endl;
     std::cout << "\t--foptimization-iterations=" << defaultConfig.additionalOptions.maxOptimizationIterations
               << "\tThe maximum number of iterations to repeat the optimizations in" << std::endl;
+    std::cout << "\t--fspirv-optimizer-timeout=" << defaultConfig.additionalOptions.spirvOptimizerTimeout
+              << "\tThe maximum time (in ms) to run the SPIRV-Tools optimizations for, 0 disables them" << std::endl;
+    std::cout << "\t--fmax-unroll-factor=" << defaultConfig.additionalOptions.maxUnrollFactor
+              << "\tThe maximum number of copies of a loop body created by unrolling the loop" << std::endl;
 
     std::cout << "options:" << std::endl;
     std::cout << "\t--kernel-info\t\tWrite the kernel-info meta-data (as required by VC4CL run-time, default)"
@@ -72,6 +76,14 @@ static void printHelp()
     std::cout << "\t--spirv\t\t\tExplicitely use the SPIR-V front-end" << std::endl;
     std::cout << "\t--llvm\t\t\tExplicitely use the LLVM-IR front-end" << std::endl;
     std::cout << "\t--disassemble\t\tDisassembles the binary input to either hex or assembler output" << std::endl;
+    std::cout << "\t--specialize=<kernel>[,name=<name>][,arg<index>=<value>][,local=<x>x<y>x<z>][,global=<x>x<y>x<z>]"
+              << std::endl
+              << "\t\t\t\tAdditionally generates a variant of the kernel with the given argument values and "
+                 "work-sizes fixed"
+              << std::endl;
+    std::cout << "\t--server <socket>\tRuns as resident compilation server on the given UNIX socket, the flags and "
+                 "options given are applied to all compilations. Runs until SIGTERM or SIGINT is received"
+              << std::endl;
     std::cout << "\tany other option is passed to the pre-compiler" << std::endl;
 }
 
@@ -149,8 +161,15 @@ int main(int argc, char** argv)
     std::string outputFile;
     std::string options;
     bool runDisassembler = false;
+    std::string serverSocket;
+
+    for(int k = 1; k < argc - 1; ++k)
+    {
+        if(strcmp("--server", argv[k]) == 0)
+            serverSocket = argv[k + 1];
+    }
 
-    if(argc < 3)
+    if(argc < 3 && serverSocket.empty())
     {
         for(int i = 1; i < argc; ++i)
         {
@@ -171,7 +190,9 @@ int main(int argc, char** argv)
     }
 
     int i = 1;
-    for(; i < argc - 2; ++i)
+    // in server mode, there are no input and output files
+    const int lastOption = serverSocket.empty() ? argc - 2 : argc;
+    for(; i < lastOption; ++i)
     {
         // flags
         if(strcmp("--help", argv[i]) == 0 || strcmp("-h", argv[i]) == 0)
@@ -205,6 +226,9 @@ int main(int argc, char** argv)
         }
         else if(strcmp("--disassemble", argv[i]) == 0)
             runDisassembler = true;
+        else if(strcmp("--server", argv[i]) == 0)
+            // socket path is already read above
+            ++i;
         else if(strcmp("-o", argv[i]) == 0)
         {
             outputFile = argv[i + 1];
@@ -229,6 +253,11 @@ int main(int argc, char** argv)
     }
     setLogger(logStream, colorLog, minLevel);
 
+    if(!serverSocket.empty())
+    {
+        return vc4c::tools::runCompilationServer(serverSocket, config, options);
+    }
+
     if(inputFiles.empty())
     {
         std::cerr << "No input file(s) specified, aborting!" << std::endl;
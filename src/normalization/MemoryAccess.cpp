@@ -10,6 +10,7 @@
 #include "../InstructionWalker.h"
 #include "../Module.h"
 #include "../Profiler.h"
+#include "../analysis/ControlFlowGraph.h"
 #include "../analysis/ValueRange.h"
 #include "../intermediate/Helper.h"
 #include "../intermediate/IntermediateInstruction.h"
@@ -1046,7 +1047,8 @@ static Optional<Value> getConstantValue(const MemoryInstruction* mem)
  * Tries to convert the array-type pointed to by the given local to a vector-type to fit into a single register.
  *
  * For this conversion to succeed, the array-element type must be a scalar of bit-width <= 32-bit and the size of the
- * array known to be less or equals to 16.
+ * array known to be less or equals to 16. Multi-dimensional private arrays (e.g. int[4][4]) are flattened, since
+ * their elements are stored contiguously and the byte-offset of an element maps directly to the flattened index.
  */
 static Optional<DataType> convertSmallArrayToRegister(const Local* local)
 {
@@ -1055,8 +1057,17 @@ static Optional<DataType> convertSmallArrayToRegister(const Local* local)
     {
         const auto& baseType = base->type.getPointerType().value()->elementType;
         auto arrayType = baseType.getArrayType();
-        if(arrayType && arrayType.value()->size <= NATIVE_VECTOR_SIZE && arrayType.value()->elementType.isScalarType())
-            return arrayType.value()->elementType.toVectorType(static_cast<uint8_t>(arrayType.value()->size));
+        if(!arrayType)
+            return {};
+        unsigned numElements = arrayType.value()->size;
+        DataType elementType = arrayType.value()->elementType;
+        while(base->is<StackAllocation>() && elementType.getArrayType() && numElements <= NATIVE_VECTOR_SIZE)
+        {
+            numElements *= elementType.getArrayType().value()->size;
+            elementType = elementType.getArrayType().value()->elementType;
+        }
+        if(numElements <= NATIVE_VECTOR_SIZE && elementType.isScalarType())
+            return elementType.toVectorType(static_cast<uint8_t>(numElements));
     }
     return {};
 }
@@ -1088,6 +1099,225 @@ static InstructionWalker lowerReadWriteOfMemoryToRegister(InstructionWalker it,
         CompilationStep::NORMALIZER, "Unhandled case of lowering memory access to register", mem->to_string());
 }
 
+// the maximum number of registers a single stack allocation is split into
+static constexpr std::size_t MAX_SCALAR_REPLACEMENT_ELEMENTS = 16;
+
+static Optional<int32_t> getConstantOffset(const Value& val)
+{
+    if(auto lit = val.getLiteralValue())
+        return lit->signedInt();
+    return findOffset(val).offset;
+}
+
+/*
+ * Determines the offset (in bytes) of the given pointer relative to the given stack allocation, if it is a
+ * compile-time constant.
+ *
+ * Only moves and additions of constant offsets starting at the stack allocation are followed.
+ */
+static Optional<int32_t> findConstantByteOffset(const Value& pointer, const Local* allocation, unsigned depth = 0)
+{
+    if(pointer.hasLocal(allocation))
+        return 0;
+    if(!pointer.hasLocal() || depth > 16)
+        return {};
+    const LocalUser* writer = nullptr;
+    for(const LocalUser* user : pointer.local()->getUsers(LocalUse::Type::WRITER))
+    {
+        // for stores, the store itself is also a write instruction
+        if(dynamic_cast<const MemoryInstruction*>(user) != nullptr)
+            continue;
+        if(writer != nullptr)
+            return {};
+        writer = user;
+    }
+    if(writer == nullptr || writer->hasConditionalExecution())
+        return {};
+    auto move = dynamic_cast<const MoveOperation*>(writer);
+    if(move != nullptr && dynamic_cast<const VectorRotation*>(writer) == nullptr)
+        return findConstantByteOffset(move->getSource(), allocation, depth + 1);
+    auto op = dynamic_cast<const Operation*>(writer);
+    if(op == nullptr || op->op != OP_ADD || !op->getSecondArg())
+        return {};
+    const Value& arg0 = op->getFirstArg();
+    const Value& arg1 = op->getSecondArg().value();
+    auto baseOffset = findConstantByteOffset(arg0, allocation, depth + 1);
+    auto offset = getConstantOffset(arg1);
+    if(!baseOffset || !offset)
+    {
+        baseOffset = findConstantByteOffset(arg1, allocation, depth + 1);
+        offset = getConstantOffset(arg0);
+    }
+    if(baseOffset && offset)
+        return baseOffset.value() + offset.value();
+    return {};
+}
+
+/*
+ * Determines the elements (byte-offset and type) the given stack allocation can be split into, one register per
+ * element.
+ *
+ * This is the case, if the address of the stack allocation does not escape (is only used in address calculations and
+ * as address of unconditional memory reads, writes and zero-fills) and all accessed addresses are known at
+ * compile-time. Accesses to the same element need to have the same size, partially overlapping accesses (e.g. reading
+ * a single element of a vector stored in a struct) are not supported.
+ */
+static Optional<OrderedMap<int32_t, DataType>> determineScalarReplacement(const Local* local)
+{
+    if(!local->is<StackAllocation>() || !local->type.getPointerType())
+        return {};
+    const auto contentSize = static_cast<int32_t>(local->type.getElementType().getPhysicalWidth());
+    OrderedMap<int32_t, DataType> elements;
+    // the byte-ranges zeroed by memory fills
+    std::vector<std::pair<int32_t, int32_t>> filledAreas;
+
+    FastSet<const Local*> pointers;
+    pointers.emplace(local);
+    std::vector<const Local*> pendingPointers{local};
+    while(!pendingPointers.empty())
+    {
+        const Local* pointer = pendingPointers.back();
+        pendingPointers.pop_back();
+        for(const LocalUser* user : pointer->getUsers(LocalUse::Type::READER))
+        {
+            if(dynamic_cast<const LifetimeBoundary*>(user) != nullptr)
+                continue;
+            if(auto mem = dynamic_cast<const MemoryInstruction*>(user))
+            {
+                if(mem->hasConditionalExecution() || !mem->getNumEntries().getLiteralValue())
+                    return {};
+                const bool isRead = mem->op == MemoryOperation::READ && mem->getSource().hasLocal(pointer);
+                const bool isWrite = (mem->op == MemoryOperation::WRITE || mem->op == MemoryOperation::FILL) &&
+                    mem->getDestination().hasLocal(pointer) && !mem->getSource().hasLocal(pointer);
+                if(!isRead && !isWrite)
+                    // copies, the pointer itself is written to memory, etc.
+                    return {};
+                const auto offset = findConstantByteOffset(pointer->createReference(), local);
+                const DataType type = isRead ? mem->getDestination().type : mem->getSource().type;
+                if(!offset || (!type.isSimpleType() && !type.getPointerType()))
+                    return {};
+                const auto numEntries = mem->getNumEntries().getLiteralValue()->signedInt();
+                const auto width = static_cast<int32_t>(type.getPhysicalWidth());
+                if(offset.value() < 0 || offset.value() + numEntries * width > contentSize)
+                    return {};
+                if(mem->op == MemoryOperation::FILL)
+                {
+                    if(!mem->getSource().getLiteralValue() || mem->getSource().getLiteralValue()->unsignedInt() != 0)
+                        return {};
+                    filledAreas.emplace_back(offset.value(), offset.value() + numEntries * width);
+                    continue;
+                }
+                if(numEntries != 1)
+                    return {};
+                auto elementIt = elements.find(offset.value());
+                if(elementIt == elements.end())
+                    elements.emplace(offset.value(), type);
+                else if(elementIt->second.getPhysicalWidth() != type.getPhysicalWidth() ||
+                    elementIt->second.getVectorWidth() != type.getVectorWidth())
+                    return {};
+            }
+            else if((dynamic_cast<const MoveOperation*>(user) != nullptr &&
+                        dynamic_cast<const VectorRotation*>(user) == nullptr) ||
+                (dynamic_cast<const Operation*>(user) != nullptr &&
+                    dynamic_cast<const Operation*>(user)->op == OP_ADD))
+            {
+                // address calculation, need to check the uses of the resulting pointer too
+                if(!user->getOutput() || !user->getOutput()->hasLocal())
+                    return {};
+                if(pointers.emplace(user->getOutput()->local()).second)
+                    pendingPointers.push_back(user->getOutput()->local());
+            }
+            else
+                // the address is used otherwise, e.g. passed to a function or compared
+                return {};
+        }
+    }
+
+    if(elements.empty() || elements.size() > MAX_SCALAR_REPLACEMENT_ELEMENTS)
+        return {};
+    int32_t lastEnd = 0;
+    for(const auto& element : elements)
+    {
+        const auto end = element.first + static_cast<int32_t>(element.second.getPhysicalWidth());
+        if(element.first < lastEnd)
+            // partially overlapping elements
+            return {};
+        for(const auto& area : filledAreas)
+        {
+            if(element.first < area.second && end > area.first && (element.first < area.first || end > area.second))
+                // element is only partially zeroed
+                return {};
+        }
+        lastEnd = end;
+    }
+    return elements;
+}
+
+/*
+ * Splits the given stack allocation into one register per accessed element and replaces all memory accesses with
+ * moves from/to these registers ("scalar replacement of aggregates").
+ *
+ * NOTE: For this lowering, all accessed addresses need to be known at compile-time, see #determineScalarReplacement.
+ */
+static bool lowerStackAllocationToRegisters(
+    Method& method, const Local* local, FastSet<InstructionWalker>& memoryInstructions)
+{
+    auto elements = determineScalarReplacement(local);
+    if(!elements)
+        return false;
+    // check whether all accesses are covered first, so we do not need to revert any changes
+    for(auto it : memoryInstructions)
+    {
+        const MemoryInstruction* mem = it.get<const MemoryInstruction>();
+        if(!mem)
+            // instruction cannot be already converted here (either all are already converted or none)
+            throw CompilationError(
+                CompilationStep::NORMALIZER, "Invalid instruction to be lowered into register", it->to_string());
+        const Value& address = mem->op == MemoryOperation::READ ? mem->getSource() : mem->getDestination();
+        auto offset = findConstantByteOffset(address, local);
+        if(mem->op == MemoryOperation::COPY || !offset ||
+            (mem->op != MemoryOperation::FILL && elements->find(offset.value()) == elements->end()))
+            return false;
+    }
+
+    FastMap<int32_t, Value> loweredRegisters;
+    for(const auto& element : elements.value())
+        loweredRegisters.emplace(element.first, method.addNewLocal(element.second, "%lowered_stack"));
+    for(auto it : memoryInstructions)
+    {
+        const MemoryInstruction* mem = it.get<const MemoryInstruction>();
+        logging::debug() << "Splitting access to stack allocation into registers: " << mem->to_string()
+                         << logging::endl;
+        const Value& address = mem->op == MemoryOperation::READ ? mem->getSource() : mem->getDestination();
+        const auto offset = findConstantByteOffset(address, local).value();
+        if(mem->op == MemoryOperation::READ)
+            it.reset(new MoveOperation(mem->getDestination(), loweredRegisters.at(offset)));
+        else if(mem->op == MemoryOperation::WRITE)
+            it.reset(new MoveOperation(loweredRegisters.at(offset), mem->getSource()));
+        else
+        {
+            // zero all elements within the filled area
+            const auto end = offset +
+                mem->getNumEntries().getLiteralValue()->signedInt() *
+                    static_cast<int32_t>(mem->getSource().type.getPhysicalWidth());
+            for(const auto& element : elements.value())
+            {
+                if(element.first >= offset && element.first < end)
+                {
+                    it.emplace(
+                        new MoveOperation(loweredRegisters.at(element.first), Value(Literal(0u), element.second)));
+                    it.nextInBlock();
+                }
+            }
+            it.erase();
+            continue;
+        }
+        logging::debug() << "Replaced access to stack allocation '" << local->to_string() << "' with: "
+                         << it->to_string() << logging::endl;
+    }
+    return true;
+}
+
 /*
  * Lowers access to a memory location into a register.
  *
@@ -1105,6 +1335,7 @@ static bool lowerMemoryToRegister(
      * - private memory which fits into register -> map to register
      * - private memory where the type can be converted to fit into register -> map to register + index by vector
      * rotation
+     * - private memory only accessed with constant indices -> map every accessed element to its own register
      */
     auto toConvertedRegisterType = convertSmallArrayToRegister(local);
     if(type == MemoryType::QPU_REGISTER_READONLY)
@@ -1170,6 +1401,9 @@ static bool lowerMemoryToRegister(
     else if(type == MemoryType::QPU_REGISTER_READWRITE && local->is<StackAllocation>())
     {
         // need to heed all access to memory area
+        if(!local->type.isSimpleType() && lowerStackAllocationToRegisters(method, local, memoryInstructions))
+            // all accessed addresses are known, no vector rotation required
+            return true;
         if(local->type.isSimpleType())
         {
             // fits into a single register on its own, without rewriting
@@ -1250,8 +1484,11 @@ static bool lowerMemoryToRegister(
             return true;
         }
         else
-            throw CompilationError(CompilationStep::NORMALIZER,
-                "Unhandled case of lowering stack allocation to register", local->to_string());
+        {
+            logging::debug() << "Failed to split stack allocation into registers: " << local->to_string()
+                             << logging::endl;
+            return false;
+        }
     }
     else
         throw CompilationError(
@@ -1301,7 +1538,8 @@ static bool mapReadsToTMULoad(
  * NOTE: This is to be preferred over keeping the memory location in RAM
  */
 static bool lowerMemoryToVPM(Method& method, const Local* local, MemoryType type,
-    FastSet<InstructionWalker>& memoryInstructions, FastMap<const Local*, const VPMArea*>& vpmAreas)
+    FastSet<InstructionWalker>& memoryInstructions, FastMap<const Local*, const VPMArea*>& vpmAreas,
+    const FastMap<const Local*, VPMLifetime>& lifetimes)
 {
     // Need to make sure addressing is still correct!
     if(type == MemoryType::VPM_PER_QPU && !local->is<StackAllocation>())
@@ -1309,8 +1547,10 @@ static bool lowerMemoryToVPM(Method& method, const Local* local, MemoryType type
             CompilationStep::NORMALIZER, "Unhandled case of per-QPU memory buffer", local->to_string());
 
     // since the stack allocation is read-write, need to lower all access or none
-    auto vpmArea = method.vpm->addArea(
-        local, local->type.getElementType(), type == MemoryType::VPM_PER_QPU, method.metaData.getWorkGroupSize());
+    auto lifetimeIt = lifetimes.find(local);
+    auto vpmArea = method.vpm->addArea(local, local->type.getElementType(), type == MemoryType::VPM_PER_QPU,
+        method.metaData.getWorkGroupSize(),
+        lifetimeIt != lifetimes.end() ? Optional<VPMLifetime>(lifetimeIt->second) : Optional<VPMLifetime>{});
     if(vpmArea == nullptr)
         // did not fit into VPM
         return false;
@@ -1403,7 +1643,7 @@ static InstructionWalker findNextValueStore(InstructionWalker it, const Value& s
  */
 static FastMap<const Local*, MemoryAccess> determineMemoryAccess(Method& method)
 {
-    // TODO lower local/private struct-elements into VPM?! At least for single structs
+    // TODO lower local struct-elements into VPM?! At least for single structs
     logging::debug() << "Determining memory access for kernel: " << method.name << logging::endl;
     FastMap<const Local*, MemoryAccess> mapping;
     for(const auto& param : method.parameters)
@@ -1505,6 +1745,16 @@ static FastMap<const Local*, MemoryAccess> determineMemoryAccess(Method& method)
                         mapping[local].fallback =
                             local->type.isSimpleType() ? MemoryType::VPM_PER_QPU : MemoryType::RAM_READ_WRITE_VPM;
                     }
+                    else if(determineScalarReplacement(local))
+                    {
+                        logging::debug() << "Stack value '" << local->to_string()
+                                         << "' with constant access offsets will be split into registers"
+                                         << logging::endl;
+                        mapping[local].preferred = MemoryType::QPU_REGISTER_READWRITE;
+                        mapping[local].fallback = local->type.getElementType().getStructType() ?
+                            MemoryType::RAM_READ_WRITE_VPM :
+                            MemoryType::VPM_PER_QPU;
+                    }
                     else if(!local->type.getElementType().getStructType())
                     {
                         logging::debug() << "Stack value '" << local->to_string()
@@ -1578,6 +1828,145 @@ static FastMap<const Local*, MemoryAccess> determineMemoryAccess(Method& method)
     return mapping;
 }
 
+static bool isSynchronizationPoint(InstructionWalker it)
+{
+    // barrier() is implemented in the VC4CL standard-library via semaphores. At this point, the intrinsic calls are not
+    // yet replaced with the semaphore instructions
+    if(it.has<SemaphoreAdjustment>())
+        return true;
+    if(auto call = it.get<MethodCall>())
+        return call->methodName.find("vc4cl_semaphore") == 0 || call->methodName.find("barrier") != std::string::npos;
+    return false;
+}
+
+/*
+ * Determines the lifetimes of the memory areas which could be lowered into VPM.
+ *
+ * The lifetime of an area is the range of instructions (in the order of the method) between the first and the last
+ * access, extended to cover all loops containing any access. For local memory (shared between all QPUs), the lifetime
+ * is further extended up to the surrounding synchronization points, since other QPUs may execute any instruction in
+ * between at the same time.
+ *
+ * NOTE: If the order of the basic blocks does not match the control flow (e.g. jumping back without a loop), no
+ * lifetimes are determined and the VPM areas will not share any rows.
+ */
+static FastMap<const Local*, VPMLifetime> determineVPMLifetimes(
+    Method& method, const FastMap<const Local*, MemoryAccess>& memoryMapping)
+{
+    FastMap<const Local*, VPMLifetime> lifetimes;
+    FastMap<const IntermediateInstruction*, std::size_t> instructionIndices;
+    FastMap<const BasicBlock*, VPMLifetime> blockRanges;
+    std::vector<std::size_t> synchronizationPoints;
+    std::size_t index = 0;
+    for(BasicBlock& block : method)
+    {
+        const std::size_t blockStart = index;
+        for(auto it = block.begin(); !it.isEndOfBlock(); it.nextInBlock())
+        {
+            if(!it.has())
+                continue;
+            instructionIndices.emplace(it.get(), index);
+            if(isSynchronizationPoint(it))
+                synchronizationPoints.push_back(index);
+            ++index;
+        }
+        blockRanges.emplace(&block, VPMLifetime{blockStart, index == blockStart ? blockStart : index - 1});
+    }
+    if(index == 0)
+        return lifetimes;
+    const std::size_t lastIndex = index - 1;
+
+    std::vector<VPMLifetime> loopRanges;
+    for(const auto& loop : method.getCFG().findLoops())
+    {
+        VPMLifetime range{lastIndex, 0};
+        for(const CFGNode* node : loop)
+        {
+            const auto& blockRange = blockRanges.at(node->key);
+            range.firstUse = std::min(range.firstUse, blockRange.firstUse);
+            range.lastUse = std::max(range.lastUse, blockRange.lastUse);
+        }
+        loopRanges.push_back(range);
+    }
+
+    // the linear order only represents the control flow, if all backward jumps are loops
+    for(BasicBlock& block : method)
+    {
+        for(auto it = block.begin(); !it.isEndOfBlock(); it.nextInBlock())
+        {
+            auto branch = it.get<Branch>();
+            if(!branch)
+                continue;
+            const BasicBlock* target = method.findBasicBlock(branch->getTarget());
+            if(target == nullptr)
+                return lifetimes;
+            const auto sourceIndex = instructionIndices.at(branch);
+            const auto targetIndex = blockRanges.at(target).firstUse;
+            if(targetIndex <= sourceIndex &&
+                std::none_of(loopRanges.begin(), loopRanges.end(), [&](const VPMLifetime& loop) -> bool {
+                    return loop.firstUse <= targetIndex && sourceIndex <= loop.lastUse;
+                }))
+            {
+                logging::debug() << "Basic block order does not match control flow, disabling sharing of VPM areas"
+                                 << logging::endl;
+                return lifetimes;
+            }
+        }
+    }
+
+    for(const auto& pair : memoryMapping)
+    {
+        if(pair.second.preferred != MemoryType::VPM_PER_QPU && pair.second.preferred != MemoryType::VPM_SHARED_ACCESS)
+            continue;
+        VPMLifetime lifetime{lastIndex, 0};
+        for(const auto& access : pair.second.accessInstructions)
+        {
+            auto indexIt = instructionIndices.find(access.get());
+            if(indexIt == instructionIndices.end())
+                continue;
+            lifetime.firstUse = std::min(lifetime.firstUse, indexIt->second);
+            lifetime.lastUse = std::max(lifetime.lastUse, indexIt->second);
+        }
+        if(lifetime.firstUse > lifetime.lastUse)
+            // not accessed at all
+            continue;
+        bool extended = true;
+        while(extended)
+        {
+            extended = false;
+            for(const auto& loop : loopRanges)
+            {
+                if(loop.overlaps(lifetime) && (loop.firstUse < lifetime.firstUse || loop.lastUse > lifetime.lastUse))
+                {
+                    lifetime.firstUse = std::min(lifetime.firstUse, loop.firstUse);
+                    lifetime.lastUse = std::max(lifetime.lastUse, loop.lastUse);
+                    extended = true;
+                }
+            }
+        }
+        if(pair.second.preferred == MemoryType::VPM_SHARED_ACCESS)
+        {
+            std::size_t first = 0;
+            std::size_t last = lastIndex;
+            for(auto sync : synchronizationPoints)
+            {
+                if(sync < lifetime.firstUse)
+                    first = sync;
+                if(sync > lifetime.lastUse)
+                {
+                    last = sync;
+                    break;
+                }
+            }
+            lifetime = VPMLifetime{first, last};
+        }
+        logging::debug() << "Memory area '" << pair.first->to_string() << "' is live in instructions ["
+                         << lifetime.firstUse << ", " << lifetime.lastUse << "]" << logging::endl;
+        lifetimes.emplace(pair.first, lifetime);
+    }
+    return lifetimes;
+}
+
 void normalization::mapMemoryAccess(const Module& module, Method& method, const Configuration& config)
 {
     /*
@@ -1675,6 +2064,8 @@ void normalization::mapMemoryAccess(const Module& module, Method& method, const
             ++mappingIt;
     }
     // 3. lower private memory into VPM
+    // areas with disjoint lifetimes can share the same VPM rows
+    const auto vpmLifetimes = determineVPMLifetimes(method, memoryMapping);
     mappingIt = memoryMapping.begin();
     while(mappingIt != memoryMapping.end())
     {
@@ -1682,7 +2073,7 @@ void normalization::mapMemoryAccess(const Module& module, Method& method, const
         {
             // TODO could optimize by preferring the private buffer accessed more often to be in VPM
             if(lowerMemoryToVPM(method, mappingIt->first, MemoryType::VPM_PER_QPU, mappingIt->second.accessInstructions,
-                   vpmMappedLocals))
+                   vpmMappedLocals, vpmLifetimes))
                 mappingIt = memoryMapping.erase(mappingIt);
             else
             {
@@ -1702,7 +2093,7 @@ void normalization::mapMemoryAccess(const Module& module, Method& method, const
         {
             // TODO could optimize by preferring the local buffer accessed more often to be in VPM
             if(lowerMemoryToVPM(method, mappingIt->first, MemoryType::VPM_SHARED_ACCESS,
-                   mappingIt->second.accessInstructions, vpmMappedLocals))
+                   mappingIt->second.accessInstructions, vpmMappedLocals, vpmLifetimes))
                 mappingIt = memoryMapping.erase(mappingIt);
             else
             {
@@ -1740,6 +2131,7 @@ void normalization::mapMemoryAccess(const Module& module, Method& method, const
     }
 
     combineVPMAccess(affectedBlocks, method);
+    method.vpm->dumpUsage();
 
     // TODO move calculation of stack/global indices in here too?
 
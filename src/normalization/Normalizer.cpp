@@ -20,6 +20,7 @@
 #include "LiteralValues.h"
 #include "MemoryAccess.h"
 #include "Rewrite.h"
+#include "Specializer.h"
 
 #include "log.h"
 
@@ -127,7 +128,16 @@ void Normalizer::normalize(Module& module) const
         PROFILE_COUNTER_WITH_PREV(vc4c::profiler::COUNTER_NORMALIZATION + 5, "Inline (after)",
             kernel.countInstructions(), vc4c::profiler::COUNTER_NORMALIZATION + 4);
     }
-    // 3. run other normalization steps on kernel functions
+    // 3. create specialized kernel variants (if any), before they get normalized themselves
+    if(!config.kernelSpecializations.empty())
+    {
+        logging::debug() << logging::endl;
+        logging::debug() << "Running pass: SpecializeKernels" << logging::endl;
+        PROFILE_START(SpecializeKernels);
+        specializeKernels(module, config);
+        PROFILE_END(SpecializeKernels);
+    }
+    // 4. run other normalization steps on kernel functions
     const auto f = [&module, this](Method* kernelFunc) -> void { normalizeMethod(module, *kernelFunc); };
     BackgroundWorker::scheduleAll<Method*>(module.getKernels(), f, "Normalization");
 }
@@ -23,11 +23,14 @@ static RegisterFile getFixedRegisterFile(const Value& val)
         return RegisterFile::PHYSICAL_B;
     else if(val.hasLocal())
     {
-        for(const auto& user : val.local()->getUsers())
+        for(const LocalUser* user : val.local()->getUsers(LocalUse::Type::READER))
         {
-            if(user.second.readsLocal() && user.first->hasUnpackMode())
+            if(user->hasUnpackMode())
                 return RegisterFile::PHYSICAL_A;
-            if(user.second.writesLocal() && user.first->hasPackMode())
+        }
+        for(const LocalUser* user : val.local()->getUsers(LocalUse::Type::WRITER))
+        {
+            if(user->hasPackMode())
                 return RegisterFile::PHYSICAL_A;
         }
     }
@@ -0,0 +1,148 @@
+/*
+ * Author: doe300
+ *
+ * See the file "LICENSE" for the full license governing this code.
+ */
+
+#include "Specializer.h"
+
+#include "../InstructionWalker.h"
+#include "../Module.h"
+#include "../intermediate/IntermediateInstruction.h"
+#include "log.h"
+
+#include <algorithm>
+
+using namespace vc4c;
+using namespace vc4c::normalization;
+
+static Literal toArgumentValue(const Parameter& param, uint32_t value)
+{
+    const unsigned numBits = param.type.getScalarBitCount();
+    if(numBits >= 32)
+        return Literal(value);
+    // the value is passed as 32-bit integer, so we need to apply the sign- or zero-extension of the parameter
+    const uint32_t mask = (1u << numBits) - 1u;
+    if(has_flag(param.decorations, ParameterDecorations::SIGN_EXTEND) && (value & (1u << (numBits - 1))) != 0)
+        return Literal(value | ~mask);
+    return Literal(value & mask);
+}
+
+static void specializeKernel(Module& module, const Method& kernel, const KernelSpecialization& specialization)
+{
+    const std::string name =
+        specialization.specializedName.empty() ? kernel.name + "_specialized" : specialization.specializedName;
+    if(std::any_of(module.begin(), module.end(),
+           [&](const std::unique_ptr<Method>& method) -> bool { return method->name == name; }))
+        throw CompilationError(CompilationStep::NORMALIZER, "Name for specialized kernel is already in use", name);
+
+    for(const auto& pair : specialization.argumentValues)
+    {
+        if(pair.first >= kernel.parameters.size())
+            throw CompilationError(CompilationStep::NORMALIZER,
+                "Argument index for specialization of kernel '" + kernel.name + "' is out of bounds",
+                std::to_string(pair.first));
+        const Parameter& param = kernel.parameters.at(pair.first);
+        if(param.type.isPointerType() || param.type.getVectorWidth() != 1)
+            throw CompilationError(CompilationStep::NORMALIZER,
+                "Only scalar arguments can be bound for kernel specialization", param.to_string());
+    }
+
+    Method* specialized = new Method(module);
+    module.methods.emplace_back(specialized);
+    specialized->name = name;
+    specialized->isKernel = true;
+    specialized->returnType = kernel.returnType;
+    specialized->metaData = kernel.metaData;
+
+    // only the unbound parameters are kept, the bound ones are converted to "normal" locals
+    specialized->parameters.reserve(kernel.parameters.size());
+    for(std::size_t i = 0; i < kernel.parameters.size(); ++i)
+    {
+        const Parameter& param = kernel.parameters[i];
+        if(specialization.argumentValues.find(static_cast<unsigned>(i)) != specialization.argumentValues.end())
+            continue;
+        specialized->parameters.emplace_back(Parameter(param.name, param.type, param.decorations));
+        Parameter& copy = specialized->parameters.back();
+        copy.maxByteOffset = param.maxByteOffset;
+        copy.parameterName = param.parameterName;
+        copy.origTypeName = param.origTypeName;
+    }
+    for(const auto& pair : specialization.argumentValues)
+    {
+        const Parameter& param = kernel.parameters.at(pair.first);
+        specialized->findOrCreateLocal(param.type, param.name);
+    }
+
+    kernel.forAllInstructions([specialized](const intermediate::IntermediateInstruction* instr) -> void {
+        specialized->appendToEnd(instr->copyFor(*specialized, ""));
+    });
+
+    // set the bound arguments at the very beginning of the kernel
+    auto it = specialized->walkAllInstructions().nextInBlock();
+    for(const auto& pair : specialization.argumentValues)
+    {
+        const Parameter& param = kernel.parameters.at(pair.first);
+        const Local* loc = specialized->findLocal(param.name);
+        const Literal value = toArgumentValue(param, pair.second);
+        logging::debug() << "Binding argument " << param.to_string() << " of specialized kernel '" << name
+                         << "' to constant value " << value.to_string() << logging::endl;
+        it.emplace(new intermediate::MoveOperation(loc->createReference(), Value(value, param.type)));
+        it.nextInBlock();
+    }
+
+    for(std::size_t i = 0; i < specialization.localSizes.size(); ++i)
+    {
+        const uint32_t localSize = specialization.localSizes[i];
+        if(localSize == 0)
+            continue;
+        if(kernel.metaData.workGroupSizes[i] != 0 && kernel.metaData.workGroupSizes[i] != localSize)
+            throw CompilationError(CompilationStep::NORMALIZER,
+                "Local size for specialization does not match the required work-group size of kernel", kernel.name);
+        specialized->metaData.workGroupSizes[i] = localSize;
+    }
+    if(specialized->metaData.isWorkGroupSizeSet())
+    {
+        // for the dimensions not explicitly given, the size is 1
+        for(auto& size : specialized->metaData.workGroupSizes)
+            size = std::max(size, 1u);
+        if(specialized->metaData.getWorkGroupSize() > NUM_QPUS)
+            throw CompilationError(CompilationStep::NORMALIZER, "Local size for specialization exceeds the maximum",
+                std::to_string(specialized->metaData.getWorkGroupSize()));
+    }
+
+    for(std::size_t i = 0; i < specialization.globalSizes.size(); ++i)
+    {
+        const uint32_t globalSize = specialization.globalSizes[i];
+        if(globalSize == 0)
+            continue;
+        const uint32_t localSize = specialized->metaData.workGroupSizes[i];
+        if(localSize == 0)
+        {
+            logging::warn() << "Global size for dimension " << i << " of specialized kernel '" << name
+                            << "' is ignored, since the local size is not fixed" << logging::endl;
+            continue;
+        }
+        if(globalSize % localSize != 0)
+            throw CompilationError(CompilationStep::NORMALIZER,
+                "Global size for specialization is not a multiple of the local size", std::to_string(globalSize));
+        specialized->metaData.numGroups[i] = globalSize / localSize;
+    }
+
+    logging::info() << "Created specialized kernel '" << name << "' of '" << kernel.name << "' with "
+                    << specialization.argumentValues.size() << " bound arguments" << logging::endl;
+}
+
+void normalization::specializeKernels(Module& module, const Configuration& config)
+{
+    for(const KernelSpecialization& specialization : config.kernelSpecializations)
+    {
+        auto kernels = module.getKernels();
+        auto kernelIt = std::find_if(kernels.begin(), kernels.end(),
+            [&](const Method* kernel) -> bool { return kernel->name == specialization.kernelName; });
+        if(kernelIt == kernels.end())
+            throw CompilationError(
+                CompilationStep::NORMALIZER, "Failed to find kernel to specialize", specialization.kernelName);
+        specializeKernel(module, **kernelIt, specialization);
+    }
+}
@@ -0,0 +1,35 @@
+/*
+ * Author: doe300
+ *
+ * See the file "LICENSE" for the full license governing this code.
+ */
+
+#ifndef VC4C_SPECIALIZER_H
+#define VC4C_SPECIALIZER_H
+
+#include "config.h"
+
+namespace vc4c
+{
+    class Module;
+
+    namespace normalization
+    {
+        /*
+         * Creates the kernel variants specialized for the compile-time known values given in
+         * Configuration#kernelSpecializations.
+         *
+         * A specialized kernel is a copy of the original kernel where:
+         * - the bound arguments are removed from the parameter list and set to the fixed values instead
+         * - the fixed local sizes are set as compile-time work-group size
+         * - the fixed number of work-groups (global size / local size) is stored in the kernel meta-data
+         *
+         * The following optimizations can then fold the constants, simplify branches, etc.
+         *
+         * NOTE: This needs to be run after in-lining all functions into the kernels
+         */
+        void specializeKernels(Module& module, const Configuration& config);
+    } // namespace normalization
+} // namespace vc4c
+
+#endif /* VC4C_SPECIALIZER_H */
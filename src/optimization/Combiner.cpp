@@ -7,6 +7,7 @@
 #include "Combiner.h"
 
 #include "../InstructionWalker.h"
+#include "../analysis/DependencyGraph.h"
 #include "../intermediate/Helper.h"
 #include "log.h"
 
@@ -410,9 +411,96 @@ static const std::vector<MergeCondition> mergeConditions = {
         return true;
     }};
 
+/*
+ * Replaces the instruction at the first position with the combination of both instructions and removes the second
+ * instruction. Returns whether the instructions could be combined.
+ */
+static bool combineInstructions(InstructionWalker it, InstructionWalker nextIt)
+{
+    Operation* op = it.get<Operation>();
+    MoveOperation* move = it.get<MoveOperation>();
+    Operation* nextOp = nextIt.get<Operation>();
+    MoveOperation* nextMove = nextIt.get<MoveOperation>();
+    // move supports both ADD and MUL ALU
+    // if merge, make "move" to other op-code or x x / v8max x x
+    if(op != nullptr && nextOp != nullptr)
+    {
+        it.reset(
+            new CombinedOperation(dynamic_cast<Operation*>(it.release()), dynamic_cast<Operation*>(nextIt.release())));
+        nextIt.erase();
+    }
+    else if(op != nullptr && nextMove != nullptr)
+    {
+        Operation* newMove = nextMove->combineWith(op->op);
+        if(newMove != nullptr)
+        {
+            it.reset(new CombinedOperation(dynamic_cast<Operation*>(it.release()), newMove));
+            nextIt.erase();
+        }
+        else
+            logging::warn() << "Error combining move-operation '" << nextMove->to_string()
+                            << "' with: " << op->to_string() << logging::endl;
+    }
+    else if(move != nullptr && nextOp != nullptr)
+    {
+        Operation* newMove = move->combineWith(nextOp->op);
+        if(newMove != nullptr)
+        {
+            it.reset(new CombinedOperation(newMove, dynamic_cast<Operation*>(nextIt.release())));
+            nextIt.erase();
+        }
+        else
+            logging::warn() << "Error combining move-operation '" << move->to_string()
+                            << "' with: " << nextOp->to_string() << logging::endl;
+    }
+    else if(move != nullptr && nextMove != nullptr)
+    {
+        Operation* newMove0 = move->combineWith(OP_MUL24);
+        Operation* newMove1 = nextMove->combineWith(OP_ADD);
+        if(newMove0 != nullptr && newMove1 != nullptr)
+        {
+            it.reset(new CombinedOperation(newMove0, newMove1));
+            nextIt.erase();
+        }
+        else
+            logging::warn() << "Error combining move-operation '" << move->to_string()
+                            << "' with: " << nextMove->to_string() << logging::endl;
+    }
+    else
+        throw CompilationError(CompilationStep::OPTIMIZER, "Unhandled combination, type",
+            (it->to_string() + ", ") + nextIt->to_string());
+    CombinedOperation* comb = it.get<CombinedOperation>();
+    if(comb == nullptr)
+        return false;
+    // move instruction usable on both ALUs to the free ALU
+    if(comb->getFirstOp()->op.runsOnAddALU() && comb->getFirstOp()->op.runsOnMulALU())
+    {
+        OpCode code = comb->getFirstOp()->op;
+        if(comb->getSecondOP()->op.runsOnAddALU())
+            code.opAdd = 0;
+        else // by default (e.g. both run on both ALUs), map to ADD ALU
+            code.opMul = 0;
+        dynamic_cast<Operation*>(comb->op1.get())->op = code;
+        logging::debug() << "Fixing operation available on both ALUs to " << (code.opAdd == 0 ? "MUL" : "ADD")
+                         << " ALU: " << comb->op1->to_string() << logging::endl;
+    }
+    if(comb->getSecondOP()->op.runsOnAddALU() && comb->getSecondOP()->op.runsOnMulALU())
+    {
+        OpCode code = comb->getSecondOP()->op;
+        if(comb->getFirstOp()->op.runsOnMulALU())
+            code.opMul = 0;
+        else // by default (e.g. both run on both ALUs), map to MUL ALU
+            code.opAdd = 0;
+        dynamic_cast<Operation*>(comb->op2.get())->op = code;
+        logging::debug() << "Fixing operation available on both ALUs to " << (code.opAdd == 0 ? "MUL" : "ADD")
+                         << " ALU: " << comb->op2->to_string() << logging::endl;
+    }
+    return true;
+}
+
 bool optimizations::combineOperations(const Module& module, Method& method, const Configuration& config)
 {
-    // TODO can combine operation x and y if y is something like (result of x & 0xFF/0xFFFF) -> pack-mode
+    // NOTE: masking the result of an operation with 0xFF/0xFFFF is folded into pack-modes in #combinePackModes
     bool hasChanged = false;
     for(BasicBlock& bb : method)
     {
@@ -519,86 +607,10 @@ bool optimizations::combineOperations(const Module& module, Method& method, cons
 
                     if(conditionsMet)
                     {
-                        hasChanged = true;
-                        // move supports both ADD and MUL ALU
-                        // if merge, make "move" to other op-code or x x / v8max x x
                         logging::debug() << "Merging instructions " << instr->to_string() << " and "
                                          << nextInstr->to_string() << logging::endl;
-                        if(op != nullptr && nextOp != nullptr)
-                        {
-                            it.reset(new CombinedOperation(
-                                dynamic_cast<Operation*>(it.release()), dynamic_cast<Operation*>(nextIt.release())));
-                            nextIt.erase();
-                        }
-                        else if(op != nullptr && nextMove != nullptr)
-                        {
-                            Operation* newMove = nextMove->combineWith(op->op);
-                            if(newMove != nullptr)
-                            {
-                                it.reset(new CombinedOperation(dynamic_cast<Operation*>(it.release()), newMove));
-                                nextIt.erase();
-                            }
-                            else
-                                logging::warn() << "Error combining move-operation '" << nextMove->to_string()
-                                                << "' with: " << op->to_string() << logging::endl;
-                        }
-                        else if(move != nullptr && nextOp != nullptr)
-                        {
-                            Operation* newMove = move->combineWith(nextOp->op);
-                            if(newMove != nullptr)
-                            {
-                                it.reset(new CombinedOperation(newMove, dynamic_cast<Operation*>(nextIt.release())));
-                                nextIt.erase();
-                            }
-                            else
-                                logging::warn() << "Error combining move-operation '" << move->to_string()
-                                                << "' with: " << nextOp->to_string() << logging::endl;
-                        }
-                        else if(move != nullptr && nextMove != nullptr)
-                        {
-                            Operation* newMove0 = move->combineWith(OP_MUL24);
-                            Operation* newMove1 = nextMove->combineWith(OP_ADD);
-                            if(newMove0 != nullptr && newMove1 != nullptr)
-                            {
-                                it.reset(new CombinedOperation(newMove0, newMove1));
-                                nextIt.erase();
-                            }
-                            else
-                                logging::warn() << "Error combining move-operation '" << move->to_string()
-                                                << "' with: " << nextMove->to_string() << logging::endl;
-                        }
-                        else
-                            throw CompilationError(CompilationStep::OPTIMIZER, "Unhandled combination, type",
-                                (instr->to_string() + ", ") + nextInstr->to_string());
-                        if(it.get<CombinedOperation>() != nullptr)
-                        {
-                            // move instruction usable on both ALUs to the free ALU
-                            CombinedOperation* comb = it.get<CombinedOperation>();
-                            if(comb->getFirstOp()->op.runsOnAddALU() && comb->getFirstOp()->op.runsOnMulALU())
-                            {
-                                OpCode code = comb->getFirstOp()->op;
-                                if(comb->getSecondOP()->op.runsOnAddALU())
-                                    code.opAdd = 0;
-                                else // by default (e.g. both run on both ALUs), map to ADD ALU
-                                    code.opMul = 0;
-                                dynamic_cast<Operation*>(comb->op1.get())->op = code;
-                                logging::debug() << "Fixing operation available on both ALUs to "
-                                                 << (code.opAdd == 0 ? "MUL" : "ADD")
-                                                 << " ALU: " << comb->op1->to_string() << logging::endl;
-                            }
-                            if(comb->getSecondOP()->op.runsOnAddALU() && comb->getSecondOP()->op.runsOnMulALU())
-                            {
-                                OpCode code = comb->getSecondOP()->op;
-                                if(comb->getFirstOp()->op.runsOnMulALU())
-                                    code.opMul = 0;
-                                else // by default (e.g. both run on both ALUs), map to MUL ALU
-                                    code.opAdd = 0;
-                                dynamic_cast<Operation*>(comb->op2.get())->op = code;
-                                logging::debug() << "Fixing operation available on both ALUs to "
-                                                 << (code.opAdd == 0 ? "MUL" : "ADD")
-                                                 << " ALU: " << comb->op2->to_string() << logging::endl;
-                            }
-                        }
+                        if(combineInstructions(it, nextIt))
+                            hasChanged = true;
                     }
                 }
             }
@@ -609,6 +621,162 @@ bool optimizations::combineOperations(const Module& module, Method& method, cons
     return hasChanged;
 }
 
+// the maximum number of instructions an instruction is moved up to be combined with a preceding instruction
+static constexpr std::size_t MAX_PACKING_DISTANCE = 16;
+// the maximum number of instructions checked after the original position of a moved instruction for delays between
+// instructions which are shortened by moving it (e.g. the up to 8 instructions between TMU load and read)
+static constexpr std::size_t MAX_DELAY_DISTANCE = 10;
+
+/*
+ * A single instruction or a pair of instructions executed together on the ADD and MUL ALU
+ */
+using PackedSlot = std::pair<IntermediateInstruction*, IntermediateInstruction*>;
+
+static bool canBePacked(IntermediateInstruction* inst)
+{
+    return inst != nullptr &&
+        (dynamic_cast<Operation*>(inst) != nullptr || dynamic_cast<MoveOperation*>(inst) != nullptr);
+}
+
+/*
+ * Checks whether the instruction in the slot at the second index can be moved up to be executed together with the
+ * instruction in the slot at the first index without violating any dependency or required delay
+ */
+static bool canBePackedInto(const DependencyGraph& graph, const std::vector<PackedSlot>& slots,
+    const FastMap<const IntermediateInstruction*, std::size_t>& slotIndices, std::size_t first, std::size_t second)
+{
+    IntermediateInstruction* instr = slots[first].first;
+    IntermediateInstruction* nextInstr = slots[second].first;
+    Operation* op = dynamic_cast<Operation*>(instr);
+    MoveOperation* move = dynamic_cast<MoveOperation*>(instr);
+    Operation* nextOp = dynamic_cast<Operation*>(nextInstr);
+    MoveOperation* nextMove = dynamic_cast<MoveOperation*>(nextInstr);
+    if(!std::all_of(mergeConditions.begin(), mergeConditions.end(),
+           [&](const MergeCondition& cond) -> bool { return cond(op, nextOp, move, nextMove); }))
+        return false;
+    // writing the same local from both ALUs requires the local to be on an accumulator, leave this to the peep-hole
+    // combination which can check the local's usage range
+    if(instr->hasValueType(ValueType::LOCAL) && nextInstr->hasValueType(ValueType::LOCAL) &&
+        instr->getOutput()->local() == nextInstr->getOutput()->local())
+        return false;
+
+    auto getSlot = [&](const IntermediateInstruction* inst) -> std::size_t {
+        auto it = slotIndices.find(inst);
+        return it == slotIndices.end() ? 0 : it->second;
+    };
+
+    // the moved instruction must not depend on any instruction executed before or together with its new position.
+    // Also the delays to the instructions it depends on need to be kept, e.g. a local written by a directly preceding
+    // instruction can only be read if it can be forwarded via an accumulator
+    bool isValid = true;
+    graph.assertNode(nextInstr).forAllIncomingEdges(
+        [&](const DependencyNode& neighbor, const DependencyEdge& edge) -> bool {
+            const std::size_t slot = getSlot(neighbor.key);
+            if(slot >= first || (edge.data.numDelayCycles > 0 && first - slot <= edge.data.numDelayCycles))
+                isValid = false;
+            return isValid;
+        });
+    if(!isValid)
+        return false;
+
+    // removing the instruction from its original position shortens the distance between the instructions around it
+    for(std::size_t index = second + 1; index < slots.size() && index <= second + MAX_DELAY_DISTANCE; ++index)
+    {
+        for(const IntermediateInstruction* inst : {slots[index].first, slots[index].second})
+        {
+            const DependencyNode* node = inst != nullptr ? graph.findNode(inst) : nullptr;
+            if(node == nullptr)
+                continue;
+            node->forAllIncomingEdges([&](const DependencyNode& neighbor, const DependencyEdge& edge) -> bool {
+                const std::size_t slot = getSlot(neighbor.key);
+                if(neighbor.key != nextInstr && slot < second && edge.data.numDelayCycles > 0 &&
+                    index - slot > edge.data.numDelayCycles && index - slot - 1 <= edge.data.numDelayCycles)
+                    isValid = false;
+                return isValid;
+            });
+            if(!isValid)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool optimizations::packALUInstructions(const Module& module, Method& method, const Configuration& config)
+{
+    std::size_t numPacked = 0;
+    for(BasicBlock& block : method)
+    {
+        auto graph = DependencyGraph::createGraph(block);
+
+        std::vector<PackedSlot> slots;
+        slots.reserve(block.size());
+        FastMap<const IntermediateInstruction*, std::size_t> slotIndices;
+        for(auto it = block.begin().nextInBlock(); !it.isEndOfBlock(); it.nextInBlock())
+        {
+            if(!it.has())
+                continue;
+            slotIndices.emplace(it.get(), slots.size());
+            slots.emplace_back(it.get(), nullptr);
+        }
+
+        // greedily combine every instruction with the first following instruction which can be moved up to it
+        std::size_t numPackedInBlock = 0;
+        for(std::size_t first = 0; first < slots.size(); ++first)
+        {
+            if(slots[first].second != nullptr || !canBePacked(slots[first].first) ||
+                graph->findNode(slots[first].first) == nullptr)
+                continue;
+            for(std::size_t second = first + 1;
+                 second < slots.size() && second <= first + MAX_PACKING_DISTANCE; ++second)
+            {
+                if(slots[second].second != nullptr || !canBePacked(slots[second].first) ||
+                    graph->findNode(slots[second].first) == nullptr ||
+                    !canBePackedInto(*graph, slots, slotIndices, first, second))
+                    continue;
+                logging::debug() << "Packing instruction '" << slots[second].first->to_string()
+                                 << "' into: " << slots[first].first->to_string() << logging::endl;
+                slots[first].second = slots[second].first;
+                slots.erase(slots.begin() + static_cast<std::ptrdiff_t>(second));
+                slotIndices[slots[first].second] = first;
+                for(std::size_t index = second; index < slots.size(); ++index)
+                {
+                    slotIndices[slots[index].first] = index;
+                    if(slots[index].second != nullptr)
+                        slotIndices[slots[index].second] = index;
+                }
+                ++numPackedInBlock;
+                break;
+            }
+        }
+        if(numPackedInBlock == 0)
+            continue;
+
+        // re-insert the instructions in their new order, skipping the label
+        auto it = block.begin().nextInBlock();
+        while(!it.isEndOfBlock())
+        {
+            if(it.has())
+                it.release();
+            it.erase();
+        }
+        for(const PackedSlot& slot : slots)
+        {
+            InstructionWalker firstIt = block.end();
+            firstIt.emplace(slot.first);
+            if(slot.second != nullptr)
+            {
+                InstructionWalker secondIt = block.end();
+                secondIt.emplace(slot.second);
+                // if the instructions cannot be combined after all, they are still valid in this order
+                combineInstructions(firstIt, secondIt);
+            }
+        }
+        numPacked += numPackedInBlock;
+    }
+    logging::debug() << "Packed " << numPacked << " pairs of ALU instructions" << logging::endl;
+    return numPacked > 0;
+}
+
 static Optional<Literal> getSourceLiteral(InstructionWalker it)
 {
     if(it.has<LoadImmediate>() && it.get<LoadImmediate>()->type == LoadType::REPLICATE_INT32)
@@ -840,6 +1008,246 @@ bool optimizations::combineVectorRotations(const Module& module, Method& method,
     return hasChanged;
 }
 
+// the maximum number of instructions to look back for an instruction to fill the delay before a vector rotation
+static constexpr unsigned MAX_ROTATION_DELAY_DISTANCE = 8;
+
+/*
+ * Returns whether all SIMD elements of the given value are guaranteed to be the same, in which case any vector rotation
+ * of the value results in the value itself
+ */
+static bool isReplicatedValue(const Value& val, unsigned depth = 0)
+{
+    if(val.isLiteralValue() || val.hasRegister(REG_UNIFORM) || val.hasRegister(REG_QPU_NUMBER))
+        return true;
+    if(val.hasContainer())
+        return val.container().isAllSame();
+    if(!val.hasLocal() || depth > 4)
+        return false;
+    const LocalUser* writer = val.getSingleWriter();
+    if(writer == nullptr || writer->hasConditionalExecution() || writer->hasPackMode())
+        return false;
+    if(auto load = dynamic_cast<const LoadImmediate*>(writer))
+        return load->type == LoadType::REPLICATE_INT32;
+    if(dynamic_cast<const VectorRotation*>(writer) != nullptr)
+        return isReplicatedValue(dynamic_cast<const VectorRotation*>(writer)->getSource(), depth + 1);
+    if(dynamic_cast<const MoveOperation*>(writer) != nullptr || dynamic_cast<const Operation*>(writer) != nullptr)
+        return std::all_of(writer->getArguments().begin(), writer->getArguments().end(),
+            [depth](const Value& arg) -> bool { return isReplicatedValue(arg, depth + 1); });
+    return false;
+}
+
+/*
+ * Returns whether the instruction(s) at the given position write any value read by the given instruction
+ */
+static bool writesInputOf(InstructionWalker writer, const IntermediateInstruction* reader)
+{
+    bool writesInput = false;
+    writer.forAllInstructions([&](const IntermediateInstruction* instr) {
+        if(!instr->getOutput())
+            return;
+        // be conservative for registers, e.g. different names for the same accumulator r5
+        if(instr->getOutput()->hasRegister() ||
+            (instr->getOutput()->hasLocal() && reader->readsLocal(instr->getOutput()->local())))
+            writesInput = true;
+    });
+    return writesInput;
+}
+
+/*
+ * Returns the last instruction mapped to machine code before the given position within the same basic block, or the
+ * start of the block if there is no such instruction
+ */
+static InstructionWalker findPreviousMachineInstruction(InstructionWalker it)
+{
+    it.previousInBlock();
+    while(!it.isStartOfBlock() && (it.get() == nullptr || !it->mapsToASMInstruction()))
+        it.previousInBlock();
+    return it;
+}
+
+/*
+ * Returns whether the given instruction can be moved down past all instructions accessing the given locals into the
+ * delay before the given vector rotation
+ */
+static bool canBeMovedIntoDelay(InstructionWalker candidateIt, const IntermediateInstruction* rotation,
+    const FastSet<const Local*>& readLocals, const FastSet<const Local*>& writtenLocals)
+{
+    if(!(candidateIt.has<Operation>() || candidateIt.has<MoveOperation>() || candidateIt.has<LoadImmediate>()) ||
+        candidateIt.has<VectorRotation>())
+        return false;
+    if(candidateIt->hasSideEffects() || candidateIt->hasConditionalExecution() || candidateIt->hasPackMode() ||
+        candidateIt->hasUnpackMode() || !candidateIt->hasValueType(ValueType::LOCAL))
+        return false;
+    const Local* output = candidateIt->getOutput()->local();
+    if(rotation->readsLocal(output) || readLocals.find(output) != readLocals.end() ||
+        writtenLocals.find(output) != writtenLocals.end())
+        return false;
+    for(const Value& arg : candidateIt->getArguments())
+    {
+        if(!arg.hasLocal() && !arg.isLiteralValue())
+            return false;
+        if(arg.hasLocal() && writtenLocals.find(arg.local()) != writtenLocals.end())
+            return false;
+    }
+    // removing the instruction must not introduce a new read-after-write between its neighbors
+    auto previousIt = findPreviousMachineInstruction(candidateIt);
+    if(previousIt.isStartOfBlock())
+        return false;
+    auto nextIt = candidateIt.copy().nextInBlock();
+    while(!nextIt.isEndOfBlock() && (nextIt.get() == nullptr || !nextIt->mapsToASMInstruction()))
+        nextIt.nextInBlock();
+    bool createsReadAfterWrite = false;
+    nextIt.forAllInstructions([&](const IntermediateInstruction* instr) {
+        if(writesInputOf(previousIt, instr))
+            createsReadAfterWrite = true;
+    });
+    return !createsReadAfterWrite;
+}
+
+/*
+ * Removes the NOP inserted before the given vector rotation if the preceding instruction does not write the rotated
+ * value (or the rotation offset), or tries to replace it with an independent preceding instruction otherwise.
+ */
+static bool removeRotationDelay(InstructionWalker it)
+{
+    auto nopIt = it.copy().previousInBlock();
+    if(nopIt.isStartOfBlock() || !nopIt.has<Nop>() || nopIt.get<Nop>()->type != DelayType::WAIT_REGISTER ||
+        nopIt->hasSideEffects())
+        return false;
+    auto lastIt = findPreviousMachineInstruction(nopIt);
+    if(lastIt.isStartOfBlock() || lastIt.has<Nop>())
+        // the value might be written at the end of a preceding block
+        return false;
+    if(!writesInputOf(lastIt, it.get()))
+    {
+        logging::debug() << "Removing unneeded delay before vector rotation: " << it->to_string() << logging::endl;
+        nopIt.erase();
+        return true;
+    }
+    // the delay is required, try to fill it with an independent instruction
+    FastSet<const Local*> readLocals;
+    FastSet<const Local*> writtenLocals;
+    auto candidateIt = lastIt;
+    for(unsigned distance = 0; distance < MAX_ROTATION_DELAY_DISTANCE && !candidateIt.isStartOfBlock();
+        candidateIt.previousInBlock())
+    {
+        if(candidateIt.get() == nullptr)
+            continue;
+        if(candidateIt != lastIt && canBeMovedIntoDelay(candidateIt, it.get(), readLocals, writtenLocals))
+        {
+            logging::debug() << "Filling delay before vector rotation '" << it->to_string()
+                             << "' with: " << candidateIt->to_string() << logging::endl;
+            // do not yet erase, otherwise iterators are wrong
+            nopIt.reset(candidateIt.release());
+            return true;
+        }
+        if(candidateIt.has<Branch>() || candidateIt.has<BranchLabel>() || candidateIt.has<MemoryBarrier>())
+            break;
+        candidateIt.forAllInstructions([&](const IntermediateInstruction* instr) {
+            instr->forUsedLocals([&](const Local* local, LocalUse::Type type) {
+                if(has_flag(type, LocalUse::Type::READER))
+                    readLocals.emplace(local);
+                if(has_flag(type, LocalUse::Type::WRITER))
+                    writtenLocals.emplace(local);
+            });
+        });
+        ++distance;
+    }
+    return false;
+}
+
+/*
+ * Combines a vector rotation of the result of a vector rotation in another basic block into a single rotation
+ */
+static bool combineRotationsAcrossBlocks(Method& method, InstructionWalker it)
+{
+    VectorRotation* rot = it.get<VectorRotation>();
+    if(!rot->getSource().hasLocal() || !rot->getOffset().hasImmediate() ||
+        rot->getOffset().immediate() == VECTOR_ROTATE_R5 ||
+        rot->getSource().local()->getUsers(LocalUse::Type::READER).size() != 1)
+        return false;
+    const VectorRotation* firstRot = dynamic_cast<const VectorRotation*>(rot->getSource().getSingleWriter());
+    if(firstRot == nullptr || firstRot->hasSideEffects() || firstRot->hasConditionalExecution() ||
+        !firstRot->getSource().hasLocal() || !firstRot->getOffset().hasImmediate() ||
+        firstRot->getOffset().immediate() == VECTOR_ROTATE_R5)
+        return false;
+    Optional<InstructionWalker> firstIt;
+    for(BasicBlock& block : method)
+    {
+        // rotations within the same block are handled by #combineVectorRotations
+        if(&block != it.getBasicBlock() && (firstIt = block.findWalkerForInstruction(firstRot, block.end())))
+            break;
+    }
+    if(!firstIt)
+        return false;
+    // the rotated value must not change between the two rotations. This is guaranteed, if it is only written before
+    // the first rotation in the same block, since then every write is followed by the first rotation
+    const Local* source = firstRot->getSource().local();
+    const auto writers = source->getUsers(LocalUse::Type::WRITER);
+    if(writers.size() > 1 || (writers.empty() && !source->is<Parameter>()))
+        return false;
+    if(writers.size() == 1 &&
+        !firstIt->getBasicBlock()->findWalkerForInstruction(*writers.begin(), firstIt->copy().previousInBlock()))
+        return false;
+
+    const uint8_t offset = (rot->getOffset().immediate().getRotationOffset().value() +
+                               firstRot->getOffset().immediate().getRotationOffset().value()) %
+        16;
+    logging::debug() << "Combining vector rotations across blocks " << firstRot->to_string() << " and "
+                     << rot->to_string() << " to a single rotation with offset " << static_cast<unsigned>(offset)
+                     << logging::endl;
+    if(offset == 0)
+        it.reset((new MoveOperation(rot->getOutput().value(), firstRot->getSource()))->copyExtrasFrom(rot));
+    else
+        it.reset((new VectorRotation(rot->getOutput().value(), firstRot->getSource(),
+                      Value(SmallImmediate::fromRotationOffset(offset), TYPE_INT8)))
+                     ->copyExtrasFrom(rot));
+    // the NOP before the first rotation is kept, since it now separates its neighbors
+    firstIt->erase();
+    return true;
+}
+
+bool optimizations::optimizeVectorRotations(const Module& module, Method& method, const Configuration& config)
+{
+    bool hasChanged = false;
+    for(BasicBlock& block : method)
+    {
+        InstructionWalker it = block.begin();
+        while(!it.isEndOfBlock())
+        {
+            if(it.has<VectorRotation>() && !it->hasSideEffects())
+            {
+                VectorRotation* rot = it.get<VectorRotation>();
+                if(isReplicatedValue(rot->getSource()))
+                {
+                    logging::debug() << "Replacing vector rotation of replicated value with move: " << rot->to_string()
+                                     << logging::endl;
+                    it.reset((new MoveOperation(rot->getOutput().value(), rot->getSource()))->copyExtrasFrom(rot));
+                    // the move does not need the delay, but the preceding instruction might still write its input
+                    auto nopIt = it.copy().previousInBlock();
+                    auto lastIt = nopIt.isStartOfBlock() ? nopIt : findPreviousMachineInstruction(nopIt);
+                    if(nopIt.has<Nop>() && nopIt.get<Nop>()->type == DelayType::WAIT_REGISTER &&
+                        !nopIt->hasSideEffects() && !lastIt.isStartOfBlock() && !lastIt.has<Nop>() &&
+                        !writesInputOf(lastIt, it.get()))
+                        nopIt.erase();
+                    hasChanged = true;
+                }
+                else
+                {
+                    if(combineRotationsAcrossBlocks(method, it))
+                        hasChanged = true;
+                    if(it.has<VectorRotation>() && removeRotationDelay(it))
+                        hasChanged = true;
+                }
+            }
+            it.nextInBlock();
+        }
+    }
+    // remove the positions of instructions moved into delays
+    method.cleanEmptyInstructions();
+    return hasChanged;
+}
+
 InstructionWalker optimizations::combineSameFlags(
     const Module& module, Method& method, InstructionWalker it, const Configuration& config)
 {
@@ -947,3 +1355,192 @@ InstructionWalker optimizations::combineArithmeticOperations(
     it.previousInBlock();
     return it;
 }
+
+/*
+ * Returns whether the given local is already fixed to physical register-file A, since it is written with a pack-mode or
+ * read with an unpack-mode
+ */
+static bool isFixedToRegisterFileA(const Local* local)
+{
+    for(const auto& user : local->getUsers())
+    {
+        if(user.second.writesLocal() && user.first->hasPackMode())
+            return true;
+        if(user.second.readsLocal() && user.first->hasUnpackMode())
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Checks whether the given local can be fixed to physical register-file A (as required for pack/unpack modes) without
+ * introducing register conflicts which can't be resolved, e.g.:
+ * - unpacking two different locals in one instruction
+ * - reading the local together with another local also fixed to register-file A, since only one register of each
+ *   register-file can be read per instruction
+ * - rotating the local, which requires the source to be located in an accumulator
+ */
+static bool canBeFixedToRegisterFileA(const Local* local)
+{
+    for(const auto& user : local->getUsers(LocalUse::Type::READER))
+    {
+        if(dynamic_cast<const VectorRotation*>(user) != nullptr)
+            return false;
+        for(const Value& arg : user->getArguments())
+        {
+            if(!arg.hasLocal() || arg.local() == local)
+                continue;
+            if(user->hasUnpackMode() || isFixedToRegisterFileA(arg.local()))
+                return false;
+        }
+    }
+    return true;
+}
+
+static Optional<Literal> getLiteralArgument(const IntermediateInstruction* inst, const Value& other)
+{
+    for(const Value& arg : inst->getArguments())
+    {
+        if(arg != other)
+            return arg.getLiteralValue();
+    }
+    return {};
+}
+
+static InstructionWalker combinePackMode(
+    const Module& module, Method& method, InstructionWalker it, const Configuration& config)
+{
+    if(!it.has<Operation>() || it->getArguments().size() != 2)
+        return it;
+    if(it->hasSideEffects() || it->hasUnpackMode() || it->hasPackMode() || it->hasConditionalExecution() ||
+        it->doesSetFlag())
+        return it;
+    const auto op = it.get<const Operation>()->op;
+    if(op != OP_AND && op != OP_ASR)
+        return it;
+    if(!it->getOutput() || !it->getOutput()->hasLocal() || it->getOutput()->type.isFloatingType())
+        return it;
+    const Value& src = it->getArgument(0)->hasLocal() ? it->getArgument(0).value() : it->getArgument(1).value();
+    if(!src.hasLocal() || (op == OP_ASR && !it->getArgument(0)->hasLocal()))
+        return it;
+    const auto literal = getLiteralArgument(it.get(), src);
+    if(!literal)
+        return it;
+    const Value& dest = it->getOutput().value();
+
+    Pack packMode = PACK_NOP;
+    if(op == OP_AND && literal->unsignedInt() == TYPE_INT8.getScalarWidthMask())
+        packMode = PACK_INT_TO_CHAR_TRUNCATE;
+    else if(op == OP_AND && literal->unsignedInt() == TYPE_INT16.getScalarWidthMask())
+        packMode = PACK_INT_TO_SHORT_TRUNCATE;
+    else if(op != OP_ASR || literal->unsignedInt() != 16)
+        return it;
+
+    // find the single writer of the masked/shifted value within this block. Moving the write of the result up to the
+    // position of the writer is only valid, if the result is not accessed in between
+    Optional<InstructionWalker> writerIt;
+    if(src.getSingleWriter() != nullptr && src.local()->getUsers(LocalUse::Type::READER).size() == 1 &&
+        dest.getSingleWriter() == it.get())
+    {
+        auto checkIt = it.copy().previousInBlock();
+        while(!checkIt.isStartOfBlock())
+        {
+            if(checkIt.get() == src.getSingleWriter())
+            {
+                writerIt = checkIt;
+                break;
+            }
+            if(checkIt.get() && (checkIt->readsLocal(dest.local()) || checkIt->writesLocal(dest.local())))
+                break;
+            checkIt.previousInBlock();
+        }
+    }
+
+    if(writerIt)
+    {
+        auto writer = writerIt->get();
+        const Operation* writerOp = writerIt->get<const Operation>();
+        if(writer->hasSideEffects() || writer->hasUnpackMode() || writer->hasPackMode() ||
+            writer->hasConditionalExecution() || writer->doesSetFlag() || writerIt->has<VectorRotation>() ||
+            writerIt->has<CombinedOperation>())
+            return it;
+
+        // the unpacked value is read at the position of the writer, so it can't be changed in between
+        const Value& unpackSource = writer->getArgument(0).value();
+        Unpack unpackMode = UNPACK_NOP;
+        if(writerOp != nullptr && writerOp->op == OP_SHR && packMode == PACK_INT_TO_CHAR_TRUNCATE &&
+            unpackSource.hasLocal())
+        {
+            auto offset = getLiteralArgument(writer, unpackSource);
+            if(offset && offset->unsignedInt() == 8)
+                unpackMode = UNPACK_8B_32;
+            else if(offset && offset->unsignedInt() == 16)
+                unpackMode = UNPACK_8C_32;
+            else if(offset && offset->unsignedInt() == 24)
+                unpackMode = UNPACK_8D_32;
+        }
+        else if(writerOp != nullptr && writerOp->op == OP_SHL && op == OP_ASR && unpackSource.hasLocal() &&
+            writer->getArgument(1)->getLiteralValue() && writer->getArgument(1)->getLiteralValue()->unsignedInt() == 16)
+            unpackMode = UNPACK_16A_32;
+
+        if(unpackMode != UNPACK_NOP && !unpackSource.type.isFloatingType() &&
+            canBeFixedToRegisterFileA(unpackSource.local()))
+        {
+            logging::debug() << "Combining extraction of " << writer->to_string() << " and " << it->to_string()
+                             << " to unpack-mode" << logging::endl;
+            auto decorations = it->decoration;
+            if(unpackMode != UNPACK_16A_32)
+                // the byte unpack-modes zero-extend
+                decorations = add_flag(decorations, InstructionDecorations::UNSIGNED_RESULT);
+            writerIt->reset(
+                (new MoveOperation(dest, unpackSource))->setUnpackMode(unpackMode)->addDecorations(decorations));
+            it.erase();
+            // don't skip next instruction
+            it.previousInBlock();
+            return it;
+        }
+
+        // the pack-modes of physical register-file A zero the remaining bits, so the masking can be done by the writer
+        if(packMode != PACK_NOP && (writerOp != nullptr || writerIt->has<MoveOperation>()) &&
+            (writerOp == nullptr || !writerOp->op.returnsFloat) && canBeFixedToRegisterFileA(dest.local()))
+        {
+            logging::debug() << "Combining " << writer->to_string() << " and " << it->to_string() << " to pack-mode"
+                             << logging::endl;
+            writer->setOutput(dest);
+            writer->setPackMode(packMode);
+            writer->addDecorations(it->decoration);
+            it.erase();
+            // don't skip next instruction
+            it.previousInBlock();
+            return it;
+        }
+    }
+
+    if(packMode == PACK_INT_TO_CHAR_TRUNCATE && !src.type.isFloatingType() && canBeFixedToRegisterFileA(src.local()))
+    {
+        // zero-extending the lowest byte via unpack-mode saves loading the mask
+        logging::debug() << "Replacing masking of lowest byte with unpack-mode: " << it->to_string() << logging::endl;
+        it.reset((new MoveOperation(dest, src))
+                     ->setUnpackMode(UNPACK_CHAR_TO_INT_ZEXT)
+                     ->addDecorations(it->decoration)
+                     ->addDecorations(InstructionDecorations::UNSIGNED_RESULT));
+    }
+    return it;
+}
+
+bool optimizations::combinePackModes(const Module& module, Method& method, const Configuration& config)
+{
+    bool hasChanged = false;
+    auto it = method.walkAllInstructions();
+    while(!it.isEndOfMethod())
+    {
+        const IntermediateInstruction* inst = it.get();
+        auto newIt = combinePackMode(module, method, it, config);
+        // the instruction is either replaced in place or removed (and the previous instruction is returned)
+        if(newIt != it || newIt.get() != inst)
+            hasChanged = true;
+        it = newIt;
+        it.nextInMethod();
+    }
+    return hasChanged;
+}
@@ -67,6 +67,19 @@ namespace vc4c
          */
         bool combineOperations(const Module& module, Method& method, const Configuration& config);
 
+        /*
+         * Combines ALU-instructions across the whole basic block into instructions using both ALUs.
+         *
+         * In contrast to #combineOperations, which only combines directly neighboring instructions, this moves an
+         * instruction up by several instructions to be executed together with a preceding one, if the dependency graph
+         * of the basic block allows it. Moving an instruction keeps all required and recommended delays between
+         * dependent instructions. Thus a local written by the instruction directly preceding the combined instruction
+         * is only read if it can be forwarded via an accumulator.
+         * Since the register-file read-ports are shared by both ALUs, the combined instructions may only read two
+         * different inputs (including small immediate values, which occupy the read-port of physical file B).
+         */
+        bool packALUInstructions(const Module& module, Method& method, const Configuration& config);
+
         /*
          * Combines the loading of the same literal within a small range in a single basic block
          *
@@ -125,6 +138,27 @@ namespace vc4c
          */
         bool combineVectorRotations(const Module& module, Method& method, const Configuration& config);
 
+        /*
+         * Optimizes vector rotations across the whole method:
+         * - rotations of values with all elements being the same are replaced with moves
+         * - rotations of the result of a rotation in another basic block are combined, if the rotated value does not
+         *   change in between
+         * - the NOP inserted before every rotation (see #insertVectorRotation) is removed if the preceding instruction
+         *   does not write the rotated value, otherwise it is replaced with an independent preceding instruction
+         *
+         * Example:
+         *   %3 = add %1, %2
+         *   %4 = mul24 %5, %6
+         *   nop
+         *   %7 = %4 << 2
+         *
+         * is converted to:
+         *   %4 = mul24 %5, %6
+         *   %3 = add %1, %2
+         *   %7 = %4 << 2
+         */
+        bool optimizeVectorRotations(const Module& module, Method& method, const Configuration& config);
+
         /*
          * Combines successive setting of the same flag (e.g. introduced by PHI-nodes)
          *
@@ -168,6 +202,32 @@ namespace vc4c
          */
         InstructionWalker combineArithmeticOperations(
             const Module& module, Method& method, InstructionWalker it, const Configuration& config);
+
+        /*
+         * Folds the extraction of bytes and half-words into the pack- and unpack-modes of physical register-file A:
+         * - masking with 0xFF/0xFFFF is moved as pack-mode into the (single) writer of the masked value
+         * - extracting a byte at a constant offset (shift right by 8, 16 or 24 and mask with 0xFF) or sign-extending
+         *   the lower half-word (shift left and arithmetic shift right by 16) is replaced with an unpack-mode
+         * - otherwise, masking with 0xFF is replaced with a move with zero-extending unpack-mode
+         *
+         * Example:
+         *   %tmp = shr %src, %offset
+         *   %dest = and %tmp, 255
+         *
+         * becomes:
+         *   %dest = shr %src, %offset (pack 8a)
+         *
+         * Also:
+         *   %tmp = shr %src, 16
+         *   %dest = and %tmp, 255
+         *
+         * becomes:
+         *   %dest = %src (unpack 8c)
+         *
+         * NOTE: Since the packed/unpacked values are fixed to register-file A, this is only applied if it does not
+         * introduce register-conflicts which can't be resolved afterwards.
+         */
+        bool combinePackModes(const Module& module, Method& method, const Configuration& config);
     } // namespace optimizations
 } // namespace vc4c
 #endif /* COMBINER_H */
@@ -10,6 +10,8 @@
 #include "../Profiler.h"
 #include "../analysis/ControlFlowGraph.h"
 #include "../analysis/DataDependencyGraph.h"
+#include "../analysis/LivenessAnalysis.h"
+#include "../analysis/ValueRange.h"
 #include "../intermediate/Helper.h"
 #include "../intermediate/TypeConversions.h"
 #include "../normalization/LiteralValues.h"
@@ -71,6 +73,36 @@ static FastSet<Local*> findLoopIterations(const ControlFlowLoop& loop, const Dat
     return intersection;
 }
 
+/*
+ * Returns the block preceding the loop, if it is the only block entering the loop and it only continues into the loop
+ */
+static BasicBlock* findLoopPreheader(const ControlFlowLoop& loop)
+{
+    const CFGNode* preheader = nullptr;
+    bool isValid = true;
+    for(const CFGNode* node : loop)
+    {
+        node->forAllIncomingEdges([&](const CFGNode& neighbor, const CFGEdge& edge) -> bool {
+            if(std::find(loop.begin(), loop.end(), &neighbor) == loop.end())
+            {
+                if(preheader != nullptr && preheader != &neighbor)
+                    isValid = false;
+                preheader = &neighbor;
+            }
+            return isValid;
+        });
+    }
+    if(!isValid || preheader == nullptr)
+        return nullptr;
+    preheader->forAllOutgoingEdges([&](const CFGNode& neighbor, const CFGEdge& edge) -> bool {
+        if(std::find(loop.begin(), loop.end(), &neighbor) == loop.end())
+            // the block also jumps somewhere else, so we would execute the hoisted code for other paths too
+            isValid = false;
+        return isValid;
+    });
+    return isValid ? preheader->key : nullptr;
+}
+
 enum class StepKind
 {
     // step-kind is not known
@@ -83,10 +115,26 @@ enum class StepKind
     MUL_CONSTANT
 };
 
+/*
+ * A value carried over from one iteration to the next, which is accumulated with the same associative operation in
+ * every iteration, e.g. a sum or a maximum
+ */
+struct Reduction
+{
+    // the local containing the accumulated value at the start of an iteration
+    Local* accumulator;
+    // the local containing the accumulated value at the end of an iteration, assigned to the accumulator (via phi-node)
+    Local* result;
+    // the operation accumulating the values
+    intermediate::Operation* operation;
+};
+
 struct LoopControl
 {
     // the initial value for the loop iteration variable
     intermediate::IntermediateInstruction* initialization = nullptr;
+    // the constant value the iteration variable is initialized with
+    int32_t initialValue = 0;
     // the value compared with to terminate the loop
     Value terminatingValue = UNDEFINED_VALUE;
     // the local containing the current iteration-variable
@@ -103,6 +151,19 @@ struct LoopControl
     std::string comparison;
     // the vectorization-factor used
     unsigned vectorizationFactor;
+    // the number of iterations of the original loop
+    int32_t iterationCount = 0;
+    // the number of iterations executed by the vectorized loop
+    int32_t vectorIterations = 0;
+    // the number of iterations left to be executed by the scalar remainder loop
+    int32_t remainderIterations = 0;
+    // whether the loop is vectorized in place (no remainder loop required)
+    bool vectorizeInPlace = false;
+    // whether the number of iterations is only known at run-time (the bound is not a compile-time constant). The
+    // vectorized and remaining iterations are then calculated at run-time too
+    bool hasRuntimeIterationCount = false;
+    // the other loop-carried values, which are accumulated element-wise and folded after the vectorized loop
+    std::vector<Reduction> reductions;
 
     void determineStepKind(const OpCode& code)
     {
@@ -178,7 +239,22 @@ struct LoopControlHash : public std::hash<Local*>
     }
 };
 
-static LoopControl extractLoopControl(const ControlFlowLoop& loop, const DataDependencyGraph& dependencyGraph)
+/*
+ * Returns the constant value of the given value, either as literal or if its value-range only contains a single value
+ */
+static Optional<int32_t> getConstantValue(const Value& val, Method& method)
+{
+    if(val.getLiteralValue())
+        return val.getLiteralValue()->signedInt();
+    auto range = analysis::ValueRange::getValueRange(val, &method).getIntRange();
+    if(range && range->minValue == range->maxValue && range->minValue >= std::numeric_limits<int32_t>::min() &&
+        range->minValue <= std::numeric_limits<int32_t>::max())
+        return static_cast<int32_t>(range->minValue);
+    return {};
+}
+
+static LoopControl extractLoopControl(
+    Method& method, const ControlFlowLoop& loop, const DataDependencyGraph& dependencyGraph)
 {
     FastSet<LoopControl, LoopControlHash> availableLoopControls;
 
@@ -191,20 +267,35 @@ static LoopControl extractLoopControl(const ControlFlowLoop& loop, const DataDep
 
         LoopControl loopControl;
         loopControl.iterationVariable = local;
+        bool hasUnknownInitialValue = false;
 
         for(const auto& pair : local->getUsers())
         {
             const intermediate::IntermediateInstruction* inst = pair.first;
             Optional<InstructionWalker> it = loop.findInLoop(inst);
             //"lower" bound: the initial setting of the value outside of the loop
-            if(pair.second.writesLocal() && inst->hasDecoration(intermediate::InstructionDecorations::PHI_NODE) && !it)
+            if(pair.second.writesLocal() && !it)
             {
-                auto tmp = inst->precalculate(4);
-                if(tmp && tmp->isLiteralValue())
+                Optional<int32_t> initialValue;
+                if(inst->hasDecoration(intermediate::InstructionDecorations::PHI_NODE))
+                {
+                    auto tmp = inst->precalculate(4);
+                    if(tmp && tmp->getLiteralValue())
+                        initialValue = tmp->getLiteralValue()->signedInt();
+                    else if(auto move = dynamic_cast<const intermediate::MoveOperation*>(inst))
+                        // the value might not be a compile-time constant, but be known to only have a single value
+                        initialValue = getConstantValue(move->getSource(), method);
+                }
+                if(initialValue && loopControl.initialization == nullptr)
                 {
-                    logging::debug() << "Found lower bound: " << tmp->to_string() << logging::endl;
+                    logging::debug() << "Found lower bound: " << initialValue.value() << logging::endl;
                     loopControl.initialization = const_cast<intermediate::IntermediateInstruction*>(inst);
+                    loopControl.initialValue = initialValue.value();
                 }
+                else
+                    // the iteration variable is also set somewhere else outside of the loop (e.g. by a vectorized copy
+                    // of the loop executed before), so we do not know the initial value
+                    hasUnknownInitialValue = true;
             }
             // iteration step: the instruction inside the loop where the iteration variable is changed
             // XXX this currently only looks for single operations with immediate values (e.g. +1,-1)
@@ -324,6 +415,8 @@ static LoopControl extractLoopControl(const ControlFlowLoop& loop, const DataDep
                 {
                     // TODO error
                 }
+                if(!loopControl.comparisonInstruction)
+                    loopControl.comparisonInstruction = loop.findInLoop(inst);
                 if(inst->assertArgument(0).hasLocal(iterationStep.local()))
                     loopControl.terminatingValue = inst->assertArgument(1);
                 else
@@ -334,6 +427,13 @@ static LoopControl extractLoopControl(const ControlFlowLoop& loop, const DataDep
                     if(tmp && tmp->isLiteralValue())
                         loopControl.terminatingValue = tmp.value();
                 }
+                if(!loopControl.terminatingValue.isLiteralValue())
+                {
+                    auto constant = getConstantValue(loopControl.terminatingValue, method);
+                    if(constant)
+                        loopControl.terminatingValue =
+                            Value(Literal(constant.value()), loopControl.terminatingValue.type);
+                }
                 logging::debug() << "Found upper bound: " << loopControl.terminatingValue.to_string() << logging::endl;
 
                 // determine type of comparison
@@ -355,6 +455,9 @@ static LoopControl extractLoopControl(const ControlFlowLoop& loop, const DataDep
             }
         }
 
+        if(hasUnknownInitialValue)
+            loopControl.initialization = nullptr;
+
         if(loopControl.initialization && !loopControl.terminatingValue.isUndefined() && loopControl.iterationStep &&
             loopControl.repetitionJump)
         {
@@ -375,64 +478,543 @@ static LoopControl extractLoopControl(const ControlFlowLoop& loop, const DataDep
 }
 
 /*
- * For now uses a very simple algorithm:
- * - checks the maximum vector-width used inside the loop
- * - tries to find an optimal factor, which never exceeds 16 elements and divides the number of iterations equally
+ * Returns all locals written inside of the loop (including the labels of the loop's basic blocks)
  */
-static Optional<unsigned> determineVectorizationFactor(const ControlFlowLoop& loop, const LoopControl& loopControl)
+static FastSet<const Local*> findLocalsWrittenInLoop(const ControlFlowLoop& loop)
 {
-    unsigned char maxTypeWidth = 1;
-    InstructionWalker it = loop.front()->key->begin();
-    while(!it.isEndOfMethod() && it != loop.back()->key->end())
+    FastSet<const Local*> writtenLocals;
+    for(const CFGNode* node : loop)
     {
-        if(it->getOutput())
+        for(auto it = node->key->begin(); !it.isEndOfBlock(); it.nextInBlock())
         {
-            // TODO is this check enough?
-            maxTypeWidth = std::max(maxTypeWidth, it->getOutput()->type.getVectorWidth());
+            if(it.has() && it->hasValueType(ValueType::LOCAL))
+                writtenLocals.emplace(it->getOutput()->local());
         }
-        it.nextInMethod();
     }
+    return writtenLocals;
+}
 
-    logging::debug() << "Found maximum used vector-width of " << static_cast<unsigned>(maxTypeWidth) << " elements"
-                     << logging::endl;
+/*
+ * Returns the value assigned to the loop-carried local for the next iteration (by the phi-node inside of the loop)
+ */
+static Optional<Value> findNextIterationValue(const ControlFlowLoop& loop, const Local* local)
+{
+    for(const auto& pair : local->getUsers())
+    {
+        const intermediate::MoveOperation* move = dynamic_cast<const intermediate::MoveOperation*>(pair.first);
+        if(pair.second.writesLocal() && move != nullptr &&
+            move->hasDecoration(intermediate::InstructionDecorations::PHI_NODE) && loop.findInLoop(move))
+            return move->getSource();
+    }
+    return NO_VALUE;
+}
+
+static bool isReductionOperation(const OpCode& code, const Configuration& config)
+{
+    if(code == OP_ADD || code == OP_AND || code == OP_OR || code == OP_XOR || code == OP_MIN || code == OP_MAX ||
+        code == OP_FMIN || code == OP_FMAX)
+        return true;
+    // floating-point additions and multiplications are not associative, so re-ordering them changes the result
+    if(code == OP_FADD || code == OP_FMUL)
+        return has_flag(config.mathType, MathType::UNSAFE_MATH);
+    return false;
+}
+
+/*
+ * Finds all values carried over from one iteration to the next (other than the iteration variable) and determines
+ * whether they are reductions, which can be calculated element-wise and folded after the loop.
+ *
+ * Returns false, if any of these values cannot be vectorized.
+ */
+static bool findReductions(const ControlFlowLoop& loop, LoopControl& loopControl, const Configuration& config)
+{
+    loopControl.reductions.clear();
+    for(const CFGNode* node : loop)
+    {
+        for(auto it = node->key->begin(); !it.isEndOfBlock(); it.nextInBlock())
+        {
+            if(!it.has<intermediate::MoveOperation>() ||
+                !it->hasDecoration(intermediate::InstructionDecorations::PHI_NODE) ||
+                !it->hasValueType(ValueType::LOCAL))
+                continue;
+            const Local* carried = it->getOutput()->local();
+            if(carried == loopControl.iterationVariable)
+                continue;
+            // values not read inside of the loop are not carried over, only passed to the following code
+            const auto readers = carried->getUsers(LocalUse::Type::READER);
+            if(std::none_of(readers.begin(), readers.end(),
+                   [&](const LocalUser* reader) -> bool { return loop.findInLoop(reader).has_value(); }))
+                continue;
+
+            const Value& source = it.get<intermediate::MoveOperation>()->getSource();
+            const intermediate::Operation* op = source.hasLocal() ?
+                dynamic_cast<const intermediate::Operation*>(source.getSingleWriter()) :
+                nullptr;
+            if(op == nullptr || !loop.findInLoop(op) || op->hasConditionalExecution() ||
+                op->setFlags != SetFlag::DONT_SET || op->getArguments().size() != 2 ||
+                !isReductionOperation(op->op, config) ||
+                op->getFirstArg().hasLocal(carried) == op->assertArgument(1).hasLocal(carried))
+            {
+                logging::debug() << "Cannot vectorize loop-carried value: " << it->to_string() << logging::endl;
+                return false;
+            }
+            // neither the accumulator nor the accumulated value can be used for anything else inside of the loop
+            bool isOnlyAccumulated = std::all_of(readers.begin(), readers.end(),
+                [&](const LocalUser* reader) -> bool { return reader == op || !loop.findInLoop(reader); });
+            source.local()->forUsers(LocalUse::Type::READER, [&](const LocalUser* reader) {
+                if(!reader->hasDecoration(intermediate::InstructionDecorations::PHI_NODE) && loop.findInLoop(reader))
+                    isOnlyAccumulated = false;
+            });
+            if(!isOnlyAccumulated)
+            {
+                logging::debug() << "Cannot vectorize reduction with intermediate results used inside of the loop: "
+                                 << op->to_string() << logging::endl;
+                return false;
+            }
+            logging::debug() << "Found reduction: " << op->to_string() << logging::endl;
+            loopControl.reductions.emplace_back(Reduction{const_cast<Local*>(carried), source.local(),
+                const_cast<intermediate::Operation*>(op)});
+        }
+    }
+    return true;
+}
+
+/*
+ * Returns whether any value calculated inside of the loop is used after the loop
+ */
+static bool hasValuesUsedAfterLoop(const ControlFlowLoop& loop)
+{
+    for(const CFGNode* node : loop)
+    {
+        for(auto it = node->key->begin(); !it.isEndOfBlock(); it.nextInBlock())
+        {
+            if(!it.has() || it.has<intermediate::BranchLabel>() || !it->hasValueType(ValueType::LOCAL))
+                continue;
+            const auto readers = it->getOutput()->local()->getUsers(LocalUse::Type::READER);
+            if(std::any_of(readers.begin(), readers.end(),
+                   [&](const LocalUser* reader) -> bool { return !loop.findInLoop(reader); }))
+                return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Checks whether the loop has the structure required to generate a vectorized copy followed by the original loop
+ * executing the remaining iterations:
+ * - the loop is entered only from its preheader into the first basic block
+ * - the basic blocks of the loop are placed consecutively
+ * - the loop is only left via a single edge
+ * - the iteration variable is changed by adding/subtracting a constant and compared to the upper bound
+ */
+static bool canGenerateRemainderLoop(Method& method, const ControlFlowLoop& loop, const LoopControl& loopControl)
+{
+    if((loopControl.stepKind != StepKind::ADD_CONSTANT && loopControl.stepKind != StepKind::SUB_CONSTANT) ||
+        !loopControl.getStep() || !loopControl.comparisonInstruction || findLoopPreheader(loop) == nullptr)
+        return false;
+
+    FastSet<const BasicBlock*> loopBlocks;
+    for(const CFGNode* node : loop)
+        loopBlocks.emplace(node->key);
+    auto blockIt = std::find_if(method.begin(), method.end(),
+        [&](const BasicBlock& block) -> bool { return loopBlocks.find(&block) != loopBlocks.end(); });
+    const BasicBlock* header = &(*blockIt);
+    std::size_t numConsecutiveBlocks = 0;
+    while(blockIt != method.end() && loopBlocks.find(&(*blockIt)) != loopBlocks.end())
+    {
+        ++numConsecutiveBlocks;
+        ++blockIt;
+    }
+    if(numConsecutiveBlocks != loopBlocks.size())
+    {
+        logging::debug() << "Cannot generate remainder loop for loop with non-consecutive basic blocks"
+                         << logging::endl;
+        return false;
+    }
+
+    bool isValid = true;
+    unsigned numExits = 0;
+    for(const CFGNode* node : loop)
+    {
+        node->forAllIncomingEdges([&](const CFGNode& neighbor, const CFGEdge& edge) -> bool {
+            if(node->key != header && loopBlocks.find(neighbor.key) == loopBlocks.end())
+                isValid = false;
+            return true;
+        });
+        node->forAllOutgoingEdges([&](const CFGNode& neighbor, const CFGEdge& edge) -> bool {
+            if(loopBlocks.find(neighbor.key) == loopBlocks.end())
+                ++numExits;
+            return true;
+        });
+    }
+    if(!isValid || numExits != 1)
+    {
+        logging::debug() << "Cannot generate remainder loop for loop with multiple entries or exits" << logging::endl;
+        return false;
+    }
+    return true;
+}
+
+// the maximum number of iterations simulated to determine the number of iterations of a loop
+static constexpr int32_t MAX_SIMULATED_ITERATIONS = 1 << 16;
+
+/*
+ * The positions of the instructions within a basic block
+ */
+using BlockPositions = FastMap<const intermediate::IntermediateInstruction*, std::size_t>;
+
+/*
+ * The values assumed for locals not written inside of the loop, e.g. for a bound only known at run-time
+ */
+using AssumedValues = FastMap<const Local*, Value>;
+
+static Optional<Value> calculateInIteration(Method& method, const intermediate::IntermediateInstruction* inst,
+    const Local* iterationVariable, const Value& iterationValue, const BlockPositions& positions,
+    const AssumedValues& assumedValues, unsigned depth);
+
+/*
+ * Calculates the value of the operand read at the given position of the loop block for the given value of the
+ * iteration variable.
+ *
+ * Only literals, constants and locals written unconditionally inside of the loop block before the given position can
+ * be calculated.
+ */
+static Optional<Value> calculateOperandInIteration(Method& method, const Value& operand, std::size_t position,
+    const Local* iterationVariable, const Value& iterationValue, const BlockPositions& positions,
+    const AssumedValues& assumedValues, unsigned depth)
+{
+    if(operand.getLiteralValue())
+        return operand;
+    if(!operand.hasLocal())
+        return {};
+    if(operand.hasLocal(iterationVariable))
+        return iterationValue;
+    const intermediate::IntermediateInstruction* writer = operand.getSingleWriter();
+    auto posIt = writer != nullptr ? positions.find(writer) : positions.end();
+    if(posIt == positions.end())
+    {
+        // not written inside of the loop, e.g. the upper bound
+        auto assumedIt = assumedValues.find(operand.local());
+        if(assumedIt != assumedValues.end())
+            return assumedIt->second;
+        if(auto constant = getConstantValue(operand, method))
+            return Value(Literal(constant.value()), operand.type);
+        return {};
+    }
+    if(posIt->second >= position || depth == 0 || writer->conditional != COND_ALWAYS)
+        return {};
+    return calculateInIteration(
+        method, writer, iterationVariable, iterationValue, positions, assumedValues, depth - 1);
+}
+
+/*
+ * Calculates the result of the given instruction of the loop block for the given value of the iteration variable
+ */
+static Optional<Value> calculateInIteration(Method& method, const intermediate::IntermediateInstruction* inst,
+    const Local* iterationVariable, const Value& iterationValue, const BlockPositions& positions,
+    const AssumedValues& assumedValues, unsigned depth)
+{
+    if(inst->hasPackMode() || inst->hasUnpackMode() || dynamic_cast<const intermediate::VectorRotation*>(inst))
+        return {};
+    const std::size_t position = positions.at(inst);
+    if(auto move = dynamic_cast<const intermediate::MoveOperation*>(inst))
+        return calculateOperandInIteration(method, move->getSource(), position, iterationVariable, iterationValue,
+            positions, assumedValues, depth);
+    if(auto op = dynamic_cast<const intermediate::Operation*>(inst))
+    {
+        auto first = calculateOperandInIteration(method, op->getFirstArg(), position, iterationVariable,
+            iterationValue, positions, assumedValues, depth);
+        Optional<Value> second = NO_VALUE;
+        if(op->getSecondArg())
+        {
+            second = calculateOperandInIteration(method, op->assertArgument(1), position, iterationVariable,
+                iterationValue, positions, assumedValues, depth);
+            if(!second)
+                return {};
+        }
+        if(!first)
+            return {};
+        auto result = op->op.calculate(first, second);
+        if(result && result->getLiteralValue())
+            return result;
+    }
+    return {};
+}
 
-    const Literal initial = loopControl.initialization->precalculate(4)->getLiteralValue().value();
-    const Literal end = loopControl.terminatingValue.getLiteralValue().value();
-    // the number of iterations from the bounds depends on the iteration operation
-    auto iterations =
-        loopControl.countIterations(initial.signedInt(), end.signedInt(), loopControl.getStep()->signedInt());
-    logging::debug() << "Determined iteration count of " << iterations << logging::endl;
+/*
+ * Determines whether an instruction with the given condition is executed for the flags set by the given result.
+ *
+ * The carry flag is not modeled, since it depends on the operation setting the flags.
+ */
+static Optional<bool> isConditionMet(ConditionCode cond, const Literal& flagsResult)
+{
+    if(cond == COND_ALWAYS)
+        return true;
+    if(cond == COND_ZERO_SET)
+        return flagsResult.unsignedInt() == 0;
+    if(cond == COND_ZERO_CLEAR)
+        return flagsResult.unsignedInt() != 0;
+    if(cond == COND_NEGATIVE_SET)
+        return flagsResult.signedInt() < 0;
+    if(cond == COND_NEGATIVE_CLEAR)
+        return flagsResult.signedInt() >= 0;
+    return {};
+}
+
+/*
+ * Returns the exact number of iterations of the single-block loop, if it can be determined at compile-time.
+ *
+ * Instead of guessing the kind of comparison from the instruction setting the flags (which is not possible for all
+ * comparisons, since e.g. "a < b" is lowered to a "max" and a "xor" and the flags are read with different conditions
+ * for "<", ">=" and "!="), the loop control is simulated: For every iteration, the instruction setting the flags, the
+ * conditional writes of the branch conditions and the branches themselves are evaluated with the actual operand order
+ * and conditions until the loop is left. If any of these cannot be evaluated exactly, no iteration count is returned.
+ *
+ * The assumed values are used for locals which are not known at compile-time, e.g. to check the behavior of the loop
+ * for some sample bounds.
+ */
+static Optional<int32_t> determineIterationCount(
+    Method& method, BasicBlock& block, const LoopControl& loopControl, const AssumedValues& assumedValues = {})
+{
+    if(!loopControl.initialization || !loopControl.iterationStep || !loopControl.repetitionJump)
+        return {};
+    const Local* iterationVariable = loopControl.iterationVariable;
+    const intermediate::IntermediateInstruction* stepInstruction = loopControl.iterationStep->get();
+    if(stepInstruction->conditional != COND_ALWAYS)
+        return {};
+
+    BlockPositions positions;
+    std::vector<const intermediate::Branch*> branches;
+    FastSet<const Local*> conditionLocals;
+    std::size_t index = 0;
+    for(auto it = block.begin(); !it.isEndOfBlock(); it.nextInBlock())
+    {
+        if(!it.has())
+            continue;
+        positions.emplace(it.get(), index++);
+        if(auto branch = it.get<const intermediate::Branch>())
+        {
+            branches.push_back(branch);
+            if(branch->getCondition().hasLocal())
+                conditionLocals.emplace(branch->getCondition().local());
+        }
+    }
+    if(positions.find(stepInstruction) == positions.end())
+        return {};
+
+    // the conditional writes of the branch conditions, they all need to depend on the same flags
+    std::vector<const intermediate::IntermediateInstruction*> conditionWriters;
+    const intermediate::IntermediateInstruction* flagsSetter = nullptr;
+    const intermediate::IntermediateInstruction* lastFlagsSetter = nullptr;
+    std::size_t lastIterationVariableWrite = 0;
+    bool writesIterationVariable = false;
+    for(auto it = block.begin(); !it.isEndOfBlock(); it.nextInBlock())
+    {
+        if(!it.has())
+            continue;
+        if(it->hasValueType(ValueType::LOCAL) &&
+            conditionLocals.find(it->getOutput()->local()) != conditionLocals.end())
+        {
+            if(it->conditional != COND_ALWAYS)
+            {
+                if(lastFlagsSetter == nullptr || (flagsSetter != nullptr && flagsSetter != lastFlagsSetter))
+                    return {};
+                flagsSetter = lastFlagsSetter;
+            }
+            conditionWriters.push_back(it.get());
+        }
+        if(it->writesLocal(iterationVariable))
+        {
+            writesIterationVariable = true;
+            lastIterationVariableWrite = positions.at(it.get());
+        }
+        if(it->setFlags == SetFlag::SET_FLAGS)
+            lastFlagsSetter = it.get();
+    }
+    for(const Local* loc : conditionLocals)
+    {
+        // the branch conditions need to be completely determined inside of the loop block
+        for(const LocalUser* writer : loc->getUsers(LocalUse::Type::WRITER))
+        {
+            if(positions.find(writer) == positions.end())
+                return {};
+        }
+    }
+    if(flagsSetter != nullptr && flagsSetter->conditional != COND_ALWAYS)
+        return {};
+    // the iteration variable is assumed to have the same value throughout the evaluated part of the loop block, it is
+    // only updated (via the phi-node) afterwards
+    const std::size_t lastEvaluatedPosition =
+        std::max(positions.at(stepInstruction), flagsSetter != nullptr ? positions.at(flagsSetter) : 0);
+    if(writesIterationVariable && lastIterationVariableWrite <= lastEvaluatedPosition)
+        return {};
+
+    const unsigned maxDepth = 8;
+    Value iterationValue(Literal(loopControl.initialValue), iterationVariable->type);
+    for(int32_t iteration = 1; iteration <= MAX_SIMULATED_ITERATIONS; ++iteration)
+    {
+        Optional<Value> flagsResult = NO_VALUE;
+        if(flagsSetter != nullptr)
+        {
+            flagsResult = calculateInIteration(
+                method, flagsSetter, iterationVariable, iterationValue, positions, assumedValues, maxDepth);
+            if(!flagsResult)
+                return {};
+        }
+
+        // the last write executed determines the value of the branch condition
+        FastMap<const Local*, Value> conditionValues;
+        for(const intermediate::IntermediateInstruction* writer : conditionWriters)
+        {
+            Optional<bool> isExecuted = writer->conditional == COND_ALWAYS ?
+                Optional<bool>(true) :
+                isConditionMet(writer->conditional, *flagsResult->getLiteralValue());
+            if(!isExecuted)
+                return {};
+            if(!isExecuted.value())
+                continue;
+            auto value = calculateInIteration(
+                method, writer, iterationVariable, iterationValue, positions, assumedValues, maxDepth);
+            if(!value)
+                return {};
+            conditionValues.erase(writer->getOutput()->local());
+            conditionValues.emplace(writer->getOutput()->local(), value.value());
+        }
+
+        // the first branch taken determines whether the loop is repeated, if no branch is taken, the loop is left
+        bool repeatLoop = false;
+        for(const intermediate::Branch* branch : branches)
+        {
+            bool isTaken = branch->isUnconditional();
+            if(!isTaken)
+            {
+                Optional<Value> condition = branch->getCondition();
+                if(branch->getCondition().hasLocal())
+                {
+                    auto condIt = conditionValues.find(branch->getCondition().local());
+                    condition = condIt != conditionValues.end() ? condIt->second : Optional<Value>{};
+                }
+                if(!condition || !condition->getLiteralValue())
+                    return {};
+                auto taken = isConditionMet(branch->conditional, *condition->getLiteralValue());
+                if(!taken)
+                    return {};
+                isTaken = taken.value();
+            }
+            if(isTaken)
+            {
+                repeatLoop = branch->getTarget() == block.getLabel()->getLabel();
+                break;
+            }
+        }
+        if(!repeatLoop)
+            return iteration;
 
-    // find the biggest factor fitting into 16 SIMD-elements
-    unsigned factor = 16 / maxTypeWidth;
-    while(factor > 0)
+        auto nextValue = calculateInIteration(
+            method, stepInstruction, iterationVariable, iterationValue, positions, assumedValues, maxDepth);
+        if(!nextValue)
+            return {};
+        iterationValue = nextValue.value();
+    }
+    logging::debug() << "Loop runs for more than " << MAX_SIMULATED_ITERATIONS
+                     << " iterations (or forever), not determining exact iteration count" << logging::endl;
+    return {};
+}
+
+// the number of iterations assumed for rating the vectorization of loops with a trip count only known at run-time
+static constexpr int32_t ASSUMED_RUNTIME_ITERATIONS = 64;
+
+/*
+ * Checks whether the number of iterations of a loop with a bound only known at run-time can be calculated at run-time
+ * as the distance between the initial value and the bound.
+ *
+ * This requires the iteration variable to be changed by +1/-1 and the loop to be left as soon as the bound is reached.
+ * For single-block loops, this is verified by simulating the loop control for some sample bounds, since the kind of
+ * comparison cannot be determined reliably from the instructions.
+ */
+static bool hasRuntimeIterationCount(Method& method, const ControlFlowLoop& loop, const LoopControl& loopControl)
+{
+    if(!loopControl.terminatingValue.hasLocal() || !loopControl.getStep().is(INT_ONE.literal()) ||
+        (loopControl.stepKind != StepKind::ADD_CONSTANT && loopControl.stepKind != StepKind::SUB_CONSTANT))
+        return false;
+    const Local* bound = loopControl.terminatingValue.local();
+    const FastSet<const Local*> writtenLocals = findLocalsWrittenInLoop(loop);
+    if(writtenLocals.find(bound) != writtenLocals.end())
+        return false;
+    if(loop.size() != 1)
+        return !loopControl.comparison.empty();
+    for(int32_t distance : {1, 2, 15, 16, 17, 100})
     {
-        // TODO factors not in [1,2,3,4,8,16] possible?? Should be from hardware-specification side
-        if((iterations % static_cast<int32_t>(factor)) == 0)
-            break;
-        --factor;
+        AssumedValues assumedValues;
+        assumedValues.emplace(bound,
+            Value(Literal(loopControl.stepKind == StepKind::SUB_CONSTANT ? loopControl.initialValue - distance :
+                                                                            loopControl.initialValue + distance),
+                loopControl.terminatingValue.type));
+        auto count = determineIterationCount(method, *loop.front()->key, loopControl, assumedValues);
+        if(!count || count.value() != distance)
+        {
+            logging::debug() << "Loop with run-time bound does not run up to the bound" << logging::endl;
+            return false;
+        }
     }
-    logging::debug() << "Determined possible vectorization-factor of " << factor << logging::endl;
-    return factor;
+    return true;
 }
 
+// the number of cycles a branch takes, including the 3 delay slots
+static constexpr int BRANCH_CYCLES = 4;
+// the number of cycles between writing the SFU input and the result being available
+static constexpr int SFU_CYCLES = 3;
+// the approximate latency of a TMU memory access, independent of the number of elements accessed
+static constexpr int TMU_CYCLES = 9;
+// the approximate fixed latency of a DMA transfer between VPM and memory
+static constexpr int DMA_CYCLES = 8;
+
 /*
- * On the cost-side, we have (as increments):
- * - instructions inserted to construct vectors from scalars
+ * Estimates the number of cycles required to execute the given instruction for the given number of vector elements
+ */
+static int estimateCycles(const intermediate::IntermediateInstruction* inst, unsigned numElements)
+{
+    if(inst == nullptr || !inst->mapsToASMInstruction())
+        return 0;
+    if(dynamic_cast<const intermediate::Branch*>(inst) != nullptr)
+        return BRANCH_CYCLES;
+    if(inst->writesRegister(REG_VPM_DMA_LOAD_ADDR) || inst->writesRegister(REG_VPM_DMA_STORE_ADDR))
+        // the DMA transfer needs to move all the elements
+        return DMA_CYCLES + static_cast<int>(numElements);
+    if(inst->getOutput() && inst->getOutput()->hasRegister())
+    {
+        // the SIMD units process all (up to 16) elements at once
+        if(inst->getOutput()->reg().isSpecialFunctionsUnit())
+            return SFU_CYCLES;
+        if(inst->getOutput()->reg().isTextureMemoryUnit())
+            return TMU_CYCLES;
+    }
+    return 1;
+}
+
+/*
+ * On the cost-side, we have:
+ * - the cycles of the vectorized loop body (times the number of vectorized iterations)
  * - additional delay for writing larger vectors through VPM
+ * - the cycles of the scalar loop body for the iterations executed by the remainder loop
+ * - instructions inserted to construct vectors from scalars (initial values, loop-invariant operands) and to fold the
+ * reductions after the loop
  * - memory address is read and written from within loop -> abort
  * - vector rotations -> for now abort
  *
- * On the benefit-side, we have (as factors):
- * - the iterations saved (times the number of instructions in an iteration)
+ * On the benefit-side, we have:
+ * - the cycles of the scalar loop body times the number of iterations of the original loop
  */
 static int calculateCostsVsBenefits(
     const ControlFlowLoop& loop, const LoopControl& loopControl, const DataDependencyGraph& dependencyGraph)
 {
-    int costs = 0;
+    int scalarCycles = 0;
+    int vectorCycles = 0;
 
     FastSet<const Local*> readAddresses;
     FastSet<const Local*> writtenAddresses;
+    FastSet<const Local*> invariantOperands;
+    const FastSet<const Local*> writtenLocals = findLocalsWrittenInLoop(loop);
 
     InstructionWalker it = loop.front()->key->begin();
     while(!it.isEndOfMethod() && it != loop.back()->key->end())
@@ -485,16 +1067,28 @@ static int calculateCostsVsBenefits(
                                  << logging::endl;
                 return std::numeric_limits<int>::min();
             }
+
+            for(const Value& arg : it->getArguments())
+            {
+                // scalar values calculated outside of the loop might need to be replicated across all elements
+                if(arg.hasLocal() && !arg.local()->is<Parameter>() && !arg.local()->is<Global>() &&
+                    !arg.type.isLabelType() && arg.type.isScalarType() && !arg.type.isPointerType() &&
+                    writtenLocals.find(arg.local()) == writtenLocals.end())
+                    invariantOperands.emplace(arg.local());
+            }
+
+            const unsigned numElements = it->getOutput() ? it->getOutput()->type.getVectorWidth() : 1;
+            scalarCycles += estimateCycles(it.get(), numElements);
+            vectorCycles += estimateCycles(it.get(), numElements * loopControl.vectorizationFactor);
         }
 
-        // TODO check and increase costs
         it.nextInMethod();
     }
 
     // constant cost - loading immediate for iteration-step for vector-width > 15 (no longer fitting into small
     // immediate)
     if(loopControl.iterationStep.value()->getOutput()->type.getVectorWidth() * loopControl.vectorizationFactor > 15)
-        ++costs;
+        ++vectorCycles;
 
     FastSet<const Local*> readAndWrittenAddresses;
     std::set_intersection(readAddresses.begin(), readAddresses.end(), writtenAddresses.begin(), writtenAddresses.end(),
@@ -512,20 +1106,137 @@ static int calculateCostsVsBenefits(
         return std::numeric_limits<int>::min();
     }
 
-    int numInstructions = 0;
-    for(const CFGNode* node : loop)
+    // one-time costs: initial value of the iteration variable and replication of loop-invariant operands
+    int overhead = 2 + 2 * static_cast<int>(invariantOperands.size());
+    for(std::size_t i = 0; i < loopControl.reductions.size(); ++i)
     {
-        // XXX to be exact, would need to include delays here too
-        numInstructions += static_cast<int>(node->key->size());
+        // initial value of the accumulator, rotations and operations to fold the elements after the loop
+        overhead += 3;
+        for(unsigned n = loopControl.vectorizationFactor / 2; n > 0; n /= 2)
+            overhead += 2;
     }
-    // the number of instructions/cycles saved
-    int benefits = numInstructions * static_cast<int>(loopControl.vectorizationFactor);
-
+    if(!loopControl.vectorizeInPlace)
+        // handing over the loop-carried values to the remainder loop
+        overhead += 1 + static_cast<int>(loopControl.reductions.size());
+    if(loopControl.hasRuntimeIterationCount)
+        // calculating the vectorized iterations and skipping the vectorized loop at run-time
+        overhead += 6 + BRANCH_CYCLES;
+
+    const int costs = loopControl.vectorIterations * vectorCycles +
+        loopControl.remainderIterations * scalarCycles + overhead;
+    const int benefits = loopControl.iterationCount * scalarCycles;
+
+    logging::debug() << "Estimated " << benefits << " cycles for the original loop and " << costs
+                     << " cycles for vectorization factor " << loopControl.vectorizationFactor << " ("
+                     << loopControl.vectorIterations << " vectorized and " << loopControl.remainderIterations
+                     << " remaining iterations)" << logging::endl;
     logging::debug() << "Calculated an cost-vs-benefit rating of " << (benefits - costs)
                      << " (estimated number of clock cycles saved, larger is better)" << logging::endl;
     return benefits - costs;
 }
 
+/*
+ * Selects the vectorization-factor with the best cost-vs-benefit rating:
+ * - checks the maximum vector-width used inside the loop, since the vectorized values cannot exceed 16 elements
+ * - if the factor divides the number of iterations and no value is passed out of the loop, the loop can be
+ * vectorized in place
+ * - otherwise, the remaining iterations are executed by the original (scalar) loop
+ */
+static Optional<unsigned> determineVectorizationFactor(Method& method, const ControlFlowLoop& loop,
+    LoopControl& loopControl, const DataDependencyGraph& dependencyGraph, bool canVectorizeInPlace,
+    bool canGenerateRemainder)
+{
+    unsigned char maxTypeWidth = 1;
+    InstructionWalker it = loop.front()->key->begin();
+    while(!it.isEndOfMethod() && it != loop.back()->key->end())
+    {
+        if(it->getOutput())
+        {
+            // TODO is this check enough?
+            maxTypeWidth = std::max(maxTypeWidth, it->getOutput()->type.getVectorWidth());
+        }
+        it.nextInMethod();
+    }
+
+    logging::debug() << "Found maximum used vector-width of " << static_cast<unsigned>(maxTypeWidth) << " elements"
+                     << logging::endl;
+
+    Optional<int32_t> iterationCount;
+    if(loopControl.hasRuntimeIterationCount)
+        // the actual number of iterations is only known at run-time, the vectorized and remaining iterations are
+        // calculated there. For rating the vectorization factors, some sufficiently large trip count is assumed
+        iterationCount = ASSUMED_RUNTIME_ITERATIONS;
+    else if(loop.size() == 1)
+        // the exact number of iterations, independent of the kind of comparison and the operand order
+        iterationCount = determineIterationCount(method, *loop.front()->key, loopControl);
+    else
+    {
+        // the number of iterations from the bounds depends on the iteration operation. This is only exact, if the step
+        // divides the distance between the bounds, since otherwise e.g. "<" and "!=" comparisons behave differently
+        const int32_t end = loopControl.terminatingValue.getLiteralValue()->signedInt();
+        const int32_t step = loopControl.getStep() ? loopControl.getStep()->signedInt() : 0;
+        const int32_t distance = loopControl.stepKind == StepKind::SUB_CONSTANT ? loopControl.initialValue - end :
+                                                                                  end - loopControl.initialValue;
+        if((loopControl.stepKind == StepKind::ADD_CONSTANT || loopControl.stepKind == StepKind::SUB_CONSTANT) &&
+            step > 0 && distance > 0 && distance % step == 0 && !loopControl.comparison.empty())
+            iterationCount = loopControl.countIterations(loopControl.initialValue, end, step);
+    }
+    if(!iterationCount)
+    {
+        logging::debug() << "Failed to determine the exact number of iterations" << logging::endl;
+        return {};
+    }
+    loopControl.iterationCount = iterationCount.value();
+    logging::debug() << "Determined iteration count of " << loopControl.iterationCount << logging::endl;
+    if(loopControl.iterationCount < 2)
+        return {};
+
+    auto applyFactor = [&](unsigned factor) -> bool {
+        const auto iterations = loopControl.iterationCount;
+        loopControl.vectorizationFactor = factor;
+        loopControl.vectorizeInPlace = canVectorizeInPlace && (iterations % static_cast<int32_t>(factor)) == 0;
+        if(loopControl.vectorizeInPlace)
+        {
+            loopControl.vectorIterations = iterations / static_cast<int32_t>(factor);
+            loopControl.remainderIterations = 0;
+            return true;
+        }
+        if(canGenerateRemainder && iterations > static_cast<int32_t>(factor))
+        {
+            // the remainder loop always executes at least one iteration
+            loopControl.vectorIterations = (iterations - 1) / static_cast<int32_t>(factor);
+            loopControl.remainderIterations = iterations - loopControl.vectorIterations * static_cast<int32_t>(factor);
+            return true;
+        }
+        return false;
+    };
+
+    Optional<unsigned> bestFactor;
+    int bestRating = 0;
+    // only use factors with native vector sizes
+    for(unsigned factor : {16u, 8u, 4u, 2u})
+    {
+        if(factor * maxTypeWidth > 16 || !applyFactor(factor))
+            continue;
+        int rating = calculateCostsVsBenefits(loop, loopControl, dependencyGraph);
+        if(rating == std::numeric_limits<int>::min())
+            // the loop cannot be vectorized at all
+            return {};
+        if(rating > bestRating)
+        {
+            bestRating = rating;
+            bestFactor = factor;
+        }
+    }
+
+    if(bestFactor)
+    {
+        applyFactor(bestFactor.value());
+        logging::debug() << "Determined vectorization-factor of " << bestFactor.value() << logging::endl;
+    }
+    return bestFactor;
+}
+
 static void scheduleForVectorization(
     const Local* local, FastSet<const intermediate::IntermediateInstruction*>& openInstructions, ControlFlowLoop& loop)
 {
@@ -670,12 +1381,23 @@ static Optional<InstructionWalker> findWalker(const CFGNode* node, const interme
                              Optional<InstructionWalker>{};
 }
 
-static void fixInitialValueAndStep(ControlFlowLoop& loop, LoopControl& loopControl)
+/*
+ * Returns whether the initial value of the iteration variable can be modified to start with the values for all vector
+ * elements, see #fixInitialValue
+ */
+static bool canFixInitialValueInPlace(const ControlFlowLoop& loop, const LoopControl& loopControl)
 {
-    intermediate::Operation* stepOp = loopControl.iterationStep->get<intermediate::Operation>();
-    if(stepOp == nullptr)
-        throw CompilationError(CompilationStep::OPTIMIZER, "Unhandled iteration step operation");
+    const intermediate::MoveOperation* move =
+        dynamic_cast<const intermediate::MoveOperation*>(loopControl.initialization);
+    if(move == nullptr || loopControl.stepKind != StepKind::ADD_CONSTANT ||
+        !loopControl.getStep().is(INT_ONE.literal()))
+        return false;
+    return move->getSource().hasLiteral(INT_ZERO.literal()) ||
+        (move->getSource().getLiteralValue() && findWalker(loop.findPredecessor(), move));
+}
 
+static void fixInitialValue(ControlFlowLoop& loop, LoopControl& loopControl)
+{
     const_cast<DataType&>(loopControl.initialization->getOutput()->type) =
         loopControl.initialization->getOutput()->type.toVectorType(
             loopControl.iterationVariable->type.getVectorWidth());
@@ -704,6 +1426,13 @@ static void fixInitialValueAndStep(ControlFlowLoop& loop, LoopControl& loopContr
     else
         throw CompilationError(
             CompilationStep::OPTIMIZER, "Unhandled initial value", loopControl.initialization->to_string());
+}
+
+static void fixIterationStep(LoopControl& loopControl)
+{
+    intermediate::Operation* stepOp = loopControl.iterationStep->get<intermediate::Operation>();
+    if(stepOp == nullptr)
+        throw CompilationError(CompilationStep::OPTIMIZER, "Unhandled iteration step operation");
 
     bool stepChanged = false;
     switch(stepOp->op.opAdd)
@@ -746,7 +1475,7 @@ static void fixInitialValueAndStep(ControlFlowLoop& loop, LoopControl& loopContr
  * - iterative (until no more values changed), modify all value (and local)-types so argument/result-types match again
  * - add new instruction-decoration (vectorized) to facilitate
  * - in final iteration, fix TMU/VPM configuration and address calculation and loop condition
- * - fix initial iteration value and step
+ * - fix iteration step (and initial iteration value, if vectorized in place)
  */
 static void vectorize(ControlFlowLoop& loop, LoopControl& loopControl, const DataDependencyGraph& dependencyGraph)
 {
@@ -756,6 +1485,14 @@ static void vectorize(ControlFlowLoop& loop, LoopControl& loopControl, const Dat
         loopControl.iterationVariable->type.toVectorType(loopControl.iterationVariable->type.getVectorWidth() *
             static_cast<unsigned char>(loopControl.vectorizationFactor));
     scheduleForVectorization(loopControl.iterationVariable, openInstructions, loop);
+    // the accumulators are calculated element-wise, independent of whether the accumulated values are vectorized
+    for(const Reduction& reduction : loopControl.reductions)
+    {
+        const_cast<DataType&>(reduction.accumulator->type) =
+            reduction.accumulator->type.toVectorType(reduction.accumulator->type.getVectorWidth() *
+                static_cast<unsigned char>(loopControl.vectorizationFactor));
+        scheduleForVectorization(reduction.accumulator, openInstructions, loop);
+    }
     std::size_t numVectorized = 0;
 
     // iteratively change all instructions
@@ -797,68 +1534,727 @@ static void vectorize(ControlFlowLoop& loop, LoopControl& loopControl, const Dat
 
     numVectorized += fixVPMSetups(loop, loopControl);
 
-    fixInitialValueAndStep(loop, loopControl);
-    numVectorized += 2;
+    if(loopControl.vectorizeInPlace)
+    {
+        fixInitialValue(loop, loopControl);
+        ++numVectorized;
+    }
+    fixIterationStep(loopControl);
+    ++numVectorized;
 
     logging::debug() << "Vectorization done, changed " << numVectorized << " instructions!" << logging::endl;
 }
 
+/*
+ * Scalar values calculated outside of the loop are not guaranteed to have the same value in all SIMD elements (e.g. if
+ * they are extracted from a vector), so the scalar operands of vectorized instructions are replicated across all
+ * elements before the loop is entered.
+ *
+ * Parameters and globals are loaded via UNIFORMs and therefore already have the same value in all elements.
+ */
+static std::size_t replicateLoopInvariantOperands(Method& method, ControlFlowLoop& loop, InstructionWalker insertIt)
+{
+    const FastSet<const Local*> writtenLocals = findLocalsWrittenInLoop(loop);
+    FastMap<const Local*, Value> replicatedLocals;
+    for(const CFGNode* node : loop)
+    {
+        for(auto it = node->key->begin(); !it.isEndOfBlock(); it.nextInBlock())
+        {
+            if(!it.has() || !it->hasDecoration(intermediate::InstructionDecorations::AUTO_VECTORIZED) ||
+                !it->getOutput() || it->getOutput()->type.isScalarType() || it->getOutput()->type.isPointerType())
+                continue;
+            for(std::size_t i = 0; i < it->getArguments().size(); ++i)
+            {
+                const Value arg = it->assertArgument(i);
+                if(!arg.hasLocal() || arg.local()->is<Parameter>() || arg.local()->is<Global>() ||
+                    arg.type.isLabelType() || !arg.type.isScalarType() || arg.type.isPointerType() ||
+                    writtenLocals.find(arg.local()) != writtenLocals.end())
+                    continue;
+                auto replicatedIt = replicatedLocals.find(arg.local());
+                if(replicatedIt == replicatedLocals.end())
+                {
+                    const Value replicated = method.addNewLocal(
+                        arg.type.toVectorType(it->getOutput()->type.getVectorWidth()), "%loop_invariant");
+                    insertIt = intermediate::insertReplication(insertIt, arg, replicated);
+                    replicatedIt = replicatedLocals.emplace(arg.local(), replicated).first;
+                    logging::debug() << "Replicated loop-invariant operand: " << arg.to_string() << logging::endl;
+                }
+                it->setArgument(i, replicatedIt->second);
+            }
+        }
+    }
+    return replicatedLocals.size();
+}
+
+/*
+ * Copies the instruction of the loop, renaming all locals written inside of the loop which are contained in the given
+ * set. All other values are shared by the original and the copied instructions.
+ */
+static intermediate::IntermediateInstruction* copyLoopInstruction(Method& method,
+    const intermediate::IntermediateInstruction* inst, const std::string& prefix,
+    const FastSet<const Local*>& renamedLocals, const Local* exitLabel)
+{
+    intermediate::IntermediateInstruction* copy = inst->copyFor(method, prefix);
+    for(std::size_t i = 0; i < inst->getArguments().size() && i < copy->getArguments().size(); ++i)
+    {
+        const Value& arg = inst->assertArgument(i);
+        if(arg.hasLocal() && renamedLocals.find(arg.local()) == renamedLocals.end())
+            copy->setArgument(i, arg);
+    }
+    if(inst->hasValueType(ValueType::LOCAL) &&
+        renamedLocals.find(inst->getOutput()->local()) == renamedLocals.end())
+        copy->setOutput(inst->getOutput());
+    // leaving the copied loop continues with the given block
+    const intermediate::Branch* branch = dynamic_cast<const intermediate::Branch*>(inst);
+    if(branch != nullptr && exitLabel != nullptr && renamedLocals.find(branch->getTarget()) == renamedLocals.end())
+        copy->setArgument(0, exitLabel->createReference());
+    // references to memory are shared too
+    if(inst->hasValueType(ValueType::LOCAL) && inst->getOutput()->local()->reference.first != nullptr &&
+        renamedLocals.find(inst->getOutput()->local()->reference.first) == renamedLocals.end())
+        const_cast<std::pair<Local*, int>&>(copy->getOutput()->local()->reference) =
+            inst->getOutput()->local()->reference;
+    return copy;
+}
+
+/*
+ * Removes the (unused) copies of stack allocations created while copying instructions with the given prefix
+ */
+static void removeCopiedStackAllocations(Method& method, const std::string& prefix)
+{
+    for(auto it = method.stackAllocations.begin(); it != method.stackAllocations.end();)
+    {
+        if(it->name.find(prefix) == 0 && it->getUsers().empty())
+            it = method.stackAllocations.erase(it);
+        else
+            ++it;
+    }
+}
+
+/*
+ * Folds the elements of the vectorized accumulated value into a scalar value by applying the reduction operation
+ * log2(vectorization-factor) times to the value and its rotated copy.
+ */
+static InstructionWalker insertReductionFold(InstructionWalker it, Method& method, const Reduction& reduction,
+    const Value& vectorValue, const Value& dest, unsigned vectorizationFactor)
+{
+    Value folded = vectorValue;
+    for(unsigned offset = vectorizationFactor / 2; offset > 0; offset /= 2)
+    {
+        const Value rotated = method.addNewLocal(vectorValue.type, "%reduction_fold");
+        it = intermediate::insertVectorRotation(
+            it, folded, Value(Literal(offset), TYPE_INT8), rotated, intermediate::Direction::DOWN);
+        const Value result = method.addNewLocal(vectorValue.type, "%reduction_fold");
+        it.emplace(new intermediate::Operation(reduction.operation->op, result, folded, rotated));
+        it->addDecorations(intermediate::InstructionDecorations::AUTO_VECTORIZED);
+        it.nextInBlock();
+        folded = result;
+    }
+    it.emplace(new intermediate::MoveOperation(dest, folded));
+    it->addDecorations(intermediate::InstructionDecorations::AUTO_VECTORIZED);
+    it.nextInBlock();
+    return it;
+}
+
+/*
+ * Generates a vectorized copy of the loop, which is executed before the original loop. The original loop then executes
+ * the remaining iterations:
+ *
+ *   preheader -> vectorized preheader -> vectorized loop -> remainder preheader -> original loop -> ...
+ *
+ * Since the original loop executes its body at least once, the vectorized loop runs (iterations - 1) / factor times,
+ * leaving 1 to factor iterations for the remainder loop. This way, any value used after the loop is still calculated by
+ * the original loop.
+ *
+ * The vectorized preheader sets the initial vector values of the iteration variable and the accumulators, the remainder
+ * preheader hands over the scalar values (e.g. the folded accumulators) to the original loop.
+ *
+ * If the number of iterations is only known at run-time, the vectorized preheader also calculates the bound of the
+ * vectorized loop and skips the vectorized loop (and the remainder preheader) if there are not more iterations than
+ * elements in a single vector:
+ *
+ *   vectorized elements = (bound - initial - 1) & ~(factor - 1)
+ *   vectorized bound = initial + vectorized elements
+ *   if vectorized elements <= 0: continue with original loop
+ *
+ * Returns the labels of the basic blocks generated
+ */
+static FastSet<const Local*> vectorizeWithRemainderLoop(const Module& module, Method& method, ControlFlowLoop& loop,
+    LoopControl& loopControl, const DataDependencyGraph& dependencyGraph, const Configuration& config)
+{
+    // 1. collect the required information, since inserting basic blocks invalidates the CFG (and the loop)
+    BasicBlock* preheader = findLoopPreheader(loop);
+    const FastSet<const Local*> writtenLocals = findLocalsWrittenInLoop(loop);
+    FastSet<const BasicBlock*> loopBlocks;
+    for(const CFGNode* node : loop)
+        loopBlocks.emplace(node->key);
+    auto headerIt = std::find_if(method.begin(), method.end(),
+        [&](const BasicBlock& block) -> bool { return loopBlocks.find(&block) != loopBlocks.end(); });
+    std::vector<BasicBlock*> originalBlocks;
+    for(auto blockIt = headerIt; blockIt != method.end() && loopBlocks.find(&(*blockIt)) != loopBlocks.end();
+        ++blockIt)
+        originalBlocks.push_back(&(*blockIt));
+    const Local* headerLabel = originalBlocks.front()->getLabel()->getLabel();
+
+    std::string prefix;
+    unsigned index = 0;
+    do
+    {
+        prefix = "%vectorized" + std::to_string(index++) + ".";
+    } while(method.findLocal(prefix + headerLabel->name) != nullptr);
+
+    // 2. insert the vectorized preheader, a copy of the loop and the remainder preheader in front of the original loop
+    const Local* remainderLabel = method.findOrCreateLocal(TYPE_LABEL, prefix + "remainder");
+    FastSet<const Local*> generatedLabels;
+    BasicBlock& vectorPreheader = method.createAndInsertNewBlock(headerIt, prefix + "preheader");
+    generatedLabels.emplace(vectorPreheader.getLabel()->getLabel());
+    FastMap<const intermediate::IntermediateInstruction*, const intermediate::IntermediateInstruction*>
+        copiedInstructions;
+    const BasicBlock* vectorHeader = nullptr;
+    for(BasicBlock* block : originalBlocks)
+    {
+        BasicBlock& copy = method.createAndInsertNewBlock(headerIt, prefix + block->getLabel()->getLabel()->name);
+        generatedLabels.emplace(copy.getLabel()->getLabel());
+        if(vectorHeader == nullptr)
+            vectorHeader = &copy;
+        InstructionWalker copyIt = copy.end();
+        for(auto it = block->begin().nextInBlock(); !it.isEndOfBlock(); it.nextInBlock())
+        {
+            if(!it.has())
+                continue;
+            copyIt.emplace(copyLoopInstruction(method, it.get(), prefix, writtenLocals, remainderLabel));
+            copiedInstructions.emplace(it.get(), copyIt.get());
+            copyIt.nextInBlock();
+        }
+    }
+    BasicBlock& remainderPreheader = method.createAndInsertNewBlock(headerIt, remainderLabel->name);
+    generatedLabels.emplace(remainderPreheader.getLabel()->getLabel());
+
+    removeCopiedStackAllocations(method, prefix);
+
+    // 3. enter the vectorized loop instead of the original loop
+    for(auto it = preheader->begin(); !it.isEndOfBlock(); it.nextInBlock())
+    {
+        const intermediate::Branch* branch = it.get<intermediate::Branch>();
+        if(branch != nullptr && branch->getTarget() == headerLabel)
+            it.reset((new intermediate::Branch(
+                          vectorPreheader.getLabel()->getLabel(), branch->conditional, branch->getCondition()))
+                         ->copyExtrasFrom(branch));
+    }
+
+    // 4. vectorize the copy of the loop
+    auto loops = method.getCFG().findLoops();
+    auto loopIt = std::find_if(loops.begin(), loops.end(), [&](const ControlFlowLoop& candidate) -> bool {
+        return std::any_of(candidate.begin(), candidate.end(),
+            [&](const CFGNode* node) -> bool { return node->key == vectorHeader; });
+    });
+    if(loopIt == loops.end())
+        throw CompilationError(CompilationStep::OPTIMIZER, "Failed to find generated vectorized loop",
+            vectorHeader->getLabel()->to_string());
+    ControlFlowLoop& vectorLoop = *loopIt;
+
+    auto findCopy = [&](const Optional<InstructionWalker>& inst) -> Optional<InstructionWalker> {
+        return vectorLoop.findInLoop(copiedInstructions.at(inst->get()));
+    };
+    LoopControl vectorControl = loopControl;
+    vectorControl.iterationVariable =
+        const_cast<Local*>(method.findLocal(prefix + loopControl.iterationVariable->name));
+    vectorControl.initialization = nullptr;
+    vectorControl.iterationStep = findCopy(loopControl.iterationStep);
+    vectorControl.comparisonInstruction = findCopy(loopControl.comparisonInstruction);
+    vectorControl.repetitionJump = findCopy(loopControl.repetitionJump);
+    for(Reduction& reduction : vectorControl.reductions)
+    {
+        reduction.accumulator = const_cast<Local*>(method.findLocal(prefix + reduction.accumulator->name));
+        reduction.result = const_cast<Local*>(method.findLocal(prefix + reduction.result->name));
+        reduction.operation = vectorLoop.findInLoop(copiedInstructions.at(reduction.operation))
+                                  ->get<intermediate::Operation>();
+    }
+    vectorize(vectorLoop, vectorControl, dependencyGraph);
+    normalization::handleImmediate(module, method, vectorControl.iterationStep.value(), config);
+
+    // the vectorized loop ends after the last full vector of iterations
+    const int32_t step = loopControl.getStep()->signedInt();
+    const int32_t initial = loopControl.initialValue;
+    InstructionWalker comparison = vectorControl.comparisonInstruction.value();
+    const Local* stepResult = vectorControl.iterationStep.value()->getOutput()->local();
+    const std::size_t limitIndex = comparison->assertArgument(0).hasLocal(stepResult) ? 1 : 0;
+    Value skipVectorLoop = UNDEFINED_VALUE;
+    if(loopControl.hasRuntimeIterationCount)
+    {
+        // the step is +1/-1, so the number of iterations is the distance between the initial value and the bound
+        const Value initialValue(Literal(initial), TYPE_INT32);
+        const bool isDecrement = loopControl.stepKind == StepKind::SUB_CONSTANT;
+        InstructionWalker it = vectorPreheader.end();
+        const Value tripCount = method.addNewLocal(TYPE_INT32, "%trip_count");
+        it.emplace(new intermediate::Operation(OP_SUB, tripCount,
+            isDecrement ? initialValue : loopControl.terminatingValue,
+            isDecrement ? loopControl.terminatingValue : initialValue));
+        it = normalization::handleImmediate(module, method, it, config);
+        it.nextInBlock();
+        // the remainder loop always executes at least one iteration
+        const Value remainderStart = method.addNewLocal(TYPE_INT32, "%trip_count");
+        it.emplace(new intermediate::Operation(OP_SUB, remainderStart, tripCount, INT_ONE));
+        it.nextInBlock();
+        const Value numElements = method.addNewLocal(TYPE_INT32, "%vector_elements");
+        it.emplace(new intermediate::Operation(OP_AND, numElements, remainderStart,
+            Value(Literal(-static_cast<int32_t>(vectorControl.vectorizationFactor)), TYPE_INT32)));
+        it = normalization::handleImmediate(module, method, it, config);
+        it.nextInBlock();
+        const Value vectorLimit = method.addNewLocal(loopControl.terminatingValue.type, "%vector_limit");
+        it.emplace(new intermediate::Operation(isDecrement ? OP_SUB : OP_ADD, vectorLimit, initialValue, numElements));
+        it = normalization::handleImmediate(module, method, it, config);
+        it.nextInBlock();
+        // the sign of (vectorized elements - 1) is set, if not a single vector of iterations is executed
+        const Value numElementsMinusOne = method.addNewLocal(TYPE_INT32, "%vector_elements");
+        it.emplace(new intermediate::Operation(OP_SUB, numElementsMinusOne, numElements, INT_ONE));
+        it.nextInBlock();
+        skipVectorLoop = method.addNewLocal(TYPE_INT32, "%vector_skip");
+        it.emplace(new intermediate::Operation(
+            OP_ASR, skipVectorLoop, numElementsMinusOne, Value(Literal(31u), TYPE_INT8)));
+        it = normalization::handleImmediate(module, method, it, config);
+        it.nextInBlock();
+        comparison->setArgument(limitIndex, vectorLimit);
+    }
+    else
+    {
+        const int32_t numElements =
+            vectorControl.vectorIterations * static_cast<int32_t>(vectorControl.vectorizationFactor);
+        const int32_t vectorLimit =
+            initial + (loopControl.stepKind == StepKind::SUB_CONSTANT ? -numElements * step : numElements * step);
+        comparison->setArgument(limitIndex, Value(Literal(vectorLimit), comparison->assertArgument(limitIndex).type));
+    }
+    logging::debug() << "Changed loop condition: " << comparison->to_string() << logging::endl;
+    normalization::handleImmediate(module, method, comparison, config);
+
+    // 5. set the initial values of the vectorized loop
+    const Value vectorIteration = vectorControl.iterationVariable->createReference();
+    InstructionWalker it = vectorPreheader.end();
+    Value elementOffset = ELEMENT_NUMBER_REGISTER;
+    if(step != 1)
+    {
+        elementOffset = method.addNewLocal(vectorIteration.type, "%element_offset");
+        it.emplace(new intermediate::Operation(
+            OP_MUL24, elementOffset, ELEMENT_NUMBER_REGISTER, Value(Literal(step), TYPE_INT8)));
+        it->addDecorations(intermediate::InstructionDecorations::AUTO_VECTORIZED);
+        it = normalization::handleImmediate(module, method, it, config);
+        it.nextInBlock();
+    }
+    it.emplace(new intermediate::Operation(loopControl.getStepOperation(), vectorIteration,
+        loopControl.iterationVariable->createReference(), elementOffset));
+    it->addDecorations(intermediate::InstructionDecorations::AUTO_VECTORIZED);
+    logging::debug() << "Initial value of vectorized loop: " << it->to_string() << logging::endl;
+    it.nextInBlock();
+    for(std::size_t i = 0; i < loopControl.reductions.size(); ++i)
+    {
+        const Reduction& reduction = loopControl.reductions[i];
+        const Value vectorAccumulator = vectorControl.reductions[i].accumulator->createReference();
+        const Value initialValue = reduction.accumulator->createReference();
+        const OpCode& op = reduction.operation->op;
+        if(op == OP_ADD || op == OP_OR || op == OP_XOR || op == OP_FADD || op == OP_FMUL)
+        {
+            // start with the neutral element in all other elements
+            const Value neutral = op == OP_FADD ? FLOAT_ZERO : (op == OP_FMUL ? FLOAT_ONE : INT_ZERO);
+            it.emplace(new intermediate::MoveOperation(vectorAccumulator, neutral));
+            it->addDecorations(intermediate::InstructionDecorations::AUTO_VECTORIZED);
+            it = normalization::handleImmediate(module, method, it, config);
+            it.nextInBlock();
+            // only the element number of the first element is zero
+            it.emplace(new intermediate::Operation(OP_OR, NOP_REGISTER, ELEMENT_NUMBER_REGISTER,
+                ELEMENT_NUMBER_REGISTER, COND_ALWAYS, SetFlag::SET_FLAGS));
+            it.nextInBlock();
+            it.emplace(new intermediate::MoveOperation(vectorAccumulator, initialValue, COND_ZERO_SET));
+            it->addDecorations(add_flag(intermediate::InstructionDecorations::ELEMENT_INSERTION,
+                intermediate::InstructionDecorations::AUTO_VECTORIZED));
+            it.nextInBlock();
+        }
+        else
+            // idempotent operations, the initial value can be used for all elements
+            it = intermediate::insertReplication(it, initialValue, vectorAccumulator);
+    }
+    std::size_t numReplicated = replicateLoopInvariantOperands(method, vectorLoop, it);
+    if(loopControl.hasRuntimeIterationCount)
+    {
+        // run all iterations in the original loop, if there are too few for the vectorized loop. The initial values of
+        // the original loop are still set by its preheader
+        vectorPreheader.end().emplace(new intermediate::Branch(headerLabel, COND_ZERO_CLEAR, skipVectorLoop));
+        logging::debug() << "Skipping vectorized loop at run-time for too few iterations: "
+                         << vectorPreheader.end().previousInBlock()->to_string() << logging::endl;
+    }
+
+    // 6. hand over the loop-carried values to the remainder loop
+    it = remainderPreheader.end();
+    const Value nextIteration = findNextIterationValue(vectorLoop, vectorControl.iterationVariable).value();
+    it = intermediate::insertVectorExtraction(
+        it, method, nextIteration, INT_ZERO, loopControl.iterationVariable->createReference());
+    for(std::size_t i = 0; i < loopControl.reductions.size(); ++i)
+    {
+        it = insertReductionFold(it, method, vectorControl.reductions[i],
+            vectorControl.reductions[i].result->createReference(),
+            loopControl.reductions[i].accumulator->createReference(), vectorControl.vectorizationFactor);
+    }
+
+    if(loopControl.hasRuntimeIterationCount)
+        logging::debug() << "Generated vectorized loop with run-time number of iterations in front of remainder loop, "
+                         << vectorControl.reductions.size() << " reductions and " << numReplicated
+                         << " replicated loop-invariant operands" << logging::endl;
+    else
+        logging::debug() << "Generated vectorized loop with " << vectorControl.vectorIterations
+                         << " iterations in front of remainder loop with " << vectorControl.remainderIterations
+                         << " iterations, " << vectorControl.reductions.size() << " reductions and " << numReplicated
+                         << " replicated loop-invariant operands" << logging::endl;
+    return generatedLabels;
+}
+
 bool optimizations::vectorizeLoops(const Module& module, Method& method, const Configuration& config)
 {
-    // 1. find loops
-    auto& cfg = method.getCFG();
-    auto loops = cfg.findLoops();
     bool hasChanged = false;
+    // the labels of the basic blocks of all loops already handled. Generating a remainder loop changes the CFG, so the
+    // loops need to be searched for again
+    FastSet<const Local*> processedLabels;
+    bool cfgChanged = true;
+    while(cfgChanged)
+    {
+        cfgChanged = false;
+        // 1. find loops
+        auto& cfg = method.getCFG();
+        auto loops = cfg.findLoops();
 
-    // 2. determine data dependencies of loop bodies
-    auto dependencyGraph = DataDependencyGraph::createDependencyGraph(method);
+        // 2. determine data dependencies of loop bodies
+        auto dependencyGraph = DataDependencyGraph::createDependencyGraph(method);
 
-    for(auto& loop : loops)
-    {
-        // 3. determine operation on iteration variable and bounds
-        LoopControl loopControl = extractLoopControl(loop, *dependencyGraph.get());
-        PROFILE_COUNTER(vc4c::profiler::COUNTER_OPTIMIZATION + 333, "Loops found", 1);
-        if(loopControl.iterationVariable == nullptr)
-            // we could not find the iteration variable, skip this loop
-            continue;
+        for(auto& loop : loops)
+        {
+            if(std::any_of(loop.begin(), loop.end(), [&](const CFGNode* node) -> bool {
+                   return processedLabels.find(node->key->getLabel()->getLabel()) != processedLabels.end();
+               }))
+                continue;
+            if(std::any_of(loops.begin(), loops.end(),
+                   [&](const ControlFlowLoop& other) -> bool { return loop.includes(other); }))
+            {
+                logging::debug() << "Vectorization of loops containing other loops is not supported" << logging::endl;
+                continue;
+            }
+            for(const CFGNode* node : loop)
+                processedLabels.emplace(node->key->getLabel()->getLabel());
+
+            // 3. determine operation on iteration variable and bounds
+            LoopControl loopControl = extractLoopControl(method, loop, *dependencyGraph.get());
+            PROFILE_COUNTER(vc4c::profiler::COUNTER_OPTIMIZATION + 333, "Loops found", 1);
+            if(loopControl.iterationVariable == nullptr)
+                // we could not find the iteration variable, skip this loop
+                continue;
+
+            if(!loopControl.initialization || loopControl.terminatingValue.isUndefined() ||
+                !loopControl.iterationStep || !loopControl.repetitionJump)
+            {
+                // we need to know the initial value and the iteration step at compile-time
+                logging::debug() << "Failed to find all bounds and step for loop, aborting vectorization!"
+                                 << logging::endl;
+                continue;
+            }
+
+            // 4. determine values carried over between iterations
+            if(!findReductions(loop, loopControl, config))
+                continue;
+            const bool canGenerateRemainder = canGenerateRemainderLoop(method, loop, loopControl);
+            if(!loopControl.terminatingValue.isLiteralValue())
+            {
+                // the bound is only known at run-time (e.g. passed as kernel parameter), so the number of vectorized
+                // and remaining iterations is calculated at run-time, which requires a remainder loop
+                loopControl.hasRuntimeIterationCount =
+                    canGenerateRemainder && hasRuntimeIterationCount(method, loop, loopControl);
+                if(!loopControl.hasRuntimeIterationCount)
+                {
+                    logging::debug() << "Failed to determine the run-time number of iterations of loop with bound "
+                                     << loopControl.terminatingValue.to_string() << ", aborting vectorization!"
+                                     << logging::endl;
+                    continue;
+                }
+            }
+            const bool canVectorizeInPlace = !loopControl.hasRuntimeIterationCount &&
+                loopControl.reductions.empty() && !hasValuesUsedAfterLoop(loop) &&
+                canFixInitialValueInPlace(loop, loopControl);
+
+            // 5. determine vectorization factor (with the best cost-benefit rating)
+            Optional<unsigned> vectorizationFactor = determineVectorizationFactor(
+                method, loop, loopControl, *dependencyGraph.get(), canVectorizeInPlace, canGenerateRemainder);
+            if(!vectorizationFactor)
+            {
+                // vectorization (probably) doesn't pay off
+                logging::debug() << "Failed to determine a vectorization factor for the loop, aborting!"
+                                 << logging::endl;
+                continue;
+            }
+
+            // 6. run vectorization
+            if(loopControl.vectorizeInPlace)
+            {
+                vectorize(loop, loopControl, *dependencyGraph.get());
+                if(BasicBlock* preheader = findLoopPreheader(loop))
+                {
+                    InstructionWalker it = preheader->begin();
+                    while(!it.isEndOfBlock() && !it.has<intermediate::Branch>())
+                        it.nextInBlock();
+                    replicateLoopInvariantOperands(method, loop, it);
+                }
+                // increasing the iteration step might create a value not fitting into small immediate
+                normalization::handleImmediate(module, method, loopControl.iterationStep.value(), config);
+            }
+            else
+            {
+                auto generatedLabels =
+                    vectorizeWithRemainderLoop(module, method, loop, loopControl, *dependencyGraph.get(), config);
+                processedLabels.insert(generatedLabels.begin(), generatedLabels.end());
+                // the CFG and with it all the loops are invalidated
+                cfgChanged = true;
+            }
+            hasChanged = true;
+
+            PROFILE_COUNTER(
+                vc4c::profiler::COUNTER_OPTIMIZATION + 334, "Vectorization factors", loopControl.vectorizationFactor);
+            if(cfgChanged)
+                break;
+        }
+    }
+
+    return hasChanged;
+}
 
-        if(!loopControl.initialization || loopControl.terminatingValue.isUndefined() ||
-            !loopControl.terminatingValue.isLiteralValue() || !loopControl.iterationStep || !loopControl.repetitionJump)
+// the maximum number of locals live at the same time within an unrolled loop. There are 32 registers per physical
+// register-file and 4 general purpose accumulators, some room is left for temporaries introduced by later steps
+static constexpr std::size_t MAX_UNROLLED_REGISTER_PRESSURE = 48;
+// the maximum number of instructions of an unrolled loop body
+static constexpr std::size_t MAX_UNROLLED_INSTRUCTIONS = 512;
+
+struct UnrollCandidate
+{
+    // the single basic block of the loop
+    BasicBlock* block;
+    // the number of iterations combined into one
+    unsigned factor;
+    // whether all iterations are unrolled, removing the loop
+    bool unrollCompletely;
+    // the block the loop continues with, if it is left via an explicit branch
+    const Local* exitLabel;
+    // the locals whose values are read before they are written in the loop body
+    FastSet<const Local*> liveIns;
+};
+
+/*
+ * Checks whether the loop consists of a single basic block, which is only left via the branches at its end and
+ * determines the label of the block the loop is left to (if the loop is left via an explicit branch)
+ */
+static bool isSingleBlockLoop(const ControlFlowLoop& loop, const Local*& exitLabel)
+{
+    if(loop.size() != 1)
+        return false;
+    const CFGNode* node = loop.front();
+    bool foundBranch = false;
+    for(auto it = node->key->begin(); !it.isEndOfBlock(); it.nextInBlock())
+    {
+        if(it.has<intermediate::Branch>())
+            foundBranch = true;
+        else if(foundBranch && it.has())
+            // the loop is left in the middle of the block
+            return false;
+    }
+    unsigned numExits = 0;
+    exitLabel = nullptr;
+    node->forAllOutgoingEdges([&](const CFGNode& neighbor, const CFGEdge& edge) -> bool {
+        if(&neighbor != node)
         {
-            // we need to know both bounds and the iteration step (for now)
-            logging::debug() << "Failed to find all bounds and step for loop, aborting vectorization!" << logging::endl;
+            ++numExits;
+            if(!edge.data.isImplicit.at(node->key))
+                exitLabel = neighbor.key->getLabel()->getLabel();
+        }
+        return true;
+    });
+    return numExits == 1;
+}
+
+/*
+ * Determines the maximum number of locals live at the same time within the basic block as well as the locals live
+ * throughout the whole basic block (e.g. loop-invariant and loop-carried values)
+ */
+static std::size_t estimateRegisterPressure(const BasicBlock& block, FastSet<const Local*>& liveIns)
+{
+    analysis::LivenessAnalysis liveness;
+    liveness(block);
+    liveIns = liveness.getStartResult();
+    std::size_t maxLiveLocals = liveIns.size();
+    for(auto it = block.begin(); !it.isEndOfBlock(); it.nextInBlock())
+    {
+        if(it.has())
+            maxLiveLocals = std::max(maxLiveLocals, liveness.getResult(it.get()).size());
+    }
+    return maxLiveLocals;
+}
+
+/*
+ * Determines the number of iterations to combine, limited by the size of the unrolled loop body and the number of
+ * locals live at the same time, which grows with every copy of the loop body.
+ */
+static unsigned determineUnrollFactor(const BasicBlock& block, int32_t iterationCount, const Configuration& config,
+    FastSet<const Local*>& liveIns, bool& unrollCompletely)
+{
+    std::size_t numInstructions = 0;
+    for(auto it = block.begin(); !it.isEndOfBlock(); it.nextInBlock())
+    {
+        if(it.has() && it->mapsToASMInstruction() && !it.has<intermediate::Branch>())
+            ++numInstructions;
+    }
+    const std::size_t maxLiveLocals = estimateRegisterPressure(block, liveIns);
+    // the locals only live within a single iteration are duplicated for every copy of the loop body
+    const std::size_t localsPerCopy = std::max(maxLiveLocals - std::min(maxLiveLocals, liveIns.size()), std::size_t{1});
+    const std::size_t pressureFactor = MAX_UNROLLED_REGISTER_PRESSURE > liveIns.size() ?
+        (MAX_UNROLLED_REGISTER_PRESSURE - liveIns.size()) / localsPerCopy :
+        1;
+    const std::size_t sizeFactor = MAX_UNROLLED_INSTRUCTIONS / std::max(numInstructions, std::size_t{1});
+    const auto maxFactor = static_cast<int32_t>(
+        std::min({static_cast<std::size_t>(config.additionalOptions.maxUnrollFactor), pressureFactor, sizeFactor}));
+    logging::debug() << "Loop with " << numInstructions << " instructions and up to " << maxLiveLocals
+                     << " live locals (" << liveIns.size() << " live throughout the loop) can be unrolled up to "
+                     << maxFactor << " times" << logging::endl;
+
+    if(maxFactor < 2)
+        return 1;
+    if(iterationCount <= maxFactor)
+    {
+        unrollCompletely = true;
+        return static_cast<unsigned>(iterationCount);
+    }
+    // the loop condition is only checked after the last copy, so the factor needs to divide the number of iterations
+    for(int32_t factor = maxFactor; factor >= 2; --factor)
+    {
+        if(iterationCount % factor == 0)
+            return static_cast<unsigned>(factor);
+    }
+    return 1;
+}
+
+/*
+ * Inserts (factor - 1) copies of the loop body in front of the original instructions.
+ *
+ * The copies do not contain any branches, since the loop condition is only checked after the last copy. Locals whose
+ * values are read before being written (e.g. loop-carried values set by phi-nodes) are shared by all copies, all other
+ * locals written inside of the loop are renamed for every copy, keeping their live-ranges independent.
+ *
+ * If the loop is unrolled completely, the branch back to the start of the loop is removed too.
+ */
+static void unrollLoop(Method& method, const UnrollCandidate& candidate)
+{
+    BasicBlock& block = *candidate.block;
+    std::vector<const intermediate::IntermediateInstruction*> body;
+    FastSet<const Local*> renamedLocals;
+    for(auto it = block.begin().nextInBlock(); !it.isEndOfBlock(); it.nextInBlock())
+    {
+        if(!it.has() || it.has<intermediate::Branch>())
             continue;
+        body.push_back(it.get());
+        if(it->hasValueType(ValueType::LOCAL) &&
+            candidate.liveIns.find(it->getOutput()->local()) == candidate.liveIns.end())
+            renamedLocals.emplace(it->getOutput()->local());
+    }
+    if(body.empty())
+        return;
+
+    InstructionWalker insertIt = block.begin().nextInBlock();
+    while(!insertIt.isEndOfBlock() && insertIt.get() != body.front())
+        insertIt.nextInBlock();
+    const std::string& blockName = block.getLabel()->getLabel()->name;
+    unsigned index = 0;
+    for(unsigned i = 1; i < candidate.factor; ++i)
+    {
+        std::string prefix;
+        do
+        {
+            prefix = "%unrolled" + std::to_string(index++) + ".";
+        } while(method.findLocal(prefix + blockName) != nullptr ||
+            std::any_of(renamedLocals.begin(), renamedLocals.end(),
+                [&](const Local* loc) -> bool { return method.findLocal(prefix + loc->name) != nullptr; }));
+        for(const intermediate::IntermediateInstruction* inst : body)
+        {
+            insertIt.emplace(copyLoopInstruction(method, inst, prefix, renamedLocals, nullptr));
+            insertIt.nextInBlock();
         }
+        removeCopiedStackAllocations(method, prefix);
+    }
 
-        // 4. determine vectorization factor
-        Optional<unsigned> vectorizationFactor = determineVectorizationFactor(loop, loopControl);
-        if(!vectorizationFactor)
+    if(candidate.unrollCompletely)
+    {
+        InstructionWalker it = block.begin();
+        while(!it.isEndOfBlock())
         {
-            logging::debug() << "Failed to determine a vectorization factor for the loop, aborting!" << logging::endl;
-            continue;
+            if(it.has<intermediate::Branch>())
+                it.erase();
+            else
+                it.nextInBlock();
         }
-        if(vectorizationFactor.value() == 1)
-            // nothing to do
-            continue;
-        loopControl.vectorizationFactor = vectorizationFactor.value();
+        if(candidate.exitLabel != nullptr)
+            block.end().emplace(new intermediate::Branch(candidate.exitLabel, COND_ALWAYS, BOOL_TRUE));
+    }
+}
 
-        // 5. cost-benefit calculation
-        int rating = calculateCostsVsBenefits(loop, loopControl, *dependencyGraph.get());
-        if(rating < 0 /* TODO some positive factor to be required before vectorizing loops? */)
-            // vectorization (probably) doesn't pay off
-            continue;
+bool optimizations::unrollLoops(const Module& module, Method& method, const Configuration& config)
+{
+    if(config.additionalOptions.maxUnrollFactor < 2)
+        return false;
+
+    // unrolling changes the CFG, so all loops are analyzed before any of them is modified
+    std::vector<UnrollCandidate> candidates;
+    {
+        auto& cfg = method.getCFG();
+        auto loops = cfg.findLoops();
+        auto dependencyGraph = DataDependencyGraph::createDependencyGraph(method);
 
-        // 6. run vectorization
-        vectorize(loop, loopControl, *dependencyGraph.get());
-        // increasing the iteration step might create a value not fitting into small immediate
-        normalization::handleImmediate(module, method, loopControl.iterationStep.value(), config);
-        hasChanged = true;
+        for(auto& loop : loops)
+        {
+            UnrollCandidate candidate{};
+            if(!isSingleBlockLoop(loop, candidate.exitLabel))
+            {
+                logging::debug() << "Unrolling of loops with multiple basic blocks is not supported" << logging::endl;
+                continue;
+            }
+            candidate.block = loop.front()->key;
 
-        PROFILE_COUNTER(
-            vc4c::profiler::COUNTER_OPTIMIZATION + 334, "Vectorization factors", loopControl.vectorizationFactor);
+            LoopControl loopControl;
+            try
+            {
+                loopControl = extractLoopControl(method, loop, *dependencyGraph.get());
+            }
+            catch(const CompilationError& e)
+            {
+                logging::debug() << "Failed to determine loop control for unrolling: " << e.what() << logging::endl;
+                continue;
+            }
+            if(loopControl.iterationVariable == nullptr)
+                continue;
+            Optional<int32_t> iterationCount = determineIterationCount(method, *candidate.block, loopControl);
+            if(!iterationCount)
+            {
+                logging::debug() << "Failed to determine number of iterations for loop '"
+                                 << candidate.block->getLabel()->getLabel()->name << "', skipping unrolling"
+                                 << logging::endl;
+                continue;
+            }
+
+            candidate.factor = determineUnrollFactor(
+                *candidate.block, iterationCount.value(), config, candidate.liveIns, candidate.unrollCompletely);
+            if(candidate.factor < 2 && !candidate.unrollCompletely)
+                continue;
+            logging::debug() << "Unrolling loop '" << candidate.block->getLabel()->getLabel()->name << "' with "
+                             << iterationCount.value() << " iterations by a factor of " << candidate.factor
+                             << (candidate.unrollCompletely ? " (completely)" : "") << logging::endl;
+            candidates.emplace_back(std::move(candidate));
+        }
     }
 
-    return hasChanged;
+    for(const UnrollCandidate& candidate : candidates)
+    {
+        unrollLoop(method, candidate);
+        PROFILE_COUNTER(vc4c::profiler::COUNTER_OPTIMIZATION + 335, "Unroll factors", candidate.factor);
+    }
+    return !candidates.empty();
 }
 
 void optimizations::extendBranches(const Module& module, Method& method, const Configuration& config)
@@ -1280,6 +2676,119 @@ bool optimizations::removeConstantLoadInLoops(const Module& module, Method& meth
     return hasChanged;
 }
 
+static bool isLoopInvariant(const Value& arg, const FastSet<const IntermediateInstruction*>& loopInstructions)
+{
+    if(arg.hasLiteral() || arg.hasImmediate())
+        return true;
+    if(arg.hasRegister())
+        // the only registers not changing their values and without side-effects on reading
+        return arg.hasRegister(REG_ELEMENT_NUMBER) || arg.hasRegister(REG_QPU_NUMBER);
+    if(arg.hasLocal())
+    {
+        if(arg.local()->type.isLabelType())
+            return false;
+        // parameters and global data addresses are never written inside the kernel code
+        bool writtenInLoop = false;
+        arg.local()->forUsers(LocalUse::Type::WRITER, [&](const LocalUser* writer) {
+            if(loopInstructions.find(writer) != loopInstructions.end())
+                writtenInLoop = true;
+        });
+        return !writtenInLoop;
+    }
+    return false;
+}
+
+static bool canBeHoisted(InstructionWalker it, const FastSet<const IntermediateInstruction*>& loopInstructions)
+{
+    if(!(it.has<Operation>() || it.has<MoveOperation>() || it.has<LoadImmediate>()) || it.has<VectorRotation>())
+        return false;
+    if(it->hasSideEffects() || it->hasConditionalExecution() || !it->hasValueType(ValueType::LOCAL) ||
+        it->hasDecoration(InstructionDecorations::PHI_NODE))
+        return false;
+    // the output must not be written anywhere else, otherwise we would change the value seen by other readers
+    const Local* out = it->getOutput()->local();
+    if(out->getUsers(LocalUse::Type::WRITER).size() != 1)
+        return false;
+    return std::all_of(it->getArguments().begin(), it->getArguments().end(),
+        [&](const Value& arg) -> bool { return isLoopInvariant(arg, loopInstructions); });
+}
+
+bool optimizations::moveLoopInvariantCode(const Module& module, Method& method, const Configuration& config)
+{
+    bool hasChanged = false;
+    auto& cfg = method.getCFG();
+    auto loops = cfg.findLoops();
+    // handle inner loops first, so the code hoisted into the inner loop's preheader can then be hoisted out of the outer
+    // loop
+    std::vector<const ControlFlowLoop*> sortedLoops;
+    for(const auto& loop : loops)
+        sortedLoops.push_back(&loop);
+    std::stable_sort(sortedLoops.begin(), sortedLoops.end(),
+        [](const ControlFlowLoop* l1, const ControlFlowLoop* l2) -> bool { return l1->size() < l2->size(); });
+
+    for(const ControlFlowLoop* loop : sortedLoops)
+    {
+        BasicBlock* preheader = findLoopPreheader(*loop);
+        if(preheader == nullptr)
+        {
+            logging::debug() << "Skipping loop without a single preheader for loop-invariant code motion"
+                             << logging::endl;
+            continue;
+        }
+        FastSet<const IntermediateInstruction*> loopInstructions;
+        for(const CFGNode* node : *loop)
+        {
+            for(auto it = node->key->begin(); !it.isEndOfBlock(); it.nextInBlock())
+            {
+                if(it.has())
+                    loopInstructions.emplace(it.get());
+            }
+        }
+
+        // Every hoisted value occupies a register for the whole loop. Values only used very locally are assumed to be
+        // mapped to accumulators, so hoisting them increases the register pressure. Limit the number of these values.
+        unsigned numHoistedLocalValues = 0;
+        bool changedLoop = true;
+        while(changedLoop)
+        {
+            changedLoop = false;
+            for(const CFGNode* node : *loop)
+            {
+                auto it = node->key->begin();
+                while(!it.isEndOfBlock())
+                {
+                    if(!it.has() || !canBeHoisted(it, loopInstructions))
+                    {
+                        it.nextInBlock();
+                        continue;
+                    }
+                    const bool isLocallyLimited = node->key->isLocallyLimited(
+                        it, it->getOutput()->local(), config.additionalOptions.accumulatorThreshold);
+                    if(isLocallyLimited && numHoistedLocalValues >= config.additionalOptions.accumulatorThreshold)
+                    {
+                        it.nextInBlock();
+                        continue;
+                    }
+                    if(isLocallyLimited)
+                        ++numHoistedLocalValues;
+                    logging::debug() << "Moving loop-invariant instruction into " << preheader->getLabel()->to_string()
+                                     << ": " << it->to_string() << logging::endl;
+                    // insert before the branch(es) at the end of the preheader
+                    auto insertIt = preheader->end();
+                    while(insertIt.copy().previousInBlock().has<Branch>())
+                        insertIt.previousInBlock();
+                    loopInstructions.erase(it.get());
+                    insertIt.emplace(it.release());
+                    it.erase();
+                    changedLoop = true;
+                    hasChanged = true;
+                }
+            }
+        }
+    }
+    return hasChanged;
+}
+
 static const Local* findSourceBlock(const Local* label, const FastMap<const Local*, const Local*>& blockMap)
 {
     auto it = blockMap.find(label);
@@ -16,11 +16,31 @@ namespace vc4c
         /*
          * Tries to find loops which then can be vectorized by combining multiple iterations into one.
          *
-         * NOTE: Currently only works with "standard" for-range loops and needs to be enabled explicitly in the
-         * Configuration
+         * The vectorization-factor is selected by estimating the cycles of the vectorized loop. If the factor does not
+         * divide the number of iterations (or values calculated inside of the loop are used afterwards), a vectorized
+         * copy of the loop is inserted in front of the original loop, which then executes the remaining iterations.
+         * Loop-carried accumulations (e.g. sums, minimum/maximum) are calculated element-wise and folded afterwards.
+         *
+         * If the bound is only known at run-time (e.g. passed as kernel parameter), the number of vectorized and
+         * remaining iterations is calculated at run-time and the vectorized loop is skipped for too few iterations.
+         *
+         * NOTE: Currently only works with "standard" for-range loops with compile-time constant initial value and step
+         * (+1/-1 for bounds only known at run-time) and needs to be enabled explicitly in the Configuration.
          */
         bool vectorizeLoops(const Module& module, Method& method, const Configuration& config);
 
+        /*
+         * Unrolls loops consisting of a single basic block with a number of iterations known at compile-time.
+         *
+         * Loops are unrolled completely, if possible, otherwise by the largest factor dividing the number of
+         * iterations. The factor is limited by the size of the unrolled loop body and the register pressure, which
+         * increases with every copy of the loop body (as estimated via the liveness of the locals).
+         *
+         * Unrolling removes the branches (and their delay slots) between the combined iterations and gives the
+         * instruction scheduler more independent instructions to work with.
+         */
+        bool unrollLoops(const Module& module, Method& method, const Configuration& config);
+
         /*
          * Extends the branches (up to now represented by a single instruction) by
          * inserting instructions setting the necessary flags (if required)
@@ -52,6 +72,15 @@ namespace vc4c
          */
         bool removeConstantLoadInLoops(const Module& module, Method& method, const Configuration& config);
 
+        /*
+         * Moves loop-invariant calculations (without side-effects and with all operands being defined outside of the
+         * loop) out of (nested) loops into the block preceding the loop.
+         *
+         * To limit the increase in register pressure, only a limited number of values which could otherwise be mapped
+         * to an accumulator are moved out of a single loop.
+         */
+        bool moveLoopInvariantCode(const Module& module, Method& method, const Configuration& config);
+
         /*
          * Concatenates "adjacent" basic blocks if the preceding block has only one successor and the succeeding block
          * has only one predecessor.
@@ -10,6 +10,7 @@
 #include "../Profiler.h"
 #include "../analysis/AvailableExpressionAnalysis.h"
 #include "../analysis/DataDependencyGraph.h"
+#include "../analysis/ValueRange.h"
 #include "../periphery/SFU.h"
 #include "log.h"
 
@@ -690,6 +691,96 @@ bool optimizations::eliminateRedundantBitOp(const Module& module, Method& method
     return replaced;
 }
 
+static Optional<Literal> getConstantOperand(const Value& val)
+{
+    if(val.getLiteralValue())
+        return val.getLiteralValue();
+    auto load = dynamic_cast<const intermediate::LoadImmediate*>(val.getSingleWriter());
+    if(load && load->type == intermediate::LoadType::REPLICATE_INT32 && !load->hasPackMode() &&
+        load->conditional == COND_ALWAYS)
+        return load->getImmediate();
+    return {};
+}
+
+/*
+ * Checks whether the value range of the given local fits into the range [minValue, maxValue]
+ */
+static bool isInRange(
+    const FastMap<const Local*, analysis::ValueRange>& ranges, const Value& val, int64_t minValue, int64_t maxValue)
+{
+    if(!val.hasLocal())
+        return false;
+    auto rangeIt = ranges.find(val.local());
+    if(rangeIt == ranges.end() || !rangeIt->second.hasExplicitBoundaries())
+        return false;
+    auto intRange = rangeIt->second.getIntRange();
+    return intRange && intRange->minValue >= minValue && intRange->maxValue <= maxValue;
+}
+
+bool optimizations::eliminateRedundantExtensions(const Module& module, Method& method, const Configuration& config)
+{
+    auto ranges = analysis::ValueRange::determineValueRanges(method);
+
+    bool replaced = false;
+    auto it = method.walkAllInstructions();
+    while(!it.isEndOfMethod())
+    {
+        auto op = it.get<intermediate::Operation>();
+        if(op && !op->hasSideEffects() && !op->hasPackMode() && !op->hasUnpackMode() && op->getArguments().size() == 2)
+        {
+            Optional<Value> source;
+            if(op->op == OP_AND)
+            {
+                // zero-extension: and %out, %in, 2^n - 1
+                auto mask = getConstantOperand(op->assertArgument(1));
+                source = op->assertArgument(0);
+                if(!mask)
+                {
+                    mask = getConstantOperand(op->assertArgument(0));
+                    source = op->assertArgument(1);
+                }
+                if(!mask || (mask->unsignedInt() & (mask->unsignedInt() + 1)) != 0 ||
+                    !isInRange(ranges, source.value(), 0, static_cast<int64_t>(mask->unsignedInt())))
+                    source = NO_VALUE;
+            }
+            else if(op->op == OP_ASR && op->assertArgument(0).getSingleWriter() != nullptr)
+            {
+                // sign-extension: shl %tmp, %in, n; asr %out, %tmp, n
+                auto shift = getConstantOperand(op->assertArgument(1));
+                auto shl = dynamic_cast<const intermediate::Operation*>(op->assertArgument(0).getSingleWriter());
+                if(shift && shift->signedInt() > 0 && shift->signedInt() < 32 && shl && shl->op == OP_SHL &&
+                    !shl->hasPackMode() && !shl->hasUnpackMode() && shl->conditional == COND_ALWAYS &&
+                    getConstantOperand(shl->assertArgument(1)).ifPresent([&](const Literal& lit) -> bool {
+                        return lit.signedInt() == shift->signedInt();
+                    }))
+                {
+                    // the value is not modified, if it fits into the remaining (32 - n) bits as signed integer. Also
+                    // the input must not be changed between the shift and here
+                    int64_t limit = int64_t{1} << (31 - shift->signedInt());
+                    if(isInRange(ranges, shl->getFirstArg(), -limit, limit - 1) &&
+                        shl->getFirstArg().local()->getUsers(LocalUse::Type::WRITER).size() <= 1)
+                        source = shl->getFirstArg();
+                }
+            }
+
+            if(source)
+            {
+                logging::debug() << "Removing extension of value already in range: " << op->to_string()
+                                 << logging::endl;
+                auto decorations = op->decoration;
+                it.reset(new intermediate::MoveOperation(
+                    op->getOutput().value(), source.value(), op->conditional, op->setFlags));
+                it->addDecorations(decorations);
+                replaced = true;
+            }
+        }
+
+        it.nextInMethod();
+    }
+
+    return replaced;
+}
+
 bool optimizations::eliminateCommonSubexpressions(const Module& module, Method& method, const Configuration& config)
 {
     bool replacedSomething = false;
@@ -145,6 +145,26 @@ namespace vc4c
          */
         bool eliminateRedundantBitOp(const Module& module, Method& method, const Configuration& config);
 
+        /*
+         * Removes zero- and sign-extensions of values whose value range (determined over the whole method) already
+         * fits into the extended type.
+         *
+         * Example:
+         *  %1 = and %2, 255 (with %2 in range [0, 100])
+         *
+         * becomes:
+         *  %1 = %2
+         *
+         * And:
+         *  %1 = shl %2, 24
+         *  %3 = asr %1, 24 (with %2 in range [-100, 100])
+         *
+         * becomes:
+         *  %1 = shl %2, 24
+         *  %3 = %2
+         */
+        bool eliminateRedundantExtensions(const Module& module, Method& method, const Configuration& config);
+
         /*
          * Propagate source value of move operation in a basic block.
          *
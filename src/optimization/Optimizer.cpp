@@ -235,10 +235,16 @@ const std::vector<OptimizationPass> Optimizer::ALL_PASSES = {
      * These optimizations may be executed in a loop until there are not more changes to the instructions
      */
     OptimizationPass(
-        "VectorizeLoops", "vectorize-loops", vectorizeLoops, "vectorizes loops (WIP)", OptimizationType::INITIAL),
+        "VectorizeLoops", "vectorize-loops", vectorizeLoops, "vectorizes loops", OptimizationType::INITIAL),
+    OptimizationPass("MoveLoopInvariantCode", "move-loop-invariant-code", moveLoopInvariantCode,
+        "moves loop-invariant calculations out of loops into the preceding block", OptimizationType::INITIAL),
+    OptimizationPass("UnrollLoops", "unroll-loops", unrollLoops,
+        "unrolls loops with a known number of iterations, limited by the register pressure", OptimizationType::INITIAL),
     OptimizationPass("SingleSteps", "single-steps", runSingleSteps,
         "runs all the single-step optimizations. Combining them results in fewer iterations over the instructions",
         OptimizationType::REPEAT),
+    OptimizationPass("CombinePackModes", "combine-pack-modes", combinePackModes,
+        "folds masking and extraction of bytes and half-words into pack- and unpack-modes", OptimizationType::REPEAT),
     OptimizationPass("CombineRotations", "combine-rotations", combineVectorRotations,
         "combines duplicate vector rotations, e.g. introduced by vector-shuffle into a single rotation",
         OptimizationType::REPEAT),
@@ -249,6 +255,9 @@ const std::vector<OptimizationPass> Optimizer::ALL_PASSES = {
         "Replaces moves with the operation producing their source", OptimizationType::REPEAT),
     OptimizationPass("EliminateBitOperations", "eliminate-bit-operations", eliminateRedundantBitOp,
         "Rewrites redundant bit operations", OptimizationType::REPEAT),
+    OptimizationPass("EliminateRedundantExtensions", "eliminate-redundant-extensions", eliminateRedundantExtensions,
+        "Removes zero- and sign-extensions of values whose value range already fits into the extended type",
+        OptimizationType::REPEAT),
     OptimizationPass("PropagateMoves", "copy-propagation", propagateMoves,
         "Replaces operands with their moved-from value", OptimizationType::REPEAT),
     OptimizationPass("EliminateDeadCode", "eliminate-dead-code", eliminateDeadCode,
@@ -260,6 +269,12 @@ const std::vector<OptimizationPass> Optimizer::ALL_PASSES = {
      */
     // OptimizationPass("CompressWorkGroupInfo", "compress-work-group-info", compressWorkGroupLocals,
     //    "compresses work-group info into single local", OptimizationType::FINAL),
+    OptimizationPass("PipelineDMAAccess", "pipeline-dma", pipelineDMAAccess,
+        "issues DMA transfers as early and waits for them as late as possible by double-buffering the VPM scratch area",
+        OptimizationType::FINAL),
+    OptimizationPass("PipelineTMUAccess", "pipeline-tmu", pipelineTMUAccess,
+        "issues TMU loads as early and reads their results as late as possible, using both TMUs",
+        OptimizationType::FINAL),
     OptimizationPass("SplitReadAfterWrites", "split-read-write", splitReadAfterWrites,
         "splits read-after-writes (except if the local is used only very locally), so the reordering and "
         "register-allocation have an easier job",
@@ -268,11 +283,17 @@ const std::vector<OptimizationPass> Optimizer::ALL_PASSES = {
         "combines loadings of the same literal value within a small range of a basic block", OptimizationType::FINAL),
     OptimizationPass("RemoveConstantLoadInLoops", "extract-loads-from-loops", removeConstantLoadInLoops,
         "move constant loads in (nested) loops outside the loops", OptimizationType::FINAL),
+    OptimizationPass("OptimizeRotations", "optimize-rotations", optimizeVectorRotations,
+        "removes and combines vector rotations across basic blocks and fills their delays with other instructions",
+        OptimizationType::FINAL),
     OptimizationPass("InstructionScheduler", "schedule-instructions", reorderInstructions,
         "schedule instructions according to their dependencies within basic blocks (WIP, slow)",
         OptimizationType::FINAL),
     OptimizationPass("ReorderInstructions", "reorder", reorderWithinBasicBlocks,
         "re-order instructions to eliminate more NOPs and stall cycles", OptimizationType::FINAL),
+    OptimizationPass("PackALUInstructions", "pack-alu", packALUInstructions,
+        "moves independent instructions of a basic block together to combine them into instructions using both ALUs",
+        OptimizationType::FINAL),
     OptimizationPass("CombineALUIinstructions", "combine", combineOperations,
         "run peep-hole optimization to combine ALU-operations", OptimizationType::FINAL)};
 
@@ -283,16 +304,22 @@ std::set<std::string> Optimizer::getPasses(OptimizationLevel level)
     {
     case OptimizationLevel::FULL:
         passes.emplace("vectorize-loops");
+        passes.emplace("unroll-loops");
         passes.emplace("extract-loads-from-loops");
         passes.emplace("schedule-instructions");
+        passes.emplace("pack-alu");
+        passes.emplace("pipeline-tmu");
         // fall-through on purpose
     case OptimizationLevel::MEDIUM:
         passes.emplace("merge-blocks");
         passes.emplace("combine-rotations");
+        passes.emplace("optimize-rotations");
         passes.emplace("eliminate-moves");
         passes.emplace("eliminate-bit-operations");
         passes.emplace("copy-propagation");
         passes.emplace("combine-loads");
+        passes.emplace("move-loop-invariant-code");
+        passes.emplace("eliminate-redundant-extensions");
         // TODO CSE is disabled, since it can result in long compilation times and very large memory consumption
         // passes.emplace("eliminate-common-subexpressions");
         // fall-through on purpose
@@ -301,6 +328,7 @@ std::set<std::string> Optimizer::getPasses(OptimizationLevel level)
         passes.emplace("simplify-branches");
         passes.emplace("eliminate-dead-code");
         passes.emplace("single-steps");
+        passes.emplace("combine-pack-modes");
         passes.emplace("reorder");
         passes.emplace("combine");
         // fall-through on purpose
@@ -8,11 +8,13 @@
 
 #include "../Profiler.h"
 #include "../intermediate/Helper.h"
+#include "../periphery/VPM.h"
 #include "log.h"
 
 using namespace vc4c;
 using namespace vc4c::optimizations;
 using namespace vc4c::intermediate;
+using namespace vc4c::periphery;
 
 /*
  * Finds the last instruction before the (list of) NOP(s) that is not a NOP -> the reason for the insertion of NOPs
@@ -271,6 +273,620 @@ static void replaceNOPs(BasicBlock& basicBlock, Method& method, const Configurat
     }
 }
 
+/*
+ * Maximum number of instructions between releasing the VPM mutex and acquiring it again for the two critical sections
+ * to be merged
+ */
+static constexpr unsigned MAX_CRITICAL_SECTION_GAP = 16;
+
+/*
+ * A single DMA transfer between RAM and VPM as inserted by VPM#insertReadRAM and VPM#insertWriteRAM
+ */
+struct DMATransfer
+{
+    InstructionWalker dmaSetup;
+    InstructionWalker strideSetup;
+    InstructionWalker addressWrite;
+    InstructionWalker dmaWait;
+    // the QPU-side setup accessing the VPM rows of this transfer, if it can be determined
+    Optional<InstructionWalker> genericSetup = {};
+    unsigned firstRow;
+    unsigned numRows;
+};
+
+static bool isOrderingBarrier(InstructionWalker it)
+{
+    return it.has<MutexLock>() || it.has<Branch>() || it.has<BranchLabel>() || it.has<MemoryBarrier>() ||
+        it.has<SemaphoreAdjustment>();
+}
+
+static bool accessesVPM(const IntermediateInstruction* inst)
+{
+    return inst->readsRegister(REG_VPM_IO) || inst->writesRegister(REG_VPM_IO) ||
+        inst->writesRegister(REG_VPM_IN_SETUP) || inst->writesRegister(REG_VPM_OUT_SETUP) ||
+        inst->writesRegister(REG_VPM_DMA_LOAD_ADDR) || inst->writesRegister(REG_VPM_DMA_STORE_ADDR) ||
+        inst->readsRegister(REG_VPM_DMA_LOAD_WAIT) || inst->readsRegister(REG_VPM_DMA_STORE_WAIT) ||
+        inst->readsRegister(REG_VPM_DMA_LOAD_BUSY) || inst->readsRegister(REG_VPM_DMA_STORE_BUSY);
+}
+
+template <typename T>
+static unsigned getQPUSideRow(const T& genericSetup)
+{
+    // see VPMArea#toReadSetup and VPMArea#toWriteSetup
+    switch(genericSetup.getSize())
+    {
+    case 0:
+        return genericSetup.getByteRow();
+    case 1:
+        return genericSetup.getHalfWordRow();
+    default:
+        return genericSetup.getWordRow();
+    }
+}
+
+template <typename T>
+static void setQPUSideRow(T& genericSetup, unsigned row)
+{
+    switch(genericSetup.getSize())
+    {
+    case 0:
+        genericSetup.setByteRow(static_cast<uint8_t>(row));
+        break;
+    case 1:
+        genericSetup.setHalfWordRow(static_cast<uint8_t>(row));
+        break;
+    default:
+        genericSetup.setWordRow(static_cast<uint8_t>(row));
+    }
+}
+
+static Optional<DMATransfer> matchDMATransfer(const Method& method, InstructionWalker it, bool isLoad)
+{
+    // only handles the fixed sequence with literal setups (no dynamic offset) as generated by VPM#insertReadRAM and
+    // VPM#insertWriteRAM
+    const Register& setupReg = isLoad ? REG_VPM_IN_SETUP : REG_VPM_OUT_SETUP;
+    DMATransfer transfer;
+    transfer.dmaSetup = it;
+    if(!it.has<LoadImmediate>() || !it->writesRegister(setupReg) || it->hasConditionalExecution())
+        return {};
+    const uint32_t dmaSetupValue = it.get<LoadImmediate>()->getImmediate().unsignedInt();
+    if(isLoad ? !VPRSetup::fromLiteral(dmaSetupValue).isDMASetup() : !VPWSetup::fromLiteral(dmaSetupValue).isDMASetup())
+        return {};
+    transfer.strideSetup = it.copy().nextInBlock();
+    if(transfer.strideSetup.isEndOfBlock() || !transfer.strideSetup.has<LoadImmediate>() ||
+        !transfer.strideSetup->writesRegister(setupReg) || transfer.strideSetup->hasConditionalExecution())
+        return {};
+    transfer.addressWrite = transfer.strideSetup.copy().nextInBlock();
+    if(transfer.addressWrite.isEndOfBlock() || !transfer.addressWrite.has<MoveOperation>() ||
+        !transfer.addressWrite->writesRegister(isLoad ? REG_VPM_DMA_LOAD_ADDR : REG_VPM_DMA_STORE_ADDR) ||
+        transfer.addressWrite->hasConditionalExecution())
+        return {};
+    // moving the address write must not change the order of reading registers (e.g. UNIFORMs)
+    const Value& address = transfer.addressWrite.get<MoveOperation>()->getSource();
+    if(!address.hasLocal() && !address.hasLiteral())
+        return {};
+    transfer.dmaWait = transfer.addressWrite.copy().nextInBlock();
+    if(transfer.dmaWait.isEndOfBlock() ||
+        !transfer.dmaWait->readsRegister(isLoad ? REG_VPM_DMA_LOAD_WAIT : REG_VPM_DMA_STORE_WAIT))
+        return {};
+
+    if(isLoad)
+    {
+        const VPRDMASetup setup = VPRSetup::fromLiteral(dmaSetupValue).dmaSetup;
+        if(setup.getVertical())
+            return {};
+        const unsigned numRows = setup.getNumberRows() == 0 ? 16 : setup.getNumberRows();
+        const unsigned pitch = setup.getVPitch() == 0 ? 16 : setup.getVPitch();
+        transfer.firstRow = setup.getWordRow();
+        // the rows between the first and the last row written are spanned by the transfer. This over-estimates the rows
+        // for 8-/16-bit transfers, which is fine here
+        transfer.numRows = (numRows - 1) * pitch + 1;
+    }
+    else
+    {
+        const VPWDMASetup setup = VPWSetup::fromLiteral(dmaSetupValue).dmaSetup;
+        if(!setup.getHorizontal())
+            return {};
+        transfer.firstRow = setup.getWordRow();
+        transfer.numRows = setup.getUnits() == 0 ? 128 : setup.getUnits();
+    }
+    if(transfer.firstRow + transfer.numRows > method.vpm->getScratchArea().numRows)
+        // we only know that no other code accesses the rows of the scratch area
+        return {};
+
+    // the QPU reads the loaded data after the wait, the QPU writes the data to be stored before the DMA setup
+    auto genericIt = isLoad ? transfer.dmaWait.copy().nextInBlock() : transfer.dmaSetup.copy().previousInBlock();
+    while(isLoad ? !genericIt.isEndOfBlock() : !genericIt.isStartOfBlock())
+    {
+        if(genericIt.has())
+        {
+            if(isOrderingBarrier(genericIt))
+                break;
+            if(isLoad && genericIt->readsRegister(REG_VPM_IO))
+                // the VPM is read with a setup we cannot associate to this transfer
+                break;
+            if(!isLoad && genericIt->writesRegister(REG_VPM_IO))
+            {
+                // the data written into VPM for this transfer
+                genericIt.previousInBlock();
+                continue;
+            }
+            if(accessesVPM(genericIt.get()))
+            {
+                if(genericIt.has<LoadImmediate>() && genericIt->writesRegister(setupReg) &&
+                    !genericIt->hasConditionalExecution())
+                {
+                    const uint32_t value = genericIt.get<LoadImmediate>()->getImmediate().unsignedInt();
+                    if(isLoad && VPRSetup::fromLiteral(value).isGenericSetup() &&
+                        getQPUSideRow(VPRSetup::fromLiteral(value).genericSetup) == transfer.firstRow)
+                        transfer.genericSetup = genericIt;
+                    if(!isLoad && VPWSetup::fromLiteral(value).isGenericSetup() &&
+                        getQPUSideRow(VPWSetup::fromLiteral(value).genericSetup) == transfer.firstRow)
+                        transfer.genericSetup = genericIt;
+                }
+                break;
+            }
+        }
+        if(isLoad)
+            genericIt.nextInBlock();
+        else
+            genericIt.previousInBlock();
+    }
+    return transfer;
+}
+
+/*
+ * Moves the VPM rows of the given transfer to the rows not overlapping with the previous transfer, so both transfers
+ * can be active at the same time (double-buffering)
+ */
+static bool retargetDMATransfer(Method& method, DMATransfer& transfer, const DMATransfer& previous, bool isLoad)
+{
+    const unsigned scratchRows = method.vpm->getScratchArea().numRows;
+    if(!transfer.genericSetup)
+        return false;
+    const unsigned newRow = previous.firstRow >= transfer.numRows ? 0 : previous.firstRow + previous.numRows;
+    if(newRow + transfer.numRows > method.vpm->getMaxCacheVectors(TYPE_INT32, true))
+        return false;
+    method.vpm->updateScratchSize(static_cast<unsigned char>(std::max(scratchRows, newRow + transfer.numRows)));
+
+    logging::debug() << "Moving DMA " << (isLoad ? "load" : "store") << " from VPM row " << transfer.firstRow
+                     << " to row " << newRow << " to allow double-buffering: " << transfer.addressWrite->to_string()
+                     << logging::endl;
+    if(isLoad)
+    {
+        VPRSetupWrapper dmaSetup(transfer.dmaSetup.get<LoadImmediate>());
+        dmaSetup.dmaSetup.setWordRow(static_cast<uint8_t>(newRow));
+        VPRSetupWrapper genericSetup(transfer.genericSetup->get<LoadImmediate>());
+        setQPUSideRow(genericSetup.genericSetup, newRow);
+    }
+    else
+    {
+        VPWSetupWrapper dmaSetup(transfer.dmaSetup.get<LoadImmediate>());
+        dmaSetup.dmaSetup.setWordRow(static_cast<uint8_t>(newRow));
+        VPWSetupWrapper genericSetup(transfer.genericSetup->get<LoadImmediate>());
+        setQPUSideRow(genericSetup.genericSetup, newRow);
+    }
+    transfer.firstRow = newRow;
+    return true;
+}
+
+static bool overlaps(const DMATransfer& first, const DMATransfer& second)
+{
+    return first.firstRow < second.firstRow + second.numRows && second.firstRow < first.firstRow + first.numRows;
+}
+
+static bool mergeCriticalSections(BasicBlock& block)
+{
+    bool hasChanged = false;
+    auto it = block.begin();
+    while(!it.isEndOfBlock())
+    {
+        if(it.has<MutexLock>() && it.get<MutexLock>()->releasesMutex())
+        {
+            auto next = it.copy().nextInBlock();
+            unsigned numInstructions = 0;
+            while(!next.isEndOfBlock() && numInstructions < MAX_CRITICAL_SECTION_GAP)
+            {
+                // never hold the mutex while waiting for other QPUs or across basic blocks
+                if(next.has() && !next.has<MutexLock>() && isOrderingBarrier(next))
+                    break;
+                if(next.has<MutexLock>())
+                {
+                    if(next.get<MutexLock>()->locksMutex())
+                    {
+                        logging::debug() << "Merging critical sections separated by " << numInstructions
+                                         << " instructions" << logging::endl;
+                        next.erase();
+                        it.erase();
+                        hasChanged = true;
+                        // re-check from the current position for the next release
+                        it.previousInBlock();
+                    }
+                    break;
+                }
+                if(next.has() && next->mapsToASMInstruction())
+                    ++numInstructions;
+                next.nextInBlock();
+            }
+        }
+        it.nextInBlock();
+    }
+    return hasChanged;
+}
+
+static bool pipelineDMALoads(Method& method, BasicBlock& block)
+{
+    bool hasChanged = false;
+    Optional<DMATransfer> previous;
+    auto it = block.begin();
+    while(!it.isEndOfBlock())
+    {
+        auto current = it.has() ? matchDMATransfer(method, it, true) : Optional<DMATransfer>{};
+        if(!current)
+        {
+            // any other VPM access, critical-section or control-flow boundary resets the chain of loads
+            if(it.has() && (isOrderingBarrier(it) || (accessesVPM(it.get()) && !it->readsRegister(REG_VPM_IO) &&
+                                                         !it->writesRegister(REG_VPM_IN_SETUP))))
+                previous = {};
+            it.nextInBlock();
+            continue;
+        }
+        if(previous)
+        {
+            // find the earliest position after the previous wait to issue this load
+            auto insertPos = previous->dmaWait.copy().nextInBlock();
+            Optional<InstructionWalker> lastPreviousRead;
+            const Value& address = current->addressWrite.get<MoveOperation>()->getSource();
+            bool isValid = true;
+            for(auto gapIt = insertPos.copy(); gapIt != current->dmaSetup; gapIt.nextInBlock())
+            {
+                if(!gapIt.has())
+                    continue;
+                if(isOrderingBarrier(gapIt) ||
+                    (accessesVPM(gapIt.get()) && !gapIt->readsRegister(REG_VPM_IO) &&
+                        !(gapIt.has<LoadImmediate>() && gapIt->writesRegister(REG_VPM_IN_SETUP) &&
+                            VPRSetup::fromLiteral(gapIt.get<LoadImmediate>()->getImmediate().unsignedInt())
+                                .isGenericSetup())))
+                {
+                    isValid = false;
+                    break;
+                }
+                if(gapIt->readsRegister(REG_VPM_IO))
+                    lastPreviousRead = gapIt;
+                if(address.hasLocal() && gapIt->writesLocal(address.local()))
+                {
+                    insertPos = gapIt.copy().nextInBlock();
+                    lastPreviousRead = {};
+                }
+            }
+            if(isValid && lastPreviousRead && overlaps(*previous, *current) &&
+                !retargetDMATransfer(method, *current, *previous, true))
+                // cannot double-buffer, so issue the load at least after all previous VPM reads
+                insertPos = lastPreviousRead->copy().nextInBlock();
+            if(isValid && insertPos != current->dmaSetup)
+            {
+                logging::debug() << "Issuing DMA load early: " << current->addressWrite->to_string()
+                                 << logging::endl;
+                // the instructions are inserted in reverse order before the same position
+                current->addressWrite = moveInstructionUp(insertPos.copy(), current->addressWrite);
+                current->strideSetup = moveInstructionUp(current->addressWrite.copy(), current->strideSetup);
+                current->dmaSetup = moveInstructionUp(current->strideSetup.copy(), current->dmaSetup);
+                hasChanged = true;
+            }
+        }
+        it = current->dmaWait.copy().nextInBlock();
+        previous = current;
+    }
+    return hasChanged;
+}
+
+static bool deferDMAStoreWaits(Method& method, BasicBlock& block)
+{
+    bool hasChanged = false;
+    auto it = block.begin();
+    while(!it.isEndOfBlock())
+    {
+        auto current = it.has() ? matchDMATransfer(method, it, false) : Optional<DMATransfer>{};
+        if(!current)
+        {
+            it.nextInBlock();
+            continue;
+        }
+        // find the first instruction which depends on the store being finished
+        auto deferPos = current->dmaWait.copy().nextInBlock();
+        while(!deferPos.isEndOfBlock())
+        {
+            // loading via DMA or TMU could read the memory still being written
+            if(deferPos.has() &&
+                (isOrderingBarrier(deferPos) || accessesVPM(deferPos.get()) ||
+                    deferPos->writesRegister(REG_TMU0_ADDRESS) || deferPos->writesRegister(REG_TMU1_ADDRESS)))
+                break;
+            deferPos.nextInBlock();
+        }
+        if(!deferPos.isEndOfBlock() && deferPos.has<LoadImmediate>() && deferPos->writesRegister(REG_VPM_OUT_SETUP) &&
+            VPWSetup::fromLiteral(deferPos.get<LoadImmediate>()->getImmediate().unsignedInt()).isGenericSetup())
+        {
+            // if the next access is the QPU-side of the next store, try to have it write into other rows
+            Optional<DMATransfer> next;
+            auto nextIt = deferPos.copy().nextInBlock();
+            while(!nextIt.isEndOfBlock())
+            {
+                if(nextIt.has())
+                {
+                    if((next = matchDMATransfer(method, nextIt, false)))
+                        break;
+                    if(isOrderingBarrier(nextIt) ||
+                        (accessesVPM(nextIt.get()) && !nextIt->writesRegister(REG_VPM_IO)) ||
+                        nextIt->writesRegister(REG_TMU0_ADDRESS) || nextIt->writesRegister(REG_TMU1_ADDRESS))
+                        break;
+                }
+                nextIt.nextInBlock();
+            }
+            if(next && next->genericSetup && next->genericSetup->get() == deferPos.get() &&
+                (!overlaps(*current, *next) || retargetDMATransfer(method, *next, *current, false)))
+                deferPos = next->dmaSetup;
+        }
+        if(deferPos != current->dmaWait.copy().nextInBlock())
+        {
+            logging::debug() << "Deferring wait for DMA store: " << current->addressWrite->to_string()
+                             << logging::endl;
+            moveInstructionUp(deferPos, current->dmaWait);
+            hasChanged = true;
+        }
+        it = current->addressWrite.copy().nextInBlock();
+    }
+    return hasChanged;
+}
+
+bool optimizations::pipelineDMAAccess(const Module& module, Method& method, const Configuration& config)
+{
+    if(!method.vpm)
+        return false;
+    bool hasChanged = false;
+    for(BasicBlock& block : method)
+    {
+        hasChanged = mergeCriticalSections(block) || hasChanged;
+        hasChanged = pipelineDMALoads(method, block) || hasChanged;
+        hasChanged = deferDMAStoreWaits(method, block) || hasChanged;
+    }
+    return hasChanged;
+}
+
+/*
+ * "Every QPU [...] can queue up to 4 requests to each of the TMUs", see TMU.h
+ */
+static constexpr unsigned TMU_FIFO_DEPTH = 4;
+/*
+ * The maximum number of instructions to move a TMU address write over, loading from RAM takes up to 20 cycles
+ */
+static constexpr unsigned MAX_TMU_LOAD_DISTANCE = 20;
+
+/*
+ * A single general TMU load as inserted by periphery#insertGeneralReadTMU and periphery#insertReadVectorFromTMU
+ */
+struct TMULoad
+{
+    InstructionWalker addressWrite;
+    InstructionWalker trigger;
+    InstructionWalker resultRead;
+    bool onTMU1;
+};
+
+static bool accessesTMU(const IntermediateInstruction* inst)
+{
+    return (inst->hasValueType(ValueType::REGISTER) && inst->getOutput()->reg().isTextureMemoryUnit()) ||
+        inst->writesRegister(REG_TMU_NOSWAP) || inst->signal == SIGNAL_LOAD_TMU0 || inst->signal == SIGNAL_LOAD_TMU1;
+}
+
+static InstructionWalker skipEmptyInstructions(InstructionWalker it)
+{
+    while(!it.isEndOfBlock() && !it.has())
+        it.nextInBlock();
+    return it;
+}
+
+static Optional<TMULoad> matchTMULoad(InstructionWalker it)
+{
+    if(!it.has<MoveOperation>() || it->hasConditionalExecution() || it->signal != SIGNAL_NONE ||
+        !(it->writesRegister(REG_TMU0_ADDRESS) || it->writesRegister(REG_TMU1_ADDRESS)))
+        return {};
+    // image reads write the other TMU coordinates before the S coordinate, which we do not handle
+    auto prevIt = it.copy().previousInBlock();
+    while(!prevIt.isStartOfBlock() && !prevIt.has())
+        prevIt.previousInBlock();
+    if(prevIt.has() && prevIt->hasValueType(ValueType::REGISTER) &&
+        prevIt->getOutput()->reg().isTextureMemoryUnit() &&
+        !(prevIt->writesRegister(REG_TMU0_ADDRESS) || prevIt->writesRegister(REG_TMU1_ADDRESS)))
+        return {};
+    TMULoad load{it, skipEmptyInstructions(it.copy().nextInBlock()), it, it->writesRegister(REG_TMU1_ADDRESS)};
+    if(load.trigger.isEndOfBlock() || load.trigger->signal != (load.onTMU1 ? SIGNAL_LOAD_TMU1 : SIGNAL_LOAD_TMU0) ||
+        load.trigger->hasValueType(ValueType::LOCAL))
+        return {};
+    load.resultRead = skipEmptyInstructions(load.trigger.copy().nextInBlock());
+    if(load.resultRead.isEndOfBlock() || !load.resultRead->readsRegister(REG_TMU_OUT) ||
+        load.resultRead->signal != SIGNAL_NONE || !load.resultRead->hasValueType(ValueType::LOCAL) ||
+        load.resultRead->hasConditionalExecution() || load.resultRead->doesSetFlag())
+        return {};
+    return load;
+}
+
+/*
+ * Whether the instruction calculating (a part of) a TMU address can be moved together with the TMU address write
+ */
+static bool isMovableAddressCalculation(InstructionWalker it)
+{
+    if(!(it.has<Operation>() || it.has<MoveOperation>() || it.has<LoadImmediate>()) || it.has<VectorRotation>())
+        return false;
+    if(it->signal != SIGNAL_NONE || !it->hasValueType(ValueType::LOCAL) || it->hasPackMode() || it->hasUnpackMode())
+        return false;
+    return std::all_of(it->getArguments().begin(), it->getArguments().end(), [](const Value& arg) -> bool {
+        return arg.hasLocal() || arg.getLiteralValue() || arg.hasRegister(REG_ELEMENT_NUMBER);
+    });
+}
+
+/*
+ * Moves the reading of the TMU result (and the triggering of the load into r4) down to the first instruction depending
+ * on it
+ */
+static bool deferTMUResultRead(TMULoad& load)
+{
+    const Local* result = load.resultRead->getOutput()->local();
+    auto it = load.resultRead.copy().nextInBlock();
+    while(!it.isEndOfBlock())
+    {
+        if(it.has())
+        {
+            // r4 is also written by the SFU, so we can't move over any other access
+            if(isOrderingBarrier(it) || accessesTMU(it.get()) || it->signal != SIGNAL_NONE ||
+                it->readsRegister(REG_TMU_OUT) ||
+                (it->hasValueType(ValueType::REGISTER) && it->getOutput()->reg().isSpecialFunctionsUnit()) ||
+                it->readsLocal(result) || it->writesLocal(result))
+                break;
+        }
+        it.nextInBlock();
+    }
+    if(it == skipEmptyInstructions(load.resultRead.copy().nextInBlock()))
+        return false;
+    logging::debug() << "Deferring reading of TMU result: " << load.resultRead->to_string() << logging::endl;
+    // the instructions are inserted in order before the same position
+    load.trigger = moveInstructionUp(it, load.trigger);
+    load.resultRead = moveInstructionUp(it, load.resultRead);
+    return true;
+}
+
+/*
+ * Moves the TMU address write (together with the calculation of the address) up, so the memory access is executed
+ * in parallel with the instructions in between
+ */
+static bool issueTMULoadEarly(TMULoad& load)
+{
+    FastSet<const Local*> requiredLocals;
+    FastSet<const Local*> writtenLocals;
+    const Value& address = load.addressWrite.get<MoveOperation>()->getSource();
+    if(address.hasLocal())
+        requiredLocals.emplace(address.local());
+    else if(!address.getLiteralValue())
+        return false;
+
+    // the instructions calculating the address, in reverse order
+    std::vector<InstructionWalker> addressCalculation;
+    std::size_t numInstructionsToMove = 0;
+    Optional<InstructionWalker> insertPos;
+    bool calculationUsesFlags = false;
+    bool skippedInstructionsUseFlags = false;
+    unsigned numPendingLoads = 1;
+    unsigned numSkippedInstructions = 0;
+    auto it = load.addressWrite.copy();
+    while(!it.isStartOfBlock() && numSkippedInstructions < MAX_TMU_LOAD_DISTANCE)
+    {
+        it.previousInBlock();
+        if(!it.has())
+            continue;
+        if(isOrderingBarrier(it) || it->writesRegister(REG_TMU_NOSWAP) ||
+            it->writesRegister(load.onTMU1 ? REG_TMU1_ADDRESS : REG_TMU0_ADDRESS))
+            // keep the order of the requests to the same TMU
+            break;
+        if(it->hasValueType(ValueType::LOCAL) && requiredLocals.find(it->getOutput()->local()) != requiredLocals.end())
+        {
+            bool usesFlags = it->hasConditionalExecution() || it->doesSetFlag();
+            if(!isMovableAddressCalculation(it) || (usesFlags && skippedInstructionsUseFlags))
+                break;
+            calculationUsesFlags = calculationUsesFlags || usesFlags;
+            for(const Value& arg : it->getArguments())
+            {
+                if(arg.hasLocal())
+                    requiredLocals.emplace(arg.local());
+            }
+            writtenLocals.emplace(it->getOutput()->local());
+            addressCalculation.push_back(it);
+            continue;
+        }
+        // the skipped instruction must not depend on the address calculation being executed afterwards
+        if(std::any_of(writtenLocals.begin(), writtenLocals.end(),
+               [&](const Local* loc) -> bool { return it->readsLocal(loc) || it->writesLocal(loc); }))
+            break;
+        bool usesFlags = it->hasConditionalExecution() || it->doesSetFlag() || it.has<Branch>();
+        if(usesFlags && calculationUsesFlags)
+            break;
+        if(it->signal == (load.onTMU1 ? SIGNAL_LOAD_TMU1 : SIGNAL_LOAD_TMU0))
+        {
+            // moving the request before reading the previous result increases the number of pending requests
+            if(numPendingLoads == TMU_FIFO_DEPTH)
+                break;
+            ++numPendingLoads;
+        }
+        skippedInstructionsUseFlags = skippedInstructionsUseFlags || usesFlags;
+        if(it->mapsToASMInstruction())
+            ++numSkippedInstructions;
+        insertPos = it;
+        numInstructionsToMove = addressCalculation.size();
+    }
+    if(!insertPos)
+        return false;
+
+    logging::debug() << "Issuing TMU load " << numSkippedInstructions << " instructions early: "
+                     << load.addressWrite->to_string() << logging::endl;
+    // the instructions are inserted in order before the same position
+    for(std::size_t i = numInstructionsToMove; i > 0; --i)
+        moveInstructionUp(insertPos.value(), addressCalculation[i - 1]);
+    load.addressWrite = moveInstructionUp(insertPos.value(), load.addressWrite);
+    return true;
+}
+
+static bool pipelineTMULoads(BasicBlock& block)
+{
+    std::vector<TMULoad> loads;
+    bool hasUnknownAccesses = false;
+    auto it = block.begin();
+    while(!it.isEndOfBlock())
+    {
+        if(auto load = it.has() ? matchTMULoad(it) : Optional<TMULoad>{})
+        {
+            loads.push_back(load.value());
+            it = load->resultRead.copy().nextInBlock();
+            continue;
+        }
+        if(it.has() && accessesTMU(it.get()))
+            hasUnknownAccesses = true;
+        it.nextInBlock();
+    }
+    if(loads.empty() || hasUnknownAccesses)
+        // e.g. image reads, which we do not handle
+        return false;
+
+    bool hasChanged = false;
+    if(loads.size() > 1)
+    {
+        // distribute the loads over both TMUs, so consecutive loads can be processed in parallel
+        bool useTMU1 = false;
+        for(TMULoad& load : loads)
+        {
+            if(load.onTMU1 != useTMU1)
+            {
+                load.addressWrite->setOutput(
+                    Value(useTMU1 ? REG_TMU1_ADDRESS : REG_TMU0_ADDRESS, load.addressWrite->getOutput()->type));
+                load.trigger->setSignaling(useTMU1 ? SIGNAL_LOAD_TMU1 : SIGNAL_LOAD_TMU0);
+                load.onTMU1 = useTMU1;
+                hasChanged = true;
+            }
+            useTMU1 = !useTMU1;
+        }
+    }
+    for(TMULoad& load : loads)
+        hasChanged = deferTMUResultRead(load) || hasChanged;
+    for(TMULoad& load : loads)
+        hasChanged = issueTMULoadEarly(load) || hasChanged;
+    return hasChanged;
+}
+
+bool optimizations::pipelineTMUAccess(const Module& module, Method& method, const Configuration& config)
+{
+    bool hasChanged = false;
+    for(BasicBlock& block : method)
+        hasChanged = pipelineTMULoads(block) || hasChanged;
+    return hasChanged;
+}
+
 bool optimizations::splitReadAfterWrites(const Module& module, Method& method, const Configuration& config)
 {
     // try to split up consecutive instructions writing/reading to the same local (so less locals are forced to
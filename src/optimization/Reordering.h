@@ -24,6 +24,31 @@ namespace vc4c
          */
         InstructionWalker moveInstructionUp(InstructionWalker dest, InstructionWalker it);
 
+        /*
+         * Overlaps DMA transfers between RAM and VPM with computations by splitting the issuing of a transfer from
+         * waiting for its completion:
+         * - adjacent critical sections (VPM mutex) within a basic block are merged
+         * - DMA loads are issued directly after the previous load completed (instead of after the previous data was
+         * read), using alternating rows of the VPM scratch area (double-buffering)
+         * - waiting for DMA stores is deferred up to the next instruction depending on the store being completed
+         *
+         * NOTE: The waits are never moved out of the critical section, so other QPUs can't access the VPM rows in use
+         * NOTE: Only transfers within a single basic block are overlapped (no prefetching for the next loop iteration),
+         * so this pass is not enabled by default
+         */
+        bool pipelineDMAAccess(const Module& module, Method& method, const Configuration& config);
+
+        /*
+         * Overlaps general memory loads via the TMUs with computations:
+         * - the loads within a basic block are distributed alternately over TMU0 and TMU1
+         * - the triggering of the load into r4 and the reading of r4 are moved down to the first use of the result
+         * - the address writes (together with the calculation of the address) are moved up, as long as no more than the
+         * TMU FIFO depth of requests is pending for a single TMU
+         *
+         * NOTE: Image reads as well as loads spanning basic blocks are not modified
+         */
+        bool pipelineTMUAccess(const Module& module, Method& method, const Configuration& config);
+
         /*
          * Splits up writing of a local directly followed by an instruction reading it if the local is unlikely to be
          * mapped to an accumulator by inserting nop-instructions. This optimization-pass on its own is actually an
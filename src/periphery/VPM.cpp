@@ -827,10 +827,53 @@ const VPMArea* VPM::findArea(const Local* local)
     for(const auto& area : areas)
         if(area && area->originalAddress == local)
             return area.get();
+    for(const auto& area : sharedAreas)
+        if(area->originalAddress == local)
+            return area.get();
     return nullptr;
 }
 
-const VPMArea* VPM::addArea(const Local* local, const DataType& elementType, bool isStackArea, unsigned numStacks)
+static unsigned getStackFrameSize(const VPMArea& area)
+{
+    if(area.usageType != VPMUsage::STACK || area.originalAddress == nullptr)
+        return 0;
+    return VPM::getVPMStorageType(area.originalAddress->type.getElementType()).getPhysicalWidth();
+}
+
+bool VPM::canShareRows(unsigned rowOffset, unsigned numRows, VPMUsage usageType, unsigned stackFrameSize,
+    const VPMLifetime& lifetime) const
+{
+    FastSet<const VPMArea*> overlappingAreas;
+    for(auto i = rowOffset; i < rowOffset + numRows; ++i)
+    {
+        if(areas[i])
+            overlappingAreas.emplace(areas[i].get());
+    }
+    for(const auto& area : sharedAreas)
+    {
+        if(area->rowOffset < rowOffset + numRows && rowOffset < area->rowOffset + area->numRows)
+            overlappingAreas.emplace(area.get());
+    }
+    for(const VPMArea* area : overlappingAreas)
+    {
+        // scratch and spilled registers are in use for the whole kernel
+        if(area->usageType != usageType || area->usageType == VPMUsage::SCRATCH ||
+            area->usageType == VPMUsage::REGISTER_SPILLING)
+            return false;
+        auto lifetimeIt = lifetimes.find(area);
+        if(lifetimeIt == lifetimes.end() || lifetimeIt->second.overlaps(lifetime))
+            return false;
+        // the stack frame of every QPU is located at the area offset + QPU number * frame size, so the frames of
+        // different QPUs only match if both areas are laid out exactly the same
+        if(usageType == VPMUsage::STACK &&
+            (area->rowOffset != rowOffset || area->numRows != numRows || getStackFrameSize(*area) != stackFrameSize))
+            return false;
+    }
+    return true;
+}
+
+const VPMArea* VPM::addArea(const Local* local, const DataType& elementType, bool isStackArea, unsigned numStacks,
+    const Optional<VPMLifetime>& lifetime)
 {
     // Since we can only read/write in packages of 16-element vectors on the QPU-side, we need to reserve enough space
     // for 16-element vectors (even if we do not use all of the elements)
@@ -846,24 +889,45 @@ const VPMArea* VPM::addArea(const Local* local, const DataType& elementType, boo
     if(area != nullptr && area->numRows >= numRows)
         return area;
 
+    const VPMUsage usageType = isStackArea ? VPMUsage::STACK : VPMUsage::LOCAL_MEMORY;
     // find free consecutive space in VPM with the requested size and return it
     // to keep the remaining space free for scratch, we start allocating space from the end of the VPM
     Optional<unsigned> rowOffset;
-    uint8_t numFreeRows = 0;
-    for(auto i = areas.size() - 1; i > 0 /* index 0 is always reserved for scratch */; --i)
+    bool sharesRows = false;
+    if(lifetime)
     {
-        if(areas[i])
+        // areas with known lifetime can re-use the rows of areas not live at the same time (similar to interval
+        // coloring). Since areas are allocated from the end, this will prefer already used rows over free rows
+        for(auto i = areas.size() - numRows; i > 0 /* index 0 is always reserved for scratch */; --i)
         {
-            // row is already reserved
-            numFreeRows = 0;
-            continue;
+            if(canShareRows(static_cast<unsigned>(i), numRows, usageType, inVPMType.getPhysicalWidth(), *lifetime))
+            {
+                rowOffset = static_cast<unsigned>(i);
+                sharesRows = std::any_of(areas.begin() + static_cast<std::ptrdiff_t>(i),
+                    areas.begin() + static_cast<std::ptrdiff_t>(i + numRows),
+                    [](const std::shared_ptr<VPMArea>& a) -> bool { return a != nullptr; });
+                break;
+            }
         }
-        else
-            ++numFreeRows;
-        if(numFreeRows >= numRows)
+    }
+    else
+    {
+        uint8_t numFreeRows = 0;
+        for(auto i = areas.size() - 1; i > 0 /* index 0 is always reserved for scratch */; --i)
         {
-            rowOffset = static_cast<unsigned>(i);
-            break;
+            if(areas[i])
+            {
+                // row is already reserved
+                numFreeRows = 0;
+                continue;
+            }
+            else
+                ++numFreeRows;
+            if(numFreeRows >= numRows)
+            {
+                rowOffset = static_cast<unsigned>(i);
+                break;
+            }
         }
     }
     if(!rowOffset)
@@ -871,15 +935,23 @@ const VPMArea* VPM::addArea(const Local* local, const DataType& elementType, boo
         return nullptr;
 
     // for now align all new VPM areas at the beginning of a column
-    auto ptr = std::make_shared<VPMArea>(VPMArea{isStackArea ? VPMUsage::STACK : VPMUsage::LOCAL_MEMORY,
-        static_cast<uint8_t>(rowOffset.value()), numRows, local});
+    auto ptr = std::make_shared<VPMArea>(VPMArea{usageType, static_cast<uint8_t>(rowOffset.value()), numRows, local});
     for(auto i = rowOffset.value(); i < (rowOffset.value() + numRows); ++i)
-        areas[i] = ptr;
+    {
+        if(!areas[i])
+            areas[i] = ptr;
+    }
+    if(sharesRows)
+        sharedAreas.push_back(ptr);
+    if(lifetime)
+        lifetimes.emplace(ptr.get(), lifetime.value());
     logging::debug() << "Allocating " << numRows << " rows (per 64 byte) of VPM cache starting at row "
                      << rowOffset.value() << " for local: " << local->to_string(false)
                      << (isStackArea ? std::string("(") + std::to_string(numStacks) + " stacks )" : "")
-                     << logging::endl;
+                     << (sharesRows ? " (sharing rows with areas of disjoint lifetime)" : "") << logging::endl;
     PROFILE_COUNTER(vc4c::profiler::COUNTER_GENERAL + 90, "VPM cache size", requestedSize);
+    if(sharesRows)
+        PROFILE_COUNTER(vc4c::profiler::COUNTER_GENERAL + 91, "VPM cache size re-used", requestedSize);
     return ptr.get();
 }
 
@@ -919,6 +991,37 @@ void VPM::updateScratchSize(unsigned char requestedRows)
     }
 }
 
+void VPM::dumpUsage() const
+{
+    unsigned usedRows = 0;
+    unsigned requestedRows = 0;
+    FastSet<const VPMArea*> allAreas;
+    for(const auto& area : areas)
+    {
+        if(area)
+        {
+            ++usedRows;
+            allAreas.emplace(area.get());
+        }
+    }
+    for(const auto& area : sharedAreas)
+        allAreas.emplace(area.get());
+    for(const VPMArea* area : allAreas)
+    {
+        requestedRows += area->numRows;
+        auto lifetimeIt = lifetimes.find(area);
+        logging::debug() << "VPM area: " << area->to_string()
+                         << (lifetimeIt != lifetimes.end() ?
+                                    " live in instructions [" + std::to_string(lifetimeIt->second.firstUse) + ", " +
+                                        std::to_string(lifetimeIt->second.lastUse) + "]" :
+                                    "")
+                         << logging::endl;
+    }
+    logging::debug() << "VPM usage: " << usedRows << " of " << (maximumVPMSize / (VPM_NUM_COLUMNS * VPM_WORD_WIDTH))
+                     << " rows (" << usedRows * VPM_NUM_COLUMNS * VPM_WORD_WIDTH << " bytes) in " << allAreas.size()
+                     << " areas, " << (requestedRows - usedRows) << " rows saved by re-using rows" << logging::endl;
+}
+
 InstructionWalker VPM::insertLockMutex(InstructionWalker it, bool useMutex) const
 {
     if(useMutex)
@@ -739,6 +739,23 @@ namespace vc4c
             std::string to_string() const;
         };
 
+        /*
+         * The range of instructions (as indices into the linear list of instructions of a method) an area of the VPM is
+         * in use.
+         *
+         * Areas with non-overlapping lifetimes can share the same rows of VPM.
+         */
+        struct VPMLifetime
+        {
+            std::size_t firstUse;
+            std::size_t lastUse;
+
+            bool overlaps(const VPMLifetime& other) const
+            {
+                return firstUse <= other.lastUse && other.firstUse <= lastUse;
+            }
+        };
+
         /*
          * Object wrapping the VPM cache component
          *
@@ -761,8 +778,14 @@ namespace vc4c
 
             const VPMArea& getScratchArea() const;
             const VPMArea* findArea(const Local* local);
-            const VPMArea* addArea(
-                const Local* local, const DataType& elementType, bool isStackArea, unsigned numStacks = NUM_QPUS);
+            /*
+             * Reserves an area of VPM for the given local.
+             *
+             * If the lifetime of the area is given, the area may re-use the rows of other areas of the same usage-type
+             * whose lifetimes do not overlap with the given one.
+             */
+            const VPMArea* addArea(const Local* local, const DataType& elementType, bool isStackArea,
+                unsigned numStacks = NUM_QPUS, const Optional<VPMLifetime>& lifetime = {});
 
             /*
              * The maximum number of vectors (of the given type) which can be cached in this VPM.
@@ -822,9 +845,21 @@ namespace vc4c
              */
             static DataType getVPMStorageType(const DataType& type);
 
+            /*
+             * Prints the usage of the VPM (areas, rows used, rows saved by sharing rows between areas)
+             */
+            void dumpUsage() const;
+
         private:
             const unsigned maximumVPMSize;
             std::vector<std::shared_ptr<VPMArea>> areas;
+            // the areas sharing (some of) their rows with other areas, these are not necessarily listed in #areas
+            std::vector<std::shared_ptr<VPMArea>> sharedAreas;
+            // the lifetimes of the areas added with a known lifetime
+            FastMap<const VPMArea*, VPMLifetime> lifetimes;
+
+            bool canShareRows(unsigned rowOffset, unsigned numRows, VPMUsage usageType, unsigned stackFrameSize,
+                const VPMLifetime& lifetime) const;
 
             InstructionWalker insertLockMutex(InstructionWalker it, bool useMutex) const;
             InstructionWalker insertUnlockMutex(InstructionWalker it, bool useMutex) const;
@@ -0,0 +1,277 @@
+/*
+ * Author: doe300
+ *
+ * See the file "LICENSE" for the full license governing this code.
+ */
+
+#include "ClangLibrary.h"
+
+#include "../Profiler.h"
+#include "log.h"
+
+#ifdef USE_CLANG_LIBRARY
+#include "clang/CodeGen/CodeGenAction.h"
+#if LLVM_LIBRARY_VERSION >= 70
+#include "clang/Driver/Driver.h"
+#endif
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#if LLVM_LIBRARY_VERSION >= 40
+#include "llvm/Bitcode/BitcodeReader.h"
+#else
+#include "llvm/Bitcode/ReaderWriter.h"
+#endif
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO/Internalize.h"
+#if LLVM_LIBRARY_VERSION >= 140
+#include "llvm/Passes/PassBuilder.h"
+#else
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#endif
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+#endif
+
+using namespace vc4c;
+using namespace vc4c::precompilation;
+
+bool precompilation::isInProcessCompilationAvailable(const Configuration& config)
+{
+#ifdef USE_CLANG_LIBRARY
+    // the in-process compilation produces LLVM modules, which can only be read by the LLVM library front-end
+    return config.frontend != Frontend::SPIR_V;
+#else
+    return false;
+#endif
+}
+
+#ifdef USE_CLANG_LIBRARY
+// name of the virtual file the OpenCL C source is mapped to, if it is read from a stream
+static const std::string STREAM_INPUT_NAME = "<stdin>.cl";
+
+static std::vector<std::string> splitOptions(const std::string& options)
+{
+    // XXX does not support quoted options containing white-spaces
+    std::vector<std::string> result;
+    std::istringstream ss(options);
+    std::copy(std::istream_iterator<std::string>(ss), std::istream_iterator<std::string>(), std::back_inserter(result));
+    return result;
+}
+
+/*
+ * Returns the resource directory of the clang the VC4C was built with, which contains the clang built-in headers (e.g.
+ * opencl-c.h included via "-finclude-default-header").
+ *
+ * Since the compiler instance is created inside the host program (e.g. VC4CL), it cannot determine the resource
+ * directory relative to its own executable like the clang executable does.
+ */
+static std::string getResourceDirectory()
+{
+#if defined(CLANG_RESOURCE_DIR)
+    return CLANG_RESOURCE_DIR;
+#elif defined(CLANG_PATH) && LLVM_LIBRARY_VERSION >= 70
+    return clang::driver::Driver::GetResourcesPath(CLANG_PATH);
+#else
+    logging::warn() << "Resource directory of clang is unknown, clang built-in headers might not be found"
+                    << logging::endl;
+    return "";
+#endif
+}
+
+static std::unique_ptr<llvm::Module> runClang(
+    llvm::LLVMContext& context, OpenCLSource&& source, const std::string& userOptions, bool usePCH)
+{
+    // in both instances, compile to SPIR to match the "architecture" the PCH was compiled for
+    std::vector<std::string> options{"-triple", "spir-unknown-unknown"};
+    auto tmp = splitOptions(userOptions);
+    options.insert(options.end(), tmp.begin(), tmp.end());
+    tmp = buildClangOptions(userOptions, usePCH);
+    options.insert(options.end(), tmp.begin(), tmp.end());
+    options.emplace_back(source.file.value_or(STREAM_INPUT_NAME));
+
+    std::vector<const char*> arguments;
+    arguments.reserve(options.size());
+    std::transform(options.begin(), options.end(), std::back_inserter(arguments),
+        [](const std::string& option) -> const char* { return option.data(); });
+
+    logging::info() << "Compiling OpenCL to LLVM module in-process with: "
+                    << std::accumulate(options.begin(), options.end(), std::string{},
+                           [](const std::string& a, const std::string& b) -> std::string { return a + " " + b; })
+                    << logging::endl;
+
+    std::string diagnostics;
+    llvm::raw_string_ostream diagnosticsStream(diagnostics);
+    clang::CompilerInstance compiler;
+    // the compiler instance takes ownership of the diagnostics printer
+    compiler.createDiagnostics(new clang::TextDiagnosticPrinter(diagnosticsStream, new clang::DiagnosticOptions()));
+
+#if LLVM_LIBRARY_VERSION >= 100
+    bool validArguments =
+        clang::CompilerInvocation::CreateFromArgs(compiler.getInvocation(), arguments, compiler.getDiagnostics());
+#else
+    bool validArguments = clang::CompilerInvocation::CreateFromArgs(compiler.getInvocation(), arguments.data(),
+        arguments.data() + arguments.size(), compiler.getDiagnostics());
+#endif
+    if(!validArguments)
+        throw CompilationError(
+            CompilationStep::PRECOMPILATION, "Invalid compilation options", diagnosticsStream.str());
+    compiler.getHeaderSearchOpts().ResourceDir = getResourceDirectory();
+
+    if(!source.file)
+    {
+        // clang cannot read from std::istreams, so we map the source code to a virtual file
+        const std::string code((std::istreambuf_iterator<char>(*source.stream)), std::istreambuf_iterator<char>());
+        // the pre-processor takes ownership of the buffer
+        compiler.getPreprocessorOpts().addRemappedFile(
+            STREAM_INPUT_NAME, llvm::MemoryBuffer::getMemBufferCopy(code, STREAM_INPUT_NAME).release());
+    }
+
+    clang::EmitLLVMOnlyAction action(&context);
+    bool success = compiler.ExecuteAction(action);
+    if(!success)
+    {
+        logging::error() << "Errors in precompilation:" << logging::endl;
+        logging::error() << diagnosticsStream.str() << logging::endl;
+        throw CompilationError(CompilationStep::PRECOMPILATION, "Error in precompilation", diagnosticsStream.str());
+    }
+    if(!diagnosticsStream.str().empty())
+    {
+        logging::warn() << "Warnings in precompilation:" << logging::endl;
+        logging::warn() << diagnosticsStream.str() << logging::endl;
+    }
+    return action.takeModule();
+}
+
+#ifdef VC4CL_STDLIB_MODULE
+/*
+ * LLVM modules are bound to the LLVMContext they were created in and can therefore not be shared between compilations.
+ * Instead, the bit-code of the VC4CL standard-library module is read from disk only once per process and then lazily
+ * loaded into the context of every single compilation.
+ */
+static const llvm::MemoryBuffer& getStdlibModuleBuffer()
+{
+    // thread-safe initialization, if reading the file fails, the next call retries
+    static const std::unique_ptr<llvm::MemoryBuffer> buffer = []() -> std::unique_ptr<llvm::MemoryBuffer> {
+        PROFILE_START(LoadStdlibModule);
+        auto result = llvm::MemoryBuffer::getFile(VC4CL_STDLIB_MODULE);
+        if(!result)
+            throw CompilationError(CompilationStep::LINKER, "Error reading VC4CL standard-library module",
+                result.getError().message());
+        logging::debug() << "Loaded VC4CL standard-library module '" << VC4CL_STDLIB_MODULE << "' with "
+                         << result.get()->getBufferSize() << " bytes" << logging::endl;
+        PROFILE_END(LoadStdlibModule);
+        return std::move(result.get());
+    }();
+    return *buffer;
+}
+
+static std::unique_ptr<llvm::Module> loadStdlibModule(llvm::LLVMContext& context)
+{
+    // only reads the module "skeleton", the function bodies are materialized by the linker as they are required
+#if LLVM_LIBRARY_VERSION >= 40
+    auto expected = llvm::getLazyBitcodeModule(getStdlibModuleBuffer().getMemBufferRef(), context);
+    if(!expected)
+        throw CompilationError(CompilationStep::LINKER, "Error reading VC4CL standard-library module",
+            llvm::toString(expected.takeError()));
+#else
+    // the LLVM module takes ownership of the buffer, so pass it a non-owning reference to our cached buffer
+    auto expected = llvm::getLazyBitcodeModule(
+        llvm::MemoryBuffer::getMemBuffer(getStdlibModuleBuffer().getMemBufferRef(), false), context);
+    if(!expected)
+        throw CompilationError(
+            CompilationStep::LINKER, "Error reading VC4CL standard-library module", expected.getError().message());
+#endif
+    return std::move(expected.get());
+}
+#endif
+
+static void linkInStdlibModule(llvm::LLVMContext& context, llvm::Module& module)
+{
+#ifdef VC4CL_STDLIB_MODULE
+    std::unique_ptr<llvm::Module> stdlib = loadStdlibModule(context);
+
+    logging::info() << "Linking in VC4CL standard-library module: " << VC4CL_STDLIB_MODULE << logging::endl;
+    // same as "llvm-link -only-needed -internalize"
+#if LLVM_LIBRARY_VERSION >= 40
+    bool failed = llvm::Linker::linkModules(module, std::move(stdlib), llvm::Linker::Flags::LinkOnlyNeeded,
+        [](llvm::Module& m, const llvm::StringSet<>& linkedGlobals) {
+            llvm::internalizeModule(m, [&linkedGlobals](const llvm::GlobalValue& global) -> bool {
+                return !global.hasName() || linkedGlobals.count(global.getName()) == 0;
+            });
+        });
+#else
+    bool failed = llvm::Linker::linkModules(module, std::move(stdlib), llvm::Linker::Flags::LinkOnlyNeeded);
+#endif
+    if(failed)
+        throw CompilationError(CompilationStep::LINKER, "Error linking in VC4CL standard-library module");
+#else
+    throw CompilationError(CompilationStep::LINKER, "LLVM IR module for VC4CL std-lib is not defined!");
+#endif
+}
+
+static void optimizeModule(llvm::Module& module)
+{
+    logging::info() << "Optimizing LLVM module in-process..." << logging::endl;
+#if LLVM_LIBRARY_VERSION >= 140
+    llvm::LoopAnalysisManager loopAnalyses;
+    llvm::FunctionAnalysisManager functionAnalyses;
+    llvm::CGSCCAnalysisManager cgsccAnalyses;
+    llvm::ModuleAnalysisManager moduleAnalyses;
+
+    llvm::PassBuilder builder;
+    builder.registerModuleAnalyses(moduleAnalyses);
+    builder.registerCGSCCAnalyses(cgsccAnalyses);
+    builder.registerFunctionAnalyses(functionAnalyses);
+    builder.registerLoopAnalyses(loopAnalyses);
+    builder.crossRegisterProxies(loopAnalyses, functionAnalyses, cgsccAnalyses, moduleAnalyses);
+
+    // same as "opt -O3"
+    llvm::ModulePassManager passes = builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+    passes.run(module, moduleAnalyses);
+#else
+    llvm::PassManagerBuilder builder;
+    builder.OptLevel = 3;
+    llvm::legacy::FunctionPassManager functionPasses(&module);
+    llvm::legacy::PassManager modulePasses;
+    builder.populateFunctionPassManager(functionPasses);
+    builder.populateModulePassManager(modulePasses);
+
+    functionPasses.doInitialization();
+    for(llvm::Function& func : module)
+        functionPasses.run(func);
+    functionPasses.doFinalization();
+    modulePasses.run(module);
+#endif
+}
+
+InMemoryLLVMModule precompilation::compileOpenCLInProcess(
+    OpenCLSource&& source, const std::string& userOptions, bool runOptimizations)
+{
+    PROFILE_START(CompileOpenCLInProcess);
+    InMemoryLLVMModule result;
+    result.context.reset(new llvm::LLVMContext());
+#ifdef VC4CL_STDLIB_MODULE
+    // same as compileOpenCLAndLinkModule
+    result.module = runClang(*result.context, std::forward<OpenCLSource>(source), userOptions, false);
+    if(result.module)
+        linkInStdlibModule(*result.context, *result.module);
+#else
+    result.module = runClang(*result.context, std::forward<OpenCLSource>(source), userOptions, true);
+#endif
+    if(!result.module)
+        throw CompilationError(CompilationStep::PRECOMPILATION, "Compilation did not produce a LLVM module");
+    if(runOptimizations)
+        optimizeModule(*result.module);
+    PROFILE_END(CompileOpenCLInProcess);
+    logging::info() << "Compilation complete!" << logging::endl;
+    return result;
+}
+#endif
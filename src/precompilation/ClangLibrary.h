@@ -0,0 +1,53 @@
+/*
+ * Author: doe300
+ *
+ * See the file "LICENSE" for the full license governing this code.
+ */
+
+#ifndef VC4C_CLANG_LIBRARY
+#define VC4C_CLANG_LIBRARY
+
+#include "FrontendCompiler.h"
+
+#ifdef USE_CLANG_LIBRARY
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#endif
+
+namespace vc4c
+{
+    namespace precompilation
+    {
+#ifdef USE_CLANG_LIBRARY
+        /*
+         * An LLVM module together with the context it was created in.
+         *
+         * The context needs to outlive the module, so they are passed around together.
+         */
+        struct InMemoryLLVMModule
+        {
+            std::unique_ptr<llvm::LLVMContext> context;
+            std::unique_ptr<llvm::Module> module;
+        };
+
+        /*
+         * Compiles the OpenCL C source into an LLVM module without leaving the current process.
+         *
+         * This runs the clang front-end via its library interface, links the VC4CL standard-library module (if
+         * configured) with the LLVM linker and optionally runs the LLVM optimization pipeline on the result. The
+         * standard-library module is read once per process and only the functions referenced are materialized. In
+         * contrast to the other pre-compilation steps, no external process is started and the module is never
+         * serialized, so it can be passed directly to the LLVM library front-end.
+         */
+        InMemoryLLVMModule compileOpenCLInProcess(
+            OpenCLSource&& source, const std::string& userOptions, bool runOptimizations);
+#endif
+
+        /*
+         * Returns whether OpenCL C code can be compiled in-process with the given configuration
+         */
+        bool isInProcessCompilationAvailable(const Configuration& config);
+    } // namespace precompilation
+} // namespace vc4c
+
+#endif /* VC4C_CLANG_LIBRARY */
@@ -20,63 +20,73 @@
 using namespace vc4c;
 using namespace vc4c::precompilation;
 
-static std::string buildClangCommand(const std::string& compiler, const std::string& defaultOptions,
-    const std::string& options, const std::string& emitter, const std::string& outputFile,
-    const std::string& inputFile = "-", bool usePCH = true)
+std::vector<std::string> precompilation::buildClangOptions(const std::string& options, bool usePCH)
 {
     // check validity of options - we do not support all of them
     if(options.find("-create-library") != std::string::npos)
         throw CompilationError(CompilationStep::PRECOMPILATION, "Invalid compilation options", options);
 
-    // build command-string
-    std::string command;
-    command.append(compiler).append(" ").append(defaultOptions).append(" ").append(options).append(" ");
-
-    // append default options
+    std::vector<std::string> defaultOptions;
     if(options.find("-O") == std::string::npos)
     {
         // unroll loops, pre-calculate constants, inline functions, ...
-        command.append("-O3 ");
+        defaultOptions.emplace_back("-O3");
     }
     if(options.find("-ffp-contract") == std::string::npos)
     {
         // disable fused floationg-point operations, since we do not support them anyway
-        command.append("-ffp-contract=off ");
+        defaultOptions.emplace_back("-ffp-contract=off");
     }
 
 #if defined USE_CLANG_OPENCL || defined SPIRV_CLANG_PATH
     if(options.find("-cl-std") == std::string::npos)
     {
         // build OpenCL 1.2
-        command.append("-cl-std=CL1.2 ");
+        defaultOptions.emplace_back("-cl-std=CL1.2");
     }
     if(options.find("-cl-kernel-arg-info") == std::string::npos)
     {
         // make sure infos for arguments are generated
-        command.append("-cl-kernel-arg-info ");
+        defaultOptions.emplace_back("-cl-kernel-arg-info");
     }
     if(options.find("-cl-single-precision-constant") == std::string::npos)
     {
         // suppressed warnings about double constants
-        command.append("-cl-single-precision-constant ");
+        defaultOptions.emplace_back("-cl-single-precision-constant");
     }
 #endif
     // link in our standard-functions
-    command.append(" -Wno-undefined-inline -Wno-unused-parameter -Wno-unused-local-typedef -Wno-gcc-compat ");
+    defaultOptions.insert(defaultOptions.end(),
+        {"-Wno-undefined-inline", "-Wno-unused-parameter", "-Wno-unused-local-typedef", "-Wno-gcc-compat"});
     if(usePCH)
-        command.append("-include-pch " VC4CL_STDLIB_HEADER " ");
+        defaultOptions.insert(defaultOptions.end(), {"-include-pch", VC4CL_STDLIB_HEADER});
     else
     {
-        command.append("-finclude-default-header ");
+        defaultOptions.emplace_back("-finclude-default-header");
         // The #defines (esp. for extensions) from the default headers differ from the supported #defines,
         // so we need to include our #defines/undefines
-        command.append("-include " VC4CL_STDLIB_CONFIG_HEADER " ");
+        defaultOptions.insert(defaultOptions.end(), {"-include", VC4CL_STDLIB_CONFIG_HEADER});
     }
     if(options.find("-x cl") == std::string::npos)
     {
         // build OpenCL, required when input is from stdin, since clang can't determine from file-type
-        command.append("-x cl ");
+        defaultOptions.insert(defaultOptions.end(), {"-x", "cl"});
     }
+    return defaultOptions;
+}
+
+static std::string buildClangCommand(const std::string& compiler, const std::string& defaultOptions,
+    const std::string& options, const std::string& emitter, const std::string& outputFile,
+    const std::string& inputFile = "-", bool usePCH = true)
+{
+    // build command-string
+    std::string command;
+    command.append(compiler).append(" ").append(defaultOptions).append(" ").append(options).append(" ");
+
+    // append default options
+    for(const auto& option : buildClangOptions(options, usePCH))
+        command.append(option).append(" ");
+
     // use temporary file as output
     // use stdin as input
     return command.append(emitter).append(" -o ").append(outputFile).append(" ").append(inputFile);
@@ -89,6 +89,12 @@ namespace vc4c
         using SPIRVResult = PrecompilationResult<SourceType::SPIRV_BIN>;
         using SPIRVTextResult = PrecompilationResult<SourceType::SPIRV_TEXT>;
 
+        /*
+         * Returns the default options passed to clang for compiling OpenCL C code in addition to the user-specified
+         * options, e.g. the optimization level, OpenCL version and the VC4CL standard-library header to include.
+         */
+        std::vector<std::string> buildClangOptions(const std::string& options, bool usePCH);
+
         void compileOpenCLWithPCH(OpenCLSource&& source, const std::string& userOptions, LLVMIRResult& result);
         void compileOpenCLWithDefaultHeader(
             OpenCLSource&& source, const std::string& userOptions, LLVMIRResult& result);
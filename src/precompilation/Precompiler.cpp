@@ -325,14 +325,29 @@ void Precompiler::run(std::unique_ptr<std::istream>& output, const SourceType ou
         extendedOptions.append(" -I ").append(tmp);
     }
 
-    if(inputType == outputType)
+    if(inputType == outputType || inputType == SourceType::LLVM_IR_TEXT)
     {
-        const std::string buffer(std::istreambuf_iterator<char>(input), {});
-        output.reset(new std::istringstream(buffer));
+        // the result of this does not necessarily have the correct output-format (e.g. LLVM IR text instead of
+        // bit-code), but can be handled by the LLVM front-end.
+        // NOTE: This does not write into the output file, but hands out the input itself
+        if(inputFile)
+        {
+            // read the input file again instead of copying its content
+            std::unique_ptr<std::ifstream> fileStream(
+                new std::ifstream(inputFile.value(), std::ios_base::in | std::ios_base::binary));
+            if(!fileStream->is_open())
+                throw CompilationError(CompilationStep::PRECOMPILATION, "Failed to open input file", inputFile.value());
+            output = std::move(fileStream);
+        }
+        else
+            // share the buffer of the input stream
+            output.reset(new std::istream(input.rdbuf()));
         return;
     }
 
-    std::ostringstream tempStream;
+    // the result is written to and read from the same buffer, which is then handed to the caller
+    std::unique_ptr<std::stringstream> tempStreamPtr(new std::stringstream());
+    std::stringstream& tempStream = *tempStreamPtr;
 
     if(inputType == SourceType::OPENCL_C)
     {
@@ -376,11 +391,6 @@ void Precompiler::run(std::unique_ptr<std::istream>& output, const SourceType ou
             compileOpenCLToSPIRVText(std::move(src), extendedOptions, res);
         }
     }
-    else if(inputType == SourceType::LLVM_IR_TEXT)
-    {
-        // the result of this does not have the correct output-format (but can be handled by the LLVM front-end)
-        tempStream << input.rdbuf();
-    }
     else if(inputType == SourceType::LLVM_IR_BIN)
     {
         LLVMIRSource src = inputFile ? LLVMIRSource(inputFile.value()) : LLVMIRSource(input);
@@ -412,5 +422,6 @@ void Precompiler::run(std::unique_ptr<std::istream>& output, const SourceType ou
 
     logging::info() << "Compilation complete!" << logging::endl;
 
-    output.reset(new std::istringstream(tempStream.str()));
+    // if an output file is given, the result is only written into the file and the stream handed out stays empty
+    output = std::move(tempStreamPtr);
 }
@@ -741,13 +741,18 @@ void spirv2qasm::consumeSPIRVMessage(
 
 std::vector<uint32_t> spirv2qasm::readStreamOfWords(std::istream* in)
 {
+    // read the data in big chunks directly into the buffer instead of word by word
+    static constexpr std::size_t CHUNK_WORDS = 16 * 1024;
     std::vector<uint32_t> words;
-    words.reserve(in->rdbuf()->in_avail());
-    char buffer[sizeof(uint32_t)];
-    while(in->read(buffer, sizeof(uint32_t)).good())
+    std::size_t numWords = 0;
+    while(in->good())
     {
-        words.push_back(*reinterpret_cast<uint32_t*>(buffer));
+        words.resize(numWords + CHUNK_WORDS);
+        in->read(reinterpret_cast<char*>(words.data() + numWords), CHUNK_WORDS * sizeof(uint32_t));
+        // incomplete trailing words are dropped
+        numWords += static_cast<std::size_t>(in->gcount()) / sizeof(uint32_t);
     }
+    words.resize(numWords);
 
     return words;
 }
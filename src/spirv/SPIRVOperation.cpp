@@ -19,10 +19,10 @@
 using namespace vc4c;
 using namespace vc4c::spirv2qasm;
 
-static Value toNewLocal(Method& method, const uint32_t id, const uint32_t typeID, const TypeMapping& typeMappings,
-    LocalTypeMapping& localTypes)
+static Value toNewLocal(Method& method, const uint32_t id, const uint32_t typeID, const TypeMapping& typeMappings)
 {
-    localTypes[id] = typeID;
+    // the type of the local is already registered in the local type mapping while parsing, so the mapping of the
+    // instructions does not modify any state shared between methods
     return method.findOrCreateLocal(typeMappings.at(typeID), std::string("%") + std::to_string(id))->createReference();
 }
 
@@ -76,7 +76,7 @@ SPIRVInstruction::SPIRVInstruction(const uint32_t id, SPIRVMethod& method, const
 void SPIRVInstruction::mapInstruction(TypeMapping& types, ConstantMapping& constants, LocalTypeMapping& localTypes,
     MethodMapping& methods, AllocationMapping& memoryAllocated) const
 {
-    const Value dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+    const Value dest = toNewLocal(*method.method, id, typeID, types);
     Value arg0 = getValue(operands.at(0), *method.method, types, constants, memoryAllocated, localTypes);
     Optional<Value> arg1(NO_VALUE);
     std::string opCode = opcode;
@@ -194,7 +194,7 @@ SPIRVComparison::SPIRVComparison(const uint32_t id, SPIRVMethod& method, const s
 void SPIRVComparison::mapInstruction(TypeMapping& types, ConstantMapping& constants, LocalTypeMapping& localTypes,
     MethodMapping& methods, AllocationMapping& memoryAllocated) const
 {
-    const Value dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+    const Value dest = toNewLocal(*method.method, id, typeID, types);
     const Value arg0 = getValue(operands.at(0), *method.method, types, constants, memoryAllocated, localTypes);
     const Value arg1 = getValue(operands.at(1), *method.method, types, constants, memoryAllocated, localTypes);
     logging::debug() << "Generating intermediate comparison '" << opcode << "' of " << arg0.to_string(false) << " and "
@@ -236,27 +236,27 @@ Optional<Value> SPIRVComparison::precalculate(
     return NO_VALUE;
 }
 
-SPIRVCallSite::SPIRVCallSite(const uint32_t id, SPIRVMethod& method, const uint32_t methodID, const uint32_t resultType,
-    const std::vector<uint32_t>& arguments) :
+SPIRVCallSite::SPIRVCallSite(const uint32_t id, SPIRVMethod& method, const SPIRVMethod& calledMethod,
+    const uint32_t resultType, const std::vector<uint32_t>& arguments) :
     SPIRVOperation(id, method),
-    methodID(methodID), typeID(resultType), arguments(arguments)
+    calledMethod(&calledMethod), typeID(resultType), arguments(arguments)
 {
 }
 
 SPIRVCallSite::SPIRVCallSite(const uint32_t id, SPIRVMethod& method, const std::string& methodName,
     const uint32_t resultType, const std::vector<uint32_t>& arguments) :
     SPIRVOperation(id, method),
-    typeID(resultType), methodName(methodName), arguments(arguments)
+    calledMethod(nullptr), typeID(resultType), methodName(methodName), arguments(arguments)
 {
 }
 
 void SPIRVCallSite::mapInstruction(TypeMapping& types, ConstantMapping& constants, LocalTypeMapping& localTypes,
     MethodMapping& methods, AllocationMapping& memoryAllocated) const
 {
-    const Value dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+    const Value dest = toNewLocal(*method.method, id, typeID, types);
     std::string calledFunction = methodName.value_or("");
-    if(methodID)
-        calledFunction = methods.at(methodID.value()).method->name;
+    if(calledMethod != nullptr)
+        calledFunction = calledMethod->method->name;
     std::vector<Value> args;
     for(const uint32_t op : arguments)
     {
@@ -349,9 +349,8 @@ Optional<Value> SPIRVBranch::precalculate(
 
 SPIRVLabel::SPIRVLabel(const uint32_t id, SPIRVMethod& method) : SPIRVOperation(id, method) {}
 
-void SPIRVLabel::mapInstruction(std::map<uint32_t, DataType>& types, std::map<uint32_t, Value>& constants,
-    std::map<uint32_t, uint32_t>& localTypes, std::map<uint32_t, SPIRVMethod>& methods,
-    std::map<uint32_t, Local*>& memoryAllocated) const
+void SPIRVLabel::mapInstruction(TypeMapping& types, ConstantMapping& constants, LocalTypeMapping& localTypes,
+    MethodMapping& methods, AllocationMapping& memoryAllocated) const
 {
     logging::debug() << "Generating intermediate label %" << id << logging::endl;
     method.method->appendToEnd(new intermediate::BranchLabel(
@@ -376,7 +375,7 @@ void SPIRVConversion::mapInstruction(TypeMapping& types, ConstantMapping& consta
     MethodMapping& methods, AllocationMapping& memoryAllocated) const
 {
     const Value source = getValue(sourceID, *method.method, types, constants, memoryAllocated, localTypes);
-    const Value dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+    const Value dest = toNewLocal(*method.method, id, typeID, types);
     const uint8_t sourceWidth = source.type.getScalarBitCount();
     const uint8_t destWidth = dest.type.getScalarBitCount();
 
@@ -483,7 +482,7 @@ void SPIRVCopy::mapInstruction(TypeMapping& types, ConstantMapping& constants, L
                 method.method->findOrCreateLocal(source.type, std::string("%") + std::to_string(id))->createReference();
     }
     else
-        dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+        dest = toNewLocal(*method.method, id, typeID, types);
     if(memoryAccess != MemoryAccess::NONE)
     {
         // FIXME can't handle I/O of complex types, e.g. array (bigger than 16 elements), see
@@ -605,7 +604,7 @@ void SPIRVShuffle::mapInstruction(TypeMapping& types, ConstantMapping& constants
     MethodMapping& methods, AllocationMapping& memoryAllocated) const
 {
     // shuffling = iteration over all elements in both vectors and re-ordering in order given
-    const Value dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+    const Value dest = toNewLocal(*method.method, id, typeID, types);
     const Value src0 = getValue(source0, *method.method, types, constants, memoryAllocated, localTypes);
     const Value src1 = getValue(source1, *method.method, types, constants, memoryAllocated, localTypes);
     Value index(UNDEFINED_VALUE);
@@ -651,8 +650,8 @@ void SPIRVShuffle::mapInstruction(TypeMapping& types, ConstantMapping& constants
     intermediate::insertVectorShuffle(method.method->appendToEnd(), *method.method, dest, src0, src1, index);
 }
 
-Optional<Value> SPIRVShuffle::precalculate(const std::map<uint32_t, DataType>& types,
-    const std::map<uint32_t, Value>& constants, const std::map<uint32_t, Local*>& memoryAllocated) const
+Optional<Value> SPIRVShuffle::precalculate(
+    const TypeMapping& types, const ConstantMapping& constants, const AllocationMapping& memoryAllocated) const
 {
     return NO_VALUE;
 }
@@ -669,7 +668,7 @@ void SPIRVIndexOf::mapInstruction(TypeMapping& types, ConstantMapping& constants
 {
     // need to get pointer/address -> reference to content
     // a[i] of type t is at position &a + i * sizeof(t)
-    const Value dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+    const Value dest = toNewLocal(*method.method, id, typeID, types);
     const Value container = getValue(this->container, *method.method, types, constants, memoryAllocated, localTypes);
 
     logging::debug() << "Generating calculating indices of " << container.to_string() << " into " << dest.to_string()
@@ -768,7 +767,7 @@ SPIRVPhi::SPIRVPhi(const uint32_t id, SPIRVMethod& method, const uint32_t result
 void SPIRVPhi::mapInstruction(TypeMapping& types, ConstantMapping& constants, LocalTypeMapping& localTypes,
     MethodMapping& methods, AllocationMapping& memoryAllocated) const
 {
-    const Value dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+    const Value dest = toNewLocal(*method.method, id, typeID, types);
 
     logging::debug() << "Generating Phi-Node with " << sources.size() << " options into " << dest.to_string()
                      << logging::endl;
@@ -804,7 +803,7 @@ void SPIRVSelect::mapInstruction(TypeMapping& types, ConstantMapping& constants,
     const Value sourceTrue = getValue(trueID, *method.method, types, constants, memoryAllocated, localTypes);
     const Value sourceFalse = getValue(falseID, *method.method, types, constants, memoryAllocated, localTypes);
     const Value condition = getValue(condID, *method.method, types, constants, memoryAllocated, localTypes);
-    const Value dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+    const Value dest = toNewLocal(*method.method, id, typeID, types);
 
     logging::debug() << "Generating intermediate select on " << condition.to_string() << " whether to write "
                      << sourceTrue.to_string() << " or " << sourceFalse.to_string() << " into " << dest.to_string(true)
@@ -825,8 +824,8 @@ void SPIRVSelect::mapInstruction(TypeMapping& types, ConstantMapping& constants,
     method.method->appendToEnd(new intermediate::MoveOperation(dest, sourceFalse, COND_ZERO_SET));
 }
 
-Optional<Value> SPIRVSelect::precalculate(const std::map<uint32_t, DataType>& types,
-    const std::map<uint32_t, Value>& constants, const std::map<uint32_t, Local*>& memoryAllocated) const
+Optional<Value> SPIRVSelect::precalculate(
+    const TypeMapping& types, const ConstantMapping& constants, const AllocationMapping& memoryAllocated) const
 {
     auto it = constants.find(condID);
     if(it != constants.end())
@@ -903,7 +902,7 @@ SPIRVImageQuery::SPIRVImageQuery(const uint32_t id, SPIRVMethod& method, const u
 void SPIRVImageQuery::mapInstruction(TypeMapping& types, ConstantMapping& constants, LocalTypeMapping& localTypes,
     MethodMapping& methods, AllocationMapping& memoryAllocated) const
 {
-    const Value dest = toNewLocal(*method.method, id, typeID, types, localTypes);
+    const Value dest = toNewLocal(*method.method, id, typeID, types);
     const Value image = getValue(imageID, *method.method, types, constants, memoryAllocated, localTypes);
     Value param(UNDEFINED_VALUE);
     if(lodOrCoordinate != UNDEFINED_ID)
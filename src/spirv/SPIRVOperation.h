@@ -9,10 +9,13 @@
 #ifdef SPIRV_FRONTEND
 
 #include "../Module.h"
+#include "CompilationError.h"
 #include "Optional.h"
 
+#include <deque>
 #include <map>
 #include <memory>
+#include <tuple>
 #include <vector>
 
 namespace vc4c
@@ -36,11 +39,105 @@ namespace vc4c
             SPIRVMethod(uint32_t id, const Module& module) : method(new Method(module)), id(id) {}
         };
 
-        using TypeMapping = std::map<uint32_t, DataType>;
-        using ConstantMapping = std::map<uint32_t, Value>;
-        using LocalTypeMapping = std::map<uint32_t, uint32_t>;
+        /*
+         * Mapping of SPIR-V IDs to the associated objects.
+         *
+         * Since all SPIR-V IDs are smaller than the ID bound given in the module header, the entries are looked up via
+         * a dense vector indexed by the ID instead of a tree-map. The entries themselves are stored in a deque, so
+         * references to them stay valid on insertion of further entries.
+         *
+         * The interface mimics the used parts of std::map, with plain pointers as iterators.
+         *
+         * NOTE: As long as the index does not grow (see #reserve()), entries for different IDs can be inserted and
+         * read concurrently.
+         */
+        template <typename T>
+        class IdMapping
+        {
+        public:
+            using value_type = std::pair<const uint32_t, T>;
+            using iterator = value_type*;
+            using const_iterator = const value_type*;
+
+            /*
+             * Reserves the index for all IDs up to the given (exclusive) bound
+             */
+            void reserve(uint32_t bound)
+            {
+                if(index.size() < bound)
+                    index.resize(bound, nullptr);
+            }
+
+            iterator find(uint32_t id)
+            {
+                return id < index.size() ? index[id] : nullptr;
+            }
+
+            const_iterator find(uint32_t id) const
+            {
+                return id < index.size() ? index[id] : nullptr;
+            }
+
+            iterator end()
+            {
+                return nullptr;
+            }
+
+            const_iterator end() const
+            {
+                return nullptr;
+            }
+
+            T& at(uint32_t id)
+            {
+                auto it = find(id);
+                if(it == end())
+                    throw CompilationError(CompilationStep::PARSER, "Use of undefined SPIR-V ID", std::to_string(id));
+                return it->second;
+            }
+
+            const T& at(uint32_t id) const
+            {
+                auto it = find(id);
+                if(it == end())
+                    throw CompilationError(CompilationStep::PARSER, "Use of undefined SPIR-V ID", std::to_string(id));
+                return it->second;
+            }
+
+            template <typename... Args>
+            std::pair<iterator, bool> emplace(uint32_t id, Args&&... args)
+            {
+                auto it = find(id);
+                if(it != end())
+                    return std::make_pair(it, false);
+                if(id >= index.size())
+                    index.resize(id + 1, nullptr);
+                entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(id),
+                    std::forward_as_tuple(std::forward<Args>(args)...));
+                index[id] = &entries.back();
+                return std::make_pair(index[id], true);
+            }
+
+            T& operator[](uint32_t id)
+            {
+                return emplace(id).first->second;
+            }
+
+            std::size_t size() const
+            {
+                return entries.size();
+            }
+
+        private:
+            std::vector<value_type*> index;
+            std::deque<value_type> entries;
+        };
+
+        using TypeMapping = IdMapping<DataType>;
+        using ConstantMapping = IdMapping<Value>;
+        using LocalTypeMapping = IdMapping<uint32_t>;
         using MethodMapping = std::map<uint32_t, SPIRVMethod>;
-        using AllocationMapping = std::map<uint32_t, Local*>;
+        using AllocationMapping = IdMapping<Local*>;
 
         class SPIRVOperation
         {
@@ -55,6 +152,14 @@ namespace vc4c
             virtual Optional<Value> precalculate(const TypeMapping& types, const ConstantMapping& constants,
                 const AllocationMapping& memoryAllocated) const = 0;
 
+            /*
+             * Returns the method this operation is located in
+             */
+            const SPIRVMethod& getMethod() const
+            {
+                return method;
+            }
+
         protected:
             const uint32_t id;
             SPIRVMethod& method;
@@ -101,7 +206,7 @@ namespace vc4c
         class SPIRVCallSite final : public SPIRVOperation
         {
         public:
-            SPIRVCallSite(uint32_t id, SPIRVMethod& method, uint32_t methodID, uint32_t resultType,
+            SPIRVCallSite(uint32_t id, SPIRVMethod& method, const SPIRVMethod& calledMethod, uint32_t resultType,
                 const std::vector<uint32_t>& arguments);
             SPIRVCallSite(uint32_t id, SPIRVMethod& method, const std::string& methodName, uint32_t resultType,
                 const std::vector<uint32_t>& arguments);
@@ -113,7 +218,8 @@ namespace vc4c
                 const AllocationMapping& memoryAllocated) const override;
 
         private:
-            Optional<uint32_t> methodID;
+            // the called method is resolved while parsing, since the method-mapping is modified concurrently
+            const SPIRVMethod* calledMethod;
             const uint32_t typeID;
             Optional<std::string> methodName;
             std::vector<uint32_t> arguments;
@@ -159,9 +265,8 @@ namespace vc4c
             SPIRVLabel(uint32_t id, SPIRVMethod& method);
             ~SPIRVLabel() override = default;
 
-            void mapInstruction(std::map<uint32_t, DataType>& types, std::map<uint32_t, Value>& constants,
-                std::map<uint32_t, uint32_t>& localTypes, std::map<uint32_t, SPIRVMethod>& methods,
-                std::map<uint32_t, Local*>& memoryAllocated) const override;
+            void mapInstruction(TypeMapping& types, ConstantMapping& constants, LocalTypeMapping& localTypes,
+                MethodMapping& methods, AllocationMapping& memoryAllocated) const override;
             Optional<Value> precalculate(const TypeMapping& types, const ConstantMapping& constants,
                 const AllocationMapping& memoryAllocated) const override;
         };
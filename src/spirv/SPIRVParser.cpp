@@ -6,31 +6,65 @@
 
 #include "SPIRVParser.h"
 
+#include "../BackgroundWorker.h"
+#include "../Profiler.h"
 #include "../intermediate/IntermediateInstruction.h"
 #include "../intrinsics/Images.h"
 #include "SPIRVHelper.h"
 #include "log.h"
 
+#include <cerrno>
 #include <chrono>
 #include <cstdint>
 #include <cstring>
 
 vc4c::spirv2qasm::SPIRVParser::~SPIRVParser()
 {
-    // out-of-line destructor
+#ifdef SPIRV_FRONTEND
+    // make sure no method is still mapped in the background when aborting the parsing
+    for(auto& mapper : methodMappers)
+        mapper.waitFor();
+#endif
 }
 
 #ifdef SPIRV_FRONTEND
 
-#if __has_include("spirv-tools/optimizer.hpp")
-#include "spirv-tools/optimizer.hpp"
-#endif
+#include "../ProcessUtil.h"
+
+#include <sstream>
 
 using namespace vc4c;
 using namespace vc4c::spirv2qasm;
 
-SPIRVParser::SPIRVParser(std::istream& input, const bool isSPIRVText) :
-    isTextInput(isSPIRVText), input(input), currentMethod(nullptr), module(nullptr)
+// the maximum number of methods mapped in parallel while parsing the remaining module
+static constexpr std::size_t MAX_PARALLEL_MAPPERS = 8;
+// the size of the blocks the operations of a single method are allocated in
+static constexpr std::size_t ARENA_BLOCK_SIZE = 16 * 1024;
+
+OperationArena::~OperationArena()
+{
+    for(SPIRVOperation* op : operations)
+        op->~SPIRVOperation();
+}
+
+void* OperationArena::allocate(const std::size_t size, const std::size_t alignment)
+{
+    blockOffset = (blockOffset + alignment - 1) / alignment * alignment;
+    if(blocks.empty() || blockOffset + size > ARENA_BLOCK_SIZE)
+    {
+        // the memory returned by new[] is aligned for all fundamental types
+        blocks.emplace_back(new uint8_t[std::max(size, ARENA_BLOCK_SIZE)]);
+        blockOffset = 0;
+    }
+    void* ptr = blocks.back().get() + blockOffset;
+    blockOffset += size;
+    return ptr;
+}
+
+SPIRVParser::SPIRVParser(std::istream& input, const bool isSPIRVText, const Configuration& config) :
+    isTextInput(isSPIRVText), optimizationLevel(config.optimizationLevel),
+    optimizerTimeout(config.additionalOptions.spirvOptimizerTimeout), input(input), currentMethod(nullptr),
+    module(nullptr)
 {
 }
 
@@ -56,42 +90,95 @@ static std::string getErrorPosition(spv_diagnostic diagnostics)
     return std::to_string(diagnostics->position.line).append(":") + std::to_string(diagnostics->position.column);
 }
 
-static std::vector<uint32_t> runSPRVToolsOptimizer(const std::vector<uint32_t>& input)
+#ifdef SPIRV_OPTIMIZER_PATH
+static std::string getSPIRVToolsPasses(const OptimizationLevel level)
 {
-#if 0 /* SPIRV-Tools optimizer hangs in some code */
-    logging::debug() << "Running SPIR-V Tools optimizations..." << logging::endl;
-    spvtools::Optimizer opt(SPV_ENV_OPENCL_EMBEDDED_1_2);
-    opt.SetMessageConsumer(consumeSPIRVMessage);
     // converts OpSpecConstant(True/False) to OpConstant(True/False)
-    opt.RegisterPass(spvtools::CreateFreezeSpecConstantValuePass());
+    std::string passes = " --freeze-spec-const";
     // converts OpSpecConstantOp and OpSpecConstantComposite to OpConstants
-    opt.RegisterPass(spvtools::CreateFoldSpecConstantOpAndCompositePass());
-    // unified duplicate constants
-    opt.RegisterPass(spvtools::CreateUnifyConstantPass());
-    // removed obsolete constants
-    opt.RegisterPass(spvtools::CreateEliminateDeadConstantPass());
-    // inline methods
-    opt.RegisterPass(spvtools::CreateInlinePass());
-    // converts access-chain with constant indices
-    opt.RegisterPass(spvtools::CreateLocalAccessChainConvertPass());
-    // replaces access to local memory with register-usage
-    opt.RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass());
-
-    std::vector<uint32_t> optimizedWords;
-    if(!opt.Run(input.data(), input.size(), &optimizedWords))
+    passes.append(" --fold-spec-const-op-composite");
+    // unifies duplicate constants
+    passes.append(" --unify-const");
+    if(level >= OptimizationLevel::MEDIUM)
     {
-        logging::warn() << "Error running SPIR-V Tools optimizer!" << logging::endl;
+        // inline methods
+        passes.append(" --inline-entry-points-exhaustive");
+        // converts access-chain with constant indices
+        passes.append(" --convert-local-access-chains");
+        // replaces access to local memory with register-usage
+        passes.append(" --eliminate-local-single-block");
+        // removes branches on constant conditions and the then unreachable blocks
+        passes.append(" --eliminate-dead-branches");
+        // removes instructions whose results are not used
+        passes.append(" --eliminate-dead-code-aggressive");
+        // removes functions not called anymore after inlining
+        passes.append(" --eliminate-dead-functions");
     }
-    else if(optimizedWords.size() > 0)
+    if(level >= OptimizationLevel::FULL)
     {
-        logging::debug() << "SPIR-V Tools optimizations complete, changed number of words from " << input.size()
-                         << " to " << optimizedWords.size() << logging::endl;
-        return optimizedWords;
+        // replaces access to local memory across basic blocks with register-usage
+        passes.append(" --eliminate-local-multi-store");
+        passes.append(" --cfg-cleanup");
     }
-    else
-        logging::debug() << "SPIR-V Tools optimizations complete, no changes." << logging::endl;
+    // removes constants not used anymore
+    passes.append(" --eliminate-dead-const");
+    if(level >= OptimizationLevel::MEDIUM)
+        // shrinks the ID bound and therefore the ID mappings of the parser
+        passes.append(" --compact-ids");
+    return passes;
+}
+#endif
+
+/*
+ * Runs the SPIRV-Tools optimizer (the spirv-opt program) on the SPIR-V module.
+ *
+ * The SPIRV-Tools optimizer is known to hang (and may crash) for some input. Running it in its own process (spawned
+ * the same way as the other external tools) allows us to abort it after the given timeout without leaving a thread
+ * running in the background and to survive crashes.
+ */
+static std::vector<uint32_t> runSPRVToolsOptimizer(
+    std::vector<uint32_t>&& input, const OptimizationLevel level, const std::chrono::milliseconds timeout)
+{
+    if(level == OptimizationLevel::NONE || timeout.count() == 0)
+        return std::move(input);
+#ifdef SPIRV_OPTIMIZER_PATH
+    logging::debug() << "Running SPIR-V Tools optimizations..." << logging::endl;
+    PROFILE_START(SPIRVToolsOptimizer);
+    // reads the module from stdin and writes the optimized module to stdout
+    const std::string command = std::string(SPIRV_OPTIMIZER_PATH) + getSPIRVToolsPasses(level) + " -o - -";
+    std::istringstream inputStream(
+        std::string(reinterpret_cast<const char*>(input.data()), input.size() * sizeof(uint32_t)));
+    std::ostringstream outputStream;
+    std::ostringstream errorStream;
+    int status = -1;
+    try
+    {
+        status = runProcess(command, &inputStream, &outputStream, &errorStream, timeout);
+    }
+    catch(const CompilationError& e)
+    {
+        logging::warn() << "Running SPIR-V Tools optimizer failed: " << e.what() << logging::endl;
+    }
+    PROFILE_END(SPIRVToolsOptimizer);
+    const std::string output = outputStream.str();
+    if(status != 0 || output.empty() || output.size() % sizeof(uint32_t) != 0)
+    {
+        logging::warn() << "Error running SPIR-V Tools optimizer, continuing with unoptimized module!"
+                        << logging::endl;
+        if(!errorStream.str().empty())
+            logging::debug() << errorStream.str() << logging::endl;
+        return std::move(input);
+    }
+    std::vector<uint32_t> optimizedWords(output.size() / sizeof(uint32_t));
+    std::copy(output.begin(), output.end(), reinterpret_cast<char*>(optimizedWords.data()));
+    logging::debug() << "SPIR-V Tools optimizations complete, changed number of words from " << input.size() << " to "
+                     << optimizedWords.size() << logging::endl;
+    return optimizedWords;
+#else
+    logging::warn() << "SPIR-V Tools optimizer (spirv-opt) not found, skipping SPIR-V Tools optimizations"
+                    << logging::endl;
+    return std::move(input);
 #endif
-    return input;
 }
 
 // to relay names of unsupported operations
@@ -127,10 +214,8 @@ void SPIRVParser::parse(Module& module)
         logging::debug() << "Read SPIR-V binary with " << words.size() << " words" << logging::endl;
     }
 
-        // run SPIR-V Tools optimizations
-#if 0 /* SPIRV-Tools optimizer hangs in some code */
-    words = runSPRVToolsOptimizer(words);
-#endif
+    // run SPIR-V Tools optimizations
+    words = runSPRVToolsOptimizer(std::move(words), optimizationLevel, optimizerTimeout);
 
     logging::debug() << "Starting parsing..." << logging::endl;
 
@@ -149,40 +234,19 @@ void SPIRVParser::parse(Module& module)
     logging::debug() << "SPIR-V binary successfully parsed" << logging::endl;
     spvContextDestroy(context);
 
-    // resolve method parameters
-    // set names, e.g. for methods, parameters
+    // all methods are already mapped (or are being mapped) while parsing
+    waitForMethodMappers(0);
+
+    // reserve the image-configurations only now, since the mapping of the methods accesses the global data
     for(auto& m : methods)
     {
-        auto it = names.find(m.first);
-        if(it != names.end())
-            m.second.method->name = it->second;
-        m.second.method->parameters.reserve(m.second.parameters.size());
-        for(const auto& pair : m.second.parameters)
+        for(auto& param : m.second.method->parameters)
         {
-            const DataType& type = typeMappings.at(pair.second);
-            Parameter param(std::string("%") + std::to_string(pair.first), type);
-            auto it2 = decorationMappings.find(pair.first);
-            if(it2 != decorationMappings.end())
-                setParameterDecorations(param, it2->second);
-            it = names.find(pair.first);
-            if(it != names.end())
-                // parameters are referenced by their IDs, not their names, but for meta-data the names are better
-                param.parameterName = it->second;
-
             if(param.type.getImageType())
                 intermediate::reserveImageConfiguration(module, param);
-
-            m.second.method->parameters.emplace_back(std::move(param));
         }
     }
 
-    // map SPIRVOperations to IntermediateInstructions
-    logging::debug() << "Mapping instructions to intermediate..." << logging::endl;
-    for(const auto& op : instructions)
-    {
-        op->mapInstruction(typeMappings, constantMappings, localTypes, methods, memoryAllocatedData);
-    }
-
     // apply kernel meta-data, decorations, ...
     for(const auto& pair : metadataMappings)
     {
@@ -232,9 +296,15 @@ spv_result_t SPIRVParser::parseHeader(
 {
     // see:
     // https://www.khronos.org/registry/spir-v/specs/1.2/SPIRV.html#_a_id_physicallayout_a_physical_layout_of_a_spir_v_module_and_instruction
-    // not completely true, since the header is not mapped to instructions, but still better than increasing every X new
-    // instruction
-    instructions.reserve(id_bound);
+    // all IDs are smaller than the given bound, so the ID mappings can be sized accordingly. This also guarantees the
+    // mappings to not grow anymore, so they can be read while the parsing still continues
+    typeMappings.reserve(id_bound);
+    constantMappings.reserve(id_bound);
+    localTypes.reserve(id_bound);
+    memoryAllocatedData.reserve(id_bound);
+    sampledImages.reserve(id_bound);
+    decorationMappings.reserve(id_bound);
+    names.reserve(id_bound);
 
     return SPV_SUCCESS;
 }
@@ -417,7 +487,7 @@ static Value parseConstantComposite(const spv_parsed_instruction_t* instruction,
 }
 
 static Optional<Value> specializeConstant(const uint32_t resultID, const DataType& type,
-    const FastMap<uint32_t, std::vector<std::pair<spv::Decoration, uint32_t>>>& decorations)
+    const IdMapping<std::vector<std::pair<spv::Decoration, uint32_t>>>& decorations)
 {
     auto it = decorations.find(resultID);
     if(it != decorations.end())
@@ -429,11 +499,64 @@ static Optional<Value> specializeConstant(const uint32_t resultID, const DataTyp
     return NO_VALUE;
 }
 
-static SPIRVMethod& getOrCreateMethod(const Module& module, MethodMapping& methods, const uint32_t id)
+SPIRVMethod& SPIRVParser::getOrCreateMethod(const uint32_t id)
 {
-    if(methods.find(id) == methods.end())
-        methods.emplace(id, SPIRVMethod(id, module));
-    return methods.at(id);
+    auto it = methods.find(id);
+    if(it == methods.end())
+    {
+        it = methods.emplace(id, SPIRVMethod(id, *module)).first;
+        // all names are declared before the first method, so the name can be set once on creation
+        auto nameIt = names.find(id);
+        if(nameIt != names.end())
+            it->second.method->name = nameIt->second;
+    }
+    return it->second;
+}
+
+void SPIRVParser::finishMethod()
+{
+    // resolve method parameters, set names (e.g. for parameters)
+    SPIRVMethod& m = *currentMethod;
+    m.method->parameters.reserve(m.parameters.size());
+    for(const auto& pair : m.parameters)
+    {
+        const DataType& type = typeMappings.at(pair.second);
+        Parameter param(std::string("%") + std::to_string(pair.first), type);
+        auto it = decorationMappings.find(pair.first);
+        if(it != decorationMappings.end())
+            setParameterDecorations(param, it->second);
+        auto it2 = names.find(pair.first);
+        if(it2 != names.end())
+            // parameters are referenced by their IDs, not their names, but for meta-data the names are better
+            param.parameterName = it2->second;
+
+        m.method->parameters.emplace_back(std::move(param));
+    }
+
+    // map SPIRVOperations to IntermediateInstructions
+    // all types, constants and globals are declared before the first method and the methods only access their own
+    // locals, so the method can be mapped in the background while the following methods are still parsed
+    std::shared_ptr<OperationArena> operations(currentOperations.release());
+    waitForMethodMappers(MAX_PARALLEL_MAPPERS - 1);
+    methodMappers.emplace_back(
+        [this, operations]() {
+            for(const SPIRVOperation* op : operations->getOperations())
+                op->mapInstruction(typeMappings, constantMappings, localTypes, methods, memoryAllocatedData);
+        },
+        "SPIR-V Mapper");
+    methodMappers.back()();
+    currentMethod = nullptr;
+}
+
+void SPIRVParser::waitForMethodMappers(const std::size_t maxRunning)
+{
+    while(methodMappers.size() > maxRunning)
+    {
+        std::exception_ptr error = methodMappers.front().waitFor();
+        methodMappers.pop_front();
+        if(error)
+            std::rethrow_exception(error);
+    }
 }
 
 static std::string toScalarType(uint16_t vectorType)
@@ -473,7 +596,7 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
      * Constants are resolved immediately
      * Specializations are immediately mapped to constants
      * Names are resolved immediately
-     * All instructions are enqueued to be mapped later
+     * All instructions are collected per method and mapped as soon as the method is completely parsed
      *
      * Only opcodes for supported capabilities (or standard-opcodes) are listed here
      */
@@ -494,8 +617,15 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
     case spv::Op::OpSourceExtension:
         break;
     case spv::Op::OpName: // e.g. method-name, parameters
-        names[getWord(parsed_instruction, 1)] = readLiteralString(parsed_instruction, &parsed_instruction->operands[1]);
+    {
+        const std::string& name = names[getWord(parsed_instruction, 1)] =
+            readLiteralString(parsed_instruction, &parsed_instruction->operands[1]);
+        // the kernel methods are already created by their entry points
+        auto it = methods.find(getWord(parsed_instruction, 1));
+        if(it != methods.end())
+            it->second.method->name = name;
         return SPV_SUCCESS;
+    }
     case spv::Op::OpMemberName: // name of struct-member
         return SPV_SUCCESS;
     case spv::Op::OpString:
@@ -526,9 +656,9 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
         if(getWord(parsed_instruction, 4) == OpenCLLIB::Entrypoints::Shuffle2)
         {
             localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-            instructions.emplace_back(
-                new SPIRVShuffle(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
-                    getWord(parsed_instruction, 5), getWord(parsed_instruction, 6), getWord(parsed_instruction, 7)));
+            currentOperations->create<SPIRVShuffle>(parsed_instruction->result_id, *currentMethod,
+                parsed_instruction->type_id, getWord(parsed_instruction, 5), getWord(parsed_instruction, 6),
+                getWord(parsed_instruction, 7));
             return SPV_SUCCESS;
         }
         // these instructions are not really handled -> throw error here (where we know the method-name)
@@ -551,7 +681,7 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
     {
         if(getWord(parsed_instruction, 1) != SpvExecutionModelKernel)
             throw CompilationError(CompilationStep::PARSER, "Invalid execution model");
-        SPIRVMethod& m = getOrCreateMethod(*module, methods, getWord(parsed_instruction, 2));
+        SPIRVMethod& m = getOrCreateMethod(getWord(parsed_instruction, 2));
         m.method->isKernel = true;
         m.method->name = readLiteralString(parsed_instruction, &parsed_instruction->operands[2]);
         logging::debug() << "Kernel-method found: " << m.method->name << logging::endl;
@@ -861,12 +991,13 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
     }
     case spv::Op::OpFunction: // new current method -> add to list of all methods
     {
-        currentMethod = &getOrCreateMethod(*module, methods, parsed_instruction->result_id);
+        currentMethod = &getOrCreateMethod(parsed_instruction->result_id);
         currentMethod->method->returnType = typeMappings.at(parsed_instruction->type_id);
+        currentOperations.reset(new OperationArena());
         // add label %0 to the beginning of the method
         // XXX maybe this is not necessary? If so, it is removed anyway
         typeMappings.emplace(0, TYPE_LABEL);
-        instructions.emplace_back(new SPIRVLabel(0, *currentMethod));
+        currentOperations->create<SPIRVLabel>(0, *currentMethod);
         auto it = names.find(parsed_instruction->result_id);
         logging::debug() << "Reading function: %" << parsed_instruction->result_id << " ("
                          << (it != names.end() ? it->second : currentMethod->method->name) << ")" << logging::endl;
@@ -879,12 +1010,14 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
                          << parsed_instruction->result_id << logging::endl;
         return SPV_SUCCESS;
     case spv::Op::OpFunctionEnd:
-        currentMethod = nullptr;
+        finishMethod();
         return SPV_SUCCESS;
     case spv::Op::OpFunctionCall:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCallSite(parsed_instruction->result_id, *currentMethod,
-            getWord(parsed_instruction, 3), parsed_instruction->type_id, parseArguments(parsed_instruction, 4)));
+        // the called method might not be defined yet, so create it here
+        currentOperations->create<SPIRVCallSite>(parsed_instruction->result_id, *currentMethod,
+            getOrCreateMethod(getWord(parsed_instruction, 3)), parsed_instruction->type_id,
+            parseArguments(parsed_instruction, 4));
         return SPV_SUCCESS;
     case spv::Op::OpVariable:
     {
@@ -939,30 +1072,30 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
         return UNSUPPORTED_INSTRUCTION("OpImageTexelPointer");
     case spv::Op::OpLoad:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCopy(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3), MemoryAccess::READ));
+        currentOperations->create<SPIRVCopy>(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
+            getWord(parsed_instruction, 3), MemoryAccess::READ);
         return SPV_SUCCESS;
     case spv::Op::OpStore:
-        instructions.emplace_back(new SPIRVCopy(getWord(parsed_instruction, 1), *currentMethod, UNDEFINED_ID,
-            getWord(parsed_instruction, 2), MemoryAccess::WRITE));
+        currentOperations->create<SPIRVCopy>(getWord(parsed_instruction, 1), *currentMethod, UNDEFINED_ID,
+            getWord(parsed_instruction, 2), MemoryAccess::WRITE);
         return SPV_SUCCESS;
     case spv::Op::OpCopyMemory:
-        instructions.emplace_back(new SPIRVCopy(getWord(parsed_instruction, 1), *currentMethod, UNDEFINED_ID,
-            getWord(parsed_instruction, 2), MemoryAccess::READ_WRITE));
+        currentOperations->create<SPIRVCopy>(getWord(parsed_instruction, 1), *currentMethod, UNDEFINED_ID,
+            getWord(parsed_instruction, 2), MemoryAccess::READ_WRITE);
         return SPV_SUCCESS;
     case spv::Op::OpCopyMemorySized:
-        instructions.emplace_back(new SPIRVCopy(getWord(parsed_instruction, 1), *currentMethod, UNDEFINED_ID,
-            getWord(parsed_instruction, 2), MemoryAccess::READ_WRITE, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCopy>(getWord(parsed_instruction, 1), *currentMethod, UNDEFINED_ID,
+            getWord(parsed_instruction, 2), MemoryAccess::READ_WRITE, getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpAccessChain: // pointer into element(s) of composite
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVIndexOf(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 4), false));
+        currentOperations->create<SPIRVIndexOf>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 4), false);
         return SPV_SUCCESS;
     case spv::Op::OpInBoundsAccessChain:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVIndexOf(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 4), false));
+        currentOperations->create<SPIRVIndexOf>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 4), false);
         return SPV_SUCCESS;
     case spv::Op::OpPtrAccessChain:
         // For pointers, the "Element" field is the first (top-level) index (see SPIR-V specification,
@@ -970,8 +1103,8 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
         // the first element of an array, and the Element element’s address is computed to be the base for the Indexes
         //[...]"
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVIndexOf(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 4), true));
+        currentOperations->create<SPIRVIndexOf>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 4), true);
         return SPV_SUCCESS;
     case spv::Op::OpGenericPtrMemSemantics:
         //"Result is a valid Memory Semantics which includes mask bits set for the Storage Class for the specific
@@ -980,8 +1113,8 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
         return SPV_SUCCESS;
     case spv::Op::OpInBoundsPtrAccessChain:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVIndexOf(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 4), true));
+        currentOperations->create<SPIRVIndexOf>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 4), true);
         return SPV_SUCCESS;
     case spv::Op::OpNoLine: // source level debug info -> skip
         return SPV_SUCCESS;
@@ -1040,30 +1173,30 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
         return UNSUPPORTED_INSTRUCTION("OpVectorInsertDynamic");
     case spv::Op::OpVectorShuffle:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVShuffle(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
-                getWord(parsed_instruction, 3), getWord(parsed_instruction, 4), parseArguments(parsed_instruction, 5)));
+        currentOperations->create<SPIRVShuffle>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, getWord(parsed_instruction, 3), getWord(parsed_instruction, 4),
+            parseArguments(parsed_instruction, 5));
         return SPV_SUCCESS;
     case spv::Op::OpCompositeConstruct:
         return UNSUPPORTED_INSTRUCTION("OpCompositeConstruct");
     case spv::Op::OpCompositeExtract:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCopy(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3), {0}, parseArguments(parsed_instruction, 4)));
+        currentOperations->create<SPIRVCopy>(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
+            getWord(parsed_instruction, 3), std::vector<uint32_t>{0}, parseArguments(parsed_instruction, 4));
         return SPV_SUCCESS;
     case spv::Op::OpCompositeInsert:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
         // 1. copy whole composite
-        instructions.emplace_back(new SPIRVCopy(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 4)));
+        currentOperations->create<SPIRVCopy>(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
+            getWord(parsed_instruction, 4));
         // 2. insert object at given index
-        instructions.emplace_back(new SPIRVCopy(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 5), {0}));
+        currentOperations->create<SPIRVCopy>(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
+            getWord(parsed_instruction, 3), parseArguments(parsed_instruction, 5), std::vector<uint32_t>{0});
         return SPV_SUCCESS;
     case spv::Op::OpCopyObject:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCopy(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCopy>(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
+            getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpSampledImage:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
@@ -1106,247 +1239,247 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
         //"Query the image format of an image [...]."
         //"The resulting value is an enumerant from Image Channel Data Type."
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVImageQuery(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, ImageQuery::CHANNEL_DATA_TYPE, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVImageQuery>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, ImageQuery::CHANNEL_DATA_TYPE, getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpImageQueryOrder:
         //"Query the channel order of an image [...]."
         //"The resulting value is an enumerant from Image Channel Order."
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVImageQuery(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, ImageQuery::CHANNEL_ORDER, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVImageQuery>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, ImageQuery::CHANNEL_ORDER, getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpImageQuerySizeLod:
         //"Query the dimensions of Image for mipmap level for Level of Detail."
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVImageQuery(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
-                ImageQuery::SIZES_LOD, getWord(parsed_instruction, 3), getWord(parsed_instruction, 4)));
+        currentOperations->create<SPIRVImageQuery>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, ImageQuery::SIZES_LOD, getWord(parsed_instruction, 3),
+            getWord(parsed_instruction, 4));
         return SPV_SUCCESS;
     case spv::Op::OpImageQuerySize:
         //"Query the dimensions of Image, with no level of detail."
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVImageQuery(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, ImageQuery::SIZES, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVImageQuery>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, ImageQuery::SIZES, getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpImageQueryLevels:
         //"Query the number of mipmap levels accessible through Image."
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVImageQuery(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, ImageQuery::MIPMAP_LEVELS, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVImageQuery>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, ImageQuery::MIPMAP_LEVELS, getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpImageQuerySamples:
         //"Query the number of samples available per texel fetch in a multisample image."
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVImageQuery(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, ImageQuery::SAMPLES_PER_TEXEL, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVImageQuery>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, ImageQuery::SAMPLES_PER_TEXEL, getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpConvertFToU:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "fptoui",
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "fptoui",
             parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
-                intermediate::InstructionDecorations::UNSIGNED_RESULT)));
+                intermediate::InstructionDecorations::UNSIGNED_RESULT));
         return SPV_SUCCESS;
     case spv::Op::OpConvertFToS:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "fptosi", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "fptosi",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpConvertSToF:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "sitofp", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "sitofp",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpConvertUToF:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "uitofp", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "uitofp",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpUConvert: // change bit-width (type) of value
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVConversion(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVConversion>(parsed_instruction->result_id, *currentMethod,
             parsed_instruction->type_id, getWord(parsed_instruction, 3), ConversionType::UNSIGNED,
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
-                intermediate::InstructionDecorations::UNSIGNED_RESULT)));
+                intermediate::InstructionDecorations::UNSIGNED_RESULT));
         return SPV_SUCCESS;
     case spv::Op::OpSConvert: // change bit-width (type) of value
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVConversion(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVConversion>(parsed_instruction->result_id, *currentMethod,
             parsed_instruction->type_id, getWord(parsed_instruction, 3), ConversionType::SIGNED,
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFConvert: // change bit-width (type) of value
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVConversion(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVConversion>(parsed_instruction->result_id, *currentMethod,
             parsed_instruction->type_id, getWord(parsed_instruction, 3), ConversionType::FLOATING,
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpConvertPtrToU: // pointer to unsigned -> same as OpUConvert
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVConversion(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVConversion>(parsed_instruction->result_id, *currentMethod,
             parsed_instruction->type_id, getWord(parsed_instruction, 3), ConversionType::UNSIGNED,
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
-                intermediate::InstructionDecorations::UNSIGNED_RESULT)));
+                intermediate::InstructionDecorations::UNSIGNED_RESULT));
         return SPV_SUCCESS;
     case spv::Op::OpSatConvertSToU: // signed to unsigned (with saturation)
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVConversion(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVConversion>(parsed_instruction->result_id, *currentMethod,
             parsed_instruction->type_id, getWord(parsed_instruction, 3), ConversionType::UNSIGNED,
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
                 intermediate::InstructionDecorations::UNSIGNED_RESULT),
-            true));
+            true);
         return SPV_SUCCESS;
     case spv::Op::OpSatConvertUToS: // unsigned to signed (with saturation)
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVConversion(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVConversion>(parsed_instruction->result_id, *currentMethod,
             parsed_instruction->type_id, getWord(parsed_instruction, 3), ConversionType::SIGNED,
-            toInstructionDecorations(parsed_instruction->result_id), true));
+            toInstructionDecorations(parsed_instruction->result_id), true);
         return SPV_SUCCESS;
     case spv::Op::OpConvertUToPtr: // unsigned to pointer -> same as OpUConvert
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVConversion(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVConversion>(parsed_instruction->result_id, *currentMethod,
             parsed_instruction->type_id, getWord(parsed_instruction, 3), ConversionType::UNSIGNED,
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpPtrCastToGeneric:
         //"Convert a pointer’s Storage Class to Generic."
         // -> simply copy the pointer
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCopy(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCopy>(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
+            getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpGenericCastToPtr:
         //"Convert a pointer’s Storage Class to a non-Generic class."
         // -> simple copy the pointer
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCopy(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCopy>(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
+            getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpGenericCastToPtrExplicit:
         //"Attempts to explicitly convert Pointer to Storage storage-class pointer value."
         // -> simple copy the pointer
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCopy(parsed_instruction->result_id, *currentMethod,
-            parsed_instruction->type_id, getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCopy>(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
+            getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpBitcast:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVConversion(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
-                getWord(parsed_instruction, 3), ConversionType::BITCAST, intermediate::InstructionDecorations::NONE));
+        currentOperations->create<SPIRVConversion>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, getWord(parsed_instruction, 3), ConversionType::BITCAST,
+            intermediate::InstructionDecorations::NONE);
         return SPV_SUCCESS;
     case spv::Op::OpSNegate:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, OP_NEGATE, parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, OP_NEGATE,
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFNegate:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, OP_NEGATE, parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, OP_NEGATE,
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpIAdd:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "add", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "add",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFAdd:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "fadd", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "fadd",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpISub:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "sub", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "sub",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFSub:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "fsub", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "fsub",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpIMul:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "mul", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "mul",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFMul:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "fmul", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "fmul",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpUDiv:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "udiv",
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "udiv",
             parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
-                intermediate::InstructionDecorations::UNSIGNED_RESULT)));
+                intermediate::InstructionDecorations::UNSIGNED_RESULT));
         return SPV_SUCCESS;
     case spv::Op::OpSDiv:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "sdiv", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "sdiv",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFDiv:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "fdiv", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "fdiv",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpUMod:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "umod",
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "umod",
             parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
-                intermediate::InstructionDecorations::UNSIGNED_RESULT)));
+                intermediate::InstructionDecorations::UNSIGNED_RESULT));
         return SPV_SUCCESS;
     case spv::Op::OpSRem:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "srem", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "srem",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpSMod:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "smod", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "smod",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFRem:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "frem", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "frem",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFMod:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "fmod", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "fmod",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpVectorTimesScalar: // type must be floating point
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "fmul", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "fmul",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpDot:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCallSite(parsed_instruction->result_id, *currentMethod, "dot",
-            parsed_instruction->type_id, parseArguments(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCallSite>(parsed_instruction->result_id, *currentMethod, "dot",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpIAddCarry:
         return UNSUPPORTED_INSTRUCTION("OpIAddCarry");
@@ -1362,274 +1495,274 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
         return UNSUPPORTED_INSTRUCTION("OpAll");
     case spv::Op::OpIsNan:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCallSite(parsed_instruction->result_id, *currentMethod, "isnan",
-            parsed_instruction->type_id, parseArguments(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCallSite>(parsed_instruction->result_id, *currentMethod, "isnan",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpIsInf:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCallSite(parsed_instruction->result_id, *currentMethod, "ifinf",
-            parsed_instruction->type_id, parseArguments(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCallSite>(parsed_instruction->result_id, *currentMethod, "ifinf",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpIsFinite:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCallSite(parsed_instruction->result_id, *currentMethod, "isfinite",
-            parsed_instruction->type_id, parseArguments(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCallSite>(parsed_instruction->result_id, *currentMethod, "isfinite",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpIsNormal:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCallSite(parsed_instruction->result_id, *currentMethod, "isnormal",
-            parsed_instruction->type_id, parseArguments(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCallSite>(parsed_instruction->result_id, *currentMethod, "isnormal",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpSignBitSet:
         return UNSUPPORTED_INSTRUCTION("OpSignBitSet");
     case spv::Op::OpLessOrGreater:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCallSite(parsed_instruction->result_id, *currentMethod, "islessgreater",
-            parsed_instruction->type_id, parseArguments(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCallSite>(parsed_instruction->result_id, *currentMethod, "islessgreater",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpOrdered:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_ORDERED, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpUnordered:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNORDERED, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpLogicalEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
-            intermediate::COMP_EQ, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod, intermediate::COMP_EQ,
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpLogicalNotEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_NEQ, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpLogicalOr:
         //"Result Type must be a scalar or vector of Boolean type."
         // -> same as bitwise OR
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "or", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "or",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpLogicalAnd:
         //"Result Type must be a scalar or vector of Boolean type."
         // -> same as bitwise AND
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "and", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "and",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpLogicalNot:
         //"Result Type must be a scalar or vector of Boolean type."
         // -> same as bitwise NOT
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "not", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "not",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpSelect:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVSelect(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
-                getWord(parsed_instruction, 3), getWord(parsed_instruction, 4), getWord(parsed_instruction, 5)));
+        currentOperations->create<SPIRVSelect>(parsed_instruction->result_id, *currentMethod,
+            parsed_instruction->type_id, getWord(parsed_instruction, 3), getWord(parsed_instruction, 4),
+            getWord(parsed_instruction, 5));
         return SPV_SUCCESS;
     case spv::Op::OpIEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
-            intermediate::COMP_EQ, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod, intermediate::COMP_EQ,
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpINotEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_NEQ, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpUGreaterThan:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNSIGNED_GT, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
-                intermediate::InstructionDecorations::UNSIGNED_RESULT)));
+                intermediate::InstructionDecorations::UNSIGNED_RESULT));
         return SPV_SUCCESS;
     case spv::Op::OpSGreaterThan:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_SIGNED_GT, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpUGreaterThanEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNSIGNED_GE, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
-                intermediate::InstructionDecorations::UNSIGNED_RESULT)));
+                intermediate::InstructionDecorations::UNSIGNED_RESULT));
         return SPV_SUCCESS;
     case spv::Op::OpSGreaterThanEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_SIGNED_GE, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpULessThan:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNSIGNED_LT, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
-                intermediate::InstructionDecorations::UNSIGNED_RESULT)));
+                intermediate::InstructionDecorations::UNSIGNED_RESULT));
         return SPV_SUCCESS;
     case spv::Op::OpSLessThan:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_SIGNED_LT, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpULessThanEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNSIGNED_LE, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
             add_flag(toInstructionDecorations(parsed_instruction->result_id),
-                intermediate::InstructionDecorations::UNSIGNED_RESULT)));
+                intermediate::InstructionDecorations::UNSIGNED_RESULT));
         return SPV_SUCCESS;
     case spv::Op::OpSLessThanEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_SIGNED_LE, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFOrdEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_ORDERED_EQ, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFUnordEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNORDERED_EQ, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFOrdNotEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_ORDERED_NEQ, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFUnordNotEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNORDERED_NEQ, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFOrdLessThan:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_ORDERED_LT, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFUnordLessThan:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNORDERED_LT, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFOrdGreaterThan:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_ORDERED_GT, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFUnordGreaterThan:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNORDERED_GT, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFOrdLessThanEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_ORDERED_LE, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFUnordLessThanEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNORDERED_LE, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFOrdGreaterThanEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_ORDERED_GE, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpFUnordGreaterThanEqual:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVComparison(parsed_instruction->result_id, *currentMethod,
+        currentOperations->create<SPIRVComparison>(parsed_instruction->result_id, *currentMethod,
             intermediate::COMP_UNORDERED_GE, parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
-            toInstructionDecorations(parsed_instruction->result_id)));
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpShiftRightLogical:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "shr", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "shr",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpShiftRightArithmetic:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "asr", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "asr",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpShiftLeftLogical:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "shl", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "shl",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpBitwiseOr:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "or", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "or",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpBitwiseXor:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "xor", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "xor",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpBitwiseAnd:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "and", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "and",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpNot:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVInstruction(parsed_instruction->result_id, *currentMethod, "not", parsed_instruction->type_id,
-                parseArguments(parsed_instruction, 3), toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVInstruction>(parsed_instruction->result_id, *currentMethod, "not",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3),
+            toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpBitCount:
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(new SPIRVCallSite(parsed_instruction->result_id, *currentMethod, "popcount",
-            parsed_instruction->type_id, parseArguments(parsed_instruction, 3)));
+        currentOperations->create<SPIRVCallSite>(parsed_instruction->result_id, *currentMethod, "popcount",
+            parsed_instruction->type_id, parseArguments(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpControlBarrier:
         //"barrier()" is handled via header-function
         return UNSUPPORTED_INSTRUCTION("OpControlBarrier");
     case spv::Op::OpMemoryBarrier:
-        instructions.emplace_back(
-            new SPIRVMemoryBarrier(*currentMethod, getWord(parsed_instruction, 1), getWord(parsed_instruction, 2)));
+        currentOperations->create<SPIRVMemoryBarrier>(*currentMethod, getWord(parsed_instruction, 1),
+            getWord(parsed_instruction, 2));
         return SPV_SUCCESS;
     case spv::Op::OpAtomicLoad:
         // OpenCL 2.x feature
@@ -1689,8 +1822,8 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
             sources.emplace_back(args[i], args[i + 1]);
         }
         localTypes[parsed_instruction->result_id] = parsed_instruction->type_id;
-        instructions.emplace_back(
-            new SPIRVPhi(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id, sources));
+        currentOperations->create<SPIRVPhi>(parsed_instruction->result_id, *currentMethod, parsed_instruction->type_id,
+            sources);
         return SPV_SUCCESS;
     }
     case spv::Op::OpLoopMerge:
@@ -1699,14 +1832,14 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
         return UNSUPPORTED_INSTRUCTION("OpSelectionMerge");
     case spv::Op::OpLabel:
         typeMappings.emplace(parsed_instruction->result_id, TYPE_LABEL);
-        instructions.emplace_back(new SPIRVLabel(parsed_instruction->result_id, *currentMethod));
+        currentOperations->create<SPIRVLabel>(parsed_instruction->result_id, *currentMethod);
         return SPV_SUCCESS;
     case spv::Op::OpBranch:
-        instructions.emplace_back(new SPIRVBranch(*currentMethod, getWord(parsed_instruction, 1)));
+        currentOperations->create<SPIRVBranch>(*currentMethod, getWord(parsed_instruction, 1));
         return SPV_SUCCESS;
     case spv::Op::OpBranchConditional:
-        instructions.emplace_back(new SPIRVBranch(*currentMethod, getWord(parsed_instruction, 1),
-            getWord(parsed_instruction, 2), getWord(parsed_instruction, 3)));
+        currentOperations->create<SPIRVBranch>(*currentMethod, getWord(parsed_instruction, 1),
+            getWord(parsed_instruction, 2), getWord(parsed_instruction, 3));
         return SPV_SUCCESS;
     case spv::Op::OpSwitch:
     {
@@ -1717,15 +1850,15 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
         {
             destinations.emplace_back(args[i], args[i + 1]);
         }
-        instructions.emplace_back(new SPIRVSwitch(parsed_instruction->result_id, *currentMethod,
-            getWord(parsed_instruction, 1), getWord(parsed_instruction, 2), destinations));
+        currentOperations->create<SPIRVSwitch>(parsed_instruction->result_id, *currentMethod,
+            getWord(parsed_instruction, 1), getWord(parsed_instruction, 2), destinations);
         return SPV_SUCCESS;
     }
     case spv::Op::OpReturn:
-        instructions.emplace_back(new SPIRVReturn(*currentMethod));
+        currentOperations->create<SPIRVReturn>(*currentMethod);
         return SPV_SUCCESS;
     case spv::Op::OpReturnValue:
-        instructions.emplace_back(new SPIRVReturn(getWord(parsed_instruction, 1), *currentMethod));
+        currentOperations->create<SPIRVReturn>(getWord(parsed_instruction, 1), *currentMethod);
         return SPV_SUCCESS;
     case spv::Op::OpUnreachable:
         return SPV_SUCCESS;
@@ -1733,13 +1866,13 @@ spv_result_t SPIRVParser::parseInstruction(const spv_parsed_instruction_t* parse
     {
         // for temporary variables (e.g. Function-Scope), the size is set via the OpLifetimeStart, since the OpVariable
         // is of type void
-        instructions.emplace_back(new SPIRVLifetimeInstruction(getWord(parsed_instruction, 1), *currentMethod,
-            getWord(parsed_instruction, 2), false, toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVLifetimeInstruction>(getWord(parsed_instruction, 1), *currentMethod,
+            getWord(parsed_instruction, 2), false, toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     }
     case spv::Op::OpLifetimeStop:
-        instructions.emplace_back(new SPIRVLifetimeInstruction(getWord(parsed_instruction, 1), *currentMethod,
-            getWord(parsed_instruction, 2), true, toInstructionDecorations(parsed_instruction->result_id)));
+        currentOperations->create<SPIRVLifetimeInstruction>(getWord(parsed_instruction, 1), *currentMethod,
+            getWord(parsed_instruction, 2), true, toInstructionDecorations(parsed_instruction->result_id));
         return SPV_SUCCESS;
     case spv::Op::OpGroupAsyncCopy:
         return UNSUPPORTED_INSTRUCTION("OpGroupAsyncCopy");
@@ -1781,8 +1914,8 @@ std::pair<spv_result_t, Optional<Value>> SPIRVParser::calculateConstantOperation
      * OpAccessChain, OpInBoundsAccessChain, OpPtrAccessChain, OpInBoundsPtrAccessChain
      */
     SPIRVMethod* methodBackup = currentMethod;
-    std::vector<std::unique_ptr<SPIRVOperation>> instructionsBackup;
-    instructions.swap(instructionsBackup);
+    std::unique_ptr<OperationArena> operationsBackup(new OperationArena());
+    currentOperations.swap(operationsBackup);
     currentMethod = nullptr;
     uint32_t dummyWords[12] = {};
     spv_parsed_instruction_t dummyInstruction;
@@ -1803,16 +1936,17 @@ std::pair<spv_result_t, Optional<Value>> SPIRVParser::calculateConstantOperation
     dummyWords[2] = dummyInstruction.result_id;
 
     spv_result_t result = parseInstruction(&dummyInstruction);
-    if(result != SPV_SUCCESS || instructions.empty())
-    {
-        return std::make_pair(result, NO_VALUE);
-    }
-
-    const Optional<Value> value = instructions.at(0)->precalculate(typeMappings, constantMappings, memoryAllocatedData);
+    Optional<Value> value = NO_VALUE;
+    if(result == SPV_SUCCESS && !currentOperations->getOperations().empty())
+        value = currentOperations->getOperations().front()->precalculate(
+            typeMappings, constantMappings, memoryAllocatedData);
 
     // swap back
     currentMethod = methodBackup;
-    instructions.swap(instructionsBackup);
+    currentOperations.swap(operationsBackup);
+
+    if(result != SPV_SUCCESS)
+        return std::make_pair(result, NO_VALUE);
 
     return std::make_pair(SPV_SUCCESS, value);
 }
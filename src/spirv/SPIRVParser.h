@@ -11,7 +11,9 @@
 #include "CompilationError.h"
 
 #include <array>
+#include <chrono>
 #include <iostream>
+#include <list>
 
 #ifdef SPIRV_FRONTEND
 
@@ -19,6 +21,7 @@
 #include "spirv/unified1/spirv.h"
 #include "spirv/unified1/spirv.hpp11"
 
+#include "../BackgroundWorker.h"
 #include "../performance.h"
 #include "SPIRVOperation.h"
 
@@ -26,10 +29,50 @@ namespace vc4c
 {
     namespace spirv2qasm
     {
+        /*
+         * Arena owning the operations of a single function.
+         *
+         * The operations are allocated in a few big blocks instead of one heap allocation each and are all freed at
+         * once, after the function is mapped to intermediate code.
+         */
+        class OperationArena
+        {
+        public:
+            OperationArena() = default;
+            OperationArena(const OperationArena&) = delete;
+            OperationArena(OperationArena&&) = delete;
+            ~OperationArena();
+
+            OperationArena& operator=(const OperationArena&) = delete;
+            OperationArena& operator=(OperationArena&&) = delete;
+
+            template <typename T, typename... Args>
+            T* create(Args&&... args)
+            {
+                static_assert(std::is_base_of<SPIRVOperation, T>::value, "Arena only manages SPIR-V operations");
+                T* op = new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+                operations.push_back(op);
+                return op;
+            }
+
+            const std::vector<SPIRVOperation*>& getOperations() const
+            {
+                return operations;
+            }
+
+        private:
+            std::vector<std::unique_ptr<uint8_t[]>> blocks;
+            std::size_t blockOffset = 0;
+            std::vector<SPIRVOperation*> operations;
+
+            void* allocate(std::size_t size, std::size_t alignment);
+        };
+
         class SPIRVParser : public Parser
         {
         public:
-            explicit SPIRVParser(std::istream& input = std::cin, bool isSPIRVText = false);
+            explicit SPIRVParser(
+                std::istream& input = std::cin, bool isSPIRVText = false, const Configuration& config = {});
             ~SPIRVParser() override;
 
             void parse(Module& module) override;
@@ -55,6 +98,10 @@ namespace vc4c
 
             // whether the input is SPIR-V text representation
             const bool isTextInput;
+            // the optimization level, also selects the SPIRV-Tools optimizations to run
+            const OptimizationLevel optimizationLevel;
+            // the maximum time to run the SPIRV-Tools optimizations for
+            const std::chrono::milliseconds optimizerTimeout;
             // all global methods in the module
             MethodMapping methods;
             // the input stream
@@ -68,20 +115,26 @@ namespace vc4c
             // the global mapping of ID -> type
             TypeMapping typeMappings;
             // the global mapping of ID -> sampled images
-            FastMap<uint32_t, SampledImage> sampledImages;
+            IdMapping<SampledImage> sampledImages;
             // the global mapping of ID -> decorations (applied to this ID)
-            FastMap<uint32_t, std::vector<Decoration>> decorationMappings;
+            IdMapping<std::vector<Decoration>> decorationMappings;
             // mapping of locals to their types
             LocalTypeMapping localTypes;
-            // the global list of instructions, each instruction stores its own reference to the method it is in
-            std::vector<std::unique_ptr<SPIRVOperation>> instructions;
+            // the operations of the currently processed method, only valid while parsing
+            std::unique_ptr<OperationArena> currentOperations;
+            // the background tasks mapping the already completely parsed methods to intermediate code
+            std::list<BackgroundWorker> methodMappers;
             // the global mapping of kernel ID -> meta-data
             FastMap<uint32_t, std::map<MetaDataType, std::array<uint32_t, 3>>> metadataMappings;
             // the global mapping of ID -> name for this ID (e.g. type-, function-name)
-            FastMap<uint32_t, std::string> names;
+            IdMapping<std::string> names;
 
             Module* module;
 
+            SPIRVMethod& getOrCreateMethod(uint32_t id);
+            void finishMethod();
+            void waitForMethodMappers(std::size_t maxRunning);
+
             std::pair<spv_result_t, Optional<Value>> calculateConstantOperation(
                 const spv_parsed_instruction_t* instruction);
         };
@@ -95,7 +148,8 @@ namespace vc4c
         class SPIRVParser final : public Parser
         {
         public:
-            explicit SPIRVParser(std::istream& input = std::cin, bool isSPIRVText = false)
+            explicit SPIRVParser(
+                std::istream& input = std::cin, bool isSPIRVText = false, const Configuration& config = {})
             {
                 throw CompilationError(CompilationStep::GENERAL, "SPIR-V frontend is not active!");
             }
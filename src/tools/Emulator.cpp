@@ -603,7 +603,14 @@ static Value calcSFU(const Value& in, const std::function<float(float)>& func)
 
 void SFU::startRecip(const Value& val)
 {
-    sfuResult = calcSFU(val, [](float f) -> float { return 1.0f / f; });
+    const int32_t numULP = reciprocalError;
+    sfuResult = calcSFU(val, [numULP](float f) -> float {
+        float result = 1.0f / f;
+        const float awayFromZero = std::copysign(std::numeric_limits<float>::infinity(), result);
+        for(int32_t i = 0; i < std::abs(numULP); ++i)
+            result = std::nextafter(result, numULP > 0 ? awayFromZero : 0.0f);
+        return result;
+    });
     lastSFUWrite = currentCycle;
 }
 
@@ -630,6 +637,11 @@ void SFU::incrementCycle()
     ++currentCycle;
 }
 
+void SFU::setReciprocalError(int32_t numULP)
+{
+    reciprocalError = numULP;
+}
+
 template <typename T>
 static std::pair<uint32_t, uint32_t> toAddresses(T setup)
 {
@@ -1661,7 +1673,8 @@ static void emulateStep(std::vector<std::unique_ptr<qpu_asm::Instruction>>::cons
 }
 
 bool tools::emulate(std::vector<std::unique_ptr<qpu_asm::Instruction>>::const_iterator firstInstruction, Memory& memory,
-    const std::vector<MemoryAddress>& uniformAddresses, InstrumentationResults& instrumentation, uint32_t maxCycles)
+    const std::vector<MemoryAddress>& uniformAddresses, InstrumentationResults& instrumentation, uint32_t maxCycles,
+    int32_t sfuReciprocalError)
 {
     if(uniformAddresses.size() > NUM_QPUS)
         throw CompilationError(CompilationStep::GENERAL, "Cannot use more than 12 QPUs!");
@@ -1669,6 +1682,8 @@ bool tools::emulate(std::vector<std::unique_ptr<qpu_asm::Instruction>>::const_it
     Mutex mutex;
     // FIXME is SFU execution per QPU or need SFUs be locked?
     std::array<SFU, NUM_QPUS> sfus;
+    for(SFU& sfu : sfus)
+        sfu.setReciprocalError(sfuReciprocalError);
     VPM vpm(memory);
     Semaphores semaphores;
 
@@ -1884,7 +1899,7 @@ EmulationResult tools::emulate(const EmulationData& data)
     InstrumentationResults instrumentation;
     bool status =
         emulate(instructions.begin() + (kernelInfo->getOffset() - module.kernelInfos.front().getOffset()).getValue(),
-            mem, uniformAddresses, instrumentation, data.maxEmulationCycles);
+            mem, uniformAddresses, instrumentation, data.maxEmulationCycles, data.sfuReciprocalError);
 
     if(!data.memoryDump.empty())
         dumpMemory(mem, data.memoryDump, uniformAddress, false);
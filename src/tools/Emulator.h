@@ -144,7 +144,7 @@ namespace vc4c
         class SFU : private NonCopyable
         {
         public:
-            explicit SFU() : lastSFUWrite(0), currentCycle(0), sfuResult(NO_VALUE) {}
+            explicit SFU() : lastSFUWrite(0), currentCycle(0), sfuResult(NO_VALUE), reciprocalError(0) {}
 
             Value readSFU();
             bool hasValueOnR4() const;
@@ -155,6 +155,7 @@ namespace vc4c
             void startLog2(const Value& val);
 
             void incrementCycle();
+            void setReciprocalError(int32_t numULP);
 
         private:
             // FIXME is SFU calculation per QPU? Or do QPUs need to lock the SFU access?
@@ -162,6 +163,8 @@ namespace vc4c
             uint32_t lastSFUWrite;
             uint32_t currentCycle;
             Optional<Value> sfuResult;
+            // the number of ULP the reciprocal results are moved away from zero
+            int32_t reciprocalError;
         };
 
         class VPM : private NonCopyable
@@ -289,7 +292,7 @@ namespace vc4c
             const KernelUniforms& uniformsUsed);
         bool emulate(std::vector<std::unique_ptr<qpu_asm::Instruction>>::const_iterator firstInstruction,
             Memory& memory, const std::vector<MemoryAddress>& uniformAddresses, InstrumentationResults& instrumentation,
-            uint32_t maxCycles = std::numeric_limits<uint32_t>::max());
+            uint32_t maxCycles = std::numeric_limits<uint32_t>::max(), int32_t sfuReciprocalError = 0);
         bool emulateTask(std::vector<std::unique_ptr<qpu_asm::Instruction>>::const_iterator firstInstruction,
             const std::vector<MemoryAddress>& parameter, Memory& memory, MemoryAddress uniformBaseAddress,
             MemoryAddress globalData, const KernelUniforms& uniformsUsed, InstrumentationResults& instrumentation,
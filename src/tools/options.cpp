@@ -12,6 +12,7 @@
 #include "../optimization/Optimizer.h"
 #include "log.h"
 
+#include <sstream>
 #include <stdexcept>
 
 using namespace vc4c;
@@ -19,6 +20,76 @@ using namespace vc4c::tools;
 
 static auto availableOptimizations = vc4c::optimizations::Optimizer::getPasses(OptimizationLevel::FULL);
 
+static bool parseWorkSizes(const std::string& value, std::array<uint32_t, 3>& sizes)
+{
+    std::istringstream s(value);
+    std::string part;
+    std::size_t dimension = 0;
+    while(std::getline(s, part, 'x'))
+    {
+        if(dimension >= sizes.size())
+            return false;
+        sizes[dimension] = static_cast<uint32_t>(std::stoul(part));
+        ++dimension;
+    }
+    return dimension > 0;
+}
+
+/*
+ * Parses a kernel specialization of the form "<kernel>[,<key>=<value>]*" with the keys:
+ * - "name" for the name of the specialized kernel
+ * - "arg<index>" for the fixed value of the scalar argument with the given index
+ * - "local" and "global" for the fixed local and global sizes, formatted as "<x>[x<y>[x<z>]]"
+ */
+static bool parseKernelSpecialization(Configuration& config, const std::string& value)
+{
+    KernelSpecialization specialization;
+    std::istringstream s(value);
+    std::string part;
+    if(!std::getline(s, specialization.kernelName, ',') || specialization.kernelName.empty())
+    {
+        std::cerr << "No kernel given for specialization: " << value << std::endl;
+        return false;
+    }
+    while(std::getline(s, part, ','))
+    {
+        const auto pos = part.find('=');
+        const std::string key = part.substr(0, pos);
+        const std::string keyValue = pos == std::string::npos ? "" : part.substr(pos + 1);
+        bool validEntry = false;
+        try
+        {
+            if(key == "name")
+            {
+                specialization.specializedName = keyValue;
+                validEntry = !keyValue.empty();
+            }
+            else if(key == "local")
+                validEntry = parseWorkSizes(keyValue, specialization.localSizes);
+            else if(key == "global")
+                validEntry = parseWorkSizes(keyValue, specialization.globalSizes);
+            else if(key.find("arg") == 0 && key.size() > 3)
+            {
+                specialization.argumentValues[static_cast<unsigned>(std::stoul(key.substr(3)))] =
+                    static_cast<uint32_t>(std::stoll(keyValue, nullptr, 0));
+                validEntry = true;
+            }
+        }
+        catch(std::exception&)
+        {
+            // invalid number, handled below
+        }
+        if(!validEntry)
+        {
+            std::cerr << "Invalid entry '" << part << "' in specialization of kernel: " << specialization.kernelName
+                      << std::endl;
+            return false;
+        }
+    }
+    config.kernelSpecializations.emplace_back(std::move(specialization));
+    return true;
+}
+
 bool tools::parseConfigurationParameter(Configuration& config, const std::string& arg)
 {
     if(arg == "-cl-opt-disable")
@@ -123,6 +194,9 @@ bool tools::parseConfigurationParameter(Configuration& config, const std::string
         return true;
     }
 
+    if(arg.find("--specialize=") == 0)
+        return parseKernelSpecialization(config, arg.substr(std::string("--specialize=").size()));
+
     std::string passName;
     if(arg.find("--fno-") == 0)
     {
@@ -168,6 +242,10 @@ bool tools::parseConfigurationParameter(Configuration& config, const std::string
                 config.additionalOptions.moveConstantsDepth = intValue;
             else if(paramName == "optimization-iterations")
                 config.additionalOptions.maxOptimizationIterations = intValue;
+            else if(paramName == "spirv-optimizer-timeout")
+                config.additionalOptions.spirvOptimizerTimeout = intValue;
+            else if(paramName == "max-unroll-factor")
+                config.additionalOptions.maxUnrollFactor = intValue;
             else
             {
                 std::cerr << "Cannot set unknown optimization parameter: " << paramName << " to " << value << std::endl;
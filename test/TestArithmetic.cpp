@@ -7,6 +7,9 @@
 #include "TestArithmetic.h"
 #include "emulation_helper.h"
 
+#include <algorithm>
+#include <cmath>
+
 static const std::string BINARY_OPERATION = R"(
 __kernel void test(__global TYPE* out, const __global TYPE* in0, const __global TYPE* in1) {
   size_t gid = get_global_id(0);
@@ -14,6 +17,29 @@ __kernel void test(__global TYPE* out, const __global TYPE* in0, const __global
 }
 )";
 
+// the masks limit the operands to the value range supported by the integer division via floating-point reciprocal,
+// without them the operand ranges are unknown and the generic division is used
+static const std::string RECIPROCAL_DIVISION_OPERATION = R"(
+__kernel void test(__global TYPE* out, const __global TYPE* in0, const __global TYPE* in1, const __global TYPE* in2,
+    const __global TYPE* in3) {
+  size_t gid = get_global_id(0);
+#if defined(UNMASKED) && defined(SIGNED)
+  TYPE a = in0[gid] - in1[gid];
+  TYPE b = in2[gid] - in3[gid];
+#elif defined(UNMASKED)
+  TYPE a = in0[gid];
+  TYPE b = in2[gid];
+#elif defined(SIGNED)
+  TYPE a = (in0[gid] & 0x7FFFFF) - (in1[gid] & 0x7FFFFF);
+  TYPE b = (in2[gid] & 0x7FFFFF) - (in3[gid] & 0x7FFFFF);
+#else
+  TYPE a = in0[gid] & 0x7FFFFF;
+  TYPE b = in2[gid] & 0x7FFFFF;
+#endif
+  out[gid] = a OP b;
+}
+)";
+
 static const std::string SELECTION_OPERATION = R"(
 __kernel void test(__global TYPE* out, const __global TYPE* in0, const __global TYPE* in1) {
   size_t gid = get_global_id(0);
@@ -57,7 +83,13 @@ TestArithmetic::TestArithmetic(const vc4c::Configuration& config) : config(confi
     TEST_ADD(TestArithmetic::testUnsignedIntModulo);
     TEST_ADD(TestArithmetic::testUnsignedShortModulo);
     TEST_ADD(TestArithmetic::testUnsignedCharModulo);
+    TEST_ADD(TestArithmetic::testUnsignedIntDivisionViaReciprocal);
+    TEST_ADD(TestArithmetic::testSignedIntDivisionViaReciprocal);
+    TEST_ADD(TestArithmetic::testUnsignedIntModuloViaReciprocal);
+    TEST_ADD(TestArithmetic::testSignedIntModuloViaReciprocal);
     TEST_ADD(TestArithmetic::testFloatingPointDivision);
+    TEST_ADD(TestArithmetic::testFloatingPointDivisionFastMath);
+    TEST_ADD(TestArithmetic::testFloatingPointDivisionInexactReciprocal);
 
     TEST_ADD(TestArithmetic::testIntegerEquality);
     TEST_ADD(TestArithmetic::testShortEquality);
@@ -139,6 +171,86 @@ static void testBinaryOperation(vc4c::Configuration& config, const std::string&
         in0, in1, out, op, options.substr(pos, options.find(' ', pos) - pos), onError);
 }
 
+/*
+ * Runs the reciprocal division kernel and returns the output and the total number of executed instructions
+ */
+template <typename T>
+static std::pair<std::array<T, 12 * 8>, unsigned> runReciprocalDivision(
+    std::stringstream& code, const std::vector<std::array<T, 12 * 8>>& inputs)
+{
+    std::vector<std::pair<uint32_t, vc4c::Optional<std::vector<uint32_t>>>> parameter;
+    parameter.emplace_back(std::make_pair(0, std::vector<uint32_t>(12 * 8)));
+    for(const auto& input : inputs)
+    {
+        parameter.emplace_back(std::make_pair(0, std::vector<uint32_t>(12 * 8)));
+        copyConvert<12 * 8>(input, parameter.back().second.value());
+    }
+    vc4c::tools::WorkGroupConfig workGroups;
+    workGroups.dimensions = 1;
+    workGroups.localSizes[0] = 12;
+    workGroups.numGroups[0] = 8;
+    vc4c::tools::EmulationData data(code, "test", parameter, workGroups);
+
+    auto result = vc4c::tools::emulate(data);
+    if(!result.executionSuccessful)
+        throw vc4c::CompilationError(vc4c::CompilationStep::GENERAL, "Kernel execution failed");
+
+    std::pair<std::array<T, 12 * 8>, unsigned> output{};
+    copyConvert<12 * 8>(result.results[0].second.value(), output.first);
+    for(const auto& instrumentation : result.instrumentation)
+        output.second += instrumentation.numExecutions;
+    return output;
+}
+
+/*
+ * Runs the division (or modulo) of all combinations of the given numerators and divisors, which all need to be within
+ * the range supported by the division via floating-point reciprocal, i.e. (-2^23, 2^23).
+ */
+template <typename T>
+static void testReciprocalDivision(vc4c::Configuration& config, const std::string& options,
+    const std::array<T, 12>& numerators, const std::array<T, 8>& divisors, const std::function<T(T, T)>& op,
+    const std::function<void(const std::string&, const std::string&)>& onError)
+{
+    std::stringstream code;
+    compileBuffer(config, code, RECIPROCAL_DIVISION_OPERATION, options);
+    std::stringstream unmaskedCode;
+    compileBuffer(config, unmaskedCode, RECIPROCAL_DIVISION_OPERATION, options + " -DUNMASKED");
+
+    std::array<T, 12 * 8> in0{};
+    std::array<T, 12 * 8> in1{};
+    for(std::size_t i = 0; i < divisors.size(); ++i)
+    {
+        std::copy(numerators.begin(), numerators.end(), in0.begin() + static_cast<std::ptrdiff_t>(i * 12));
+        std::fill_n(in1.begin() + static_cast<std::ptrdiff_t>(i * 12), 12, divisors[i]);
+    }
+    // the kernel calculates the signed operands as difference of the two positive masked inputs
+    auto positivePart = [](const std::array<T, 12 * 8>& values) -> std::array<T, 12 * 8> {
+        std::array<T, 12 * 8> result{};
+        std::transform(values.begin(), values.end(), result.begin(), [](T val) -> T { return val < 0 ? 0 : val; });
+        return result;
+    };
+    auto negativePart = [](const std::array<T, 12 * 8>& values) -> std::array<T, 12 * 8> {
+        std::array<T, 12 * 8> result{};
+        std::transform(values.begin(), values.end(), result.begin(), [](T val) -> T { return val < 0 ? -val : 0; });
+        return result;
+    };
+
+    const std::vector<std::array<T, 12 * 8>> inputs = {
+        positivePart(in0), negativePart(in0), positivePart(in1), negativePart(in1)};
+    auto out = runReciprocalDivision<T>(code, inputs);
+    auto unmasked = runReciprocalDivision<T>(unmaskedCode, inputs);
+    auto pos = options.find("-DOP=") + std::string("-DOP=").size();
+    checkBinaryResults<T, T, 12 * 8>(
+        in0, in1, out.first, op, options.substr(pos, options.find(' ', pos) - pos), onError);
+    checkBinaryResults<T, T, 12 * 8>(
+        in0, in1, unmasked.first, op, options.substr(pos, options.find(' ', pos) - pos), onError);
+
+    // the division via reciprocal is a fixed sequence of instructions, while the generic division loops over the bits
+    if(out.second >= unmasked.second)
+        onError("less than " + std::to_string(unmasked.second) + " instructions executed for division via reciprocal",
+            std::to_string(out.second));
+}
+
 template <typename T>
 static void testRelationalOperation(vc4c::Configuration& config, const std::string& options,
     const std::function<int(T, T)>& op, const std::function<void(const std::string&, const std::string&)>& onError)
@@ -300,12 +412,150 @@ void TestArithmetic::testUnsignedCharModulo()
         std::bind(&TestArithmetic::onMismatch, this, std::placeholders::_1, std::placeholders::_2));
 }
 
+// the edges of the supported operand range, values around powers of two and the largest divisors
+static const std::array<unsigned, 12> UNSIGNED_NUMERATORS = {
+    0, 1, 2, 3, 12345, 0x3FFFFF, 0x400000, 0x400001, 0x555555, 0x7FFFFD, 0x7FFFFE, 0x7FFFFF};
+static const std::array<unsigned, 8> UNSIGNED_DIVISORS = {1, 2, 3, 7, 0x400000, 0x400001, 0x7FFFFE, 0x7FFFFF};
+static const std::array<int, 12> SIGNED_NUMERATORS = {
+    0, 1, -1, 3, -12345, 0x400000, -0x400000, 0x555555, 0x7FFFFE, -0x7FFFFE, 0x7FFFFF, -0x7FFFFF};
+static const std::array<int, 8> SIGNED_DIVISORS = {1, -1, -3, 7, 0x400001, -0x400000, 0x7FFFFF, -0x7FFFFF};
+
+void TestArithmetic::testUnsignedIntDivisionViaReciprocal()
+{
+    testReciprocalDivision<unsigned>(config, "-DTYPE=uint -DOP=/", UNSIGNED_NUMERATORS, UNSIGNED_DIVISORS,
+        std::divides<unsigned>{},
+        std::bind(&TestArithmetic::onMismatch, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+void TestArithmetic::testSignedIntDivisionViaReciprocal()
+{
+    testReciprocalDivision<int>(config, "-DTYPE=int -DOP=/ -DSIGNED", SIGNED_NUMERATORS, SIGNED_DIVISORS,
+        std::divides<int>{},
+        std::bind(&TestArithmetic::onMismatch, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+void TestArithmetic::testUnsignedIntModuloViaReciprocal()
+{
+    testReciprocalDivision<unsigned>(config, "-DTYPE=uint -DOP=%", UNSIGNED_NUMERATORS, UNSIGNED_DIVISORS,
+        std::modulus<unsigned>{},
+        std::bind(&TestArithmetic::onMismatch, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+void TestArithmetic::testSignedIntModuloViaReciprocal()
+{
+    testReciprocalDivision<int>(config, "-DTYPE=int -DOP=% -DSIGNED", SIGNED_NUMERATORS, SIGNED_DIVISORS,
+        std::modulus<int>{},
+        std::bind(&TestArithmetic::onMismatch, this, std::placeholders::_1, std::placeholders::_2));
+}
+
 void TestArithmetic::testFloatingPointDivision()
 {
-    testBinaryOperation<float, CompareULP<3>>(config, "-DTYPE=float16 -DOP=/", std::divides<float>{},
+    testBinaryOperation<float, CompareULP<2>>(config, "-DTYPE=float16 -DOP=/", std::divides<float>{},
+        std::bind(&TestArithmetic::onMismatch, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+/*
+ * Runs the float16 division kernel and returns the output and the total number of executed instructions
+ */
+static std::pair<std::array<float, 16 * 12>, unsigned> runFloatingPointDivision(std::stringstream& code,
+    const std::array<float, 16 * 12>& in0, const std::array<float, 16 * 12>& in1, int32_t sfuReciprocalError = 0)
+{
+    std::vector<std::pair<uint32_t, vc4c::Optional<std::vector<uint32_t>>>> parameter;
+    parameter.emplace_back(std::make_pair(0, std::vector<uint32_t>(16 * 12)));
+    for(const auto& input : {in0, in1})
+    {
+        parameter.emplace_back(std::make_pair(0, std::vector<uint32_t>(16 * 12)));
+        copyConvert<16 * 12>(input, parameter.back().second.value());
+    }
+    vc4c::tools::WorkGroupConfig workGroups;
+    workGroups.dimensions = 1;
+    workGroups.localSizes[0] = 12;
+    vc4c::tools::EmulationData data(code, "test", parameter, workGroups);
+    data.sfuReciprocalError = sfuReciprocalError;
+
+    auto result = vc4c::tools::emulate(data);
+    if(!result.executionSuccessful)
+        throw vc4c::CompilationError(vc4c::CompilationStep::GENERAL, "Kernel execution failed");
+
+    std::pair<std::array<float, 16 * 12>, unsigned> output{};
+    copyConvert<16 * 12>(result.results[0].second.value(), output.first);
+    for(const auto& instrumentation : result.instrumentation)
+        output.second += instrumentation.numExecutions;
+    return output;
+}
+
+static void testFastMathDivision(vc4c::Configuration& config, const std::string& options,
+    const std::function<void(const std::string&, const std::string&)>& onError)
+{
+    // limit the range to not run into denormal or infinite quotients
+    auto in0 = generateInput<float, 16 * 12>(false, -1e15, 1e15);
+    auto in1 = generateInput<float, 16 * 12>(false, -1e15, 1e15);
+
+    std::stringstream preciseCode;
+    compileBuffer(config, preciseCode, BINARY_OPERATION, "-DTYPE=float16 -DOP=/");
+    vc4c::Configuration fastMathConfig = config;
+    fastMathConfig.mathType = vc4c::MathType::FAST_RELAXED_MATH;
+    std::stringstream fastMathCode;
+    compileBuffer(fastMathConfig, fastMathCode, BINARY_OPERATION, "-DTYPE=float16 -DOP=/ " + options);
+
+    auto precise = runFloatingPointDivision(preciseCode, in0, in1);
+    auto fastMath = runFloatingPointDivision(fastMathCode, in0, in1);
+
+    // the fast-math division is a single multiplication with the reciprocal, which skips the Newton-Raphson steps and
+    // the correction of the precise division
+    if(fastMath.second >= precise.second)
+        onError("less than " + std::to_string(precise.second) + " instructions executed for fast-math division",
+            std::to_string(fastMath.second));
+
+    /*
+     * The emulated SFU_RECIP calculates the exact (correctly rounded) reciprocal, while the hardware result is only
+     * accurate to about 1 ULP. So instead of comparing with the exact quotient, the result needs to be within the
+     * quotients calculated with the reciprocal being off by 1 ULP in either direction.
+     */
+    for(std::size_t i = 0; i < in0.size(); ++i)
+    {
+        const float recip = 1.0f / in1[i];
+        const float infinity = std::copysign(std::numeric_limits<float>::infinity(), recip);
+        const float lower = in0[i] * std::nextafter(recip, 0.0f);
+        const float upper = in0[i] * std::nextafter(recip, infinity);
+        const float result = fastMath.first[i];
+        if(!(result >= std::min(lower, upper) && result <= std::max(lower, upper)))
+            onError(std::to_string(in0[i]) + " / " + std::to_string(in1[i]) + " in [" + std::to_string(lower) + ", " +
+                    std::to_string(upper) + "]",
+                std::to_string(result));
+    }
+}
+
+void TestArithmetic::testFloatingPointDivisionFastMath()
+{
+    // front-end flags, the division is already marked as fast-math instruction
+    testFastMathDivision(config, "-cl-fast-relaxed-math",
+        std::bind(&TestArithmetic::onMismatch, this, std::placeholders::_1, std::placeholders::_2));
+    // only the math-type of the configuration selects the fast division
+    testFastMathDivision(config, "",
         std::bind(&TestArithmetic::onMismatch, this, std::placeholders::_1, std::placeholders::_2));
 }
 
+void TestArithmetic::testFloatingPointDivisionInexactReciprocal()
+{
+    // limit the range to not run into denormal or infinite quotients
+    auto in0 = generateInput<float, 16 * 12>(false, -1e15, 1e15);
+    auto in1 = generateInput<float, 16 * 12>(false, -1e15, 1e15);
+
+    std::stringstream code;
+    compileBuffer(config, code, BINARY_OPERATION, "-DTYPE=float16 -DOP=/");
+
+    // the hardware SFU_RECIP is only accurate to about 1 ULP, which needs to be corrected by the precise division
+    for(int32_t reciprocalError : {-1, 1})
+    {
+        auto out = runFloatingPointDivision(code, in0, in1, reciprocalError);
+        checkBinaryResults<float, float, 16 * 12, CompareULP<2>>(in0, in1, out.first,
+            std::function<float(float, float)>{std::divides<float>{}},
+            "/ (reciprocal off by " + std::to_string(reciprocalError) + " ULP)",
+            std::bind(&TestArithmetic::onMismatch, this, std::placeholders::_1, std::placeholders::_2));
+    }
+}
+
 void TestArithmetic::testIntegerEquality()
 {
     testRelationalOperation<int>(config, "-DTYPE=int16 -DOP===", checkRelation<std::equal_to<int>>,
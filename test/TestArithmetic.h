@@ -35,7 +35,13 @@ public:
     void testUnsignedIntModulo();
     void testUnsignedShortModulo();
     void testUnsignedCharModulo();
+    void testUnsignedIntDivisionViaReciprocal();
+    void testSignedIntDivisionViaReciprocal();
+    void testUnsignedIntModuloViaReciprocal();
+    void testSignedIntModuloViaReciprocal();
     void testFloatingPointDivision();
+    void testFloatingPointDivisionFastMath();
+    void testFloatingPointDivisionInexactReciprocal();
 
     // relational operators
     void testIntegerEquality();
@@ -8,16 +8,28 @@
 
 #include "Compiler.h"
 #include "Locals.h"
+#include "c_interface.h"
 #include "asm/Instruction.h"
 #include "asm/KernelInfo.h"
 #include "helper.h"
+#include "tools.h"
 #include "../src/Profiler.h"
 
 #include "test_cases.h"
 
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <cstring>
 #include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
 
 using namespace vc4c;
 using namespace vc4c::tools;
@@ -30,6 +42,20 @@ TestEmulator::TestEmulator(const vc4c::Configuration& config) : config(config)
 	TEST_ADD(TestEmulator::testBarrier);
 	TEST_ADD(TestEmulator::testBranches);
 	TEST_ADD(TestEmulator::testWorkItem);
+	TEST_ADD(TestEmulator::testKernelSpecialization);
+	TEST_ADD(TestEmulator::testBatchCompilation);
+	TEST_ADD(TestEmulator::testLazyFunctionMaterialization);
+	TEST_ADD(TestEmulator::testCompilationServer);
+	TEST_ADD(TestEmulator::testLoopUnrolling);
+	TEST_ADD(TestEmulator::testLoopVectorization);
+	TEST_ADD(TestEmulator::testLoopInvariantCodeMotion);
+	TEST_ADD(TestEmulator::testRegisterPressure);
+	TEST_ADD(TestEmulator::testVectorRotations);
+	TEST_ADD(TestEmulator::testPackModes);
+	TEST_ADD(TestEmulator::testDMAPipelining);
+	TEST_ADD(TestEmulator::testRedundantExtensions);
+	TEST_ADD(TestEmulator::testALUPacking);
+	TEST_ADD(TestEmulator::testTMUPipelining);
 	//TODO requires v8muld
 	//TEST_ADD(TestEmulator::testSHA1);
 	TEST_ADD(TestEmulator::testSHA256);
@@ -54,9 +80,33 @@ void TestEmulator::compileFile(std::stringstream& buffer, const std::string& fil
 	config.outputMode = OutputMode::BINARY;
 	config.writeKernelInfo = true;
 	std::ifstream input(fileName);
-	Compiler::compile(input, buffer, config, "", fileName);
+	Compiler::compile(input, buffer, config, options, fileName);
 }
 
+TestEmulator::KernelExecution TestEmulator::runKernel(std::stringstream& buffer, const std::string& kernelName,
+	const std::vector<std::pair<uint32_t, Optional<std::vector<uint32_t>>>>& parameters, uint32_t localSize)
+{
+	buffer.clear();
+	buffer.seekg(0);
+	EmulationData data;
+	data.kernelName = kernelName;
+	data.maxEmulationCycles = vc4c::test::maxExecutionCycles;
+	data.module = std::make_pair("", &buffer);
+	data.workGroup.localSizes = {localSize, 1, 1};
+	data.parameter = parameters;
+
+	const auto result = emulate(data);
+	TEST_ASSERT(result.executionSuccessful);
+	KernelExecution execution;
+	if(!result.results.empty() && result.results.front().second)
+		execution.output = *result.results.front().second;
+	for(const auto& instrumentation : result.instrumentation)
+	{
+		execution.numInstructions += instrumentation.numExecutions;
+		execution.numBranchesTaken += instrumentation.numBranchTaken;
+	}
+	return execution;
+}
 
 void TestEmulator::testHelloWorld()
 {
@@ -279,6 +329,942 @@ void TestEmulator::testWorkItem()
 	}
 }
 
+void TestEmulator::testKernelSpecialization()
+{
+	// factor = 3, count = 4, 12 work-items per group, 2 groups
+	TEST_ASSERT(parseConfigurationParameter(
+		config, "--specialize=test_specialization,name=test_specialized,arg2=3,arg3=4,local=12x1x1,global=24x1x1"));
+	std::stringstream buffer;
+	compileFile(buffer, "./testing/test_specialization.cl");
+	config.kernelSpecializations.clear();
+	const std::string code = buffer.str();
+
+	std::vector<uint32_t> input(24);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i;
+
+	std::stringstream genericCode(code);
+	EmulationData genericData;
+	genericData.kernelName = "test_specialization";
+	genericData.maxEmulationCycles = vc4c::test::maxExecutionCycles;
+	genericData.module = std::make_pair("", &genericCode);
+	genericData.workGroup.dimensions = 1;
+	genericData.workGroup.localSizes = {12, 1, 1};
+	genericData.workGroup.numGroups = {2, 1, 1};
+	genericData.parameter.emplace_back(0, std::vector<uint32_t>(24));
+	genericData.parameter.emplace_back(0, input);
+	genericData.parameter.emplace_back(3, Optional<std::vector<uint32_t>>{});
+	genericData.parameter.emplace_back(4, Optional<std::vector<uint32_t>>{});
+
+	// the specialized kernel has neither the factor nor the count parameter
+	std::stringstream specializedCode(code);
+	EmulationData specializedData;
+	specializedData.kernelName = "test_specialized";
+	specializedData.maxEmulationCycles = vc4c::test::maxExecutionCycles;
+	specializedData.module = std::make_pair("", &specializedCode);
+	specializedData.workGroup = genericData.workGroup;
+	specializedData.parameter.emplace_back(0, std::vector<uint32_t>(24));
+	specializedData.parameter.emplace_back(0, input);
+
+	const auto genericResult = emulate(genericData);
+	const auto specializedResult = emulate(specializedData);
+	TEST_ASSERT(genericResult.executionSuccessful);
+	TEST_ASSERT(specializedResult.executionSuccessful);
+	TEST_ASSERT_EQUALS(4u, genericResult.results.size());
+	TEST_ASSERT_EQUALS(2u, specializedResult.results.size());
+
+	const auto& genericOut = *genericResult.results.front().second;
+	const auto& specializedOut = *specializedResult.results.front().second;
+	for(uint32_t i = 0; i < input.size(); ++i)
+	{
+		// 4 * (3 * in) + (0 + 1 + 2 + 3) + 12 + 2
+		TEST_ASSERT_EQUALS(12 * i + 20, genericOut.at(i));
+		TEST_ASSERT_EQUALS(genericOut.at(i), specializedOut.at(i));
+	}
+	// the instrumentation has an entry per instruction of the executed kernel
+	TEST_ASSERT(specializedResult.instrumentation.size() < genericResult.instrumentation.size());
+}
+
+void TestEmulator::testBatchCompilation()
+{
+	auto readFile = [](const std::string& fileName) -> std::string {
+		std::ifstream file(fileName);
+		return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	};
+	std::string packModesSource = readFile("./testing/test_pack_modes.cl");
+	std::string specializationSource = readFile("./testing/test_specialization.cl");
+	std::string brokenSource = "__kernel void test_broken(__global int* out) { out[0] = undefined_value; }";
+	TEST_ASSERT(!packModesSource.empty());
+	TEST_ASSERT(!specializationSource.empty());
+
+	const std::size_t bufferSize = 256 * 1024;
+	std::vector<char> packModesOutput(bufferSize);
+	std::vector<char> specializationOutput(bufferSize);
+	std::vector<char> brokenOutput(bufferSize);
+	// too small for any compiled module
+	std::vector<char> tooSmallOutput(16);
+
+	configuration jobConfig = DEFAULT_CONFIG;
+	jobConfig.output_mode = OUTPUT_BINARY;
+	const std::string specialization =
+		"--specialize=test_specialization,name=test_specialized,arg2=3,arg3=4,local=12x1x1,global=24x1x1";
+	auto createJob = [&](std::string& source, std::vector<char>& output, const char* options) -> compilation_job {
+		compilation_job job{};
+		job.input.is_file = 0;
+		job.input.data = &source[0];
+		job.input.data_length = source.size();
+		job.output.is_file = 0;
+		job.output.data = output.data();
+		job.output.data_length = output.size();
+		job.config = jobConfig;
+		job.optimization_level = OPTIMIZATION_LEVEL_MEDIUM;
+		job.options = options;
+		return job;
+	};
+	std::array<compilation_job, 4> jobs = {createJob(packModesSource, packModesOutput, ""),
+		createJob(specializationSource, specializationOutput, specialization.data()),
+		createJob(brokenSource, brokenOutput, ""), createJob(packModesSource, tooSmallOutput, "")};
+
+	// the callback is invoked (from any background thread) once per job, after the job is completed
+	struct CallbackData
+	{
+		std::mutex lock;
+		std::map<const compilation_job*, int> statuses;
+	} callbackData;
+	auto callback = [](compilation_job* job, void* userData) {
+		auto& data = *static_cast<CallbackData*>(userData);
+		std::lock_guard<std::mutex> guard(data.lock);
+		data.statuses.emplace(job, job->status);
+	};
+	compilation_handle handle = submitCompilations(jobs.data(), jobs.size(), callback, &callbackData);
+	TEST_ASSERT(handle != nullptr);
+	// the status of the first failed job is returned
+	TEST_ASSERT_EQUALS(-15, waitForCompilations(handle));
+	TEST_ASSERT_EQUALS(1, isCompilationDone(handle));
+	releaseCompilations(handle);
+	TEST_ASSERT_EQUALS(jobs.size(), callbackData.statuses.size());
+	for(const auto& job : jobs)
+		TEST_ASSERT_EQUALS(job.status, callbackData.statuses.at(&job));
+
+	TEST_ASSERT_EQUALS(0, jobs[0].status);
+	TEST_ASSERT(jobs[0].output.data_length > 0);
+	TEST_ASSERT(jobs[0].output.data_length <= bufferSize);
+	TEST_ASSERT_EQUALS(0, jobs[1].status);
+	TEST_ASSERT(jobs[1].output.data_length > 0);
+	TEST_ASSERT(jobs[1].output.data_length <= bufferSize);
+	TEST_ASSERT_EQUALS(-15, jobs[2].status);
+	// the required size is reported for the too small buffer
+	TEST_ASSERT_EQUALS(-61, jobs[3].status);
+	TEST_ASSERT_EQUALS(jobs[0].output.data_length, jobs[3].output.data_length);
+
+	// the compiled modules can be executed, the specialized kernel is generated too
+	std::stringstream packModesCode(std::string(packModesOutput.data(), jobs[0].output.data_length));
+	std::vector<uint32_t> input(16);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x89ABCDEFu;
+	const auto bytes = runKernel(packModesCode, "test_extract_bytes", {{0u, std::vector<uint32_t>(64)}, {0u, input}}, 16);
+	for(uint32_t i = 0; i < 16; ++i)
+		TEST_ASSERT_EQUALS((input[i] * 3u) & 0xFFu, bytes.output.at(i * 4));
+
+	std::stringstream specializedCode(std::string(specializationOutput.data(), jobs[1].output.data_length));
+	EmulationData data;
+	data.kernelName = "test_specialized";
+	data.maxEmulationCycles = vc4c::test::maxExecutionCycles;
+	data.module = std::make_pair("", &specializedCode);
+	data.workGroup.localSizes = {12, 1, 1};
+	data.workGroup.numGroups = {2, 1, 1};
+	std::vector<uint32_t> indices(24);
+	for(uint32_t i = 0; i < indices.size(); ++i)
+		indices[i] = i;
+	data.parameter.emplace_back(0, std::vector<uint32_t>(24));
+	data.parameter.emplace_back(0, indices);
+	const auto result = emulate(data);
+	TEST_ASSERT(result.executionSuccessful);
+	const auto& specializedOut = *result.results.front().second;
+	for(uint32_t i = 0; i < indices.size(); ++i)
+		// 4 * (3 * in) + (0 + 1 + 2 + 3) + 12 + 2, see #testKernelSpecialization
+		TEST_ASSERT_EQUALS(12 * i + 20, specializedOut.at(i));
+}
+
+static int connectToServer(const std::string& socketPath)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	std::copy(socketPath.begin(), socketPath.end(), address.sun_path);
+	// the server might not yet listen on the socket
+	for(unsigned i = 0; i < 100; ++i)
+	{
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(fd < 0)
+			return -1;
+		if(connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0)
+			return fd;
+		close(fd);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	return -1;
+}
+
+static std::string sendServerRequest(const std::string& socketPath, const std::string& request)
+{
+	int fd = connectToServer(socketPath);
+	if(fd < 0)
+		return "";
+	std::string response;
+	if(write(fd, request.data(), request.size()) == static_cast<ssize_t>(request.size()))
+	{
+		char buffer[4096];
+		ssize_t numBytes = 0;
+		while((numBytes = read(fd, buffer, sizeof(buffer))) > 0)
+			response.append(buffer, static_cast<std::size_t>(numBytes));
+	}
+	close(fd);
+	return response;
+}
+
+void TestEmulator::testLazyFunctionMaterialization()
+{
+	std::stringstream llvmBuffer;
+	std::stringstream defaultBuffer;
+	compileFile(defaultBuffer, "./testing/test_lazy_functions.cl");
+	{
+		ConfigurationScope scope(config);
+		// the LLVM IR front-end reads the function bodies lazily
+		config.frontend = Frontend::LLVM_IR;
+		compileFile(llvmBuffer, "./testing/test_lazy_functions.cl");
+	}
+
+	std::vector<uint32_t> input(12);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x89ABCDEFu;
+	auto nestedHelper = [](uint32_t a) -> uint32_t { return a * 3u + 1u; };
+
+	// the bodies of the called (and transitively called) functions are read
+	const auto called = runKernel(llvmBuffer, "test_lazy_call", {{0u, std::vector<uint32_t>(12)}, {0u, input}}, 12);
+	for(uint32_t i = 0; i < called.output.size(); ++i)
+		TEST_ASSERT_EQUALS(nestedHelper(input[i]) ^ i, called.output.at(i));
+	TEST_ASSERT(called.output ==
+		runKernel(defaultBuffer, "test_lazy_call", {{0u, std::vector<uint32_t>(12)}, {0u, input}}, 12).output);
+
+	// the bodies already read for the other kernel are re-used
+	const auto shared =
+		runKernel(llvmBuffer, "test_lazy_shared_call", {{0u, std::vector<uint32_t>(12)}, {0u, input}}, 12);
+	for(uint32_t i = 0; i < shared.output.size(); ++i)
+		TEST_ASSERT_EQUALS(nestedHelper(input[i]) + (nestedHelper(input[i]) ^ 5u), shared.output.at(i));
+	TEST_ASSERT(shared.output ==
+		runKernel(defaultBuffer, "test_lazy_shared_call", {{0u, std::vector<uint32_t>(12)}, {0u, input}}, 12).output);
+}
+
+void TestEmulator::testCompilationServer()
+{
+	const std::string socketPath = "/tmp/vc4c-test-server-" + std::to_string(getpid());
+	int status = -1;
+	std::thread server([&]() {
+		try
+		{
+			status = runCompilationServer(socketPath, config, "");
+		}
+		catch(const std::exception& e)
+		{
+			std::cerr << "Failed to run compilation server: " << e.what() << std::endl;
+		}
+	});
+
+	std::ifstream input("./example/hello_world.cl");
+	const std::string source((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	const std::string request = "--bin --kernel-info\n" + std::to_string(source.size()) + "\n" + source;
+
+	const auto response = sendServerRequest(socketPath, request);
+	TEST_ASSERT_EQUALS(0u, response.find("OK "));
+	const auto headerEnd = response.find('\n');
+	TEST_ASSERT(headerEnd != std::string::npos);
+	std::stringstream buffer(response.substr(headerEnd + 1));
+	TEST_ASSERT_EQUALS(std::to_string(buffer.str().size()), response.substr(3, headerEnd - 3));
+
+	// the repeated request is answered from the cache with the same result
+	TEST_ASSERT_EQUALS(response, sendServerRequest(socketPath, request));
+	// malformed requests are rejected
+	TEST_ASSERT_EQUALS(0u, sendServerRequest(socketPath, "--bin\nfoo\n").find("ERROR "));
+
+	stopCompilationServer();
+	server.join();
+	TEST_ASSERT_EQUALS(0, status);
+	// the socket is removed on shutdown
+	TEST_ASSERT(access(socketPath.data(), F_OK) != 0);
+
+	// the compiled code is correct
+	EmulationData data;
+	data.kernelName = "hello_world";
+	data.maxEmulationCycles = vc4c::test::maxExecutionCycles;
+	data.module = std::make_pair("", &buffer);
+	data.workGroup.localSizes = {1, 1, 1};
+	data.parameter.emplace_back(0u, std::vector<uint32_t>(16 / sizeof(uint32_t)));
+
+	const auto result = emulate(data);
+	TEST_ASSERT(result.executionSuccessful);
+	const auto& out = *result.results.front().second;
+	TEST_ASSERT_EQUALS(0, strncmp("Hello World!", reinterpret_cast<const char*>(out.data()), 16));
+}
+
+void TestEmulator::testLoopUnrolling()
+{
+	std::stringstream unrolledBuffer;
+	compileFile(unrolledBuffer, "./testing/test_loop_unrolling.cl");
+	std::stringstream rolledBuffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalOptions.maxUnrollFactor = 1;
+		compileFile(rolledBuffer, "./testing/test_loop_unrolling.cl");
+	}
+
+	std::vector<uint32_t> input(16);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = 3 * i + 1;
+	// computes the expected result for the loop with the given start, step and continuation condition
+	auto expected = [&](int32_t start, int32_t step, const std::function<bool(int32_t)>& condition) -> uint32_t {
+		uint32_t sum = 0;
+		for(int32_t i = start; condition(i); i += step)
+			sum += input.at(static_cast<std::size_t>(i)) * static_cast<uint32_t>(i + 1);
+		return sum;
+	};
+	const std::vector<std::pair<std::string, uint32_t>> kernels = {
+		{"test_unroll_less", expected(0, 3, [](int32_t i) -> bool { return i < 10; })},
+		{"test_unroll_less_equal", expected(1, 2, [](int32_t i) -> bool { return i <= 9; })},
+		{"test_unroll_not_equal", expected(0, 4, [](int32_t i) -> bool { return i != 12; })},
+		{"test_unroll_decrement", expected(15, -1, [](int32_t i) -> bool { return i > 0; })},
+		{"test_unroll_decrement_greater_equal", expected(14, -3, [](int32_t i) -> bool { return i >= 0; })}};
+
+	for(const auto& kernel : kernels)
+	{
+		for(std::stringstream* buffer : {&unrolledBuffer, &rolledBuffer})
+		{
+			const auto execution =
+				runKernel(*buffer, kernel.first, {{0u, std::vector<uint32_t>(4)}, {0u, input}}, 4);
+			for(auto res : execution.output)
+				TEST_ASSERT_EQUALS(kernel.second, res);
+		}
+	}
+}
+
+void TestEmulator::testLoopVectorization()
+{
+	std::stringstream scalarBuffer;
+	std::stringstream vectorBuffer;
+	std::stringstream fastMathBuffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalOptions.maxUnrollFactor = 1;
+		compileFile(scalarBuffer, "./testing/test_loop_vectorization.cl");
+		config.additionalEnabledOptimizations.emplace("vectorize-loops");
+		compileFile(vectorBuffer, "./testing/test_loop_vectorization.cl");
+		config.mathType = MathType::FAST_RELAXED_MATH;
+		compileFile(fastMathBuffer, "./testing/test_loop_vectorization.cl");
+	}
+
+	std::vector<uint32_t> intInput(32);
+	std::vector<uint32_t> floatInput(32);
+	for(uint32_t i = 0; i < intInput.size(); ++i)
+	{
+		intInput[i] = static_cast<uint32_t>((static_cast<int32_t>(i) - 10) * 0x01030507);
+		// only (negative) powers of two, so sums and products are exact in any order
+		const float value = std::ldexp(i % 4 == 1 ? -1.0f : 1.0f, static_cast<int>(i % 3) - 1);
+		floatInput[i] = bit_cast<float, uint32_t>(value);
+	}
+	// computes the expected result of folding the first 21 input values with the given operation
+	auto expectInt = [&](int32_t initial, const std::function<int32_t(int32_t, int32_t)>& op) -> uint32_t {
+		int32_t result = initial;
+		for(std::size_t i = 0; i < 21; ++i)
+			result = op(result, static_cast<int32_t>(intInput[i]));
+		return static_cast<uint32_t>(result);
+	};
+	auto expectFloat = [&](float initial, const std::function<float(float, float)>& op) -> uint32_t {
+		float result = initial;
+		for(std::size_t i = 0; i < 21; ++i)
+			result = op(result, bit_cast<uint32_t, float>(floatInput[i]));
+		return bit_cast<float, uint32_t>(result);
+	};
+	uint32_t stepSum = 0;
+	for(uint32_t i = 0; i < 61; i += 3)
+		stepSum += intInput[i / 2];
+
+	struct VectorizationTest
+	{
+		std::string kernelName;
+		std::stringstream* vectorizedBuffer;
+		const std::vector<uint32_t>& input;
+		uint32_t expected;
+	};
+	const std::vector<VectorizationTest> kernels = {
+		{"test_vectorize_remainder_step", &vectorBuffer, intInput, stepSum},
+		{"test_vectorize_add", &vectorBuffer, intInput, expectInt(0, std::plus<int32_t>{})},
+		{"test_vectorize_and", &vectorBuffer, intInput, expectInt(-1, std::bit_and<int32_t>{})},
+		{"test_vectorize_or", &vectorBuffer, intInput, expectInt(0, std::bit_or<int32_t>{})},
+		{"test_vectorize_xor", &vectorBuffer, intInput, expectInt(0, std::bit_xor<int32_t>{})},
+		{"test_vectorize_min", &vectorBuffer, intInput,
+			expectInt(0x7FFFFFFF, [](int32_t a, int32_t b) -> int32_t { return std::min(a, b); })},
+		{"test_vectorize_max", &vectorBuffer, intInput,
+			expectInt(-0x7FFFFFFF - 1, [](int32_t a, int32_t b) -> int32_t { return std::max(a, b); })},
+		{"test_vectorize_fmin", &vectorBuffer, floatInput,
+			expectFloat(std::numeric_limits<float>::infinity(),
+				[](float a, float b) -> float { return std::fmin(a, b); })},
+		{"test_vectorize_fmax", &vectorBuffer, floatInput,
+			expectFloat(-std::numeric_limits<float>::infinity(),
+				[](float a, float b) -> float { return std::fmax(a, b); })},
+		{"test_vectorize_fadd", &fastMathBuffer, floatInput, expectFloat(0.0f, std::plus<float>{})},
+		{"test_vectorize_fmul", &fastMathBuffer, floatInput, expectFloat(1.0f, std::multiplies<float>{})}};
+
+	auto run = [&](const std::string& kernelName, std::stringstream& buffer,
+				   const std::vector<uint32_t>& input) -> KernelExecution {
+		return runKernel(buffer, kernelName, {{0u, std::vector<uint32_t>(32)}, {0u, input}});
+	};
+
+	for(const auto& kernel : kernels)
+	{
+		const auto scalar = run(kernel.kernelName, scalarBuffer, kernel.input);
+		const auto vectorized = run(kernel.kernelName, *kernel.vectorizedBuffer, kernel.input);
+		TEST_ASSERT_EQUALS(kernel.expected, scalar.output.at(0));
+		TEST_ASSERT_EQUALS(kernel.expected, vectorized.output.at(0));
+		// the vectorized loop runs fewer iterations, even with the remainder loop
+		TEST_ASSERT(vectorized.numBranchesTaken < scalar.numBranchesTaken);
+	}
+
+	// element-wise loop with remainder iterations, the elements not written by the loop are kept
+	const auto scalar = run("test_vectorize_remainder", scalarBuffer, intInput);
+	const auto vectorized = run("test_vectorize_remainder", vectorBuffer, intInput);
+	TEST_ASSERT_EQUALS(0u, vectorized.output.at(0));
+	for(uint32_t i = 1; i < 22; ++i)
+		TEST_ASSERT_EQUALS(intInput[i] + i, vectorized.output.at(i));
+	for(uint32_t i = 22; i < vectorized.output.size(); ++i)
+		TEST_ASSERT_EQUALS(0u, vectorized.output.at(i));
+	TEST_ASSERT(scalar.output == vectorized.output);
+	TEST_ASSERT(vectorized.numBranchesTaken < scalar.numBranchesTaken);
+
+	// loops with bounds only known at run-time, the vectorized loop is skipped for too few iterations
+	for(uint32_t count : {0u, 1u, 5u, 16u, 17u, 21u, 32u})
+	{
+		auto runWithCount = [&](const std::string& kernelName, std::stringstream& buffer) -> KernelExecution {
+			return runKernel(
+				buffer, kernelName, {{0u, std::vector<uint32_t>(32)}, {0u, intInput}, {count, {}}});
+		};
+		const auto scalarElements = runWithCount("test_vectorize_runtime_bound", scalarBuffer);
+		const auto vectorElements = runWithCount("test_vectorize_runtime_bound", vectorBuffer);
+		for(uint32_t i = 0; i < vectorElements.output.size(); ++i)
+			TEST_ASSERT_EQUALS(i < count ? intInput[i] + i : 0u, vectorElements.output.at(i));
+		TEST_ASSERT(scalarElements.output == vectorElements.output);
+
+		const auto scalarSum = runWithCount("test_vectorize_runtime_bound_add", scalarBuffer);
+		const auto vectorSum = runWithCount("test_vectorize_runtime_bound_add", vectorBuffer);
+		uint32_t sum = 0;
+		for(uint32_t i = 0; i < count; ++i)
+			sum += intInput[i];
+		TEST_ASSERT_EQUALS(sum, scalarSum.output.at(0));
+		TEST_ASSERT_EQUALS(sum, vectorSum.output.at(0));
+
+		if(count > 16)
+		{
+			// at least one full vector of iterations is executed by the vectorized loop
+			TEST_ASSERT(vectorElements.numBranchesTaken < scalarElements.numBranchesTaken);
+			TEST_ASSERT(vectorSum.numBranchesTaken < scalarSum.numBranchesTaken);
+		}
+	}
+}
+
+void TestEmulator::testLoopInvariantCodeMotion()
+{
+	std::stringstream hoistedBuffer;
+	std::stringstream unhoistedBuffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalOptions.maxUnrollFactor = 1;
+		config.additionalEnabledOptimizations.emplace("move-loop-invariant-code");
+		compileFile(hoistedBuffer, "./testing/test_loop_invariant.cl");
+	}
+	{
+		ConfigurationScope scope(config);
+		config.additionalOptions.maxUnrollFactor = 1;
+		config.additionalDisabledOptimizations.emplace("move-loop-invariant-code");
+		compileFile(unhoistedBuffer, "./testing/test_loop_invariant.cl");
+	}
+
+	std::vector<uint32_t> input(16);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x89ABCDEFu;
+	const uint32_t a = 0x12345;
+	const uint32_t b = static_cast<uint32_t>(-7);
+	const uint32_t c = 3;
+
+	// runs the kernel with and without moving the invariant code, checks both produce the same output and returns the
+	// executions
+	auto run = [&](const std::string& kernelName, const std::vector<uint32_t>& output) {
+		const auto hoisted = runKernel(hoistedBuffer, kernelName, {{0u, output}, {0u, input}, {a, {}}, {b, {}}, {c, {}}});
+		const auto unhoisted =
+			runKernel(unhoistedBuffer, kernelName, {{0u, output}, {0u, input}, {a, {}}, {b, {}}, {c, {}}});
+		TEST_ASSERT(hoisted.output == unhoisted.output);
+		TEST_ASSERT(hoisted.numInstructions <= unhoisted.numInstructions);
+		return std::make_pair(hoisted, unhoisted);
+	};
+
+	const auto invariant = run("test_invariant", std::vector<uint32_t>(16));
+	for(uint32_t i = 0; i < 16; ++i)
+		TEST_ASSERT_EQUALS(input[i] * (a * b + c) + (a ^ c), invariant.first.output.at(i));
+	// the invariant calculations are executed once instead of in every iteration
+	TEST_ASSERT(invariant.first.numInstructions < invariant.second.numInstructions);
+
+	const auto conditional = run("test_conditional_write", std::vector<uint32_t>(16));
+	uint32_t val = a * 3u;
+	for(uint32_t i = 0; i < 16; ++i)
+	{
+		if(static_cast<int32_t>(input[i]) > static_cast<int32_t>(c))
+			val = b + 7u;
+		TEST_ASSERT_EQUALS(val * 2u + a, conditional.first.output.at(i));
+	}
+
+	const auto written = run("test_written_in_loop", std::vector<uint32_t>(16));
+	uint32_t acc = a;
+	for(uint32_t i = 0; i < 16; ++i)
+	{
+		const uint32_t tmp = acc * 5u + b;
+		acc = tmp + input[i];
+		TEST_ASSERT_EQUALS(tmp - c, written.first.output.at(i));
+	}
+
+	std::vector<uint32_t> data(17);
+	data[0] = 0x42;
+	const auto sideEffects = run("test_side_effects", data);
+	uint32_t sum = data[0];
+	for(uint32_t i = 0; i < 16; ++i)
+	{
+		TEST_ASSERT_EQUALS(sum * a + b, sideEffects.first.output.at(i + 1));
+		sum += input[i];
+	}
+	TEST_ASSERT_EQUALS(sum, sideEffects.first.output.at(0));
+}
+
+void TestEmulator::testRegisterPressure()
+{
+	// moving the constant loads out of the loop exceeds the available registers, unless they are re-loaded before use
+	std::stringstream buffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalOptions.maxUnrollFactor = 1;
+		config.additionalEnabledOptimizations.emplace("extract-loads-from-loops");
+		compileFile(buffer, "./testing/test_register_pressure.cl");
+	}
+
+	std::vector<uint32_t> input(64);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01010101u + 0x12345678u;
+
+	const auto output =
+		runKernel(buffer, "test_register_pressure", {{0u, std::vector<uint32_t>(64)}, {0u, input}}, 4).output;
+	for(uint32_t lid = 0; lid < 4; ++lid)
+	{
+		std::array<uint32_t, 16> accumulators{};
+		for(uint32_t k = 0; k < accumulators.size(); ++k)
+			accumulators[k] = k;
+		for(uint32_t i = 0; i < 4; ++i)
+		{
+			const uint32_t x = input[i * 16 + lid];
+			for(uint32_t k = 0; k < 56; ++k)
+			{
+				uint32_t& acc = accumulators[k % 16];
+				const uint32_t val = acc ^ (x + (0x9E3779B9u + k * 0x01000193u));
+				const uint32_t offset = k % 31 + 1;
+				acc = (val << offset) | (val >> (32 - offset));
+			}
+		}
+		for(uint32_t k = 0; k < accumulators.size(); ++k)
+			TEST_ASSERT_EQUALS(accumulators[k], output.at(lid * 16 + k));
+	}
+}
+
+void TestEmulator::testVectorRotations()
+{
+	std::stringstream optimizedBuffer;
+	compileFile(optimizedBuffer, "./testing/test_vector_rotations.cl");
+	std::stringstream unoptimizedBuffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalDisabledOptimizations.emplace("optimize-rotations");
+		compileFile(unoptimizedBuffer, "./testing/test_vector_rotations.cl");
+	}
+
+	std::vector<uint32_t> input(128);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x12345678u;
+	// the first element of every other vector is odd, to run both branches
+	for(uint32_t k = 0; k < input.size() / 16; ++k)
+		input[k * 16] = (input[k * 16] & ~1u) | ((k + 1) % 2);
+
+	auto run = [&](const std::string& kernelName, std::stringstream& buffer) -> KernelExecution {
+		return runKernel(buffer, kernelName, {{0u, std::vector<uint32_t>(64)}, {0u, input}}, 4);
+	};
+
+	// the rotations across the blocks cancel each other out, replacing the second rotation with a move
+	{
+		const auto optimized = run("test_rotation_across_blocks", optimizedBuffer);
+		const auto unoptimized = run("test_rotation_across_blocks", unoptimizedBuffer);
+		for(uint32_t i = 0; i < 64; ++i)
+		{
+			const uint32_t val = input[i];
+			const bool isOdd = (input[i / 16 * 16] & 1) != 0;
+			TEST_ASSERT_EQUALS(isOdd ? val : val + 1, optimized.output.at(i));
+		}
+		TEST_ASSERT(optimized.output == unoptimized.output);
+		TEST_ASSERT(optimized.numInstructions < unoptimized.numInstructions);
+	}
+
+	// the delays before the rotations are filled with independent instructions or removed
+	{
+		const auto optimized = run("test_rotation_delay", optimizedBuffer);
+		const auto unoptimized = run("test_rotation_delay", unoptimizedBuffer);
+		for(uint32_t k = 0; k < 4; ++k)
+		{
+			const uint32_t* a = &input[k * 32];
+			const uint32_t* b = &input[k * 32 + 16];
+			for(uint32_t i = 0; i < 16; ++i)
+			{
+				const uint32_t lower = (i + 13) % 16;
+				const uint32_t upper = (i + 3) % 16;
+				const uint32_t opposite = (i + 8) % 16;
+				const uint32_t expected =
+					(a[lower] + b[lower]) + (a[upper] + b[upper]) + (a[opposite] - b[opposite]);
+				TEST_ASSERT_EQUALS(expected, optimized.output.at(k * 16 + i));
+			}
+		}
+		TEST_ASSERT(optimized.output == unoptimized.output);
+		TEST_ASSERT(optimized.numInstructions < unoptimized.numInstructions);
+	}
+}
+
+void TestEmulator::testPackModes()
+{
+	std::stringstream packedBuffer;
+	compileFile(packedBuffer, "./testing/test_pack_modes.cl");
+	std::stringstream maskedBuffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalDisabledOptimizations.emplace("combine-pack-modes");
+		compileFile(maskedBuffer, "./testing/test_pack_modes.cl");
+	}
+
+	std::vector<uint32_t> input(64);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x89ABCDEFu;
+
+	// runs the kernel with and without the pack-modes, checks both produce the same output and returns the output
+	auto run = [&](const std::string& kernelName, uint32_t localSize, bool isFolded) -> std::vector<uint32_t> {
+		const auto packed = runKernel(packedBuffer, kernelName, {{0u, std::vector<uint32_t>(64)}, {0u, input}}, localSize);
+		const auto masked = runKernel(maskedBuffer, kernelName, {{0u, std::vector<uint32_t>(64)}, {0u, input}}, localSize);
+		TEST_ASSERT(packed.output == masked.output);
+		if(isFolded)
+			// the shifts and masks are replaced with pack- and unpack-modes
+			TEST_ASSERT(packed.numInstructions < masked.numInstructions);
+		else
+			TEST_ASSERT(packed.numInstructions <= masked.numInstructions);
+		return packed.output;
+	};
+	auto signExtend = [](uint32_t val) -> uint32_t {
+		return static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(val & 0xFFFFu)));
+	};
+
+	const auto bytes = run("test_extract_bytes", 16, true);
+	const auto halfWords = run("test_extract_half_words", 16, true);
+	const auto added = run("test_add_masked", 16, false);
+	for(uint32_t i = 0; i < 16; ++i)
+	{
+		const uint32_t val = input[i] * 3u;
+		TEST_ASSERT_EQUALS(val & 0xFFu, bytes.at(i * 4 + 0));
+		TEST_ASSERT_EQUALS((val >> 8) & 0xFFu, bytes.at(i * 4 + 1));
+		TEST_ASSERT_EQUALS((val >> 16) & 0xFFu, bytes.at(i * 4 + 2));
+		TEST_ASSERT_EQUALS((input[i] + 7u) & 0xFFu, bytes.at(i * 4 + 3));
+
+		TEST_ASSERT_EQUALS((input[i] + 7u) & 0xFFFFu, halfWords.at(i * 4 + 0));
+		TEST_ASSERT_EQUALS(signExtend(val), halfWords.at(i * 4 + 1));
+		TEST_ASSERT_EQUALS(signExtend(input[i] ^ 0x5A5Au), halfWords.at(i * 4 + 2));
+		TEST_ASSERT_EQUALS((val >> 16) & 0xFFFFu, halfWords.at(i * 4 + 3));
+
+		TEST_ASSERT_EQUALS(((input[i] + 7u) & 0xFFFFu) + (val & 0xFFu), added.at(i));
+	}
+
+	// the rotation by half the vector-width is independent of the direction
+	const auto rotated = run("test_rotate_masked", 4, false);
+	for(uint32_t i = 0; i < rotated.size(); ++i)
+	{
+		const uint32_t source = input[i / 16 * 16 + (i + 8) % 16];
+		TEST_ASSERT_EQUALS(((source + 7u) & 0xFFu) + ((source * 3u) & 0xFFFFu), rotated.at(i));
+	}
+
+	// the elements are loaded from unaligned addresses
+	const auto chars = run("test_load_chars", 12, false);
+	const auto shorts = run("test_load_shorts", 12, false);
+	for(uint32_t i = 0; i < 12; ++i)
+	{
+		TEST_ASSERT_EQUALS(((input[i / 4] >> (i % 4 * 8)) & 0xFFu) + 1u, chars.at(i));
+		TEST_ASSERT_EQUALS(signExtend(input[i / 2] >> (i % 2 * 16)) + 1u, shorts.at(i));
+	}
+}
+
+void TestEmulator::testDMAPipelining()
+{
+	std::stringstream pipelinedBuffer;
+	std::stringstream sequentialBuffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalDisabledOptimizations.emplace("pipeline-dma");
+		compileFile(sequentialBuffer, "./testing/test_dma_pipelining.cl");
+	}
+	{
+		ConfigurationScope scope(config);
+		config.additionalEnabledOptimizations.emplace("pipeline-dma");
+		compileFile(pipelinedBuffer, "./testing/test_dma_pipelining.cl");
+	}
+
+	// 4 work-items with 4 vectors each
+	std::vector<uint32_t> input(4 * 4 * 16);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x89ABCDEFu;
+
+	// runs the kernel with and without pipelining, checks both produce the same output and returns the output
+	auto run = [&](const std::string& kernelName,
+				   const std::vector<std::pair<uint32_t, Optional<std::vector<uint32_t>>>>& parameters) {
+		const auto pipelined = runKernel(pipelinedBuffer, kernelName, parameters, 4);
+		const auto sequential = runKernel(sequentialBuffer, kernelName, parameters, 4);
+		TEST_ASSERT(pipelined.output == sequential.output);
+		// the critical sections of the back-to-back transfers are merged
+		TEST_ASSERT(pipelined.numInstructions < sequential.numInstructions);
+		return pipelined.output;
+	};
+
+	const auto loaded = run("test_dma_loads", {{0u, input}});
+	for(uint32_t i = 0; i < loaded.size(); ++i)
+	{
+		if(i % 64 >= 16)
+			TEST_ASSERT_EQUALS(input[i], loaded.at(i));
+		else
+			TEST_ASSERT_EQUALS(input[i] + input[i + 16] * 2u + input[i + 32] * 3u + input[i + 48] * 4u, loaded.at(i));
+	}
+
+	const auto stored = run("test_dma_stores", {{0u, std::vector<uint32_t>(input.size())}, {0u, input}});
+	for(uint32_t i = 0; i < stored.size(); ++i)
+	{
+		const uint32_t val = input[i / 64 * 16 + i % 16];
+		const uint32_t expected[] = {val, val + 1u, val * 2u, val ^ 0x5A5Au};
+		TEST_ASSERT_EQUALS(expected[i % 64 / 16], stored.at(i));
+	}
+
+	// the loads read the values stored by the previous statement
+	const auto loadedStored = run("test_dma_load_store", {{0u, input}});
+	for(uint32_t i = 0; i < loadedStored.size(); ++i)
+	{
+		const uint32_t first = input[i / 64 * 64 + i % 16];
+		const uint32_t expected[] = {first, first + 1u, (first + 1u) * 3u, (first + 1u) * 3u - first};
+		TEST_ASSERT_EQUALS(expected[i % 64 / 16], loadedStored.at(i));
+	}
+}
+
+void TestEmulator::testRedundantExtensions()
+{
+	std::stringstream eliminatedBuffer;
+	std::stringstream extendedBuffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalOptions.maxUnrollFactor = 1;
+		config.additionalEnabledOptimizations.emplace("eliminate-redundant-extensions");
+		compileFile(eliminatedBuffer, "./testing/test_redundant_extensions.cl");
+	}
+	{
+		ConfigurationScope scope(config);
+		config.additionalOptions.maxUnrollFactor = 1;
+		config.additionalDisabledOptimizations.emplace("eliminate-redundant-extensions");
+		compileFile(extendedBuffer, "./testing/test_redundant_extensions.cl");
+	}
+
+	std::vector<uint32_t> input(16);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x89ABCDEFu;
+	auto getByte = [&](uint32_t index) -> uint32_t { return (input[index / 4] >> (index % 4 * 8)) & 0xFFu; };
+	auto getHalfWord = [&](uint32_t index) -> uint32_t { return (input[index / 2] >> (index % 2 * 16)) & 0xFFFFu; };
+
+	// runs the kernel with and without eliminating the extensions, checks both produce the same output and returns
+	// the output
+	auto run = [&](const std::string& kernelName, uint32_t localSize) -> std::vector<uint32_t> {
+		const auto eliminated =
+			runKernel(eliminatedBuffer, kernelName, {{0u, std::vector<uint32_t>(16)}, {0u, input}}, localSize);
+		const auto extended =
+			runKernel(extendedBuffer, kernelName, {{0u, std::vector<uint32_t>(16)}, {0u, input}}, localSize);
+		TEST_ASSERT(eliminated.output == extended.output);
+		TEST_ASSERT(eliminated.numInstructions <= extended.numInstructions);
+		return eliminated.output;
+	};
+
+	// the values overflow the range of their types, so they need to be truncated and extended
+	const auto zeroExtended = run("test_needed_zero_extension", 16);
+	const auto signExtended = run("test_needed_sign_extension", 16);
+	for(uint32_t i = 0; i < 16; ++i)
+	{
+		TEST_ASSERT_EQUALS((getByte(i) + 200u) & 0xFFu, zeroExtended.at(i));
+		TEST_ASSERT_EQUALS(static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(getHalfWord(i) * 3u))),
+			signExtended.at(i));
+	}
+
+	const auto loopExtended = run("test_needed_loop_extension", 1);
+	uint32_t acc = 0;
+	for(uint32_t i = 0; i < 16; ++i)
+		acc = (acc + input[i]) & 0xFFu;
+	TEST_ASSERT_EQUALS(acc, loopExtended.at(0));
+
+	const auto redundant = run("test_redundant_extension", 16);
+	for(uint32_t i = 0; i < 16; ++i)
+		TEST_ASSERT_EQUALS((getByte(i) & 0x7Fu) * 2u, redundant.at(i));
+}
+
+void TestEmulator::testALUPacking()
+{
+	std::stringstream packedBuffer;
+	std::stringstream unpackedBuffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalEnabledOptimizations.emplace("pack-alu");
+		compileFile(packedBuffer, "./testing/test_pack_alu.cl");
+	}
+	{
+		ConfigurationScope scope(config);
+		config.additionalDisabledOptimizations.emplace("pack-alu");
+		compileFile(unpackedBuffer, "./testing/test_pack_alu.cl");
+	}
+
+	std::vector<uint32_t> input(64);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x89ABCDEFu;
+	// positive values with a reciprocal above and below 0.5 and small enough to calculate the exponent of
+	std::vector<uint32_t> floatInput(32);
+	for(uint32_t i = 0; i < floatInput.size(); ++i)
+		floatInput[i] = bit_cast<float, uint32_t>(1.0f + static_cast<float>(i) * 0.25f);
+
+	// runs the kernel with and without packing, checks both produce the same output and returns the output
+	auto run = [&](const std::string& kernelName, const std::vector<uint32_t>& in, uint32_t numOutputs,
+				   bool isPacked) -> std::vector<uint32_t> {
+		const auto packed =
+			runKernel(packedBuffer, kernelName, {{0u, std::vector<uint32_t>(numOutputs)}, {0u, in}}, 16);
+		const auto unpacked =
+			runKernel(unpackedBuffer, kernelName, {{0u, std::vector<uint32_t>(numOutputs)}, {0u, in}}, 16);
+		TEST_ASSERT(packed.output == unpacked.output);
+		if(isPacked)
+			// the independent calculations are executed in parallel on both ALUs
+			TEST_ASSERT(packed.numInstructions < unpacked.numInstructions);
+		else
+			TEST_ASSERT(packed.numInstructions <= unpacked.numInstructions);
+		return packed.output;
+	};
+
+	const auto independent = run("test_independent", input, 64, true);
+	const auto conditional = run("test_conditional", input, 64, false);
+	const auto tmu = run("test_tmu", input, 32, false);
+	for(uint32_t i = 0; i < 16; ++i)
+	{
+		const uint32_t a = input[i];
+		const uint32_t b = input[i + 16];
+		TEST_ASSERT_EQUALS((a + 7u) ^ (b - 3u), independent.at(i * 4 + 0));
+		TEST_ASSERT_EQUALS((a & 0xFF00FFu) | (b >> 4), independent.at(i * 4 + 1));
+		TEST_ASSERT_EQUALS((a << 3) - (b & 0x0F0F0Fu), independent.at(i * 4 + 2));
+		TEST_ASSERT_EQUALS(std::max(a, b) + std::min(a ^ 0x5A5Au, b), independent.at(i * 4 + 3));
+
+		const int32_t x = static_cast<int32_t>(a);
+		const int32_t y = static_cast<int32_t>(b);
+		TEST_ASSERT_EQUALS(x > y ? a - b : b + 5u, conditional.at(i * 4 + 0));
+		TEST_ASSERT_EQUALS((a & 1u) != 0 ? a ^ 0x1234u : b, conditional.at(i * 4 + 1));
+		TEST_ASSERT_EQUALS((y < 0 ? 1u : 2u) + (x == y ? 3u : 4u), conditional.at(i * 4 + 2));
+		TEST_ASSERT_EQUALS(x < 0 ? (y > 0 ? a + b : a - b) : (b & a), conditional.at(i * 4 + 3));
+
+		const uint32_t loaded = input[(a & 15u) + 16u];
+		TEST_ASSERT_EQUALS(loaded + (a ^ 0x1234u), tmu.at(i * 2 + 0));
+		TEST_ASSERT_EQUALS((input[i + 32] - a) | (loaded & 0xF0u), tmu.at(i * 2 + 1));
+	}
+
+	// the SFU results are calculated exactly by the emulator, so a result read from r4 at the wrong position differs
+	const auto sfu = run("test_sfu", floatInput, 64, false);
+	for(uint32_t i = 0; i < 16; ++i)
+	{
+		const float a = bit_cast<uint32_t, float>(floatInput[i]);
+		const float b = bit_cast<uint32_t, float>(floatInput[i + 16]);
+		const float recip = 1.0f / a;
+		const float expected[] = {
+			recip > 0.5f ? recip : b, 1.0f / std::sqrt(b) * a, std::exp2(a) - std::log2(b), a * b + 1.0f};
+		for(uint32_t k = 0; k < 4; ++k)
+		{
+			const float result = bit_cast<uint32_t, float>(sfu.at(i * 4 + k));
+			TEST_ASSERT(std::abs(result - expected[k]) <= std::abs(expected[k]) * 1e-5f);
+		}
+	}
+}
+
+void TestEmulator::testTMUPipelining()
+{
+	std::stringstream pipelinedBuffer;
+	std::stringstream sequentialBuffer;
+	{
+		ConfigurationScope scope(config);
+		config.additionalEnabledOptimizations.emplace("pipeline-tmu");
+		compileFile(pipelinedBuffer, "./testing/test_tmu_pipelining.cl");
+	}
+	{
+		ConfigurationScope scope(config);
+		config.additionalDisabledOptimizations.emplace("pipeline-tmu");
+		compileFile(sequentialBuffer, "./testing/test_tmu_pipelining.cl");
+	}
+
+	std::vector<uint32_t> input(112);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x89ABCDEFu;
+	std::vector<uint32_t> floatInput(48);
+	for(uint32_t i = 0; i < floatInput.size(); ++i)
+		floatInput[i] = bit_cast<float, uint32_t>(1.0f + static_cast<float>(i) * 0.25f);
+
+	// runs the kernel with and without pipelining, checks both produce the same output and returns the output
+	auto run = [&](const std::string& kernelName,
+				   const std::vector<std::pair<uint32_t, Optional<std::vector<uint32_t>>>>& parameters,
+				   bool isPipelined) -> std::vector<uint32_t> {
+		const auto pipelined = runKernel(pipelinedBuffer, kernelName, parameters, 16);
+		const auto sequential = runKernel(sequentialBuffer, kernelName, parameters, 16);
+		TEST_ASSERT(pipelined.output == sequential.output);
+		if(isPipelined)
+			// the loads are executed in parallel with the instructions in between, so the QPUs stall less often
+			TEST_ASSERT(pipelined.numInstructions < sequential.numInstructions);
+		else
+			TEST_ASSERT(pipelined.numInstructions <= sequential.numInstructions);
+		return pipelined.output;
+	};
+
+	const std::vector<uint32_t> in0(input.begin(), input.begin() + 32);
+	const std::vector<uint32_t> in1(input.begin() + 32, input.begin() + 64);
+	const auto loaded = run("test_tmu_loads", {{0u, std::vector<uint32_t>(16)}, {0u, in0}, {0u, in1}}, true);
+	// the 7 loads exceed the depth of the TMU FIFO
+	const auto manyLoaded = run("test_tmu_many_loads", {{0u, std::vector<uint32_t>(16)}, {0u, input}}, true);
+	for(uint32_t i = 0; i < 16; ++i)
+	{
+		const uint32_t a = in0[i];
+		TEST_ASSERT_EQUALS((a + in1[i] * 3u) ^ (in0[i + 16] - in1[(a & 15u) + 16u]), loaded.at(i));
+
+		const uint32_t* values = &input[i];
+		TEST_ASSERT_EQUALS(values[0] + values[16] * 2u + values[32] * 3u + (values[48] ^ values[64]) +
+				(values[80] | values[96]),
+			manyLoaded.at(i));
+	}
+
+	// the SFU results are read from r4 like the TMU results, so reading the wrong result gives a different output
+	const auto sfu = run("test_tmu_sfu", {{0u, std::vector<uint32_t>(16)}, {0u, floatInput}}, false);
+	for(uint32_t i = 0; i < 16; ++i)
+	{
+		const float a = bit_cast<uint32_t, float>(floatInput[i]);
+		const float b = bit_cast<uint32_t, float>(floatInput[i + 16]);
+		const float c = bit_cast<uint32_t, float>(floatInput[i + 32]);
+		const float expected = (1.0f / a) * c + (1.0f / std::sqrt(b)) * a + std::exp2(c - b);
+		const float result = bit_cast<uint32_t, float>(sfu.at(i));
+		TEST_ASSERT(std::abs(result - expected) <= std::abs(expected) * 1e-5f);
+	}
+}
+
 void TestEmulator::testSHA1()
 {
 	const std::string sample("Hello World!");
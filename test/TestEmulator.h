@@ -9,9 +9,11 @@
 
 #include "cpptest.h"
 
+#include "Optional.h"
 #include "config.h"
 
 #include <map>
+#include <sstream>
 #include <vector>
 
 namespace vc4c
@@ -34,6 +36,20 @@ public:
 	void testBarrier();
 	void testBranches();
 	void testWorkItem();
+	void testKernelSpecialization();
+	void testBatchCompilation();
+	void testLazyFunctionMaterialization();
+	void testCompilationServer();
+	void testLoopUnrolling();
+	void testLoopVectorization();
+	void testLoopInvariantCodeMotion();
+	void testRegisterPressure();
+	void testVectorRotations();
+	void testPackModes();
+	void testDMAPipelining();
+	void testRedundantExtensions();
+	void testALUPacking();
+	void testTMUPipelining();
 	void testSHA1();
 	void testSHA256();
 	void testIntegerEmulations(std::size_t index, std::string name);
@@ -46,7 +62,42 @@ protected:
 	void testFloatingEmulation(vc4c::tools::EmulationData& data, std::map<uint32_t, std::vector<uint32_t>>& expectedResults, unsigned maxULP = 1);
 	
 	void compileFile(std::stringstream& buffer, const std::string& fileName, const std::string& options = "");
-	
+
+	/*
+	 * The output and the instrumentation totals of a single kernel execution
+	 */
+	struct KernelExecution
+	{
+		// the contents of the first parameter after the execution
+		std::vector<uint32_t> output;
+		unsigned numInstructions = 0;
+		unsigned numBranchesTaken = 0;
+	};
+	/*
+	 * Emulates the kernel from the compiled buffer with the given parameters and a single work-group
+	 */
+	KernelExecution runKernel(std::stringstream& buffer, const std::string& kernelName,
+		const std::vector<std::pair<uint32_t, vc4c::Optional<std::vector<uint32_t>>>>& parameters, uint32_t localSize = 1);
+
+	/*
+	 * Resets the configuration to its state on construction when leaving the scope, also if the compilation throws
+	 */
+	class ConfigurationScope
+	{
+	public:
+		explicit ConfigurationScope(vc4c::Configuration& config) : config(config), original(config) {}
+		ConfigurationScope(const ConfigurationScope&) = delete;
+		ConfigurationScope& operator=(const ConfigurationScope&) = delete;
+		~ConfigurationScope()
+		{
+			config = original;
+		}
+
+	private:
+		vc4c::Configuration& config;
+		const vc4c::Configuration original;
+	};
+
 	vc4c::Configuration config;
 };
 
@@ -9,6 +9,16 @@
 #include "Values.h"
 #include "asm/OpCodes.h"
 #include "Bitfield.h"
+#include "CompilationError.h"
+#include "Method.h"
+#include "Module.h"
+#include "ProcessUtil.h"
+#include "analysis/ValueRange.h"
+#include "intermediate/IntermediateInstruction.h"
+#include "periphery/VPM.h"
+
+#include <chrono>
+#include <sstream>
 
 using namespace vc4c;
 
@@ -18,6 +28,9 @@ TestInstructions::TestInstructions()
 	TEST_ADD(TestInstructions::testConstantSaturations);
 	TEST_ADD(TestInstructions::testBitfields);
 	TEST_ADD(TestInstructions::testOpCodes);
+	TEST_ADD(TestInstructions::testVPMAreaReuse);
+	TEST_ADD(TestInstructions::testValueRanges);
+	TEST_ADD(TestInstructions::testRunProcess);
 }
 
 TestInstructions::~TestInstructions()
@@ -183,4 +196,158 @@ void TestInstructions::testOpCodes()
 	
 	TEST_ASSERT_EQUALS(INT_ZERO, OP_V8SUBS(INT_ONE, INT_ONE).value());
 	TEST_ASSERT_EQUALS(INT_ONE, OP_V8MAX(INT_ONE, INT_ZERO).value());
-}
\ No newline at end of file
+}
+void TestInstructions::testVPMAreaReuse()
+{
+	Configuration config;
+	Module module(config);
+	Method method(module);
+	periphery::VPM vpm(VPM_DEFAULT_SIZE);
+
+	const DataType type = TYPE_INT32.toVectorType(16);
+	const DataType pointerType = type.toPointerType(AddressSpace::LOCAL);
+	const Local* first = method.addNewLocal(pointerType, "%first").local();
+	const Local* overlapping = method.addNewLocal(pointerType, "%overlapping").local();
+	const Local* reusing = method.addNewLocal(pointerType, "%reusing").local();
+	const Local* unknown = method.addNewLocal(pointerType, "%unknown").local();
+
+	auto firstArea = vpm.addArea(first, type, false, 1, periphery::VPMLifetime{0, 10});
+	auto overlappingArea = vpm.addArea(overlapping, type, false, 1, periphery::VPMLifetime{5, 15});
+	auto reusingArea = vpm.addArea(reusing, type, false, 1, periphery::VPMLifetime{11, 20});
+	// areas without known lifetime never share rows
+	auto unknownArea = vpm.addArea(unknown, type, false, 1);
+
+	TEST_ASSERT(firstArea != nullptr);
+	TEST_ASSERT(overlappingArea != nullptr);
+	TEST_ASSERT(reusingArea != nullptr);
+	TEST_ASSERT(unknownArea != nullptr);
+
+	// live at the same time -> different rows
+	TEST_ASSERT(firstArea->rowOffset != overlappingArea->rowOffset);
+	TEST_ASSERT(reusingArea->rowOffset != overlappingArea->rowOffset);
+	// disjoint lifetimes -> same rows
+	TEST_ASSERT_EQUALS(static_cast<unsigned>(firstArea->rowOffset), static_cast<unsigned>(reusingArea->rowOffset));
+	TEST_ASSERT_EQUALS(reusingArea, vpm.findArea(reusing));
+	TEST_ASSERT(unknownArea->rowOffset != firstArea->rowOffset);
+	TEST_ASSERT(unknownArea->rowOffset != overlappingArea->rowOffset);
+}
+
+void TestInstructions::testValueRanges()
+{
+	using namespace vc4c::intermediate;
+	Configuration config;
+	Module module(config);
+	Method method(module);
+
+	BasicBlock& start = method.createAndInsertNewBlock(method.end(), "%start");
+	BasicBlock& other = method.createAndInsertNewBlock(method.end(), "%other");
+	BasicBlock& loop = method.createAndInsertNewBlock(method.end(), "%loop");
+	BasicBlock& end = method.createAndInsertNewBlock(method.end(), "%end");
+
+	const Value phi = method.addNewLocal(TYPE_INT32, "%phi");
+	const Value phiUser = method.addNewLocal(TYPE_INT32, "%phi_user");
+	const Value counter = method.addNewLocal(TYPE_INT32, "%counter");
+	const Value counterNext = method.addNewLocal(TYPE_INT32, "%counter_next");
+	const Value masked = method.addNewLocal(TYPE_INT32, "%masked");
+	const Value maskedNext = method.addNewLocal(TYPE_INT32, "%masked_next");
+
+	// the phi-node is set to different values in the two predecessors of the loop
+	start.end().emplace(new MoveOperation(phi, Value(Literal(5), TYPE_INT32)))
+		->addDecorations(InstructionDecorations::PHI_NODE);
+	start.end().emplace(new MoveOperation(counter, INT_ZERO))->addDecorations(InstructionDecorations::PHI_NODE);
+	start.end().emplace(new MoveOperation(masked, INT_ZERO))->addDecorations(InstructionDecorations::PHI_NODE);
+	start.end().emplace(new Branch(loop.getLabel()->getLabel(), COND_ALWAYS, BOOL_TRUE));
+	other.end().emplace(new MoveOperation(phi, Value(Literal(17), TYPE_INT32)))
+		->addDecorations(InstructionDecorations::PHI_NODE);
+	other.end().emplace(new MoveOperation(counter, INT_ZERO))->addDecorations(InstructionDecorations::PHI_NODE);
+	other.end().emplace(new MoveOperation(masked, INT_ZERO))->addDecorations(InstructionDecorations::PHI_NODE);
+
+	// the loop-carried counter grows in every iteration, while the masked value stays within its range
+	loop.end().emplace(new Operation(OP_ADD, phiUser, phi, Value(Literal(3), TYPE_INT32)));
+	loop.end().emplace(new Operation(OP_ADD, counterNext, counter, INT_ONE));
+	loop.end().emplace(new Operation(OP_AND, maskedNext, counterNext, Value(Literal(15), TYPE_INT32)));
+	loop.end().emplace(new MoveOperation(counter, counterNext))->addDecorations(InstructionDecorations::PHI_NODE);
+	loop.end().emplace(new MoveOperation(masked, maskedNext))->addDecorations(InstructionDecorations::PHI_NODE);
+	loop.end().emplace(new Branch(loop.getLabel()->getLabel(), COND_ALWAYS, BOOL_TRUE));
+	end.end().emplace(new MoveOperation(Value(REG_NOP, TYPE_INT32), masked));
+
+	// terminates although the counter never reaches a fixed point without widening
+	const auto ranges = analysis::ValueRange::determineValueRanges(method);
+
+	// the ranges of all writes of the phi-node are joined
+	TEST_ASSERT(ranges.find(phi.local()) != ranges.end());
+	TEST_ASSERT_EQUALS(int64_t{5}, ranges.at(phi.local()).getIntRange()->minValue);
+	TEST_ASSERT_EQUALS(int64_t{17}, ranges.at(phi.local()).getIntRange()->maxValue);
+	TEST_ASSERT(ranges.find(phiUser.local()) != ranges.end());
+	TEST_ASSERT_EQUALS(int64_t{8}, ranges.at(phiUser.local()).getIntRange()->minValue);
+	TEST_ASSERT_EQUALS(int64_t{20}, ranges.at(phiUser.local()).getIntRange()->maxValue);
+
+	// the growing counter is widened instead of being discarded, the widened range covers all iterations
+	TEST_ASSERT(ranges.find(counter.local()) != ranges.end());
+	TEST_ASSERT(ranges.find(counterNext.local()) != ranges.end());
+	TEST_ASSERT(!ranges.at(counter.local()).fitsIntoType(TYPE_INT16));
+	TEST_ASSERT(!ranges.at(counterNext.local()).fitsIntoType(TYPE_INT16));
+
+	// the loop-carried value calculated from the widened counter keeps its precise range
+	TEST_ASSERT(ranges.find(masked.local()) != ranges.end());
+	TEST_ASSERT_EQUALS(int64_t{0}, ranges.at(masked.local()).getIntRange()->minValue);
+	TEST_ASSERT_EQUALS(int64_t{15}, ranges.at(masked.local()).getIntRange()->maxValue);
+	TEST_ASSERT(ranges.at(masked.local()).isUnsigned());
+	TEST_ASSERT(ranges.at(masked.local()).fitsIntoType(TYPE_INT8, false));
+}
+
+void TestInstructions::testRunProcess()
+{
+	// larger than the pipe buffers, so the input and output need to be transferred at the same time
+	const std::string largeData(1024 * 1024 + 17, 'x');
+
+	// forwards the standard input to the standard output
+	{
+		std::istringstream in(largeData);
+		std::ostringstream out;
+		std::ostringstream err;
+		TEST_ASSERT_EQUALS(0, runProcess("cat", &in, &out, &err));
+		TEST_ASSERT(out.str() == largeData);
+		TEST_ASSERT(err.str().empty());
+	}
+
+	// large output without any input
+	{
+		std::ostringstream out;
+		TEST_ASSERT_EQUALS(0, runProcess("head -c 1048576 /dev/zero", nullptr, &out));
+		TEST_ASSERT_EQUALS(std::size_t{1024 * 1024}, out.str().size());
+	}
+
+	// large error output, dd also prints its statistics to the standard error
+	{
+		std::ostringstream out;
+		std::ostringstream err;
+		TEST_ASSERT_EQUALS(0, runProcess("dd if=/dev/zero of=/dev/stderr bs=1024 count=1024", nullptr, &out, &err));
+		TEST_ASSERT(out.str().empty());
+		TEST_ASSERT(err.str().size() >= std::size_t{1024 * 1024});
+	}
+
+	// the exit status of the child is returned
+	{
+		std::ostringstream out;
+		std::ostringstream err;
+		TEST_ASSERT_EQUALS(1, runProcess("false", nullptr, &out, &err));
+		TEST_ASSERT(runProcess("cat /this/file/does/not/exist", nullptr, &out, &err) != 0);
+		TEST_ASSERT(out.str().empty());
+		TEST_ASSERT(!err.str().empty());
+	}
+
+	// the child is killed after the timeout, with and without any streams to wait on
+	for(bool hasStreams : {false, true})
+	{
+		std::ostringstream out;
+		std::ostringstream err;
+		const auto start = std::chrono::steady_clock::now();
+		TEST_THROWS(runProcess("sleep 10", nullptr, hasStreams ? &out : nullptr, hasStreams ? &err : nullptr,
+						std::chrono::milliseconds(200)),
+			CompilationError);
+		TEST_ASSERT(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+	}
+	// the timeout does not affect a child finishing in time
+	TEST_ASSERT_EQUALS(0, runProcess("sleep 0.1", nullptr, nullptr, nullptr, std::chrono::milliseconds(10000)));
+}
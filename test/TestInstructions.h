@@ -19,6 +19,9 @@ public:
 	void testConstantSaturations();
 	void testBitfields();
 	void testOpCodes();
+	void testVPMAreaReuse();
+	void testValueRanges();
+	void testRunProcess();
 };
 
 #endif /* TEST_INSTRUCTIONS_H */
@@ -90,6 +90,7 @@ __kernel void test(__global TYPE* out, const __global TYPE* in, __global TYPE* p
 TestMemoryAccess::TestMemoryAccess(const Configuration& config) : TestEmulator(false, config)
 {
     TEST_ADD(TestMemoryAccess::testPrivateStorage);
+    TEST_ADD(TestMemoryAccess::testPrivateStructStorage);
     TEST_ADD(TestMemoryAccess::testLocalStorage);
     TEST_ADD(TestMemoryAccess::testConstantStorage);
     TEST_ADD(TestMemoryAccess::testRegisterStorage);
@@ -192,6 +193,56 @@ void TestMemoryAccess::testPrivateStorage()
     }
 }
 
+void TestMemoryAccess::testPrivateStructStorage()
+{
+    // without -O0, the front-end would already promote the private struct and array to registers
+    std::stringstream buffer;
+    compileFile(buffer, "./testing/test_private_struct_storage.cl", "-O0");
+
+    std::vector<uint32_t> input(24);
+    for(uint32_t i = 0; i < input.size(); ++i)
+        input[i] = i * 7;
+
+    // returns the total number of executed instructions
+    auto run = [&](const std::string& kernelName) -> unsigned {
+        buffer.clear();
+        buffer.seekg(0);
+        EmulationData data;
+        data.kernelName = kernelName;
+        data.maxEmulationCycles = vc4c::test::maxExecutionCycles;
+        data.module = std::make_pair("", &buffer);
+        data.workGroup.dimensions = 3;
+        data.workGroup.globalOffsets = {0, 0, 0};
+        data.workGroup.localSizes = {12, 1, 1};
+        data.workGroup.numGroups = {2, 1, 1};
+
+        // parameter 0 is the input
+        data.parameter.emplace_back(0, input);
+        // parameter 1 is the output
+        data.parameter.emplace_back(0, std::vector<uint32_t>(24));
+
+        const auto result = emulate(data);
+        TEST_ASSERT(result.executionSuccessful);
+        TEST_ASSERT_EQUALS(2u, result.results.size());
+        const auto& output = result.results.at(1).second.value();
+        for(std::size_t i = 0; i < output.size(); ++i)
+        {
+            TEST_ASSERT_EQUALS(2 * input[i] + 8, output[i]);
+        }
+        unsigned numInstructions = 0;
+        for(const auto& instrumentation : result.instrumentation)
+            numInstructions += instrumentation.numExecutions;
+        return numInstructions;
+    };
+
+    const unsigned numStructInstructions = run("test_private_struct_storage");
+    const unsigned numReferenceInstructions = run("test_private_struct_storage_reference");
+    // if the struct and array are lowered into registers, only a few moves are executed in addition to the reference
+    // kernel. Otherwise, every of the 6 accesses would need to lock the mutex, set up the VPM and/or DMA and wait for
+    // the transfer to finish.
+    TEST_ASSERT(numStructInstructions * 4 <= numReferenceInstructions * 5);
+}
+
 void TestMemoryAccess::testLocalStorage()
 {
     std::stringstream buffer;
@@ -15,6 +15,7 @@ public:
     TestMemoryAccess(const vc4c::Configuration& config = {});
 
     void testPrivateStorage();
+    void testPrivateStructStorage();
     void testLocalStorage();
     void testConstantStorage();
     void testRegisterStorage();
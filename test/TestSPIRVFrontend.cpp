@@ -6,16 +6,27 @@
 
 #include "TestSPIRVFrontend.h"
 
+#include "Compiler.h"
 #include "spirv/SPIRVHelper.h"
+#include "tools.h"
 #ifdef SPIRV_HEADER
 #include SPIRV_PARSER_HEADER
 
 using namespace vc4c::spirv2qasm;
 #endif
 
+#include "test_cases.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace vc4c;
+using namespace vc4c::tools;
+
 TestSPIRVFrontend::TestSPIRVFrontend()
 {
 	TEST_ADD(TestSPIRVFrontend::testCapabilitiesSupport);
+	TEST_ADD(TestSPIRVFrontend::testSPIRVToolsOptimizer);
 }
 
 TestSPIRVFrontend::~TestSPIRVFrontend()
@@ -44,3 +55,49 @@ void TestSPIRVFrontend::testCapabilitiesSupport()
 	TEST_ASSERT_EQUALS(SPV_SUCCESS, checkCapability(SpvCapability::SpvCapabilityVector16));
 #endif
 }
+
+void TestSPIRVFrontend::testSPIRVToolsOptimizer()
+{
+#ifdef SPIRV_FRONTEND
+	std::vector<uint32_t> input(12);
+	for(uint32_t i = 0; i < input.size(); ++i)
+		input[i] = i * 0x01030507u + 0x89ABCDEFu;
+
+	// compiles the kernel via the SPIR-V front-end with the given timeout for the SPIRV-Tools optimizations and runs it
+	auto run = [&](unsigned optimizerTimeout) -> std::vector<uint32_t> {
+		Configuration config;
+		config.frontend = Frontend::SPIR_V;
+		config.outputMode = OutputMode::BINARY;
+		config.writeKernelInfo = true;
+		config.additionalOptions.spirvOptimizerTimeout = optimizerTimeout;
+		const std::string fileName = "./testing/test_lazy_functions.cl";
+		std::ifstream source(fileName);
+		std::stringstream buffer;
+		Compiler::compile(source, buffer, config, "", fileName);
+
+		EmulationData data;
+		data.kernelName = "test_lazy_call";
+		data.maxEmulationCycles = vc4c::test::maxExecutionCycles;
+		data.module = std::make_pair("", &buffer);
+		data.workGroup.localSizes = {12, 1, 1};
+		data.parameter.emplace_back(0, std::vector<uint32_t>(12));
+		data.parameter.emplace_back(0, input);
+		const auto result = emulate(data);
+		TEST_ASSERT(result.executionSuccessful);
+		return result.results.empty() || !result.results.front().second ? std::vector<uint32_t>{} :
+																			 *result.results.front().second;
+	};
+
+	// the default timeout is large enough for the optimizations to finish, which e.g. inline the helper functions
+	const auto optimized = run(Configuration{}.additionalOptions.spirvOptimizerTimeout);
+	const auto unoptimized = run(0);
+	// the optimizations are aborted and the unoptimized module is used instead
+	const auto aborted = run(1);
+
+	TEST_ASSERT_EQUALS(input.size(), optimized.size());
+	for(uint32_t i = 0; i < optimized.size(); ++i)
+		TEST_ASSERT_EQUALS((input[i] * 3u + 1u) ^ i, optimized.at(i));
+	TEST_ASSERT(optimized == unoptimized);
+	TEST_ASSERT(optimized == aborted);
+#endif
+}
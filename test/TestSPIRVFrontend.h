@@ -16,6 +16,7 @@ public:
 	~TestSPIRVFrontend() override;
 
 	void testCapabilitiesSupport();
+	void testSPIRVToolsOptimizer();
 };
 
 #endif /* TEST_SPIRVFRONTEND_H */
@@ -0,0 +1,43 @@
+/*
+ * Tests the pipelining of DMA transfers between RAM and VPM.
+ *
+ * The buffers are read and written, so they are accessed via DMA instead of TMU.
+ */
+
+/*
+ * Back-to-back loads, the next load can be issued while the previous data is read from VPM
+ */
+__kernel void test_dma_loads(__global int16* data)
+{
+	size_t gid = get_global_id(0);
+	int16 a = data[gid * 4 + 0];
+	int16 b = data[gid * 4 + 1];
+	int16 c = data[gid * 4 + 2];
+	int16 d = data[gid * 4 + 3];
+	data[gid * 4] = a + b * 2 + c * 3 + d * 4;
+}
+
+/*
+ * Back-to-back stores, waiting for the previous store can be deferred while writing the next data into VPM
+ */
+__kernel void test_dma_stores(__global int16* out, __global int16* in)
+{
+	size_t gid = get_global_id(0);
+	int16 val = in[gid];
+	out[gid * 4 + 0] = val;
+	out[gid * 4 + 1] = val + 1;
+	out[gid * 4 + 2] = val * 2;
+	out[gid * 4 + 3] = val ^ 0x5A5A;
+	in[gid] = val - 1;
+}
+
+/*
+ * Alternating loads and stores of the same memory, the loads must not be issued before the previous stores finished
+ */
+__kernel void test_dma_load_store(__global int16* data)
+{
+	size_t gid = get_global_id(0);
+	data[gid * 4 + 1] = data[gid * 4 + 0] + 1;
+	data[gid * 4 + 2] = data[gid * 4 + 1] * 3;
+	data[gid * 4 + 3] = data[gid * 4 + 2] - data[gid * 4 + 0];
+}
@@ -0,0 +1,36 @@
+/*
+ * Tests the lazy loading of function bodies in the LLVM IR front-end.
+ *
+ * The helper functions are not inlined by the compiler front-end, so their bodies are only read when a kernel calling
+ * them is parsed. The last helper function is never called, so its body is never read.
+ */
+
+__attribute__((noinline)) int nested_helper(int a)
+{
+	return a * 3 + 1;
+}
+
+__attribute__((noinline)) int helper(int a, int b)
+{
+	return nested_helper(a) ^ b;
+}
+
+__attribute__((noinline)) int unused_helper(int a)
+{
+	return a / 7;
+}
+
+__kernel void test_lazy_call(__global int* out, const __global int* in)
+{
+	size_t gid = get_global_id(0);
+	out[gid] = helper(in[gid], (int) gid);
+}
+
+/*
+ * Calls the function already read for the other kernel directly
+ */
+__kernel void test_lazy_shared_call(__global int* out, const __global int* in)
+{
+	size_t gid = get_global_id(0);
+	out[gid] = nested_helper(in[gid]) + helper(in[gid], 5);
+}
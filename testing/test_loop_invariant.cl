@@ -0,0 +1,55 @@
+/*
+ * Tests the moving of loop-invariant code out of loops.
+ *
+ * Only the values calculated in the first kernel are actually invariant, the values in the other kernels only look
+ * like they are.
+ */
+
+__kernel void test_invariant(__global int* out, const __global int* in, int a, int b, int c)
+{
+	for(int i = 0; i < 16; ++i)
+	{
+		out[i] = in[i] * (a * b + c) + (a ^ c);
+	}
+}
+
+/*
+ * The value is conditionally overwritten inside the loop
+ */
+__kernel void test_conditional_write(__global int* out, const __global int* in, int a, int b, int c)
+{
+	int val = a * 3;
+	for(int i = 0; i < 16; ++i)
+	{
+		if(in[i] > c)
+			val = b + 7;
+		out[i] = val * 2 + a;
+	}
+}
+
+/*
+ * The value is calculated from a local which is written in the loop
+ */
+__kernel void test_written_in_loop(__global int* out, const __global int* in, int a, int b, int c)
+{
+	int acc = a;
+	for(int i = 0; i < 16; ++i)
+	{
+		int tmp = acc * 5 + b;
+		acc = tmp + in[i];
+		out[i] = tmp - c;
+	}
+}
+
+/*
+ * The address of the memory access is invariant, but the memory is modified inside the loop
+ */
+__kernel void test_side_effects(__global int* data, const __global int* in, int a, int b, int c)
+{
+	for(int i = 0; i < 16; ++i)
+	{
+		int val = data[0];
+		data[0] = val + in[i];
+		data[i + 1] = val * a + b;
+	}
+}
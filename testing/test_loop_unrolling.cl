@@ -0,0 +1,59 @@
+/*
+ * Tests the determination of the iteration count for unrolling loops with different comparisons and steps.
+ *
+ * The loops are not unrolled by the front-end, so the unrolling (if any) is done by VC4C.
+ */
+__kernel void test_unroll_less(__global int* out, const __global int* in)
+{
+	int sum = 0;
+#pragma unroll 1
+	for(int i = 0; i < 10; i += 3)
+	{
+		sum += in[i] * (i + 1);
+	}
+	out[get_global_id(0)] = sum;
+}
+
+__kernel void test_unroll_less_equal(__global int* out, const __global int* in)
+{
+	int sum = 0;
+#pragma unroll 1
+	for(int i = 1; i <= 9; i += 2)
+	{
+		sum += in[i] * (i + 1);
+	}
+	out[get_global_id(0)] = sum;
+}
+
+__kernel void test_unroll_not_equal(__global int* out, const __global int* in)
+{
+	int sum = 0;
+#pragma unroll 1
+	for(int i = 0; i != 12; i += 4)
+	{
+		sum += in[i] * (i + 1);
+	}
+	out[get_global_id(0)] = sum;
+}
+
+__kernel void test_unroll_decrement(__global int* out, const __global int* in)
+{
+	int sum = 0;
+#pragma unroll 1
+	for(int i = 15; i > 0; --i)
+	{
+		sum += in[i] * (i + 1);
+	}
+	out[get_global_id(0)] = sum;
+}
+
+__kernel void test_unroll_decrement_greater_equal(__global int* out, const __global int* in)
+{
+	int sum = 0;
+#pragma unroll 1
+	for(int i = 14; i >= 0; i -= 3)
+	{
+		sum += in[i] * (i + 1);
+	}
+	out[get_global_id(0)] = sum;
+}
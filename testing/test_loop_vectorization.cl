@@ -0,0 +1,177 @@
+/*
+ * Tests the vectorization of loops, which need a scalar remainder loop and which accumulate values.
+ *
+ * The loops are neither unrolled nor vectorized by the front-end, so the vectorization (if any) is done by VC4C.
+ * All loops with compile-time bounds run 21 iterations, so they cannot be vectorized without executing remaining
+ * iterations.
+ */
+__kernel void test_vectorize_remainder(__global int* out, const __global int* in)
+{
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 1; i < 22; ++i)
+	{
+		out[i] = in[i] + i;
+	}
+}
+
+__kernel void test_vectorize_remainder_step(__global int* out, const __global int* in)
+{
+	int sum = 0;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 61; i += 3)
+	{
+		sum += in[i / 2];
+	}
+	out[0] = sum;
+}
+
+__kernel void test_vectorize_add(__global int* out, const __global int* in)
+{
+	int sum = 0;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		sum += in[i];
+	}
+	out[0] = sum;
+}
+
+__kernel void test_vectorize_and(__global int* out, const __global int* in)
+{
+	int sum = -1;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		sum &= in[i];
+	}
+	out[0] = sum;
+}
+
+__kernel void test_vectorize_or(__global int* out, const __global int* in)
+{
+	int sum = 0;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		sum |= in[i];
+	}
+	out[0] = sum;
+}
+
+__kernel void test_vectorize_xor(__global int* out, const __global int* in)
+{
+	int sum = 0;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		sum ^= in[i];
+	}
+	out[0] = sum;
+}
+
+__kernel void test_vectorize_min(__global int* out, const __global int* in)
+{
+	int result = 0x7FFFFFFF;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		result = min(result, in[i]);
+	}
+	out[0] = result;
+}
+
+__kernel void test_vectorize_max(__global int* out, const __global int* in)
+{
+	int result = -0x7FFFFFFF - 1;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		result = max(result, in[i]);
+	}
+	out[0] = result;
+}
+
+__kernel void test_vectorize_fmin(__global float* out, const __global float* in)
+{
+	float result = INFINITY;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		result = fmin(result, in[i]);
+	}
+	out[0] = result;
+}
+
+__kernel void test_vectorize_fmax(__global float* out, const __global float* in)
+{
+	float result = -INFINITY;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		result = fmax(result, in[i]);
+	}
+	out[0] = result;
+}
+
+/*
+ * Floating-point additions and multiplications are only vectorized with fast-math enabled.
+ * The inputs are chosen to make the results independent of the order of the operations.
+ */
+__kernel void test_vectorize_fadd(__global float* out, const __global float* in)
+{
+	float sum = 0.0f;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		sum += in[i];
+	}
+	out[0] = sum;
+}
+
+__kernel void test_vectorize_fmul(__global float* out, const __global float* in)
+{
+	float product = 1.0f;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < 21; ++i)
+	{
+		product *= in[i];
+	}
+	out[0] = product;
+}
+
+/*
+ * The bound is only known at run-time, so the numbers of vectorized and remaining iterations are calculated at run-time
+ */
+__kernel void test_vectorize_runtime_bound(__global int* out, const __global int* in, int count)
+{
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < count; ++i)
+	{
+		out[i] = in[i] + i;
+	}
+}
+
+__kernel void test_vectorize_runtime_bound_add(__global int* out, const __global int* in, int count)
+{
+	int sum = 0;
+#pragma unroll 1
+#pragma clang loop vectorize(disable)
+	for(int i = 0; i < count; ++i)
+	{
+		sum += in[i];
+	}
+	out[0] = sum;
+}
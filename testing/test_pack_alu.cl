@@ -0,0 +1,61 @@
+/*
+ * Tests the packing of instructions to be executed together on the ADD and MUL ALU.
+ */
+
+/*
+ * The calculations of the different outputs are independent, so they can be executed in parallel
+ */
+__kernel void test_independent(__global uint* out, const __global uint* in)
+{
+	size_t gid = get_global_id(0);
+	uint a = in[gid];
+	uint b = in[gid + 16];
+	out[gid * 4 + 0] = (a + 7u) ^ (b - 3u);
+	out[gid * 4 + 1] = (a & 0xFF00FFu) | (b >> 4);
+	out[gid * 4 + 2] = (a << 3) - (b & 0x0F0F0Fu);
+	out[gid * 4 + 3] = max(a, b) + min(a ^ 0x5A5Au, b);
+}
+
+/*
+ * The selections set flags and conditionally write their results, so the flags need to be kept between the setting
+ * and the conditional instructions
+ */
+__kernel void test_conditional(__global int* out, const __global int* in)
+{
+	size_t gid = get_global_id(0);
+	int a = in[gid];
+	int b = in[gid + 16];
+	out[gid * 4 + 0] = a > b ? a - b : b + 5;
+	out[gid * 4 + 1] = (a & 1) ? a ^ 0x1234 : b;
+	out[gid * 4 + 2] = (b < 0 ? 1 : 2) + (a == b ? 3 : 4);
+	out[gid * 4 + 3] = a < 0 ? (b > 0 ? a + b : a - b) : (b & a);
+}
+
+/*
+ * The results of the SFU calculations need to be read a fixed number of instructions after they are started, so the
+ * delays can't be shortened by moving instructions away
+ */
+__kernel void test_sfu(__global float* out, const __global float* in)
+{
+	size_t gid = get_global_id(0);
+	float a = in[gid];
+	float b = in[gid + 16];
+	float recip = native_recip(a);
+	out[gid * 4 + 0] = recip > 0.5f ? recip : b;
+	out[gid * 4 + 1] = native_rsqrt(b) * a;
+	out[gid * 4 + 2] = native_exp2(a) - native_log2(b);
+	out[gid * 4 + 3] = a * b + 1.0f;
+}
+
+/*
+ * The address of the second load depends on the first loaded value, so the TMU results need to be read in order
+ */
+__kernel void test_tmu(__global uint* out, const __global uint* in)
+{
+	size_t gid = get_global_id(0);
+	uint a = in[gid];
+	uint b = in[(a & 15u) + 16u];
+	uint c = in[gid + 32];
+	out[gid * 2 + 0] = b + (a ^ 0x1234u);
+	out[gid * 2 + 1] = (c - a) | (b & 0xF0u);
+}
@@ -0,0 +1,59 @@
+/*
+ * Tests the masking and extraction of bytes and half-words, which can be folded into pack- and unpack-modes.
+ */
+__kernel void test_extract_bytes(__global uint* out, const __global uint* in)
+{
+	size_t gid = get_global_id(0);
+	uint val = in[gid] * 3u;
+	out[gid * 4 + 0] = val & 0xFFu;
+	out[gid * 4 + 1] = (val >> 8) & 0xFFu;
+	out[gid * 4 + 2] = (val >> 16) & 0xFFu;
+	out[gid * 4 + 3] = (in[gid] + 7u) & 0xFFu;
+}
+
+__kernel void test_extract_half_words(__global int* out, const __global int* in)
+{
+	size_t gid = get_global_id(0);
+	int val = in[gid] * 3;
+	out[gid * 4 + 0] = (in[gid] + 7) & 0xFFFF;
+	out[gid * 4 + 1] = (val << 16) >> 16;
+	out[gid * 4 + 2] = (int) (short) (in[gid] ^ 0x5A5A);
+	out[gid * 4 + 3] = (val >> 16) & 0xFFFF;
+}
+
+/*
+ * Both masked values are read by the same instruction, so they can't both be fixed to physical register-file A
+ */
+__kernel void test_add_masked(__global uint* out, const __global uint* in)
+{
+	size_t gid = get_global_id(0);
+	uint a = in[gid] + 7u;
+	uint b = in[gid] * 3u;
+	out[gid] = (a & 0xFFFFu) + (b & 0xFFu);
+}
+
+/*
+ * The masked values are rotated, so they can't be fixed to physical register-file A
+ */
+__kernel void test_rotate_masked(__global int16* out, const __global int16* in)
+{
+	size_t gid = get_global_id(0);
+	int16 bytes = (in[gid] + 7) & 0xFF;
+	int16 halfWords = (in[gid] * 3) & 0xFFFF;
+	out[gid] = vc4cl_vector_rotate(bytes, 8) + vc4cl_vector_rotate(halfWords, 8);
+}
+
+/*
+ * Reads the char and short elements via TMU, which extracts the bytes and half-words from the loaded words
+ */
+__kernel void test_load_chars(__global uint* out, const __global uchar* in)
+{
+	size_t gid = get_global_id(0);
+	out[gid] = in[gid] + 1u;
+}
+
+__kernel void test_load_shorts(__global int* out, const __global short* in)
+{
+	size_t gid = get_global_id(0);
+	out[gid] = in[gid] + 1;
+}
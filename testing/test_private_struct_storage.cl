@@ -0,0 +1,38 @@
+/*
+ * Tests the lowering of private structs and arrays only accessed at constant offsets into registers.
+ *
+ * NOTE: This file needs to be compiled with -O0, since otherwise the front-end already promotes the private memory.
+ */
+struct Pair
+{
+	int first;
+	int4 second;
+};
+
+__kernel void test_private_struct_storage(__global int* in, __global int* out)
+{
+	size_t gid = get_global_id(0);
+
+	__private struct Pair pair;
+	__private int loc[24];
+
+	pair.first = in[gid];
+	pair.second = (int4)(in[gid] + 1, 2, 3, 4);
+	loc[17] = pair.first + 3;
+	loc[3] = pair.second.x;
+
+	out[gid] = loc[17] + loc[3] + pair.second.w;
+}
+
+/*
+ * Calculates the same result as the kernel above without any private struct or array
+ */
+__kernel void test_private_struct_storage_reference(__global int* in, __global int* out)
+{
+	size_t gid = get_global_id(0);
+
+	int first = in[gid];
+	int4 second = (int4)(in[gid] + 1, 2, 3, 4);
+
+	out[gid] = (first + 3) + second.x + second.w;
+}
@@ -0,0 +1,43 @@
+/*
+ * Tests the elimination of zero- and sign-extensions of values already in range.
+ *
+ * The values in the first kernels exceed the range of their types, so their extensions must not be removed.
+ */
+
+__kernel void test_needed_zero_extension(__global uint* out, const __global uchar* in)
+{
+	size_t gid = get_global_id(0);
+	uchar sum = in[gid] + (uchar) 200;
+	out[gid] = sum;
+}
+
+__kernel void test_needed_sign_extension(__global int* out, const __global short* in)
+{
+	size_t gid = get_global_id(0);
+	short product = in[gid] * (short) 3;
+	out[gid] = product;
+}
+
+/*
+ * The loop-carried value exceeds the range of its type after a few iterations
+ */
+__kernel void test_needed_loop_extension(__global uint* out, const __global uint* in)
+{
+	uchar acc = 0;
+	for(int i = 0; i < 16; ++i)
+	{
+		acc += (uchar) in[i];
+	}
+	out[0] = acc;
+}
+
+/*
+ * The masked value fits into the positive range of both types, so the extensions can be removed
+ */
+__kernel void test_redundant_extension(__global int* out, const __global uchar* in)
+{
+	size_t gid = get_global_id(0);
+	uchar c = in[gid] & 0x7F;
+	short s = (short) (char) c;
+	out[gid] = (int) c + (int) s;
+}
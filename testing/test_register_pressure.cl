@@ -0,0 +1,94 @@
+/*
+ * Tests the register allocation of kernels with more live values than registers available.
+ *
+ * If the loads of the constants are moved out of the loop, the 56 constants and 16 accumulators are live across the
+ * whole loop, which does not fit into the physical registers without re-loading some of the constants before their use.
+ */
+
+// large constants, which cannot be encoded as small immediates and need to be loaded separately
+#define CONSTANT(i) (0x9E3779B9u + (i) * 0x01000193u)
+#define MIX(acc, i) acc = rotate(acc ^ (x + CONSTANT(i)), (uint) ((i) % 31 + 1))
+
+__kernel void test_register_pressure(__global uint* out, const __global uint* in)
+{
+	uint lid = get_local_id(0);
+	uint a0 = 0, a1 = 1, a2 = 2, a3 = 3, a4 = 4, a5 = 5, a6 = 6, a7 = 7;
+	uint a8 = 8, a9 = 9, a10 = 10, a11 = 11, a12 = 12, a13 = 13, a14 = 14, a15 = 15;
+#pragma unroll 1
+	for(uint i = 0; i < 4; ++i)
+	{
+		uint x = in[i * 16 + lid];
+		MIX(a0, 0);
+		MIX(a1, 1);
+		MIX(a2, 2);
+		MIX(a3, 3);
+		MIX(a4, 4);
+		MIX(a5, 5);
+		MIX(a6, 6);
+		MIX(a7, 7);
+		MIX(a8, 8);
+		MIX(a9, 9);
+		MIX(a10, 10);
+		MIX(a11, 11);
+		MIX(a12, 12);
+		MIX(a13, 13);
+		MIX(a14, 14);
+		MIX(a15, 15);
+		MIX(a0, 16);
+		MIX(a1, 17);
+		MIX(a2, 18);
+		MIX(a3, 19);
+		MIX(a4, 20);
+		MIX(a5, 21);
+		MIX(a6, 22);
+		MIX(a7, 23);
+		MIX(a8, 24);
+		MIX(a9, 25);
+		MIX(a10, 26);
+		MIX(a11, 27);
+		MIX(a12, 28);
+		MIX(a13, 29);
+		MIX(a14, 30);
+		MIX(a15, 31);
+		MIX(a0, 32);
+		MIX(a1, 33);
+		MIX(a2, 34);
+		MIX(a3, 35);
+		MIX(a4, 36);
+		MIX(a5, 37);
+		MIX(a6, 38);
+		MIX(a7, 39);
+		MIX(a8, 40);
+		MIX(a9, 41);
+		MIX(a10, 42);
+		MIX(a11, 43);
+		MIX(a12, 44);
+		MIX(a13, 45);
+		MIX(a14, 46);
+		MIX(a15, 47);
+		MIX(a0, 48);
+		MIX(a1, 49);
+		MIX(a2, 50);
+		MIX(a3, 51);
+		MIX(a4, 52);
+		MIX(a5, 53);
+		MIX(a6, 54);
+		MIX(a7, 55);
+	}
+	out[lid * 16 + 0] = a0;
+	out[lid * 16 + 1] = a1;
+	out[lid * 16 + 2] = a2;
+	out[lid * 16 + 3] = a3;
+	out[lid * 16 + 4] = a4;
+	out[lid * 16 + 5] = a5;
+	out[lid * 16 + 6] = a6;
+	out[lid * 16 + 7] = a7;
+	out[lid * 16 + 8] = a8;
+	out[lid * 16 + 9] = a9;
+	out[lid * 16 + 10] = a10;
+	out[lid * 16 + 11] = a11;
+	out[lid * 16 + 12] = a12;
+	out[lid * 16 + 13] = a13;
+	out[lid * 16 + 14] = a14;
+	out[lid * 16 + 15] = a15;
+}
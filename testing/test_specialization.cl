@@ -0,0 +1,13 @@
+/*
+ * Tests the specialization of kernels for constant arguments and work-sizes
+ */
+__kernel void test_specialization(__global int* out, const __global int* in, int factor, int count)
+{
+	size_t gid = get_global_id(0);
+	int sum = 0;
+	for(int i = 0; i < count; ++i)
+	{
+		sum += in[gid] * factor + i;
+	}
+	out[gid] = sum + (int) get_local_size(0) + (int) get_num_groups(0);
+}
@@ -0,0 +1,48 @@
+/*
+ * Tests the pipelining of memory loads via the TMU.
+ */
+
+/*
+ * Several independent loads in the same block, which can be distributed over both TMUs and issued early. The address of
+ * the last load depends on the first loaded value.
+ */
+__kernel void test_tmu_loads(__global uint* out, const __global uint* in0, const __global uint* in1)
+{
+	size_t gid = get_global_id(0);
+	uint a = in0[gid];
+	uint b = in1[gid];
+	uint c = in0[gid + 16];
+	uint d = in1[(a & 15u) + 16u];
+	out[gid] = (a + b * 3u) ^ (c - d);
+}
+
+/*
+ * More loads than requests fit into the TMU FIFO, so not all of them can be issued before reading the first result
+ */
+__kernel void test_tmu_many_loads(__global uint* out, const __global uint* in)
+{
+	size_t gid = get_global_id(0);
+	uint a = in[gid];
+	uint b = in[gid + 16];
+	uint c = in[gid + 32];
+	uint d = in[gid + 48];
+	uint e = in[gid + 64];
+	uint f = in[gid + 80];
+	uint g = in[gid + 96];
+	out[gid] = a + b * 2u + c * 3u + (d ^ e) + (f | g);
+}
+
+/*
+ * The results of the SFU calculations are also read via r4, so they can't be placed between the loading and the
+ * reading of a TMU result
+ */
+__kernel void test_tmu_sfu(__global float* out, const __global float* in)
+{
+	size_t gid = get_global_id(0);
+	float a = in[gid];
+	float recip = native_recip(a);
+	float b = in[gid + 16];
+	float root = native_rsqrt(b);
+	float c = in[gid + 32];
+	out[gid] = recip * c + root * a + native_exp2(c - b);
+}
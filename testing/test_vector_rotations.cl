@@ -0,0 +1,35 @@
+/*
+ * Tests the optimizations of vector rotations.
+ *
+ * The rotations are called directly, since the front-end would already combine consecutive vector shuffles.
+ * The results are independent of the direction of the rotation.
+ */
+
+/*
+ * The two rotations are located in different basic blocks and their offsets add up to a full rotation, so the second
+ * rotation is replaced with a move of the original vector.
+ */
+__kernel void test_rotation_across_blocks(__global int16* out, const __global int16* in)
+{
+	size_t gid = get_global_id(0);
+	int16 val = in[gid];
+	int16 rotated = vc4cl_vector_rotate(val, 3);
+	if(val.s0 & 1)
+		out[gid] = vc4cl_vector_rotate(rotated, 13);
+	else
+		out[gid] = val + 1;
+}
+
+/*
+ * The rotated vectors are calculated directly before the rotation, so the delay between writing and rotating them is
+ * filled with the independent calculations.
+ */
+__kernel void test_rotation_delay(__global int16* out, const __global int16* in)
+{
+	size_t gid = get_global_id(0);
+	int16 a = in[gid * 2];
+	int16 b = in[gid * 2 + 1];
+	int16 sum = a + b;
+	int16 diff = a - b;
+	out[gid] = vc4cl_vector_rotate(sum, 3) + vc4cl_vector_rotate(sum, 13) + vc4cl_vector_rotate(diff, 8);
+}